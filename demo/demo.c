@@ -374,6 +374,8 @@ static void notify_time_dependent(anjay_demo_t *demo) {
     }
 }
 
+#define DEMO_SERVE_BATCH_SIZE 16
+
 typedef struct {
     anjay_demo_t *demo;
     avs_net_abstract_socket_t *socket;
@@ -383,8 +385,9 @@ typedef struct {
 static void socket_dispatch(short revents, void *arg_) {
     (void) revents;
     socket_entry_t *arg = (socket_entry_t *) arg_;
-    int result = anjay_serve(arg->demo->anjay, arg->socket);
-    demo_log(DEBUG, "anjay_serve returned %d", result);
+    int result = anjay_serve_batch(arg->demo->anjay, arg->socket,
+                                   DEMO_SERVE_BATCH_SIZE);
+    demo_log(DEBUG, "anjay_serve_batch returned %d", result);
 }
 
 static socket_entry_t *create_socket_entry(anjay_demo_t *demo,
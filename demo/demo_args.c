@@ -140,9 +140,10 @@ static void print_option_help(const struct option *opt) {
         { 'q', "[BINDING_MODE=UQ]", "U", "set the Binding Mode to use." },
         { 's', "MODE", NULL, "set security mode, one of: psk rpk cert nosec." },
         { 'u', "URI", DEFAULT_CMDLINE_ARGS.connection_args.servers[0].uri,
-          "server URI to use. Note: coap:// URIs require --security-mode nosec "
-          "to be set. N consecutive URIs will create N servers enumerated "
-          "from 1 to N." },
+          "server URI to use. Note: coap:// and coap+tcp:// URIs require "
+          "--security-mode nosec to be set; coap+tcp:// and coaps+tcp:// URIs "
+          "require --binding=T or --binding=TQ. N consecutive URIs will create "
+          "N servers enumerated from 1 to N." },
         { 'I', "SIZE", "4000", "Nonnegative integer representing maximum "
                                "size of an incoming CoAP packet the client "
                                "should be able to handle." },
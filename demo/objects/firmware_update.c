@@ -562,17 +562,17 @@ static int write_firmware_to_file(anjay_t *anjay,
     bool finished = false;
     while (!finished) {
         size_t bytes_read;
-        char buffer[1024];
-        if ((result = anjay_get_bytes(ctx, &bytes_read, &finished, buffer,
-                            sizeof(buffer)))) {
-            demo_log(ERROR, "anjay_get_bytes() failed");
+        const void *data;
+        if ((result = anjay_get_bytes_view(ctx, &bytes_read, &finished,
+                                           &data))) {
+            demo_log(ERROR, "anjay_get_bytes_view() failed");
 
             set_state(anjay, fw, UPDATE_STATE_IDLE);
             set_update_result(anjay, fw, UPDATE_RESULT_FAILED);
             return result;
         }
 
-        if (fwrite(buffer, 1, bytes_read, f) != bytes_read) {
+        if (fwrite(data, 1, bytes_read, f) != bytes_read) {
             demo_log(ERROR, "fwrite failed");
 
             set_state(anjay, fw, UPDATE_STATE_IDLE);
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ANJAY_INCLUDE_ANJAY_MODULES_DTLS_SESSION_CACHE_H
+#define ANJAY_INCLUDE_ANJAY_MODULES_DTLS_SESSION_CACHE_H
+
+#include <anjay/anjay.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * Called for each entry of the (D)TLS session cache. @p config_hash identifies
+ * the socket configuration, including credentials, the session was
+ * established with. @p data is the opaque session state maintained by the
+ * (D)TLS backend, @p data_size is always @c ANJAY_DTLS_SESSION_BUFFER_SIZE.
+ */
+typedef int anjay_dtls_session_visitor_t(anjay_ssid_t ssid,
+                                         const char *host,
+                                         const char *port,
+                                         uint32_t config_hash,
+                                         const void *data,
+                                         size_t data_size,
+                                         void *arg);
+
+int _anjay_dtls_session_cache_foreach(anjay_t *anjay,
+                                      anjay_dtls_session_visitor_t *visitor,
+                                      void *arg);
+
+/**
+ * Stores session state for server @p ssid, reachable at @p host : @p port,
+ * established with the socket configuration identified by @p config_hash, as
+ * passed to @ref anjay_dtls_session_visitor_t. The state is discarded when
+ * connecting with a different configuration. If @p data_size is smaller than
+ * @c ANJAY_DTLS_SESSION_BUFFER_SIZE, the rest of the buffer is zeroed. If the
+ * session cache is compiled out, the data is ignored.
+ *
+ * @returns 0 on success, or a negative value if the data does not fit or in
+ *          case of an out-of-memory condition.
+ */
+int _anjay_dtls_session_cache_put(anjay_t *anjay,
+                                  anjay_ssid_t ssid,
+                                  const char *host,
+                                  const char *port,
+                                  uint32_t config_hash,
+                                  const void *data,
+                                  size_t data_size);
+
+/**
+ * Forgets all cached session state. Handshake statistics are retained.
+ */
+void _anjay_dtls_session_cache_clear(anjay_t *anjay);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_INCLUDE_ANJAY_MODULES_DTLS_SESSION_CACHE_H */
@@ -27,7 +27,9 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 
 typedef struct {
     bool instance_set_changed;
-    // NOTE: known_{added,removed}_iids lists may not be exhaustive
+    // NOTE: known_{added,removed}_iids lists are exhaustive only if
+    // unknown_change is false
+    bool unknown_change;
     AVS_LIST(anjay_iid_t) known_added_iids;
     AVS_LIST(anjay_iid_t) known_removed_iids;
 } anjay_notify_queue_instance_entry_t;
@@ -16,6 +16,11 @@
 
 #ifndef ANJAY_INCLUDE_ANJAY_MODULES_OBSERVE_H
 #define ANJAY_INCLUDE_ANJAY_MODULES_OBSERVE_H
+#include <stdint.h>
+#include <time.h>
+
+#include <avsystem/commons/list.h>
+
 #include <anjay/anjay.h>
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
@@ -24,6 +29,78 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 
 void _anjay_observe_gc(anjay_t *anjay);
 
+/**
+ * State of a single observation, sufficient to continue sending notifications
+ * after the client restarts.
+ */
+typedef struct {
+    anjay_ssid_t ssid;
+    /** anjay_connection_type_t value */
+    uint8_t conn_type;
+    anjay_oid_t oid;
+    /** ANJAY_IID_INVALID if the whole Object is observed */
+    anjay_iid_t iid;
+    /** -1 if the whole Object or Object Instance is observed */
+    int32_t rid;
+    /** Content-Format requested by the observer */
+    uint16_t format;
+
+    uint8_t token_size;
+    char token[8];
+
+    /* Last notification sent to the observer */
+    uint16_t last_msg_id;
+    uint8_t last_msg_code;
+    uint16_t last_format;
+    /** Real-time clock */
+    struct timespec last_timestamp;
+    /** Real-time clock */
+    struct timespec last_confirmable;
+    double last_numeric;
+    size_t last_value_size;
+    /** Heap-allocated */
+    void *last_value;
+} anjay_observation_state_t;
+
+/**
+ * Position of the monotonic clock Observe option values are derived from.
+ * Restoring it keeps the values increasing across restarts of the client, so
+ * that observers do not discard notifications as reordered (OBSERVE 3.4).
+ */
+typedef struct {
+    /** Observe option value a notification would carry */
+    uint32_t serial;
+    /** Real-time clock at the time @ref serial was read */
+    struct timespec timestamp;
+} anjay_observe_serial_state_t;
+
+/**
+ * Collects the state of all observations into <c>*out_states</c>, which must
+ * be empty, and the current position of the Observe option clock into
+ * @p out_serial.
+ */
+int _anjay_observe_export(anjay_t *anjay,
+                          anjay_observe_serial_state_t *out_serial,
+                          AVS_LIST(anjay_observation_state_t) *out_states);
+
+/**
+ * Replaces all observations with ones described by @p states. Each of them is
+ * checked for a changed value as soon as possible, as if the observed value
+ * was just changed.
+ *
+ * If @p serial is not NULL, the Observe option clock is moved forward from
+ * the exported position by the real time elapsed since then.
+ *
+ * @returns 0 on success, or a negative value in case of error, in which case
+ *          all observations are cancelled.
+ */
+int _anjay_observe_import(anjay_t *anjay,
+                          const anjay_observe_serial_state_t *serial,
+                          AVS_LIST(anjay_observation_state_t) states);
+
+void _anjay_observation_state_list_clear(
+        AVS_LIST(anjay_observation_state_t) *states);
+
 #else // WITH_OBSERVE
 
 #define _anjay_observe_gc(...) ((void) 0)
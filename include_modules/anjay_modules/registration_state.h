@@ -0,0 +1,81 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ANJAY_INCLUDE_ANJAY_MODULES_REGISTRATION_STATE_H
+#define ANJAY_INCLUDE_ANJAY_MODULES_REGISTRATION_STATE_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include <avsystem/commons/list.h>
+
+#include <anjay/anjay.h>
+
+#include <anjay_modules/utils.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * State of a registration to a single LwM2M Server, sufficient to keep using
+ * it after the client restarts.
+ */
+typedef struct {
+    anjay_ssid_t ssid;
+    /**
+     * Identifies the Endpoint Client Name, server URI and security
+     * configuration the registration has been made with.
+     */
+    uint32_t config_hash;
+    /**
+     * Identifies the list of Objects and Instances last reported to the server,
+     * or 0 if it is not known.
+     */
+    uint32_t payload_hash;
+    /** Expiration time of the registration, according to the real-time clock. */
+    time_t expire_time;
+    int64_t lifetime_s;
+    anjay_binding_mode_t binding_mode;
+    AVS_LIST(const anjay_string_t) endpoint_path;
+} anjay_registration_state_t;
+
+/**
+ * Collects the state of all registrations that may be resumed after a restart
+ * into <c>*out_states</c>, which must be empty. These include registrations
+ * restored with @ref _anjay_registration_state_import that have not been used
+ * yet.
+ */
+int _anjay_registration_state_export(
+        anjay_t *anjay,
+        AVS_LIST(anjay_registration_state_t) *out_states);
+
+/**
+ * Replaces the set of registrations to resume when activating servers with
+ * <c>*states</c>. Takes ownership of the list.
+ *
+ * A registration is only resumed if it has not expired and the configuration
+ * of the server did not change. Otherwise, the client registers as usual.
+ */
+void _anjay_registration_state_import(
+        anjay_t *anjay,
+        AVS_LIST(anjay_registration_state_t) *states);
+
+void _anjay_registration_state_list_clear(
+        AVS_LIST(anjay_registration_state_t) *states);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_INCLUDE_ANJAY_MODULES_REGISTRATION_STATE_H */
@@ -35,6 +35,14 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 #define ANJAY_MIN(a, b) ((a) < (b) ? (a) : (b))
 #define ANJAY_MAX(a, b) ((a) > (b) ? (a) : (b))
 
+#define ANJAY_MAX_URL_PROTO_SIZE sizeof("coaps+tcp")
+#define ANJAY_MAX_URL_HOSTNAME_SIZE (256 - ANJAY_MAX_URL_PROTO_SIZE - (sizeof("://" ":0") - 1))
+#define ANJAY_MAX_URL_PORT_SIZE sizeof("65535")
+
+typedef struct anjay_string {
+    char c_str[1]; // actually a FAM, but a struct must not consist of FAM only
+} anjay_string_t;
+
 typedef struct {
     void *data;
     /** Amount of bytes currently stored in the buffer. */
@@ -106,6 +106,63 @@ typedef struct anjay_configuration {
      * NOTE: Either both <c>sms_driver</c> and <c>local_msisdn</c> have to be
      * <c>NULL</c>, or both have to be non-<c>NULL</c>. */
     const char *local_msisdn;
+
+    /** Number of changes that may be queued using
+     * @ref anjay_notify_changed_threadsafe and
+     * @ref anjay_notify_instances_changed_threadsafe before they are processed
+     * by @ref anjay_sched_run. Rounded up to the nearest power of two.
+     *
+     * If left at 0, the thread-safe notification API is disabled. */
+    size_t notify_inbox_size;
+
+    /** If set to true, jobs whose exact timing is not critical (e.g.
+     * Registration Updates, closing queue mode sockets, notifications triggered
+     * by pmin and pmax attributes) are allowed to run slightly later (or, in
+     * case of pmax, earlier) than their nominal time, so that jobs with nearby
+     * deadlines are handled during a single wakeup of the application.
+     *
+     * By default, every job runs at its exact deadline. */
+    bool enable_sched_slack;
+
+    /** Time, in seconds, for which the addresses that server hostnames resolve
+     * to are cached, so that reconnecting does not need to wait for the DNS
+     * resolver. If connecting to a cached address fails, other addresses of
+     * the same server are tried before resolving the hostname again.
+     *
+     * The cache is not used for servers configured in the Certificate security
+     * mode, as their hostnames may be needed to verify server certificates.
+     *
+     * If a hostname resolves to both IPv6 and IPv4 addresses, the address
+     * families are tried alternately, starting with the one over which the
+     * server has last been reached. When (D)TLS connections are re-established
+     * in the background, a connection attempt over the other family is started
+     * if the first one does not finish within
+     * <c>ANJAY_CONNECTION_ATTEMPT_DELAY_MS</c>, and whichever succeeds first is
+     * used (RFC 8305 "Happy Eyeballs").
+     *
+     * If left at 0, the addresses are not cached. */
+    uint32_t dns_cache_ttl_s;
+
+    /** If set to true, failed attempts to Register, Update, reconnect or
+     * request Client-Initiated Bootstrap are retried after randomized delays
+     * ("decorrelated jitter": each delay is drawn uniformly between the initial
+     * delay and three times the previous one, up to the maximum delay) instead
+     * of delays that double after each failure. This prevents a fleet of
+     * clients from retrying in lockstep after a server outage. */
+    bool randomize_retry_backoff;
+
+    /** Percentage (0-100) of the delay before each periodic Registration
+     * Update by which the Update is sent earlier, chosen at random for every
+     * Update, so that clients registered at the same time do not keep sending
+     * Updates at the same time. If left at 0, Updates are sent at fixed
+     * intervals. */
+    uint8_t update_jitter_percent;
+
+    /** Maximum random delay, in milliseconds, before reconnecting to a server
+     * (e.g. after @ref anjay_schedule_reconnect or a network error) and before
+     * requesting Client-Initiated Bootstrap (in addition to the Client Hold
+     * Off Time). If left at 0, these happen immediately. */
+    uint32_t reconnect_jitter_ms;
 } anjay_configuration_t;
 
 /**
@@ -129,6 +186,11 @@ anjay_t *anjay_new(const anjay_configuration_t *config);
  * NOTE: It shall be called <strong>before</strong> freeing LwM2M Objects
  * registered within the <c>anjay</c> object.
  *
+ * NOTE: (D)TLS handshakes performed in the background cannot be interrupted.
+ * If any of them is still in progress, this function blocks until it finishes,
+ * which may take as long as the handshake timeout configured through
+ * <c>udp_socket_config</c>.
+ *
  * @param anjay Anjay object to delete.
  */
 void anjay_delete(anjay_t *anjay);
@@ -161,6 +223,11 @@ void anjay_delete(anjay_t *anjay);
  * }
  * @endcode
  *
+ * While a secure connection is being established in the background, its
+ * socket is not included in the list. An internal socket that becomes readable
+ * when the handshake finishes is included instead; it shall be passed to
+ * @ref anjay_serve like any other socket.
+ *
  * @param anjay Anjay object to operate on.
  *
  * @returns A list of valid server sockets on success,
@@ -180,6 +247,28 @@ AVS_LIST(avs_net_abstract_socket_t *const) anjay_get_sockets(anjay_t *anjay);
 int anjay_serve(anjay_t *anjay,
                 avs_net_abstract_socket_t *ready_socket);
 
+/**
+ * Reads and handles messages from given @p ready_socket, just like
+ * @ref anjay_serve, but instead of returning after the first message, keeps
+ * handling further datagrams that are already queued on the socket.
+ *
+ * This reduces the number of wakeups of the application loop when a server
+ * sends a burst of requests. The function never blocks waiting for more data
+ * than was available when the previous message was handled.
+ *
+ * @param anjay        Anjay object to operate on.
+ * @param ready_socket A socket to read the messages from.
+ * @param max_messages Maximum number of messages to handle in a single call.
+ *                     At least one message is always read, even if this is 0.
+ *
+ * @returns 0 if all messages were handled successfully, a negative value if
+ *          handling any of them failed. A failure does not stop processing of
+ *          the remaining queued messages.
+ */
+int anjay_serve_batch(anjay_t *anjay,
+                      avs_net_abstract_socket_t *ready_socket,
+                      size_t max_messages);
+
 /** Short Server ID type. */
 typedef uint16_t anjay_ssid_t;
 
@@ -440,6 +529,76 @@ int anjay_ret_array_index(anjay_output_ctx_t *array_ctx, anjay_riid_t index);
  */
 int anjay_ret_array_finish(anjay_output_ctx_t *array_ctx);
 
+/** Handle to a Read operation suspended using @ref anjay_read_defer . */
+typedef struct anjay_read_deferred_struct anjay_read_deferred_t;
+
+/**
+ * Value to be returned from @ref anjay_dm_resource_read_t after a successful
+ * call to @ref anjay_read_defer . It is distinct from all ANJAY_ERR_*
+ * constants, and is treated as an error if returned without a successful call
+ * to @ref anjay_read_defer .
+ */
+#define ANJAY_READ_DEFERRED (-0xDEF0)
+
+/**
+ * Suspends the Read operation that the resource_read handler writing to
+ * @p ctx is a part of, for when the value is not available immediately (e.g.
+ * it requires sampling a slow sensor). After a successful call, the handler
+ * shall return @ref ANJAY_READ_DEFERRED without calling any anjay_ret_*
+ * function.
+ *
+ * - If the Read (or Observe) was requested by a server, the request is
+ *   acknowledged with an Empty message.
+ * - If the value was being read to check whether a notification needs to be
+ *   sent, the notification is postponed.
+ *
+ * Once the value is available, @ref anjay_read_deferred_complete shall be
+ * called. The Read is then performed again - calling the same handler, which
+ * is expected to return the value immediately this time - and its result is
+ * sent as a separate response or notification.
+ *
+ * NOTE: A separate response to a deferred Read is not sent
+ * using block-wise transfer, so the resumed value, after encoding, MUST fit in
+ * <c>MAX_OBSERVABLE_RESOURCE_SIZE</c> bytes (2048 by default, configurable at
+ * build time) - the same limit that applies to observed values. Larger values
+ * make the Read fail with 5.00 Internal Server Error.
+ *
+ * Deferring is only possible while handling Read and Observe requests and
+ * when checking for notifications; it is not possible e.g. when values are
+ * read by the library for internal purposes, or if the library was compiled
+ * without Observe support. In these cases, this function fails and the
+ * handler shall read the value synchronously.
+ *
+ * @param anjay Anjay object to operate on.
+ * @param ctx   Output context passed to the handler.
+ *
+ * @returns Handle to pass to @ref anjay_read_deferred_complete, or NULL if the
+ *          operation cannot be deferred. All handles that were not completed
+ *          are released by @ref anjay_delete .
+ */
+anjay_read_deferred_t *anjay_read_defer(anjay_t *anjay,
+                                        anjay_output_ctx_t *ctx);
+
+/**
+ * Resumes a Read operation suspended using @ref anjay_read_defer . The Read is
+ * performed again from within @ref anjay_sched_run .
+ *
+ * @param anjay  Anjay object to operate on.
+ * @param handle Handle returned by @ref anjay_read_defer . It is released by
+ *               this function and MUST NOT be used afterwards.
+ * @param result 0 if the value is now available, or a negative value if it
+ *               could not be obtained. In the latter case, the error is
+ *               reported to the server without calling the handler again,
+ *               in the same way as return values of
+ *               @ref anjay_dm_resource_read_t .
+ *
+ * @returns 0 on success, a negative value if the operation could not be
+ *          scheduled. The handle is released in either case.
+ */
+int anjay_read_deferred_complete(anjay_t *anjay,
+                                 anjay_read_deferred_t *handle,
+                                 int result);
+
 /** Type used to retrieve RPC content. */
 typedef struct anjay_input_ctx_struct anjay_input_ctx_t;
 
@@ -492,6 +651,50 @@ int anjay_execute_get_next_arg(anjay_execute_ctx_t *ctx, int *out_arg,
 ssize_t anjay_execute_get_arg_value(anjay_execute_ctx_t *ctx, char* out_buf,
                                     ssize_t buf_size);
 
+/** Handle to an Execute request whose response has been deferred. */
+typedef struct anjay_execute_deferred_struct anjay_execute_deferred_t;
+
+/**
+ * Defers the response to the Execute request currently being handled. May
+ * only be called from within an @ref anjay_dm_resource_execute_t handler, at
+ * most once per request.
+ *
+ * If the handler then returns 0, the request is acknowledged with an Empty
+ * message and no response is sent until @ref anjay_execute_deferred_complete
+ * is called with the returned handle. This allows long-running operations to
+ * be performed without blocking @ref anjay_serve and other servers.
+ *
+ * If the handler returns an error, it is reported to the server immediately,
+ * as if the response was not deferred. The handle still needs to be passed to
+ * @ref anjay_execute_deferred_complete to release it.
+ *
+ * Execution arguments may only be read before the handler returns.
+ *
+ * @param ctx Execute context passed to the handler.
+ *
+ * @returns Handle to pass to @ref anjay_execute_deferred_complete, or NULL in
+ *          case of error. All handles that were not completed are released by
+ *          @ref anjay_delete .
+ */
+anjay_execute_deferred_t *anjay_execute_defer(anjay_execute_ctx_t *ctx);
+
+/**
+ * Finishes an Execute request deferred using @ref anjay_execute_defer . The
+ * response is sent as a separate message from within @ref anjay_sched_run .
+ *
+ * @param anjay  Anjay object to operate on.
+ * @param handle Handle returned by @ref anjay_execute_defer . It is released by
+ *               this function and MUST NOT be used afterwards.
+ * @param result Result of the operation, interpreted in the same way as the
+ *               return value of @ref anjay_dm_resource_execute_t .
+ *
+ * @returns 0 on success, a negative value if the response could not be
+ *          scheduled for sending. The handle is released in either case.
+ */
+int anjay_execute_deferred_complete(anjay_t *anjay,
+                                    anjay_execute_deferred_t *handle,
+                                    int result);
+
 /**
  * Reads a chunk of data blob from the RPC request message.
  *
@@ -535,6 +738,47 @@ int anjay_get_bytes(anjay_input_ctx_t *ctx,
                     void *out_buf,
                     size_t buf_size);
 
+/**
+ * Reads a chunk of data blob from the RPC request message without copying it
+ * into a user-provided buffer.
+ *
+ * Semantics are the same as of @ref anjay_get_bytes, except that on success,
+ * <c>*out_data</c> is set to point to @p out_bytes_read bytes of data stored
+ * inside the library's own buffers - usually the buffer the CoAP message has
+ * been received into. The chunk returned is the largest one available without
+ * copying, so it may end at a packet (e.g. Block1 transfer) boundary.
+ *
+ * The returned pointer is only valid until the next call to any function
+ * operating on @p ctx .
+ *
+ * Example: writing a large data blob to file.
+ *
+ * @code
+ * bool finished;
+ * do {
+ *     const void *data;
+ *     size_t bytes_read;
+ *     if (anjay_get_bytes_view(ctx, &bytes_read, &finished, &data)
+ *             || fwrite(data, 1, bytes_read, file) < bytes_read) {
+ *         // handle error
+ *     }
+ * } while (!finished);
+ * @endcode
+ *
+ * @param      ctx                  Input context to operate on.
+ * @param[out] out_bytes_read       Number of bytes available at
+ *                                  <c>*out_data</c> .
+ * @param[out] out_message_finished Set to true if there is no more data
+ *                                  to read.
+ * @param[out] out_data             Set to point to the data read.
+ *
+ * @returns 0 on success, a negative value in case of error.
+ */
+int anjay_get_bytes_view(anjay_input_ctx_t *ctx,
+                         size_t *out_bytes_read,
+                         bool *out_message_finished,
+                         const void **out_data);
+
 #define ANJAY_BUFFER_TOO_SHORT 1
 /**
  * Reads a null-terminated string from the RPC request content. On success,
@@ -1065,6 +1309,8 @@ anjay_dm_resource_operations_t(anjay_t *anjay,
  *
  * @returns This handler should return:
  * - 0 on success,
+ * - @ref ANJAY_READ_DEFERRED if the value is not available yet, after calling
+ *   @ref anjay_read_defer ,
  * - a negative value in case of error. If it returns one of ANJAY_ERR_
  *   constants, it will be used as a hint for the CoAP response code to use. The
  *   library may decide to override the returned value in case of a more
@@ -1118,7 +1364,8 @@ typedef int anjay_dm_resource_write_t(anjay_t *anjay,
  *                anjay_execute_get_* function family.
  *
  * @returns This handler should return:
- * - 0 on success,
+ * - 0 on success, or after deferring the response using
+ *   @ref anjay_execute_defer ,
  * - a negative value in case of error. If it returns one of ANJAY_ERR_
  *   constants, the response message will have an appropriate CoAP response
  *   code. Otherwise, the device will respond with an unspecified (but valid)
@@ -1457,6 +1704,59 @@ int anjay_notify_changed(anjay_t *anjay,
  */
 int anjay_notify_instances_changed(anjay_t *anjay, anjay_oid_t oid);
 
+/**
+ * Thread-safe variant of @ref anjay_notify_changed.
+ *
+ * Unlike any other function of this library, it may be called from any thread
+ * concurrently with the thread running the event loop. It never blocks nor
+ * allocates memory: the change is put into a fixed-size queue (see
+ * <c>notify_inbox_size</c> in @ref anjay_configuration_t) and processed during
+ * the next call to @ref anjay_sched_run, which also wakes up the event loop
+ * through the descriptor returned by @ref anjay_get_notify_wakeup_fd.
+ *
+ * @param anjay Anjay object to operate on.
+ * @param oid   Object ID of the changed Resource.
+ * @param iid   Object Instance ID of the changed Resource.
+ * @param rid   Resource ID of the changed Resource.
+ *
+ * @returns 0 on success, a negative value if the queue is disabled or full.
+ *          In the latter case, the change is lost and it is up to the caller to
+ *          report it again later.
+ */
+int anjay_notify_changed_threadsafe(anjay_t *anjay,
+                                    anjay_oid_t oid,
+                                    anjay_iid_t iid,
+                                    anjay_rid_t rid);
+
+/**
+ * Thread-safe variant of @ref anjay_notify_instances_changed. See
+ * @ref anjay_notify_changed_threadsafe for details.
+ *
+ * @param anjay Anjay object to operate on.
+ * @param oid   Object ID of the changed Object.
+ *
+ * @returns 0 on success, a negative value if the queue is disabled or full.
+ */
+int anjay_notify_instances_changed_threadsafe(anjay_t *anjay,
+                                              anjay_oid_t oid);
+
+/**
+ * Returns a file descriptor that becomes readable whenever changes were queued
+ * using @ref anjay_notify_changed_threadsafe or
+ * @ref anjay_notify_instances_changed_threadsafe. It is meant to be polled
+ * along with the sockets returned by @ref anjay_get_sockets; when it is
+ * readable, @ref anjay_sched_run shall be called, which also clears it.
+ *
+ * The descriptor is owned by the library and shall not be read from or closed
+ * by the application.
+ *
+ * @param anjay Anjay object to operate on.
+ *
+ * @returns A file descriptor, or -1 if the thread-safe notification API is
+ *          disabled.
+ */
+int anjay_get_notify_wakeup_fd(anjay_t *anjay);
+
 /**
  * Determines time of next scheduled task.
  *
@@ -1513,6 +1813,62 @@ int anjay_sched_calculate_wait_time_ms(anjay_t *anjay, int limit_ms);
  */
 int anjay_sched_run(anjay_t *anjay);
 
+/** Scheduler activity counters, see @ref anjay_get_sched_stats. */
+typedef struct {
+    /** Number of @ref anjay_sched_run calls that executed at least one job. */
+    uint32_t wakeups;
+    /** Number of @ref anjay_sched_run calls that had nothing to execute. */
+    uint32_t idle_runs;
+    /** Total number of executed jobs. */
+    uint32_t jobs_executed;
+} anjay_sched_stats_t;
+
+/**
+ * Retrieves the scheduler activity counters accumulated since the Anjay object
+ * was created. Comparing the number of wakeups per executed job with and
+ * without <c>enable_sched_slack</c> set in @ref anjay_configuration_t shows how
+ * effectively the wakeups are coalesced.
+ *
+ * @param      anjay     Anjay object to operate on.
+ * @param[out] out_stats Pointer to a structure to fill with the counters.
+ */
+void anjay_get_sched_stats(anjay_t *anjay, anjay_sched_stats_t *out_stats);
+
+/**
+ * Runs a complete application loop: waits for incoming messages on all server
+ * sockets and for scheduled jobs, handling them using
+ * @ref anjay_serve_batch and @ref anjay_sched_run, until
+ * @ref anjay_event_loop_interrupt is called.
+ *
+ * This is an alternative to a hand-written loop built around
+ * @ref anjay_get_sockets. Sockets are registered in the underlying epoll
+ * instance only when they are created, reconnected or closed, and the wait is
+ * driven by a timerfd armed exactly at the next scheduler deadline. If the
+ * thread-safe notification API is enabled, its wakeup descriptor (see
+ * @ref anjay_get_notify_wakeup_fd) is monitored as well.
+ *
+ * NOTE: This function is only available on Linux, if the library has been
+ * compiled with the <c>WITH_EVENT_LOOP</c> option. Otherwise it always fails.
+ *
+ * @param anjay Anjay object to operate on.
+ *
+ * @returns 0 if the loop has been interrupted using
+ *          @ref anjay_event_loop_interrupt, a negative value in case of a fatal
+ *          error.
+ */
+int anjay_event_loop_run(anjay_t *anjay);
+
+/**
+ * Makes @ref anjay_event_loop_run return as soon as possible. May be called
+ * from within any callback invoked by the event loop, or from another thread
+ * while the loop is running.
+ *
+ * @param anjay Anjay object to operate on.
+ *
+ * @returns 0 on success, a negative value in case of error.
+ */
+int anjay_event_loop_interrupt(anjay_t *anjay);
+
 /**
  * Registers the Object in the data model, making it available for RPC calls.
  *
@@ -1608,6 +1964,165 @@ int anjay_schedule_reconnect(anjay_t *anjay);
  */
 int anjay_disable_server(anjay_t *anjay, anjay_ssid_t ssid);
 
+/**
+ * Round-trip time statistics of a connection to an LwM2M Server, as used to
+ * calculate CoAP retransmission timeouts.
+ *
+ * Anjay measures the time between sending each Confirmable request and
+ * receiving a response to it. "Strong" samples come from exchanges completed
+ * without retransmissions, "weak" ones from exchanges that required one or two
+ * retransmissions. Each kind is smoothed separately (in a way similar to TCP,
+ * see RFC 6298) and both are combined into the retransmission timeout (RTO)
+ * used as the base for the next exchange, instead of a fixed ACK_TIMEOUT.
+ *
+ * Estimates are reset whenever the connection is re-established.
+ */
+typedef struct {
+    /** Number of strong RTT samples collected so far. */
+    uint32_t strong_samples;
+    /** Smoothed RTT calculated from strong samples, in milliseconds. */
+    int32_t strong_srtt_ms;
+    /** RTT variation calculated from strong samples, in milliseconds. */
+    int32_t strong_rttvar_ms;
+    /** Number of weak RTT samples collected so far. */
+    uint32_t weak_samples;
+    /** Smoothed RTT calculated from weak samples, in milliseconds. */
+    int32_t weak_srtt_ms;
+    /** RTT variation calculated from weak samples, in milliseconds. */
+    int32_t weak_rttvar_ms;
+    /**
+     * Retransmission timeout that will be used for the next Confirmable
+     * message, before applying the random factor, in milliseconds.
+     */
+    int32_t rto_ms;
+} anjay_server_rtt_stats_t;
+
+/**
+ * Retrieves round-trip time statistics of the connection to an LwM2M Server.
+ *
+ * Connections over reliable transports (CoAP over TCP) do not use CoAP-level
+ * retransmissions, so no statistics are available for them.
+ *
+ * @param anjay     Anjay object to operate on.
+ * @param ssid      Short Server ID of the server to query, or
+ *                  @ref ANJAY_SSID_BOOTSTRAP for the Bootstrap Server.
+ * @param out_stats Pointer to a structure to fill with the statistics.
+ *
+ * @returns 0 on success, a negative value if there is no active server with
+ *          given @p ssid or it does not use an unreliable transport.
+ */
+int anjay_get_server_rtt_stats(anjay_t *anjay,
+                               anjay_ssid_t ssid,
+                               anjay_server_rtt_stats_t *out_stats);
+
+/**
+ * (D)TLS handshake statistics for a single LwM2M Server, see
+ * @ref anjay_get_dtls_handshake_stats.
+ *
+ * Anjay caches (D)TLS session state for each server, so that reconnecting -
+ * e.g. after the socket has been closed in queue mode, or after a restart if
+ * the cache has been persisted using the persistence module - may use an
+ * abbreviated handshake instead of a full one.
+ */
+typedef struct {
+    /** Number of successful handshakes that established a new session. */
+    uint32_t full_handshakes;
+    /** Number of successful handshakes that resumed a cached session. */
+    uint32_t resumed_handshakes;
+    /** Number of handshakes that failed. */
+    uint32_t failed_handshakes;
+    /** Duration of the most recent successful handshake, in milliseconds. */
+    int32_t last_duration_ms;
+    /** Total duration of all successful full handshakes, in milliseconds. */
+    int64_t full_duration_ms;
+    /** Total duration of all successful resumed handshakes, in milliseconds. */
+    int64_t resumed_duration_ms;
+} anjay_dtls_handshake_stats_t;
+
+/**
+ * Retrieves (D)TLS handshake statistics of the connections to an LwM2M Server.
+ * Statistics are kept since the creation of the Anjay object and are not
+ * reset when the server is reconfigured.
+ *
+ * @param anjay     Anjay object to operate on.
+ * @param ssid      Short Server ID of the server to query, or
+ *                  @ref ANJAY_SSID_BOOTSTRAP for the Bootstrap Server.
+ * @param out_stats Pointer to a structure to fill with the statistics.
+ *
+ * @returns 0 on success, a negative value if no secure connection to the server
+ *          with given @p ssid has been attempted so far, or if Anjay has been
+ *          compiled without (D)TLS session cache support (the
+ *          WITH_DTLS_SESSION_CACHE CMake option, which requires a recent
+ *          enough avs_commons).
+ */
+int anjay_get_dtls_handshake_stats(anjay_t *anjay,
+                                   anjay_ssid_t ssid,
+                                   anjay_dtls_handshake_stats_t *out_stats);
+
+/**
+ * Statistics of reloading server connections after the Security object
+ * changes, see @ref anjay_get_socket_reload_stats.
+ *
+ * The configuration of each active server - URI, security mode, keys and
+ * binding - is compared with the one its connection has been created with.
+ * Only connections with changed configuration are re-created, which is
+ * followed by a Registration Update or Register.
+ */
+typedef struct {
+    /** Number of reloads performed. */
+    uint32_t reloads;
+    /** Number of server connections re-created due to changed configuration. */
+    uint32_t reconnects;
+    /**
+     * Number of times a server connection flagged as affected by a change in
+     * the Security object has been kept, as its configuration did not change.
+     */
+    uint32_t unchanged;
+    /** Duration of the most recent reload, in milliseconds. */
+    int32_t last_duration_ms;
+    /** Total duration of all reloads, in milliseconds. */
+    int64_t total_duration_ms;
+} anjay_socket_reload_stats_t;
+
+/**
+ * Retrieves statistics of reloading server connections. Statistics are kept
+ * since the creation of the Anjay object.
+ *
+ * @param anjay     Anjay object to operate on.
+ * @param out_stats Pointer to a structure to fill with the statistics.
+ */
+void anjay_get_socket_reload_stats(anjay_t *anjay,
+                                   anjay_socket_reload_stats_t *out_stats);
+
+/**
+ * Statistics of the cache of server addresses, see
+ * @ref anjay_configuration_t::dns_cache_ttl_s and
+ * @ref anjay_get_dns_cache_stats.
+ */
+typedef struct {
+    /** Number of connection attempts that used a cached address. */
+    uint32_t hits;
+    /** Number of connection attempts that needed to resolve a hostname. */
+    uint32_t misses;
+    /** Number of times a cached address failed and another one was chosen. */
+    uint32_t failovers;
+    /** Number of times a server has been reached over a different address
+     * family (IPv4 or IPv6) than the last time. */
+    uint32_t family_switches;
+} anjay_dns_cache_stats_t;
+
+/**
+ * Retrieves statistics of the cache of server addresses. Statistics are kept
+ * since the creation of the Anjay object.
+ *
+ * @param anjay     Anjay object to operate on.
+ * @param out_stats Pointer to a structure to fill with the statistics.
+ *
+ * @returns 0 on success, a negative value if the cache is disabled.
+ */
+int anjay_get_dns_cache_stats(anjay_t *anjay,
+                              anjay_dns_cache_stats_t *out_stats);
+
 
 /**
  * Checks whether anjay is currently in offline state.
@@ -1662,7 +2177,9 @@ typedef enum {
     ANJAY_BINDING_S,
     ANJAY_BINDING_SQ,
     ANJAY_BINDING_US,
-    ANJAY_BINDING_UQS
+    ANJAY_BINDING_UQS,
+    ANJAY_BINDING_T,
+    ANJAY_BINDING_TQ
 } anjay_binding_mode_t;
 
 /**
@@ -1684,6 +2201,10 @@ typedef enum {
  * +------------------------+----------------------------+
  * |          "UQS"         |       ANJAY_BINDING_UQS    |
  * +------------------------+----------------------------+
+ * |          "T"           |       ANJAY_BINDING_T      |
+ * +------------------------+----------------------------+
+ * |          "TQ"          |       ANJAY_BINDING_TQ     |
+ * +------------------------+----------------------------+
  * |      anything else     |       ANJAY_BINDING_NONE   |
  * +------------------------+----------------------------+
  *
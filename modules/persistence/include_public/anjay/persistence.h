@@ -197,6 +197,115 @@ int anjay_persistence_tree(
         anjay_persistence_handler_collection_element_t *handler,
         anjay_persistence_cleanup_collection_element_t *cleanup);
 
+/**
+ * Stores the (D)TLS session state cached for all LwM2M Servers in
+ * @p out_stream, so that it can be loaded with
+ * @ref anjay_dtls_session_cache_restore e.g. after a restart, allowing the
+ * first handshake with each server to be abbreviated.
+ *
+ * NOTE: The stored data contains session master secrets. It shall be
+ * protected in the same way as the credentials in the Security object.
+ *
+ * @param anjay         Anjay object to operate on.
+ * @param out_stream    Stream to write the data to.
+ * @return 0 in case of success, negative value in case of failure.
+ */
+int anjay_dtls_session_cache_persist(anjay_t *anjay,
+                                     avs_stream_abstract_t *out_stream);
+
+/**
+ * Replaces the (D)TLS session cache with data stored by
+ * @ref anjay_dtls_session_cache_persist. It is intended to be called after
+ * @ref anjay_new, before the first call to @ref anjay_sched_run.
+ *
+ * A cached session is only used if the server is still reachable at the same
+ * address; otherwise a full handshake is performed as usual.
+ *
+ * @param anjay         Anjay object to operate on.
+ * @param in_stream     Stream to read the data from.
+ * @return 0 in case of success, negative value in case of failure, in which
+ *         case the session cache is left empty.
+ */
+int anjay_dtls_session_cache_restore(anjay_t *anjay,
+                                     avs_stream_abstract_t *in_stream);
+
+/**
+ * Stores the state of registrations to all LwM2M Servers in @p out_stream, so
+ * that it can be loaded with @ref anjay_registration_state_restore after
+ * a restart. A Server for which a valid registration is restored is sent an
+ * Update message instead of a full Register on startup.
+ *
+ * Registrations that are about to expire are not stored.
+ *
+ * NOTE: @ref anjay_delete De-registers from all servers, which invalidates the
+ * stored state. This function is intended for devices that may lose power or
+ * be restarted without a clean shutdown - the state shall be stored after each
+ * successful Register or Update, e.g. whenever @ref anjay_sched_run returns.
+ *
+ * @param anjay         Anjay object to operate on.
+ * @param out_stream    Stream to write the data to.
+ * @return 0 in case of success, negative value in case of failure.
+ */
+int anjay_registration_state_persist(anjay_t *anjay,
+                                     avs_stream_abstract_t *out_stream);
+
+/**
+ * Loads registration state stored by @ref anjay_registration_state_persist.
+ * It is intended to be called after @ref anjay_new, before the first call to
+ * @ref anjay_sched_run.
+ *
+ * A restored registration is discarded, and a Register message is sent as
+ * usual, if the Server URI, security configuration or endpoint name changed
+ * since the state was stored, if the registration expired in the meantime, or
+ * if the Server rejects the Update.
+ *
+ * @param anjay         Anjay object to operate on.
+ * @param in_stream     Stream to read the data from.
+ * @return 0 in case of success, negative value in case of failure, in which
+ *         case no registration state is restored.
+ */
+int anjay_registration_state_restore(anjay_t *anjay,
+                                     avs_stream_abstract_t *in_stream);
+
+/**
+ * Stores the state of all observations established by LwM2M Servers in
+ * @p out_stream, so that it can be loaded with @ref anjay_observe_restore
+ * after a restart. The stored state includes the observation tokens, the
+ * last value sent to each observer and the position of the clock used to
+ * generate Observe option values, so that they keep increasing after the
+ * restart.
+ *
+ * Together with @ref anjay_registration_state_persist, this allows the client
+ * to keep sending notifications after a restart, without the servers having
+ * to observe the resources again. Attributes set with Write-Attributes are not
+ * part of the observation state - if they are managed by the Attribute Storage
+ * module, use @ref anjay_attr_storage_persist to store them.
+ *
+ * @param anjay         Anjay object to operate on.
+ * @param out_stream    Stream to write the data to.
+ * @return 0 in case of success, negative value in case of failure, including
+ *         when Anjay is compiled without Observe support.
+ */
+int anjay_observe_persist(anjay_t *anjay, avs_stream_abstract_t *out_stream);
+
+/**
+ * Replaces all observations with ones stored by @ref anjay_observe_persist.
+ * It is intended to be called after @ref anjay_new and registering the data
+ * model objects, before the first call to @ref anjay_sched_run.
+ *
+ * Each restored observation is checked for a changed value as soon as
+ * possible, so changes that happened while the client was not running are
+ * notified as usual. If a Server no longer recognizes an observation, e.g.
+ * because the client had to register again, it rejects the notification with
+ * a Reset message and the observation is cancelled.
+ *
+ * @param anjay         Anjay object to operate on.
+ * @param in_stream     Stream to read the data from.
+ * @return 0 in case of success, negative value in case of failure, in which
+ *         case all observations are cancelled.
+ */
+int anjay_observe_restore(anjay_t *anjay, avs_stream_abstract_t *in_stream);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <config.h>
+
+#include <string.h>
+
+#include <avsystem/commons/list.h>
+
+#include <anjay/persistence.h>
+
+#include <anjay_modules/dtls_session_cache.h>
+#include <anjay_modules/utils.h>
+
+VISIBILITY_SOURCE_BEGIN
+
+#define persistence_log(...) _anjay_log(anjay_persistence, __VA_ARGS__)
+
+typedef struct {
+    anjay_ssid_t ssid;
+    char host[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    char port[ANJAY_MAX_URL_PORT_SIZE];
+    uint32_t config_hash;
+    uint32_t data_size;
+    uint8_t data[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+} session_entry_t;
+
+static int handle_string(anjay_persistence_context_t *ctx,
+                         char *buffer,
+                         size_t buffer_size) {
+    uint32_t length = (uint32_t) strlen(buffer);
+    int retval = anjay_persistence_u32(ctx, &length);
+    if (retval) {
+        return retval;
+    }
+    if (length >= buffer_size) {
+        return -1;
+    }
+    if ((retval = anjay_persistence_bytes(ctx, (uint8_t *) buffer, length))) {
+        return retval;
+    }
+    buffer[length] = '\0';
+    return 0;
+}
+
+static int handle_session_entry(anjay_persistence_context_t *ctx,
+                                void *entry_) {
+    session_entry_t *entry = (session_entry_t *) entry_;
+    int retval;
+    (void) ((retval = anjay_persistence_u16(ctx, &entry->ssid))
+            || (retval = handle_string(ctx, entry->host, sizeof(entry->host)))
+            || (retval = handle_string(ctx, entry->port, sizeof(entry->port)))
+            || (retval = anjay_persistence_u32(ctx, &entry->config_hash))
+            || (retval = anjay_persistence_u32(ctx, &entry->data_size))
+            || (retval = (entry->data_size > sizeof(entry->data) ? -1 : 0))
+            || (retval = anjay_persistence_bytes(ctx, entry->data,
+                                                 entry->data_size)));
+    return retval;
+}
+
+static int collect_session(anjay_ssid_t ssid,
+                           const char *host,
+                           const char *port,
+                           uint32_t config_hash,
+                           const void *data,
+                           size_t data_size,
+                           void *entries_) {
+    AVS_LIST(session_entry_t) *entries = (AVS_LIST(session_entry_t) *) entries_;
+    AVS_LIST(session_entry_t) entry = AVS_LIST_NEW_ELEMENT(session_entry_t);
+    if (!entry) {
+        persistence_log(ERROR, "Out of memory");
+        return -1;
+    }
+    entry->ssid = ssid;
+    strcpy(entry->host, host);
+    strcpy(entry->port, port);
+    entry->config_hash = config_hash;
+    entry->data_size = (uint32_t) data_size;
+    memcpy(entry->data, data, data_size);
+    AVS_LIST_INSERT(entries, entry);
+    return 0;
+}
+
+static int install_sessions(anjay_t *anjay,
+                            AVS_LIST(session_entry_t) entries) {
+    AVS_LIST(session_entry_t) entry;
+    AVS_LIST_FOREACH(entry, entries) {
+        if (_anjay_dtls_session_cache_put(anjay, entry->ssid, entry->host,
+                                          entry->port, entry->config_hash,
+                                          entry->data, entry->data_size)) {
+            _anjay_dtls_session_cache_clear(anjay);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * NOTE: The last byte is supposed to be a version number. The format of the
+ * session state itself depends on the (D)TLS backend used by avs_commons.
+ *
+ * Version 1 added the configuration hash, so that sessions are not resumed
+ * after the credentials change while the client is down.
+ */
+static const char MAGIC[] = { 'D', 'S', 'C', '\1' };
+
+int anjay_dtls_session_cache_persist(anjay_t *anjay,
+                                     avs_stream_abstract_t *out_stream) {
+    AVS_LIST(session_entry_t) entries = NULL;
+    int retval = _anjay_dtls_session_cache_foreach(anjay, collect_session,
+                                                   &entries);
+    if (!retval) {
+        retval = avs_stream_write(out_stream, MAGIC, sizeof(MAGIC));
+    }
+    if (!retval) {
+        anjay_persistence_context_t *ctx =
+                anjay_persistence_store_context_new(out_stream);
+        if (!ctx) {
+            persistence_log(ERROR, "Out of memory");
+            retval = -1;
+        } else {
+            retval = anjay_persistence_list(ctx, (AVS_LIST(void) *) &entries,
+                                            sizeof(session_entry_t),
+                                            handle_session_entry);
+            anjay_persistence_context_delete(ctx);
+        }
+    }
+    AVS_LIST_CLEAR(&entries);
+    return retval;
+}
+
+int anjay_dtls_session_cache_restore(anjay_t *anjay,
+                                     avs_stream_abstract_t *in_stream) {
+    _anjay_dtls_session_cache_clear(anjay);
+
+    char magic_buffer[sizeof(MAGIC)];
+    int retval = avs_stream_read_reliably(in_stream, magic_buffer,
+                                          sizeof(magic_buffer));
+    if (retval) {
+        return retval;
+    } else if (memcmp(MAGIC, magic_buffer, sizeof(MAGIC))) {
+        persistence_log(ERROR, "Magic value mismatch");
+        return -1;
+    }
+
+    anjay_persistence_context_t *ctx =
+            anjay_persistence_restore_context_new(in_stream);
+    if (!ctx) {
+        persistence_log(ERROR, "Out of memory");
+        return -1;
+    }
+    AVS_LIST(session_entry_t) entries = NULL;
+    retval = anjay_persistence_list(ctx, (AVS_LIST(void) *) &entries,
+                                    sizeof(session_entry_t),
+                                    handle_session_entry);
+    anjay_persistence_context_delete(ctx);
+    if (!retval) {
+        retval = install_sessions(anjay, entries);
+    }
+    AVS_LIST_CLEAR(&entries);
+    return retval;
+}
+
+#if defined(ANJAY_TEST) && defined(WITH_DTLS_SESSION_CACHE)
+#include "test/dtls_session_cache.c"
+#endif // defined(ANJAY_TEST) && defined(WITH_DTLS_SESSION_CACHE)
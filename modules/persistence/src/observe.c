@@ -0,0 +1,210 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <avsystem/commons/list.h>
+
+#include <anjay/persistence.h>
+
+#include <anjay_modules/observe.h>
+#include <anjay_modules/utils.h>
+
+VISIBILITY_SOURCE_BEGIN
+
+#define persistence_log(...) _anjay_log(anjay_persistence, __VA_ARGS__)
+
+#ifdef WITH_OBSERVE
+
+static int handle_u8(anjay_persistence_context_t *ctx, uint8_t *value) {
+    return anjay_persistence_bytes(ctx, value, 1);
+}
+
+static int handle_timespec(anjay_persistence_context_t *ctx,
+                           struct timespec *value) {
+    uint32_t nsec = (uint32_t) value->tv_nsec;
+    int retval;
+    (void) ((retval = anjay_persistence_time(ctx, &value->tv_sec))
+            || (retval = anjay_persistence_u32(ctx, &nsec)));
+    if (!retval && nsec >= 1000000000) {
+        persistence_log(ERROR, "Invalid timestamp");
+        retval = -1;
+    }
+    value->tv_nsec = (long) nsec;
+    return retval;
+}
+
+static int handle_value(anjay_persistence_context_t *ctx,
+                        anjay_observation_state_t *state) {
+    uint32_t size = (uint32_t) state->last_value_size;
+    int retval = anjay_persistence_u32(ctx, &size);
+    if (!retval && size && !state->last_value) {
+        // restoring
+        if (size > ANJAY_MAX_OBSERVABLE_RESOURCE_SIZE) {
+            persistence_log(ERROR, "Invalid notification value size");
+            return -1;
+        }
+        if (!(state->last_value = malloc(size))) {
+            persistence_log(ERROR, "Out of memory");
+            return -1;
+        }
+        state->last_value_size = size;
+    }
+    if (!retval) {
+        retval = anjay_persistence_bytes(ctx, (uint8_t *) state->last_value,
+                                         size);
+    }
+    return retval;
+}
+
+static int handle_token(anjay_persistence_context_t *ctx,
+                        anjay_observation_state_t *state) {
+    int retval = handle_u8(ctx, &state->token_size);
+    if (!retval && state->token_size > sizeof(state->token)) {
+        persistence_log(ERROR, "Invalid token size");
+        retval = -1;
+    }
+    if (!retval) {
+        retval = anjay_persistence_bytes(ctx, (uint8_t *) state->token,
+                                         state->token_size);
+    }
+    return retval;
+}
+
+static int handle_observation(anjay_persistence_context_t *ctx,
+                              void *state_) {
+    anjay_observation_state_t *state = (anjay_observation_state_t *) state_;
+    uint32_t rid = (uint32_t) state->rid;
+    int retval;
+    (void) ((retval = anjay_persistence_u16(ctx, &state->ssid))
+            || (retval = handle_u8(ctx, &state->conn_type))
+            || (retval = anjay_persistence_u16(ctx, &state->oid))
+            || (retval = anjay_persistence_u16(ctx, &state->iid))
+            || (retval = anjay_persistence_u32(ctx, &rid))
+            || (retval = anjay_persistence_u16(ctx, &state->format))
+            || (retval = handle_token(ctx, state))
+            || (retval = anjay_persistence_u16(ctx, &state->last_msg_id))
+            || (retval = handle_u8(ctx, &state->last_msg_code))
+            || (retval = anjay_persistence_u16(ctx, &state->last_format))
+            || (retval = handle_timespec(ctx, &state->last_timestamp))
+            || (retval = handle_timespec(ctx, &state->last_confirmable))
+            || (retval = anjay_persistence_double(ctx, &state->last_numeric))
+            || (retval = handle_value(ctx, state)));
+    state->rid = (int32_t) rid;
+    return retval;
+}
+
+static int handle_serial(anjay_persistence_context_t *ctx,
+                         anjay_observe_serial_state_t *serial) {
+    int retval;
+    (void) ((retval = anjay_persistence_u32(ctx, &serial->serial))
+            || (retval = handle_timespec(ctx, &serial->timestamp)));
+    return retval;
+}
+
+/**
+ * NOTE: The last byte is supposed to be a version number.
+ *
+ * Version 1 added the position of the Observe option clock.
+ */
+static const char MAGIC[] = { 'O', 'B', 'S', '\1' };
+
+int anjay_observe_persist(anjay_t *anjay, avs_stream_abstract_t *out_stream) {
+    anjay_observe_serial_state_t serial;
+    AVS_LIST(anjay_observation_state_t) states = NULL;
+    int retval = _anjay_observe_export(anjay, &serial, &states);
+    if (!retval) {
+        retval = avs_stream_write(out_stream, MAGIC, sizeof(MAGIC));
+    }
+    if (!retval) {
+        anjay_persistence_context_t *ctx =
+                anjay_persistence_store_context_new(out_stream);
+        if (!ctx) {
+            persistence_log(ERROR, "Out of memory");
+            retval = -1;
+        } else {
+            (void) ((retval = handle_serial(ctx, &serial))
+                    || (retval = anjay_persistence_list(
+                            ctx, (AVS_LIST(void) *) &states,
+                            sizeof(anjay_observation_state_t),
+                            handle_observation)));
+            anjay_persistence_context_delete(ctx);
+        }
+    }
+    _anjay_observation_state_list_clear(&states);
+    return retval;
+}
+
+int anjay_observe_restore(anjay_t *anjay, avs_stream_abstract_t *in_stream) {
+    anjay_observe_serial_state_t serial;
+    AVS_LIST(anjay_observation_state_t) states = NULL;
+    char magic_buffer[sizeof(MAGIC)];
+    int retval = avs_stream_read_reliably(in_stream, magic_buffer,
+                                          sizeof(magic_buffer));
+    if (!retval && memcmp(MAGIC, magic_buffer, sizeof(MAGIC))) {
+        persistence_log(ERROR, "Magic value mismatch");
+        retval = -1;
+    }
+    if (!retval) {
+        anjay_persistence_context_t *ctx =
+                anjay_persistence_restore_context_new(in_stream);
+        if (!ctx) {
+            persistence_log(ERROR, "Out of memory");
+            retval = -1;
+        } else {
+            (void) ((retval = handle_serial(ctx, &serial))
+                    || (retval = anjay_persistence_list(
+                            ctx, (AVS_LIST(void) *) &states,
+                            sizeof(anjay_observation_state_t),
+                            handle_observation)));
+            anjay_persistence_context_delete(ctx);
+        }
+    }
+    if (retval) {
+        // servers will observe the resources again if needed
+        _anjay_observation_state_list_clear(&states);
+    }
+    int import_retval =
+            _anjay_observe_import(anjay, retval ? NULL : &serial, states);
+    _anjay_observation_state_list_clear(&states);
+    return retval ? retval : import_retval;
+}
+
+#ifdef ANJAY_TEST
+#include "test/observe.c"
+#endif // ANJAY_TEST
+
+#else // WITH_OBSERVE
+
+int anjay_observe_persist(anjay_t *anjay, avs_stream_abstract_t *out_stream) {
+    (void) anjay;
+    (void) out_stream;
+    persistence_log(ERROR, "Observe support is disabled");
+    return -1;
+}
+
+int anjay_observe_restore(anjay_t *anjay, avs_stream_abstract_t *in_stream) {
+    (void) anjay;
+    (void) in_stream;
+    persistence_log(ERROR, "Observe support is disabled");
+    return -1;
+}
+
+#endif // WITH_OBSERVE
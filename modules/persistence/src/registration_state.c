@@ -0,0 +1,144 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <config.h>
+
+#include <string.h>
+
+#include <avsystem/commons/list.h>
+
+#include <anjay/persistence.h>
+
+#include <anjay_modules/registration_state.h>
+#include <anjay_modules/utils.h>
+
+VISIBILITY_SOURCE_BEGIN
+
+#define persistence_log(...) _anjay_log(anjay_persistence, __VA_ARGS__)
+
+static int handle_endpoint_path(anjay_persistence_context_t *ctx,
+                                AVS_LIST(const anjay_string_t) *path) {
+    uint32_t count = (uint32_t) AVS_LIST_SIZE(*path);
+    int retval = anjay_persistence_u32(ctx, &count);
+    AVS_LIST(const anjay_string_t) *segment_ptr = path;
+    for (uint32_t i = 0; !retval && i < count; ++i) {
+        uint32_t length =
+                *segment_ptr ? (uint32_t) strlen((*segment_ptr)->c_str) : 0;
+        if ((retval = anjay_persistence_u32(ctx, &length))) {
+            break;
+        }
+        if (!*segment_ptr) {
+            // restoring; the zeroed buffer is already nul-terminated
+            AVS_LIST(anjay_string_t) segment = (AVS_LIST(anjay_string_t))
+                    AVS_LIST_NEW_BUFFER((size_t) length + 1);
+            if (!segment) {
+                persistence_log(ERROR, "Out of memory");
+                return -1;
+            }
+            AVS_LIST_INSERT(segment_ptr, segment);
+        }
+        retval = anjay_persistence_bytes(
+                ctx, (uint8_t *) (uintptr_t) (*segment_ptr)->c_str, length);
+        segment_ptr = AVS_LIST_NEXT_PTR(segment_ptr);
+    }
+    return retval;
+}
+
+static int handle_registration_state(anjay_persistence_context_t *ctx,
+                                     void *state_) {
+    anjay_registration_state_t *state = (anjay_registration_state_t *) state_;
+    if (state->lifetime_s < 0 || state->lifetime_s > UINT32_MAX) {
+        return -1;
+    }
+    uint32_t lifetime_s = (uint32_t) state->lifetime_s;
+    uint16_t binding_mode = (uint16_t) state->binding_mode;
+    int retval;
+    (void) ((retval = anjay_persistence_u16(ctx, &state->ssid))
+            || (retval = anjay_persistence_u32(ctx, &state->config_hash))
+            || (retval = anjay_persistence_u32(ctx, &state->payload_hash))
+            || (retval = anjay_persistence_time(ctx, &state->expire_time))
+            || (retval = anjay_persistence_u32(ctx, &lifetime_s))
+            || (retval = anjay_persistence_u16(ctx, &binding_mode))
+            || (retval = handle_endpoint_path(ctx, &state->endpoint_path)));
+    state->lifetime_s = lifetime_s;
+    state->binding_mode = (anjay_binding_mode_t) binding_mode;
+    return retval;
+}
+
+/**
+ * NOTE: The last byte is supposed to be a version number.
+ */
+static const char MAGIC[] = { 'R', 'E', 'G', '\0' };
+
+int anjay_registration_state_persist(anjay_t *anjay,
+                                     avs_stream_abstract_t *out_stream) {
+    AVS_LIST(anjay_registration_state_t) states = NULL;
+    int retval = _anjay_registration_state_export(anjay, &states);
+    if (!retval) {
+        retval = avs_stream_write(out_stream, MAGIC, sizeof(MAGIC));
+    }
+    if (!retval) {
+        anjay_persistence_context_t *ctx =
+                anjay_persistence_store_context_new(out_stream);
+        if (!ctx) {
+            persistence_log(ERROR, "Out of memory");
+            retval = -1;
+        } else {
+            retval = anjay_persistence_list(ctx, (AVS_LIST(void) *) &states,
+                                            sizeof(anjay_registration_state_t),
+                                            handle_registration_state);
+            anjay_persistence_context_delete(ctx);
+        }
+    }
+    _anjay_registration_state_list_clear(&states);
+    return retval;
+}
+
+int anjay_registration_state_restore(anjay_t *anjay,
+                                     avs_stream_abstract_t *in_stream) {
+    AVS_LIST(anjay_registration_state_t) states = NULL;
+    char magic_buffer[sizeof(MAGIC)];
+    int retval = avs_stream_read_reliably(in_stream, magic_buffer,
+                                          sizeof(magic_buffer));
+    if (!retval && memcmp(MAGIC, magic_buffer, sizeof(MAGIC))) {
+        persistence_log(ERROR, "Magic value mismatch");
+        retval = -1;
+    }
+    if (!retval) {
+        anjay_persistence_context_t *ctx =
+                anjay_persistence_restore_context_new(in_stream);
+        if (!ctx) {
+            persistence_log(ERROR, "Out of memory");
+            retval = -1;
+        } else {
+            retval = anjay_persistence_list(ctx, (AVS_LIST(void) *) &states,
+                                            sizeof(anjay_registration_state_t),
+                                            handle_registration_state);
+            anjay_persistence_context_delete(ctx);
+        }
+    }
+    if (retval) {
+        // registering from scratch is always safe
+        _anjay_registration_state_list_clear(&states);
+    }
+    _anjay_registration_state_import(anjay, &states);
+    return retval;
+}
+
+#ifdef ANJAY_TEST
+#include "test/registration_state.c"
+#endif // ANJAY_TEST
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <avsystem/commons/stream/stream_inbuf.h>
+#include <avsystem/commons/stream/stream_outbuf.h>
+#include <avsystem/commons/unit/test.h>
+
+typedef struct {
+    char buffer[4 * ANJAY_DTLS_SESSION_BUFFER_SIZE];
+    avs_stream_inbuf_t in;
+    avs_stream_outbuf_t out;
+} storage_ctx_t;
+
+static void init_context(storage_ctx_t *ctx) {
+    memcpy(&ctx->in, &AVS_STREAM_INBUF_STATIC_INITIALIZER,
+           sizeof(avs_stream_inbuf_t));
+    memcpy(&ctx->out, &AVS_STREAM_OUTBUF_STATIC_INITIALIZER,
+           sizeof(avs_stream_outbuf_t));
+    ctx->out.buffer = ctx->buffer;
+    ctx->out.buffer_size = sizeof(ctx->buffer);
+    ctx->in.buffer = ctx->buffer;
+}
+
+static anjay_t *create_fake_anjay(void) {
+    anjay_configuration_t fake_config;
+    memset(&fake_config, 0, sizeof(fake_config));
+    fake_config.endpoint_name = "fake";
+    anjay_t *fake_anjay = anjay_new(&fake_config);
+    AVS_UNIT_ASSERT_NOT_NULL(fake_anjay);
+    return fake_anjay;
+}
+
+AVS_UNIT_TEST(dtls_session_cache_persistence, store_restore) {
+    anjay_t *anjay1 = create_fake_anjay();
+    anjay_t *anjay2 = create_fake_anjay();
+
+    static const char SESSION1[] = "first session";
+    static const char SESSION2[] = "second session";
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_dtls_session_cache_put(
+            anjay1, 1, "one.example", "5684", 0x1234, SESSION1,
+            sizeof(SESSION1)));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_dtls_session_cache_put(
+            anjay1, 2, "two.example", "5685", 0x5678, SESSION2,
+            sizeof(SESSION2)));
+    // replaced by the restored data
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_dtls_session_cache_put(
+            anjay2, 1, "one.example", "5684", 0x4321, SESSION2,
+            sizeof(SESSION2)));
+
+    storage_ctx_t ctx = { .buffer = "" };
+    init_context(&ctx);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_dtls_session_cache_persist(
+            anjay1, (avs_stream_abstract_t *) &ctx.out));
+    ctx.in.buffer_size = avs_stream_outbuf_offset(&ctx.out);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_dtls_session_cache_restore(
+            anjay2, (avs_stream_abstract_t *) &ctx.in));
+
+    AVS_LIST(session_entry_t) entries = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_dtls_session_cache_foreach(
+            anjay2, collect_session, &entries));
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(entries), 2);
+
+    // entries are collected in reverse order
+    AVS_UNIT_ASSERT_EQUAL(entries->ssid, 2);
+    AVS_UNIT_ASSERT_EQUAL_STRING(entries->host, "two.example");
+    AVS_UNIT_ASSERT_EQUAL_STRING(entries->port, "5685");
+    AVS_UNIT_ASSERT_EQUAL(entries->config_hash, 0x5678);
+    AVS_UNIT_ASSERT_EQUAL(entries->data_size, ANJAY_DTLS_SESSION_BUFFER_SIZE);
+    AVS_UNIT_ASSERT_EQUAL_BYTES(entries->data, SESSION2);
+
+    session_entry_t *second = AVS_LIST_NEXT(entries);
+    AVS_UNIT_ASSERT_EQUAL(second->ssid, 1);
+    AVS_UNIT_ASSERT_EQUAL_STRING(second->host, "one.example");
+    AVS_UNIT_ASSERT_EQUAL_STRING(second->port, "5684");
+    AVS_UNIT_ASSERT_EQUAL(second->config_hash, 0x1234);
+    AVS_UNIT_ASSERT_EQUAL_BYTES(second->data, SESSION1);
+
+    AVS_LIST_CLEAR(&entries);
+    anjay_delete(anjay1);
+    anjay_delete(anjay2);
+}
+
+AVS_UNIT_TEST(dtls_session_cache_persistence, restore_invalid) {
+    anjay_t *anjay = create_fake_anjay();
+
+    static const char SESSION[] = "session";
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_dtls_session_cache_put(
+            anjay, 1, "one.example", "5684", 0x1234, SESSION,
+            sizeof(SESSION)));
+
+    storage_ctx_t ctx = { .buffer = "FAS" };
+    init_context(&ctx);
+    ctx.in.buffer_size = 4;
+    AVS_UNIT_ASSERT_FAILED(anjay_dtls_session_cache_restore(
+            anjay, (avs_stream_abstract_t *) &ctx.in));
+
+    // the cached state is discarded on failure
+    AVS_LIST(session_entry_t) entries = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_dtls_session_cache_foreach(
+            anjay, collect_session, &entries));
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(entries), 1);
+    for (size_t i = 0; i < entries->data_size; ++i) {
+        AVS_UNIT_ASSERT_EQUAL(entries->data[i], 0);
+    }
+
+    AVS_LIST_CLEAR(&entries);
+    anjay_delete(anjay);
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <avsystem/commons/stream/stream_inbuf.h>
+#include <avsystem/commons/stream/stream_outbuf.h>
+#include <avsystem/commons/unit/test.h>
+
+typedef struct {
+    char buffer[1024];
+    avs_stream_inbuf_t in;
+    avs_stream_outbuf_t out;
+} storage_ctx_t;
+
+static void init_context(storage_ctx_t *ctx) {
+    memcpy(&ctx->in, &AVS_STREAM_INBUF_STATIC_INITIALIZER,
+           sizeof(avs_stream_inbuf_t));
+    memcpy(&ctx->out, &AVS_STREAM_OUTBUF_STATIC_INITIALIZER,
+           sizeof(avs_stream_outbuf_t));
+    ctx->out.buffer = ctx->buffer;
+    ctx->out.buffer_size = sizeof(ctx->buffer);
+    ctx->in.buffer = ctx->buffer;
+}
+
+static anjay_t *create_fake_anjay(void) {
+    anjay_configuration_t fake_config;
+    memset(&fake_config, 0, sizeof(fake_config));
+    fake_config.endpoint_name = "fake";
+    anjay_t *fake_anjay = anjay_new(&fake_config);
+    AVS_UNIT_ASSERT_NOT_NULL(fake_anjay);
+    return fake_anjay;
+}
+
+static void add_observation(AVS_LIST(anjay_observation_state_t) *states,
+                            anjay_ssid_t ssid,
+                            anjay_oid_t oid,
+                            anjay_iid_t iid,
+                            int32_t rid,
+                            const char *value) {
+    AVS_LIST(anjay_observation_state_t) state =
+            AVS_LIST_NEW_ELEMENT(anjay_observation_state_t);
+    AVS_UNIT_ASSERT_NOT_NULL(state);
+    state->ssid = ssid;
+    state->oid = oid;
+    state->iid = iid;
+    state->rid = rid;
+    state->format = 0xFFFF;
+    state->token_size = 2;
+    memcpy(state->token, "ab", 2);
+    state->last_msg_id = (uint16_t) (0x1230 + ssid);
+    state->last_msg_code = 0x45; // 2.05 Content
+    state->last_format = 0; // text/plain
+    state->last_timestamp = (struct timespec) { 1500000000, 123 };
+    state->last_confirmable = (struct timespec) { 1400000000, 456 };
+    state->last_numeric = 42.0;
+    state->last_value_size = strlen(value);
+    state->last_value = malloc(state->last_value_size);
+    AVS_UNIT_ASSERT_NOT_NULL(state->last_value);
+    memcpy(state->last_value, value, state->last_value_size);
+    AVS_LIST_INSERT(AVS_LIST_APPEND_PTR(states), state);
+}
+
+AVS_UNIT_TEST(observe_persistence, store_restore) {
+    anjay_t *anjay1 = create_fake_anjay();
+    anjay_t *anjay2 = create_fake_anjay();
+
+    AVS_LIST(anjay_observation_state_t) states = NULL;
+    add_observation(&states, 1, 3, 0, 1, "42");
+    add_observation(&states, 2, 42, ANJAY_IID_INVALID, -1, "Hello");
+    anjay_observe_serial_state_t serial = {
+        .serial = 0x123456
+    };
+    clock_gettime(CLOCK_REALTIME, &serial.timestamp);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_import(anjay1, &serial, states));
+    _anjay_observation_state_list_clear(&states);
+
+    storage_ctx_t ctx = { .buffer = "" };
+    init_context(&ctx);
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_observe_persist(anjay1, (avs_stream_abstract_t *) &ctx.out));
+    ctx.in.buffer_size = avs_stream_outbuf_offset(&ctx.out);
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_observe_restore(anjay2, (avs_stream_abstract_t *) &ctx.in));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_export(anjay2, &serial, &states));
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(states), 2);
+    // Observe option values continue from where the first instance was,
+    // give or take a second
+    AVS_UNIT_ASSERT_TRUE(((serial.serial - 0x123456) & 0xFFFFFF) < 0x8000);
+
+    AVS_UNIT_ASSERT_EQUAL(states->ssid, 1);
+    AVS_UNIT_ASSERT_EQUAL(states->oid, 3);
+    AVS_UNIT_ASSERT_EQUAL(states->iid, 0);
+    AVS_UNIT_ASSERT_EQUAL(states->rid, 1);
+    AVS_UNIT_ASSERT_EQUAL(states->format, 0xFFFF);
+    AVS_UNIT_ASSERT_EQUAL(states->token_size, 2);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(states->token, "ab", 2);
+    AVS_UNIT_ASSERT_EQUAL(states->last_msg_id, 0x1231);
+    AVS_UNIT_ASSERT_EQUAL(states->last_msg_code, 0x45);
+    AVS_UNIT_ASSERT_EQUAL(states->last_timestamp.tv_sec, 1500000000);
+    AVS_UNIT_ASSERT_EQUAL(states->last_timestamp.tv_nsec, 123);
+    AVS_UNIT_ASSERT_EQUAL(states->last_confirmable.tv_sec, 1400000000);
+    AVS_UNIT_ASSERT_EQUAL(states->last_confirmable.tv_nsec, 456);
+    AVS_UNIT_ASSERT_EQUAL(states->last_numeric, 42.0);
+    AVS_UNIT_ASSERT_EQUAL(states->last_value_size, 2);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(states->last_value, "42", 2);
+
+    anjay_observation_state_t *second = AVS_LIST_NEXT(states);
+    AVS_UNIT_ASSERT_EQUAL(second->ssid, 2);
+    AVS_UNIT_ASSERT_EQUAL(second->oid, 42);
+    AVS_UNIT_ASSERT_EQUAL(second->iid, ANJAY_IID_INVALID);
+    AVS_UNIT_ASSERT_EQUAL(second->rid, -1);
+    AVS_UNIT_ASSERT_EQUAL(second->last_value_size, 5);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(second->last_value, "Hello", 5);
+
+    _anjay_observation_state_list_clear(&states);
+    anjay_delete(anjay1);
+    anjay_delete(anjay2);
+}
+
+AVS_UNIT_TEST(observe_persistence, restore_invalid) {
+    anjay_t *anjay = create_fake_anjay();
+
+    AVS_LIST(anjay_observation_state_t) states = NULL;
+    add_observation(&states, 1, 3, 0, 1, "42");
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_import(anjay, NULL, states));
+    _anjay_observation_state_list_clear(&states);
+
+    // valid magic and Observe clock position, truncated list
+    storage_ctx_t ctx = {
+        .buffer = "OBS\1\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\1\0\1"
+    };
+    init_context(&ctx);
+    ctx.in.buffer_size = 22;
+    AVS_UNIT_ASSERT_FAILED(
+            anjay_observe_restore(anjay, (avs_stream_abstract_t *) &ctx.in));
+
+    // all observations are cancelled on failure
+    anjay_observe_serial_state_t serial;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_export(anjay, &serial, &states));
+    AVS_UNIT_ASSERT_NULL(states);
+
+    anjay_delete(anjay);
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <avsystem/commons/stream/stream_inbuf.h>
+#include <avsystem/commons/stream/stream_outbuf.h>
+#include <avsystem/commons/unit/test.h>
+
+typedef struct {
+    char buffer[1024];
+    avs_stream_inbuf_t in;
+    avs_stream_outbuf_t out;
+} storage_ctx_t;
+
+static void init_context(storage_ctx_t *ctx) {
+    memcpy(&ctx->in, &AVS_STREAM_INBUF_STATIC_INITIALIZER,
+           sizeof(avs_stream_inbuf_t));
+    memcpy(&ctx->out, &AVS_STREAM_OUTBUF_STATIC_INITIALIZER,
+           sizeof(avs_stream_outbuf_t));
+    ctx->out.buffer = ctx->buffer;
+    ctx->out.buffer_size = sizeof(ctx->buffer);
+    ctx->in.buffer = ctx->buffer;
+}
+
+static anjay_t *create_fake_anjay(void) {
+    anjay_configuration_t fake_config;
+    memset(&fake_config, 0, sizeof(fake_config));
+    fake_config.endpoint_name = "fake";
+    anjay_t *fake_anjay = anjay_new(&fake_config);
+    AVS_UNIT_ASSERT_NOT_NULL(fake_anjay);
+    return fake_anjay;
+}
+
+static void append_segment(AVS_LIST(const anjay_string_t) *path,
+                           const char *segment) {
+    AVS_LIST(anjay_string_t) element = (AVS_LIST(anjay_string_t))
+            AVS_LIST_NEW_BUFFER(strlen(segment) + 1);
+    AVS_UNIT_ASSERT_NOT_NULL(element);
+    strcpy(element->c_str, segment);
+    AVS_LIST_APPEND(path, element);
+}
+
+static void add_state(AVS_LIST(anjay_registration_state_t) *states,
+                      anjay_ssid_t ssid,
+                      int64_t lifetime_s,
+                      anjay_binding_mode_t binding_mode,
+                      AVS_LIST(const anjay_string_t) endpoint_path) {
+    AVS_LIST(anjay_registration_state_t) state =
+            AVS_LIST_NEW_ELEMENT(anjay_registration_state_t);
+    AVS_UNIT_ASSERT_NOT_NULL(state);
+    state->ssid = ssid;
+    state->config_hash = 0x12345678 + ssid;
+    state->payload_hash = 0x9ABCDEF0 + ssid;
+    state->expire_time = 1500000000 + ssid;
+    state->lifetime_s = lifetime_s;
+    state->binding_mode = binding_mode;
+    state->endpoint_path = endpoint_path;
+    AVS_LIST_INSERT(states, state);
+}
+
+AVS_UNIT_TEST(registration_state_persistence, store_restore) {
+    anjay_t *anjay1 = create_fake_anjay();
+    anjay_t *anjay2 = create_fake_anjay();
+
+    AVS_LIST(const anjay_string_t) path = NULL;
+    append_segment(&path, "rd");
+    append_segment(&path, "5a3f");
+    AVS_LIST(anjay_registration_state_t) states = NULL;
+    add_state(&states, 1, 86400, ANJAY_BINDING_UQ, path);
+    add_state(&states, 2, 60, ANJAY_BINDING_U, NULL);
+    _anjay_registration_state_import(anjay1, &states);
+    AVS_UNIT_ASSERT_NULL(states);
+
+    storage_ctx_t ctx = { .buffer = "" };
+    init_context(&ctx);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_registration_state_persist(
+            anjay1, (avs_stream_abstract_t *) &ctx.out));
+    ctx.in.buffer_size = avs_stream_outbuf_offset(&ctx.out);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_registration_state_restore(
+            anjay2, (avs_stream_abstract_t *) &ctx.in));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_registration_state_export(anjay2, &states));
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(states), 2);
+
+    // each export reverses the order
+    AVS_UNIT_ASSERT_EQUAL(states->ssid, 2);
+    AVS_UNIT_ASSERT_EQUAL(states->config_hash, 0x1234567A);
+    AVS_UNIT_ASSERT_EQUAL(states->payload_hash, 0x9ABCDEF2);
+    AVS_UNIT_ASSERT_EQUAL(states->expire_time, 1500000002);
+    AVS_UNIT_ASSERT_EQUAL(states->lifetime_s, 60);
+    AVS_UNIT_ASSERT_EQUAL(states->binding_mode, ANJAY_BINDING_U);
+    AVS_UNIT_ASSERT_NULL(states->endpoint_path);
+
+    anjay_registration_state_t *second = AVS_LIST_NEXT(states);
+    AVS_UNIT_ASSERT_EQUAL(second->ssid, 1);
+    AVS_UNIT_ASSERT_EQUAL(second->lifetime_s, 86400);
+    AVS_UNIT_ASSERT_EQUAL(second->binding_mode, ANJAY_BINDING_UQ);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(second->endpoint_path), 2);
+    AVS_UNIT_ASSERT_EQUAL_STRING(second->endpoint_path->c_str, "rd");
+    AVS_UNIT_ASSERT_EQUAL_STRING(AVS_LIST_NEXT(second->endpoint_path)->c_str,
+                                 "5a3f");
+
+    _anjay_registration_state_list_clear(&states);
+    anjay_delete(anjay1);
+    anjay_delete(anjay2);
+}
+
+AVS_UNIT_TEST(registration_state_persistence, restore_invalid) {
+    anjay_t *anjay = create_fake_anjay();
+
+    AVS_LIST(anjay_registration_state_t) states = NULL;
+    add_state(&states, 1, 86400, ANJAY_BINDING_U, NULL);
+    _anjay_registration_state_import(anjay, &states);
+
+    // valid magic, truncated list
+    storage_ctx_t ctx = { .buffer = "REG\0\0\0\0\1\0\1" };
+    init_context(&ctx);
+    ctx.in.buffer_size = 10;
+    AVS_UNIT_ASSERT_FAILED(anjay_registration_state_restore(
+            anjay, (avs_stream_abstract_t *) &ctx.in));
+
+    // previously imported state is discarded on failure
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_registration_state_export(anjay, &states));
+    AVS_UNIT_ASSERT_NULL(states);
+
+    anjay_delete(anjay);
+}
@@ -79,6 +79,8 @@ static int restore_instance(anjay_persistence_context_t *ctx, void *element_) {
         case ANJAY_BINDING_SQ:
         case ANJAY_BINDING_US:
         case ANJAY_BINDING_UQS:
+        case ANJAY_BINDING_T:
+        case ANJAY_BINDING_TQ:
             element->data.binding = (anjay_binding_mode_t) binding;
             break;
         default:
@@ -20,9 +20,12 @@
 #include <math.h>
 #include <ctype.h>
 #include <inttypes.h>
+#include <poll.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include <avsystem/commons/stream/net.h>
 #include <avsystem/commons/stream_v_table.h>
@@ -34,6 +37,7 @@
 #include "anjay.h"
 #include "utils.h"
 #include "dm.h"
+#include "dm/execute.h"
 #include "io.h"
 #include "coap/stream.h"
 #include "interface/bootstrap.h"
@@ -60,6 +64,7 @@ static int init(anjay_t *anjay,
 
     anjay->udp_socket_config = config->udp_socket_config;
     anjay->udp_listen_port = config->udp_listen_port;
+    anjay->dns_cache.ttl_s = (time_t) config->dns_cache_ttl_s;
 
     anjay->servers = _anjay_servers_create();
 
@@ -74,16 +79,43 @@ static int init(anjay_t *anjay,
         _anjay_coap_socket_cleanup(&coap_sock);
         return -1;
     }
+    anjay->in_buffer_size = config->in_buffer_size;
+    anjay->out_buffer_size = config->out_buffer_size;
 
     anjay->sched = _anjay_sched_new(anjay);
     if (!anjay->sched) {
         return -1;
     }
+    if (config->enable_sched_slack) {
+        _anjay_sched_enable_slack(anjay->sched);
+    }
+
+    if (config->update_jitter_percent > 100) {
+        anjay_log(ERROR, "update_jitter_percent must not exceed 100");
+        return -1;
+    }
+    anjay->update_jitter_percent = config->update_jitter_percent;
+    anjay->reconnect_jitter_ms = config->reconnect_jitter_ms;
+    // clients of a fleet may well be started at the same second, so the
+    // endpoint name is mixed into the seed
+    anjay->rand_seed = (anjay_rand_seed_t) (
+            (uint32_t) time(NULL)
+            ^ _anjay_fnv1a32(ANJAY_FNV1A32_INITIAL, anjay->endpoint_name,
+                             strlen(anjay->endpoint_name)));
+    if (config->randomize_retry_backoff) {
+        _anjay_sched_randomize_backoff(anjay->sched,
+                                       _anjay_rand32(&anjay->rand_seed));
+    }
 
     if (_anjay_observe_init(anjay)) {
         return -1;
     }
 
+    if (_anjay_notify_inbox_init(&anjay->notify_inbox,
+                                 config->notify_inbox_size)) {
+        return -1;
+    }
+
     if ((config->sms_driver != NULL) != (config->local_msisdn != NULL)) {
         anjay_log(ERROR,
                   "inconsistent nullness of sms_driver and local_msisdn");
@@ -115,6 +147,8 @@ void _anjay_release_server_stream_without_scheduling_queue(anjay_t *anjay) {
     if (avs_stream_net_setsock(anjay->comm_stream, NULL)) {
         anjay_log(ERROR, "could not set stream socket to NULL");
     }
+    _anjay_coap_stream_set_rtt_estimator(anjay->comm_stream, NULL);
+    _anjay_coap_stream_set_block_size_tuner(anjay->comm_stream, NULL);
 }
 
 void anjay_delete(anjay_t *anjay) {
@@ -122,7 +156,14 @@ void anjay_delete(anjay_t *anjay) {
 
     _anjay_bootstrap_cleanup(anjay);
     _anjay_servers_cleanup(anjay, &anjay->servers);
-
+    _anjay_async_connect_cleanup(&anjay->async_connect);
+    // may only be cleaned up once no socket can refer to it anymore
+    _anjay_dtls_session_cache_cleanup(&anjay->dtls_sessions);
+    _anjay_dns_cache_cleanup(&anjay->dns_cache);
+
+    _anjay_event_loop_cleanup(&anjay->event_loop);
+    _anjay_execute_deferred_cleanup(anjay);
+    _anjay_read_deferred_cleanup(anjay);
     _anjay_sched_delete(&anjay->sched);
 
     assert(avs_stream_net_getsock(anjay->comm_stream) == NULL);
@@ -131,6 +172,8 @@ void anjay_delete(anjay_t *anjay) {
     _anjay_dm_cleanup(anjay);
     _anjay_observe_cleanup(anjay);
     _anjay_notify_clear_queue(&anjay->scheduled_notify.queue);
+    _anjay_notify_inbox_cleanup(&anjay->notify_inbox);
+    _anjay_register_cache_cleanup(&anjay->register_cache);
 
     free(anjay);
 }
@@ -562,7 +605,17 @@ static int handle_request(anjay_t *anjay,
         result = _anjay_dm_perform_action(anjay, anjay->comm_stream, details);
     }
 
-    if (result) {
+    if (result == ANJAY_DM_RESPONSE_DEFERRED) {
+        int ack_result = 0;
+        if (details->msg_type == ANJAY_COAP_MSG_CONFIRMABLE) {
+            ack_result = _anjay_coap_stream_send_empty_ack(stream);
+        }
+        if (details->ssid != ANJAY_SSID_BOOTSTRAP) {
+            _anjay_observe_sched_flush(anjay, details->ssid,
+                                       details->conn_type);
+        }
+        return ack_result;
+    } else if (result) {
         uint8_t error_code = _anjay_make_error_response_code(result);
 
         if (_anjay_coap_msg_code_is_client_error(error_code)) {
@@ -679,7 +732,17 @@ _anjay_get_server_stream(anjay_t *anjay, anjay_connection_ref_t ref) {
     if (!socket
             || avs_stream_net_setsock(anjay->comm_stream, socket)
             || _anjay_coap_stream_set_tx_params(anjay->comm_stream,
-                                                tx_params)) {
+                                                tx_params)
+            || _anjay_coap_stream_set_rtt_estimator(
+                    anjay->comm_stream,
+                    ref.conn_type == ANJAY_CONNECTION_UDP
+                            ? _anjay_connection_rtt_estimator(connection)
+                            : NULL)
+            || _anjay_coap_stream_set_block_size_tuner(
+                    anjay->comm_stream,
+                    ref.conn_type == ANJAY_CONNECTION_UDP
+                            ? _anjay_connection_block_size_tuner(connection)
+                            : NULL)) {
         anjay_log(ERROR, "could not set stream socket");
         return NULL;
     }
@@ -747,10 +810,11 @@ static void queue_mode_activate_socket(anjay_t *anjay,
         .conn_type = (uint16_t) ref.conn_type
     };
     // see comment on field declaration for logic summary
-    if (_anjay_sched(anjay->sched,
-                     &connection->queue_mode_close_socket_clb_handle,
-                     delay, queue_mode_close_socket,
-                     queue_mode_close_socket_args_encode(args))) {
+    if (_anjay_sched_with_slack(anjay->sched,
+                                &connection->queue_mode_close_socket_clb_handle,
+                                delay, _anjay_sched_default_slack(delay),
+                                queue_mode_close_socket,
+                                queue_mode_close_socket_args_encode(args))) {
         anjay_log(ERROR, "could not schedule queue mode operations");
     }
 }
@@ -790,6 +854,19 @@ size_t _anjay_num_non_bootstrap_servers(anjay_t *anjay) {
     return num_servers;
 }
 
+struct timespec _anjay_random_delay(anjay_t *anjay, uint64_t max_ms) {
+    if (!max_ms) {
+        return ANJAY_TIME_ZERO;
+    }
+    uint64_t random = ((uint64_t) _anjay_rand32(&anjay->rand_seed) << 32)
+                      | _anjay_rand32(&anjay->rand_seed);
+    uint64_t delay_ms = random % (max_ms + 1);
+    return (struct timespec) {
+        .tv_sec = (time_t) (delay_ms / 1000),
+        .tv_nsec = (long) (delay_ms % 1000) * 1000000L
+    };
+}
+
 static int udp_serve(anjay_t *anjay,
                      avs_net_abstract_socket_t *ready_socket) {
     anjay_connection_ref_t connection = {
@@ -823,9 +900,49 @@ int anjay_serve(anjay_t *anjay,
             && ready_socket == _anjay_sms_poll_socket(anjay)) {
         return sms_serve(anjay);
     }
+    if (ready_socket && ready_socket == anjay->async_connect.wakeup_socket) {
+        return _anjay_async_connect_process(anjay);
+    }
+    if (ready_socket && _anjay_servers_serve_activating(anjay, ready_socket)) {
+        return 0;
+    }
     return udp_serve(anjay, ready_socket);
 }
 
+static bool socket_has_pending_data(avs_net_abstract_socket_t *socket) {
+    const int *fd = (const int *) avs_net_socket_get_system(socket);
+    if (!fd || *fd < 0) {
+        return false;
+    }
+
+    struct pollfd poll_fd = {
+        .fd = *fd,
+        .events = POLLIN
+    };
+    return poll(&poll_fd, 1, 0) > 0 && (poll_fd.revents & POLLIN);
+}
+
+int anjay_serve_batch(anjay_t *anjay,
+                      avs_net_abstract_socket_t *ready_socket,
+                      size_t max_messages) {
+    int result = 0;
+    size_t served = 0;
+
+    do {
+        int serve_result = anjay_serve(anjay, ready_socket);
+        if (serve_result) {
+            result = serve_result;
+        }
+        ++served;
+    } while (served < max_messages
+             && _anjay_servers_find_by_udp_socket(&anjay->servers,
+                                                  ready_socket)
+             && socket_has_pending_data(ready_socket));
+
+    anjay_log(TRACE, "served %lu messages in a batch", (unsigned long) served);
+    return result;
+}
+
 int anjay_sched_time_to_next(anjay_t *anjay,
                              struct timespec *out_delay) {
     return _anjay_sched_time_to_next(anjay->sched, out_delay);
@@ -850,6 +967,11 @@ int anjay_sched_calculate_wait_time_ms(anjay_t *anjay, int limit_ms) {
 }
 
 int anjay_sched_run(anjay_t *anjay) {
+    if (_anjay_notify_inbox_drain(anjay)) {
+        anjay_log(WARNING, "could not queue some of the cross-thread "
+                           "notifications");
+    }
+
     ssize_t tasks_executed = _anjay_sched_run(anjay->sched);
     if (tasks_executed < 0) {
         anjay_log(ERROR, "sched_run failed");
@@ -863,6 +985,10 @@ int anjay_sched_run(anjay_t *anjay) {
     return 0;
 }
 
+void anjay_get_sched_stats(anjay_t *anjay, anjay_sched_stats_t *out_stats) {
+    _anjay_sched_get_stats(anjay->sched, out_stats);
+}
+
 void anjay_smsdrv_cleanup(anjay_smsdrv_t **smsdrv_ptr) {
     if (*smsdrv_ptr) {
         assert(0 && "SMS drivers not supported by this version of Anjay");
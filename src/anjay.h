@@ -21,13 +21,19 @@
 #include <avsystem/commons/stream.h>
 #include <avsystem/commons/net.h>
 
+#include "async_connect.h"
 #include "dm.h"
+#include "dns_cache.h"
+#include "dtls_session_cache.h"
+#include "event_loop.h"
+#include "notify_inbox.h"
 #include "observe.h"
 #include "sched.h"
 
 #include "servers.h"
 #include "utils.h"
 #include "interface/bootstrap.h"
+#include "interface/register_cache.h"
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
@@ -49,6 +55,7 @@ struct anjay_struct {
     anjay_dm_t dm;
     uint16_t udp_listen_port;
     anjay_servers_t servers;
+    anjay_register_cache_t register_cache;
 #ifdef WITH_OBSERVE
     anjay_observe_state_t observe;
 #endif
@@ -56,10 +63,28 @@ struct anjay_struct {
     anjay_bootstrap_t bootstrap;
 #endif
     avs_stream_abstract_t *comm_stream;
+    /* buffer sizes of comm_stream, also used for requests sent without it */
+    size_t in_buffer_size;
+    size_t out_buffer_size;
     anjay_scheduled_notify_t scheduled_notify;
+    anjay_notify_inbox_t notify_inbox;
+    anjay_event_loop_t event_loop;
+    anjay_async_connect_t async_connect;
+    anjay_dtls_session_cache_t dtls_sessions;
+    anjay_dns_cache_t dns_cache;
+    AVS_LIST(anjay_execute_deferred_t) execute_deferred;
+#ifdef WITH_OBSERVE
+    AVS_LIST(anjay_read_deferred_t) read_deferred;
+    struct anjay_read_deferral_struct *current_read;
+#endif
 
     const char *endpoint_name;
     anjay_transaction_state_t transaction_state;
+
+    /* used to spread the activity of a fleet of clients in time */
+    anjay_rand_seed_t rand_seed;
+    uint8_t update_jitter_percent;
+    uint32_t reconnect_jitter_ms;
 };
 
 #define ANJAY_DM_DEFAULT_PMIN_VALUE 1
@@ -86,6 +111,11 @@ void _anjay_release_server_stream(anjay_t *anjay,
 
 size_t _anjay_num_non_bootstrap_servers(anjay_t *anjay);
 
+/**
+ * @returns A random duration between zero and @p max_ms milliseconds.
+ */
+struct timespec _anjay_random_delay(anjay_t *anjay, uint64_t max_ms);
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif	/* ANJAY_ANJAY_H */
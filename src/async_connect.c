@@ -0,0 +1,455 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <avsystem/commons/socket_v_table.h>
+
+#include "anjay.h"
+#include "async_connect.h"
+#include "utils.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#ifdef WITH_ASYNC_CONNECT
+
+struct anjay_async_connect_task {
+    anjay_async_connect_t *owner;
+    pthread_t thread;
+    avs_net_abstract_socket_t *socket;
+    char host[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    char port[ANJAY_MAX_URL_PORT_SIZE];
+    /* NULL if the task has been cancelled; the task owns the socket then */
+    anjay_async_connect_finished_t *finished_clb;
+    void *finished_clb_arg;
+    /* freed along with the socket after cancelling */
+    void *socket_data;
+
+    /* written by the background thread, protected by owner->mutex */
+    bool finished;
+    int result;
+};
+
+/**
+ * Socket exposed through anjay_get_sockets() so that the application polls
+ * the read end of the wakeup pipe along with the server sockets. Only the
+ * operations needed to poll and serve it are supported.
+ */
+typedef struct {
+    const avs_net_socket_v_table_t *const operations;
+    anjay_t *anjay;
+} wakeup_socket_t;
+
+static int wakeup_unsupported(void) {
+    errno = ENOTSUP;
+    return -1;
+}
+
+static int wakeup_connect(avs_net_abstract_socket_t *sock,
+                          const char *host,
+                          const char *port) {
+    (void) sock; (void) host; (void) port;
+    return wakeup_unsupported();
+}
+
+static int wakeup_decorate(avs_net_abstract_socket_t *sock,
+                           avs_net_abstract_socket_t *backend) {
+    (void) sock; (void) backend;
+    return wakeup_unsupported();
+}
+
+static int wakeup_send(avs_net_abstract_socket_t *sock,
+                       const void *buffer,
+                       size_t buffer_length) {
+    (void) sock; (void) buffer; (void) buffer_length;
+    return wakeup_unsupported();
+}
+
+static int wakeup_send_to(avs_net_abstract_socket_t *sock,
+                          size_t *out_bytes_sent,
+                          const void *buffer,
+                          size_t buffer_length,
+                          const char *host,
+                          const char *port) {
+    (void) sock; (void) out_bytes_sent; (void) buffer; (void) buffer_length;
+    (void) host; (void) port;
+    return wakeup_unsupported();
+}
+
+static void clear_wakeup(anjay_async_connect_t *async_connect) {
+    char buf[64];
+    ssize_t result;
+    do {
+        result = read(async_connect->wakeup_fds[0], buf, sizeof(buf));
+    } while (result > 0 || (result < 0 && errno == EINTR));
+}
+
+static int wakeup_receive(avs_net_abstract_socket_t *sock,
+                          size_t *out_bytes_received,
+                          void *buffer,
+                          size_t buffer_length) {
+    (void) buffer; (void) buffer_length;
+    // the contents of the pipe carry no information
+    clear_wakeup(&((wakeup_socket_t *) sock)->anjay->async_connect);
+    *out_bytes_received = 0;
+    return 0;
+}
+
+static int wakeup_receive_from(avs_net_abstract_socket_t *sock,
+                               size_t *out_bytes_received,
+                               void *buffer,
+                               size_t buffer_length,
+                               char *out_host,
+                               size_t out_host_size,
+                               char *out_port,
+                               size_t out_port_size) {
+    (void) out_host; (void) out_host_size; (void) out_port;
+    (void) out_port_size;
+    return wakeup_receive(sock, out_bytes_received, buffer, buffer_length);
+}
+
+static int wakeup_bind(avs_net_abstract_socket_t *sock,
+                       const char *address,
+                       const char *port) {
+    (void) sock; (void) address; (void) port;
+    return wakeup_unsupported();
+}
+
+static int wakeup_accept(avs_net_abstract_socket_t *server_socket,
+                         avs_net_abstract_socket_t *new_socket) {
+    (void) server_socket; (void) new_socket;
+    return wakeup_unsupported();
+}
+
+static int wakeup_close(avs_net_abstract_socket_t *sock) {
+    (void) sock;
+    return 0;
+}
+
+static int wakeup_cleanup(avs_net_abstract_socket_t **sock_ptr) {
+    free(*sock_ptr);
+    *sock_ptr = NULL;
+    return 0;
+}
+
+static const void *wakeup_get_system(avs_net_abstract_socket_t *sock) {
+    return &((wakeup_socket_t *) sock)->anjay->async_connect.wakeup_fds[0];
+}
+
+static int wakeup_get_interface(avs_net_abstract_socket_t *sock,
+                                avs_net_socket_interface_name_t *if_name) {
+    (void) sock; (void) if_name;
+    return wakeup_unsupported();
+}
+
+static int wakeup_get_name(avs_net_abstract_socket_t *sock,
+                           char *out_buffer,
+                           size_t out_buffer_size) {
+    (void) sock; (void) out_buffer; (void) out_buffer_size;
+    return wakeup_unsupported();
+}
+
+static int wakeup_get_opt(avs_net_abstract_socket_t *sock,
+                          avs_net_socket_opt_key_t option_key,
+                          avs_net_socket_opt_value_t *out_option_value) {
+    (void) sock;
+    if (option_key == AVS_NET_SOCKET_OPT_STATE) {
+        out_option_value->state = AVS_NET_SOCKET_STATE_CONNECTED;
+        return 0;
+    }
+    return wakeup_unsupported();
+}
+
+static int wakeup_set_opt(avs_net_abstract_socket_t *sock,
+                          avs_net_socket_opt_key_t option_key,
+                          avs_net_socket_opt_value_t option_value) {
+    (void) sock; (void) option_key; (void) option_value;
+    return wakeup_unsupported();
+}
+
+static int wakeup_errno(avs_net_abstract_socket_t *sock) {
+    (void) sock;
+    return 0;
+}
+
+static const avs_net_socket_v_table_t WAKEUP_SOCKET_VTABLE = {
+    .connect = wakeup_connect,
+    .decorate = wakeup_decorate,
+    .send = wakeup_send,
+    .send_to = wakeup_send_to,
+    .receive = wakeup_receive,
+    .receive_from = wakeup_receive_from,
+    .bind = wakeup_bind,
+    .accept = wakeup_accept,
+    .close = wakeup_close,
+    .shutdown = wakeup_close,
+    .cleanup = wakeup_cleanup,
+    .get_system_socket = wakeup_get_system,
+    .get_interface_name = wakeup_get_interface,
+    .get_remote_host = wakeup_get_name,
+    .get_remote_hostname = wakeup_get_name,
+    .get_remote_port = wakeup_get_name,
+    .get_local_port = wakeup_get_name,
+    .get_opt = wakeup_get_opt,
+    .set_opt = wakeup_set_opt,
+    .get_errno = wakeup_errno
+};
+
+static int set_nonblocking_cloexec(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK)) {
+        return -1;
+    }
+    flags = fcntl(fd, F_GETFD);
+    if (flags < 0 || fcntl(fd, F_SETFD, flags | FD_CLOEXEC)) {
+        return -1;
+    }
+    return 0;
+}
+
+static void close_wakeup_fds(anjay_async_connect_t *async_connect) {
+    for (size_t i = 0; i < 2; ++i) {
+        if (async_connect->wakeup_fds[i] >= 0) {
+            close(async_connect->wakeup_fds[i]);
+            async_connect->wakeup_fds[i] = -1;
+        }
+    }
+}
+
+static int init_async_connect(anjay_t *anjay,
+                              anjay_async_connect_t *async_connect) {
+    const wakeup_socket_t initializer = {
+        .operations = &WAKEUP_SOCKET_VTABLE,
+        .anjay = anjay
+    };
+    wakeup_socket_t *socket =
+            (wakeup_socket_t *) malloc(sizeof(wakeup_socket_t));
+    if (!socket) {
+        anjay_log(ERROR, "Out of memory");
+        return -1;
+    }
+    memcpy(socket, &initializer, sizeof(*socket));
+
+    if (pipe(async_connect->wakeup_fds)) {
+        anjay_log(ERROR, "could not create connect wakeup pipe: %s",
+                  strerror(errno));
+        async_connect->wakeup_fds[0] = -1;
+        async_connect->wakeup_fds[1] = -1;
+        free(socket);
+        return -1;
+    }
+    if (set_nonblocking_cloexec(async_connect->wakeup_fds[0])
+            || set_nonblocking_cloexec(async_connect->wakeup_fds[1])) {
+        anjay_log(ERROR, "could not configure connect wakeup pipe");
+        goto error;
+    }
+    if (pthread_mutex_init(&async_connect->mutex, NULL)) {
+        anjay_log(ERROR, "could not initialize mutex");
+        goto error;
+    }
+
+    async_connect->wakeup_socket = (avs_net_abstract_socket_t *) socket;
+    async_connect->wakeup_pending = false;
+    async_connect->initialized = true;
+    return 0;
+
+error:
+    close_wakeup_fds(async_connect);
+    free(socket);
+    return -1;
+}
+
+static void *connect_thread(void *task_) {
+    anjay_async_connect_task_t *task = (anjay_async_connect_task_t *) task_;
+    int result = avs_net_socket_connect(task->socket, task->host, task->port);
+
+    anjay_async_connect_t *owner = task->owner;
+    pthread_mutex_lock(&owner->mutex);
+    task->result = result;
+    task->finished = true;
+    bool needs_wakeup = !owner->wakeup_pending;
+    owner->wakeup_pending = true;
+    pthread_mutex_unlock(&owner->mutex);
+
+    if (needs_wakeup) {
+        // EAGAIN means that the pipe is full, i.e. already readable
+        ssize_t written;
+        do {
+            written = write(owner->wakeup_fds[1], "", 1);
+        } while (written < 0 && errno == EINTR);
+    }
+    return NULL;
+}
+
+int _anjay_async_connect_start(anjay_t *anjay,
+                               anjay_async_connect_task_t **out_task,
+                               avs_net_abstract_socket_t *socket,
+                               const char *host,
+                               const char *port,
+                               anjay_async_connect_finished_t *finished_clb,
+                               void *finished_clb_arg) {
+    anjay_async_connect_t *async_connect = &anjay->async_connect;
+    if (!async_connect->initialized
+            && init_async_connect(anjay, async_connect)) {
+        return -1;
+    }
+
+    AVS_LIST(anjay_async_connect_task_t) task =
+            AVS_LIST_NEW_ELEMENT(anjay_async_connect_task_t);
+    if (!task) {
+        anjay_log(ERROR, "Out of memory");
+        return -1;
+    }
+    task->owner = async_connect;
+    task->socket = socket;
+    task->finished_clb = finished_clb;
+    task->finished_clb_arg = finished_clb_arg;
+    if (_anjay_snprintf(task->host, sizeof(task->host), "%s", host) < 0
+            || _anjay_snprintf(task->port, sizeof(task->port), "%s",
+                               port) < 0) {
+        AVS_LIST_DELETE(&task);
+        return -1;
+    }
+
+    int result = pthread_create(&task->thread, NULL, connect_thread, task);
+    if (result) {
+        anjay_log(WARNING, "could not start connect thread: %s",
+                  strerror(result));
+        AVS_LIST_DELETE(&task);
+        return -1;
+    }
+
+    AVS_LIST_INSERT(&async_connect->tasks, task);
+    *out_task = task;
+    return 0;
+}
+
+void _anjay_async_connect_cancel(anjay_async_connect_task_t **task_ptr,
+                                 void *socket_data) {
+    assert(*task_ptr || !socket_data);
+    if (*task_ptr) {
+        (*task_ptr)->finished_clb = NULL;
+        (*task_ptr)->socket_data = socket_data;
+        *task_ptr = NULL;
+    }
+}
+
+avs_net_abstract_socket_t *_anjay_async_connect_wakeup_socket(anjay_t *anjay) {
+    return anjay->async_connect.tasks ? anjay->async_connect.wakeup_socket
+                                      : NULL;
+}
+
+static void release_task(AVS_LIST(anjay_async_connect_task_t) *task_ptr) {
+    pthread_join((*task_ptr)->thread, NULL);
+    if (!(*task_ptr)->finished_clb) {
+        avs_net_socket_cleanup(&(*task_ptr)->socket);
+        free((*task_ptr)->socket_data);
+    }
+    AVS_LIST_DELETE(task_ptr);
+}
+
+int _anjay_async_connect_process(anjay_t *anjay) {
+    anjay_async_connect_t *async_connect = &anjay->async_connect;
+    if (!async_connect->initialized) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&async_connect->mutex);
+    async_connect->wakeup_pending = false;
+    clear_wakeup(async_connect);
+    // tasks are detached from the main list first, as the callbacks may start
+    // new connection attempts
+    AVS_LIST(anjay_async_connect_task_t) finished = NULL;
+    AVS_LIST(anjay_async_connect_task_t) *task_ptr;
+    AVS_LIST(anjay_async_connect_task_t) helper;
+    AVS_LIST_DELETABLE_FOREACH_PTR(task_ptr, helper, &async_connect->tasks) {
+        if ((*task_ptr)->finished) {
+            AVS_LIST_INSERT(&finished, AVS_LIST_DETACH(task_ptr));
+        }
+    }
+    pthread_mutex_unlock(&async_connect->mutex);
+
+    while (finished) {
+        if (finished->finished_clb) {
+            finished->finished_clb(anjay, finished->finished_clb_arg,
+                                   finished->result);
+        }
+        release_task(&finished);
+    }
+    return 0;
+}
+
+void _anjay_async_connect_cleanup(anjay_async_connect_t *async_connect) {
+    if (!async_connect->initialized) {
+        return;
+    }
+    while (async_connect->tasks) {
+        // connect attempts cannot be interrupted - this may block until the
+        // handshake times out
+        async_connect->tasks->finished_clb = NULL;
+        release_task(&async_connect->tasks);
+    }
+    avs_net_socket_cleanup(&async_connect->wakeup_socket);
+    close_wakeup_fds(async_connect);
+    pthread_mutex_destroy(&async_connect->mutex);
+    async_connect->initialized = false;
+}
+
+#ifdef ANJAY_TEST
+#include "test/async_connect.c"
+#endif // ANJAY_TEST
+
+#else // WITH_ASYNC_CONNECT
+
+int _anjay_async_connect_start(anjay_t *anjay,
+                               anjay_async_connect_task_t **out_task,
+                               avs_net_abstract_socket_t *socket,
+                               const char *host,
+                               const char *port,
+                               anjay_async_connect_finished_t *finished_clb,
+                               void *finished_clb_arg) {
+    (void) anjay; (void) out_task; (void) socket; (void) host; (void) port;
+    (void) finished_clb; (void) finished_clb_arg;
+    return -1;
+}
+
+void _anjay_async_connect_cancel(anjay_async_connect_task_t **task_ptr,
+                                 void *socket_data) {
+    (void) task_ptr; (void) socket_data;
+}
+
+avs_net_abstract_socket_t *_anjay_async_connect_wakeup_socket(anjay_t *anjay) {
+    (void) anjay;
+    return NULL;
+}
+
+int _anjay_async_connect_process(anjay_t *anjay) {
+    (void) anjay;
+    return 0;
+}
+
+void _anjay_async_connect_cleanup(anjay_async_connect_t *async_connect) {
+    (void) async_connect;
+}
+
+#endif // WITH_ASYNC_CONNECT
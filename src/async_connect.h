@@ -0,0 +1,127 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_ASYNC_CONNECT_H
+#define ANJAY_ASYNC_CONNECT_H
+
+#include <stdbool.h>
+
+#ifdef WITH_ASYNC_CONNECT
+#include <pthread.h>
+#endif // WITH_ASYNC_CONNECT
+
+#include <avsystem/commons/list.h>
+#include <avsystem/commons/net.h>
+
+#include <anjay/anjay.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+typedef struct anjay_async_connect_task anjay_async_connect_task_t;
+
+/**
+ * Called from the event loop thread once the connection attempt finishes.
+ *
+ * @param result Value returned by <c>avs_net_socket_connect()</c>.
+ */
+typedef void anjay_async_connect_finished_t(anjay_t *anjay,
+                                            void *arg,
+                                            int result);
+
+/**
+ * Connects sockets - which, for (D)TLS, includes the whole handshake - on
+ * background threads, so that the event loop thread is not blocked for the
+ * duration of the handshake.
+ *
+ * avs_commons does not allow driving a handshake incrementally, so a thread is
+ * spawned for each connection attempt instead. The socket is not touched by
+ * the event loop thread until the attempt finishes.
+ *
+ * Completion is reported through a wakeup socket, which is included in the set
+ * returned by @ref anjay_get_sockets while any attempt is in progress. Calling
+ * @ref anjay_serve on it invokes the completion callbacks.
+ *
+ * System resources are allocated on the first connection attempt.
+ */
+typedef struct {
+    bool initialized;
+#ifdef WITH_ASYNC_CONNECT
+    /* protects anjay_async_connect_task_t::finished and wakeup_pending */
+    pthread_mutex_t mutex;
+#endif // WITH_ASYNC_CONNECT
+    int wakeup_fds[2];
+    bool wakeup_pending;
+    avs_net_abstract_socket_t *wakeup_socket;
+    AVS_LIST(anjay_async_connect_task_t) tasks;
+} anjay_async_connect_t;
+
+/**
+ * Starts connecting @p socket to @p host : @p port in the background.
+ * @p finished_clb will be called with @p finished_clb_arg once the attempt
+ * finishes, unless it is cancelled before that.
+ *
+ * @returns 0 on success, or a negative value if the background connection
+ *          could not be started - the caller shall connect the socket in
+ *          a blocking manner in that case.
+ */
+int _anjay_async_connect_start(anjay_t *anjay,
+                               anjay_async_connect_task_t **out_task,
+                               avs_net_abstract_socket_t *socket,
+                               const char *host,
+                               const char *port,
+                               anjay_async_connect_finished_t *finished_clb,
+                               void *finished_clb_arg);
+
+/**
+ * Cancels a connection attempt started with @ref _anjay_async_connect_start
+ * and sets <c>*task_ptr</c> to NULL. The completion callback will not be
+ * called. The socket passed to @ref _anjay_async_connect_start becomes owned
+ * by the task and is cleaned up once the background thread finishes - it must
+ * not be used afterwards.
+ *
+ * @param socket_data Memory the socket may still be using, e.g. its session
+ *                    resumption buffer, or NULL. It is freed along with the
+ *                    socket. Shall be NULL if <c>*task_ptr</c> is NULL.
+ */
+void _anjay_async_connect_cancel(anjay_async_connect_task_t **task_ptr,
+                                 void *socket_data);
+
+/**
+ * @returns The socket that becomes readable when any connection attempt
+ *          finishes, or NULL if there are no attempts in progress.
+ */
+avs_net_abstract_socket_t *_anjay_async_connect_wakeup_socket(anjay_t *anjay);
+
+/**
+ * Invokes completion callbacks of all finished connection attempts and
+ * releases their resources.
+ */
+int _anjay_async_connect_process(anjay_t *anjay);
+
+/**
+ * Waits for all connection attempts to finish and releases all resources.
+ * Completion callbacks are not called.
+ *
+ * NOTE: The attempts cannot be interrupted, as avs_commons sockets must not be
+ * accessed from multiple threads at once, so this may block until the
+ * handshakes time out. Detaching the threads instead is not an option either,
+ * as the sockets they use would then never be cleaned up.
+ */
+void _anjay_async_connect_cleanup(anjay_async_connect_t *async_connect);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_ASYNC_CONNECT_H */
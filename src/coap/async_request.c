@@ -0,0 +1,319 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <stdlib.h>
+
+#include <anjay_modules/time.h>
+
+#define ANJAY_COAP_STREAM_INTERNALS
+
+#include "async_request.h"
+#include "log.h"
+#include "msg_builder.h"
+#include "stream/common.h"
+#include "stream/in.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+struct anjay_coap_async_request {
+    anjay_coap_async_request_state_t state;
+    /* set after an Empty ACK; the response will come in a separate message */
+    bool acknowledged;
+    anjay_coap_socket_t *socket;
+    coap_input_buffer_t in;
+    coap_retry_state_t retry_state;
+    struct timespec deadline;
+    anjay_coap_msg_identity_t identity;
+    /* serialized request, allocated as anjay_coap_msg_t for alignment */
+    anjay_coap_msg_t *msg;
+};
+
+static void set_deadline_after_ms(anjay_coap_async_request_t *request,
+                                  int32_t timeout_ms) {
+    struct timespec timeout;
+    _anjay_time_from_ms(&timeout, timeout_ms);
+    clock_gettime(CLOCK_MONOTONIC, &request->deadline);
+    _anjay_time_add(&request->deadline, &timeout);
+}
+
+static void transmit(anjay_coap_async_request_t *request) {
+    int result = _anjay_coap_socket_send(request->socket, request->msg);
+    _anjay_coap_common_update_retry_state(&request->retry_state, &request->in);
+    if (result) {
+        coap_log(DEBUG, "send failed");
+        request->state = ANJAY_COAP_ASYNC_REQUEST_FAILED;
+        return;
+    }
+    set_deadline_after_ms(request, request->retry_state.recv_timeout_ms);
+}
+
+static int build_msg(anjay_coap_async_request_t *request,
+                     const anjay_coap_async_request_config_t *config,
+                     const anjay_msg_details_t *details,
+                     const void *payload,
+                     size_t payload_size) {
+    anjay_coap_msg_info_t info = _anjay_coap_msg_info_init();
+    int result = -1;
+    if (_anjay_coap_common_fill_msg_info(&info, details, &request->identity,
+                                         NULL)) {
+        goto finish;
+    }
+
+    size_t capacity = config->out_buffer_size;
+    avs_net_socket_opt_value_t mtu;
+    if (!avs_net_socket_get_opt(config->socket, AVS_NET_SOCKET_OPT_INNER_MTU,
+                                &mtu)
+            && mtu.mtu > 0) {
+        capacity = ANJAY_MIN(capacity, (size_t) mtu.mtu);
+    }
+
+    size_t storage_size =
+            _anjay_coap_msg_info_get_packet_storage_size(&info, payload_size);
+    if (storage_size > capacity) {
+        result = ANJAY_COAP_ASYNC_REQUEST_TOO_LARGE;
+        goto finish;
+    }
+
+    request->msg = (anjay_coap_msg_t *) malloc(storage_size);
+    if (!request->msg) {
+        coap_log(ERROR, "out of memory");
+        goto finish;
+    }
+
+    anjay_coap_msg_builder_t builder;
+    if (_anjay_coap_msg_builder_init(
+                &builder, _anjay_coap_ensure_aligned_buffer(request->msg),
+                storage_size, &info)
+            || _anjay_coap_msg_builder_payload(&builder, payload, payload_size)
+                    != payload_size) {
+        goto finish;
+    }
+    assert(_anjay_coap_msg_builder_get_msg(&builder) == request->msg);
+    result = 0;
+
+finish:
+    _anjay_coap_msg_info_reset(&info);
+    return result;
+}
+
+int _anjay_coap_async_request_send(
+        anjay_coap_async_request_t **out_request,
+        const anjay_coap_async_request_config_t *config,
+        const anjay_msg_details_t *details,
+        const anjay_coap_msg_identity_t *identity,
+        const void *payload,
+        size_t payload_size) {
+    assert(details->msg_type == ANJAY_COAP_MSG_CONFIRMABLE);
+
+    anjay_coap_async_request_t *request = (anjay_coap_async_request_t *)
+            calloc(1, sizeof(anjay_coap_async_request_t));
+    if (!request) {
+        coap_log(ERROR, "out of memory");
+        return -1;
+    }
+    request->identity = *identity;
+    request->in.transmission_params = *config->tx_params;
+    request->in.rtt_estimator = config->rtt_estimator;
+    request->in.rand_seed = config->rand_seed;
+    request->in.buffer_size = config->in_buffer_size;
+
+    int result;
+    if ((result = build_msg(request, config, details, payload, payload_size))) {
+        goto fail;
+    }
+
+    result = -1;
+    // malloc() returns memory aligned for any type, including anjay_coap_msg_t
+    if (!(request->in.buffer = (uint8_t *) malloc(config->in_buffer_size))
+            || _anjay_coap_socket_create(&request->socket, config->socket)) {
+        coap_log(ERROR, "out of memory");
+        goto fail;
+    }
+
+    transmit(request);
+    if (request->state == ANJAY_COAP_ASYNC_REQUEST_FAILED) {
+        goto fail;
+    }
+
+    *out_request = request;
+    return 0;
+
+fail:
+    _anjay_coap_async_request_cleanup(&request);
+    return result;
+}
+
+anjay_coap_async_request_state_t
+_anjay_coap_async_request_state(const anjay_coap_async_request_t *request) {
+    return request->state;
+}
+
+avs_net_abstract_socket_t *
+_anjay_coap_async_request_socket(const anjay_coap_async_request_t *request) {
+    return _anjay_coap_socket_get_backend(request->socket);
+}
+
+struct timespec
+_anjay_coap_async_request_deadline(const anjay_coap_async_request_t *request) {
+    return request->deadline;
+}
+
+static void finish(anjay_coap_async_request_t *request) {
+    request->state = ANJAY_COAP_ASYNC_REQUEST_FINISHED;
+    _anjay_coap_common_retry_state_complete(&request->retry_state,
+                                            &request->in);
+}
+
+/**
+ * Mirrors the response matching done by a blocking request in the CoAP
+ * client stream: messages that do not belong to the request are ignored,
+ * except for Confirmable ones, which the server would otherwise retransmit.
+ */
+static void process_msg(anjay_coap_async_request_t *request,
+                        const anjay_coap_msg_t *msg) {
+    const bool id_matches =
+            !request->acknowledged
+            && _anjay_coap_msg_get_id(msg) == request->identity.msg_id;
+
+    switch (_anjay_coap_msg_header_get_type(&msg->header)) {
+    case ANJAY_COAP_MSG_RESET:
+        if (id_matches) {
+            coap_log(DEBUG, "Reset response");
+            request->state = ANJAY_COAP_ASYNC_REQUEST_FAILED;
+            return;
+        }
+        break;
+
+    case ANJAY_COAP_MSG_ACKNOWLEDGEMENT:
+        if (!id_matches) {
+            break;
+        }
+        if (msg->header.code == ANJAY_COAP_CODE_EMPTY) {
+            coap_log(DEBUG, "Separate Response: ACK");
+            request->acknowledged = true;
+            set_deadline_after_ms(request,
+                                  ANJAY_COAP_SEPARATE_RESPONSE_TIMEOUT_MS);
+            return;
+        }
+        if (_anjay_coap_common_token_matches(msg, &request->identity)) {
+            finish(request);
+            return;
+        }
+        coap_log(DEBUG, "invalid response: token mismatch");
+        break;
+
+    case ANJAY_COAP_MSG_CONFIRMABLE:
+        if (_anjay_coap_common_token_matches(msg, &request->identity)) {
+            coap_log(TRACE, "Separate response received; sending ACK");
+            _anjay_coap_common_send_empty(request->socket,
+                                          ANJAY_COAP_MSG_ACKNOWLEDGEMENT,
+                                          _anjay_coap_msg_get_id(msg));
+            finish(request);
+            return;
+        }
+        {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            _anjay_coap_common_send_service_unavailable(
+                    request->socket, msg,
+                    (int32_t) _anjay_time_diff_ms(&request->deadline, &now));
+        }
+        return;
+
+    default:
+        break;
+    }
+    coap_log(DEBUG, "ignoring unexpected message");
+}
+
+void _anjay_coap_async_request_handle_readable(
+        anjay_coap_async_request_t *request) {
+    if (request->state != ANJAY_COAP_ASYNC_REQUEST_WAITING) {
+        return;
+    }
+
+    // the socket is known to be readable - do not wait if it turns out that
+    // it was not a complete message, e.g. a DTLS record of a different type
+    const int original_recv_timeout =
+            _anjay_coap_socket_get_recv_timeout(request->socket);
+    _anjay_coap_socket_set_recv_timeout(request->socket, 0);
+    int result = _anjay_coap_in_get_next_message(&request->in,
+                                                 request->socket);
+    _anjay_coap_socket_set_recv_timeout(request->socket,
+                                        original_recv_timeout);
+
+    if (!result) {
+        process_msg(request, _anjay_coap_in_get_message(&request->in));
+    } else if (result == ANJAY_COAP_SOCKET_ERR_NETWORK) {
+        request->state = ANJAY_COAP_ASYNC_REQUEST_FAILED;
+    }
+}
+
+void _anjay_coap_async_request_handle_timeout(
+        anjay_coap_async_request_t *request) {
+    if (request->state != ANJAY_COAP_ASYNC_REQUEST_WAITING) {
+        return;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (_anjay_time_before(&now, &request->deadline)) {
+        return;
+    }
+
+    if (request->acknowledged) {
+        coap_log(DEBUG, "Separate Response not received in time");
+        request->state = ANJAY_COAP_ASYNC_REQUEST_FAILED;
+    } else if (request->retry_state.retry_count
+                   >= request->in.transmission_params.max_retransmit) {
+        // same limit as in send_confirmable_with_retry() in stream/client.c
+        coap_log(DEBUG, "no response after %u transmissions",
+                 request->retry_state.retry_count);
+        request->state = ANJAY_COAP_ASYNC_REQUEST_FAILED;
+    } else {
+        coap_log(DEBUG, "timeout reached, retransmitting");
+        transmit(request);
+    }
+}
+
+const anjay_coap_msg_t *
+_anjay_coap_async_request_response(const anjay_coap_async_request_t *request) {
+    if (request->state != ANJAY_COAP_ASYNC_REQUEST_FINISHED) {
+        return NULL;
+    }
+    return _anjay_coap_in_get_message(&request->in);
+}
+
+void _anjay_coap_async_request_cleanup(anjay_coap_async_request_t **request) {
+    if (!request || !*request) {
+        return;
+    }
+    if ((*request)->socket) {
+        // the backend socket is owned by the caller
+        _anjay_coap_socket_set_backend((*request)->socket, NULL);
+        _anjay_coap_socket_cleanup(&(*request)->socket);
+    }
+    free((*request)->in.buffer);
+    free((*request)->msg);
+    free(*request);
+    *request = NULL;
+}
+
+#ifdef ANJAY_TEST
+#include "test/async_request.c"
+#endif // ANJAY_TEST
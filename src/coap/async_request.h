@@ -0,0 +1,127 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_COAP_ASYNC_REQUEST_H
+#define ANJAY_COAP_ASYNC_REQUEST_H
+
+#include <time.h>
+
+#include <avsystem/commons/net.h>
+
+#include "msg.h"
+#include "rtt.h"
+#include "stream.h"
+#include "utils.h"
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * A Confirmable request that does not block the caller while waiting for the
+ * response. Unlike requests sent through the CoAP stream, any number of them
+ * may be in progress at the same time, each on its own socket.
+ *
+ * The caller is responsible for waiting until either the socket becomes
+ * readable or the deadline passes, and for calling
+ * @ref _anjay_coap_async_request_handle_readable or
+ * @ref _anjay_coap_async_request_handle_timeout accordingly.
+ */
+typedef struct anjay_coap_async_request anjay_coap_async_request_t;
+
+typedef struct {
+    avs_net_abstract_socket_t *socket;
+    const coap_transmission_params_t *tx_params;
+    /* may be NULL to use fixed timeouts */
+    coap_rtt_estimator_t *rtt_estimator;
+    /* maximum size of the request and response messages, respectively */
+    size_t out_buffer_size;
+    size_t in_buffer_size;
+    /* seeds the randomization of retransmission timeouts */
+    anjay_rand_seed_t rand_seed;
+} anjay_coap_async_request_config_t;
+
+typedef enum {
+    ANJAY_COAP_ASYNC_REQUEST_WAITING,
+    ANJAY_COAP_ASYNC_REQUEST_FINISHED,
+    ANJAY_COAP_ASYNC_REQUEST_FAILED
+} anjay_coap_async_request_state_t;
+
+/**
+ * Returned by @ref _anjay_coap_async_request_send if the request does not fit
+ * in a single message and needs to be sent using a BLOCK1 transfer, which is
+ * not supported by asynchronous requests.
+ */
+#define ANJAY_COAP_ASYNC_REQUEST_TOO_LARGE 1
+
+/**
+ * Builds a Confirmable request and sends it for the first time.
+ *
+ * @returns 0 on success, @ref ANJAY_COAP_ASYNC_REQUEST_TOO_LARGE if the message
+ *          would not fit in the output buffer or the socket MTU, or a negative
+ *          value in case of error. <c>*out_request</c> is only set on success.
+ */
+int _anjay_coap_async_request_send(
+        anjay_coap_async_request_t **out_request,
+        const anjay_coap_async_request_config_t *config,
+        const anjay_msg_details_t *details,
+        const anjay_coap_msg_identity_t *identity,
+        const void *payload,
+        size_t payload_size);
+
+anjay_coap_async_request_state_t
+_anjay_coap_async_request_state(const anjay_coap_async_request_t *request);
+
+avs_net_abstract_socket_t *
+_anjay_coap_async_request_socket(const anjay_coap_async_request_t *request);
+
+/**
+ * @returns Time at which the request needs to be retransmitted or, if the
+ *          request has been acknowledged, the Separate Response is considered
+ *          lost. Only meaningful in the WAITING state.
+ */
+struct timespec
+_anjay_coap_async_request_deadline(const anjay_coap_async_request_t *request);
+
+/**
+ * Receives a single message from the socket and matches it against the
+ * request. Unrelated Confirmable messages are answered with 5.03 Service
+ * Unavailable, just like during a blocking request.
+ */
+void _anjay_coap_async_request_handle_readable(
+        anjay_coap_async_request_t *request);
+
+/**
+ * Retransmits the request, or moves it to the FAILED state if all
+ * retransmissions have already been made. Does nothing if the deadline has
+ * not passed yet.
+ */
+void _anjay_coap_async_request_handle_timeout(
+        anjay_coap_async_request_t *request);
+
+/**
+ * @returns The response if the request is in the FINISHED state, NULL
+ *          otherwise. Remains valid until the request is cleaned up.
+ */
+const anjay_coap_msg_t *
+_anjay_coap_async_request_response(const anjay_coap_async_request_t *request);
+
+/**
+ * Frees @p request. The socket is not closed.
+ */
+void _anjay_coap_async_request_cleanup(anjay_coap_async_request_t **request);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // ANJAY_COAP_ASYNC_REQUEST_H
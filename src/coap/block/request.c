@@ -102,17 +102,17 @@ static int block_request_update_block_option(coap_block_transfer_ctx_t *ctx,
     return 0;
 }
 
-static int handle_block_options(const anjay_coap_msg_t *msg,
-                                coap_block_transfer_ctx_t *ctx) {
+static int handle_block_options(coap_block_transfer_ctx_t *ctx) {
+    const anjay_coap_opt_index_t *opts = _anjay_coap_in_get_opts(ctx->in);
     coap_block_info_t block1;
-    if (_anjay_coap_common_get_block_info(msg, COAP_BLOCK1,
+    if (_anjay_coap_common_get_block_info(opts, COAP_BLOCK1,
                                           &block1) || !block1.valid) {
         coap_log(DEBUG, "BLOCK1 missing or invalid in response to block-wise "
                  "request");
         return -1;
     }
     coap_block_info_t block2;
-    if (_anjay_coap_common_get_block_info(msg, COAP_BLOCK2,
+    if (_anjay_coap_common_get_block_info(opts, COAP_BLOCK2,
                                           &block2) || block2.valid) {
         coap_log(DEBUG, "block-wise responses to block-wise requests are not "
                  "supported");
@@ -136,7 +136,7 @@ static int handle_matching_block_response(const anjay_coap_msg_t *msg,
         return -1;
     }
 
-    return handle_block_options(msg, ctx);
+    return handle_block_options(ctx);
 }
 
 static int handle_matching_response(const anjay_coap_msg_t *msg,
@@ -64,14 +64,15 @@ static int block_recv_handler(const anjay_coap_msg_t *msg,
     anjay_coap_msg_identity_t id = _anjay_coap_common_identity_from_msg(msg);
     _anjay_coap_id_source_static_reset(ctx->id_source, &id);
 
+    const anjay_coap_opt_index_t *opts = _anjay_coap_in_get_opts(ctx->in);
     coap_block_info_t block1;
-    if (_anjay_coap_common_get_block_info(msg, COAP_BLOCK1,
+    if (_anjay_coap_common_get_block_info(opts, COAP_BLOCK1,
                                           &block1) || block1.valid) {
         *out_error_code = -ANJAY_ERR_BAD_OPTION;
         return -1;
     }
     coap_block_info_t block2;
-    if (_anjay_coap_common_get_block_info(msg, COAP_BLOCK2, &block2)
+    if (_anjay_coap_common_get_block_info(opts, COAP_BLOCK2, &block2)
             || !block2.valid) {
         *out_error_code = -ANJAY_ERR_BAD_REQUEST;
         return -1;
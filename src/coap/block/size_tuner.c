@@ -0,0 +1,101 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include "../log.h"
+#include "../msg.h"
+
+#include "size_tuner.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+uint16_t _anjay_coap_block_size_tuner_limit(
+        const coap_block_size_tuner_t *tuner,
+        uint16_t block_size) {
+    if (tuner && tuner->block_size && tuner->block_size < block_size) {
+        return tuner->block_size;
+    }
+    return block_size;
+}
+
+static void lower_block_size(coap_block_size_tuner_t *tuner,
+                             uint16_t block_size,
+                             const char *reason) {
+    uint16_t new_size = (uint16_t) (block_size / 2);
+    if (new_size < ANJAY_COAP_MSG_BLOCK_MIN_SIZE) {
+        return;
+    }
+    if (!tuner->block_size || new_size < tuner->block_size) {
+        coap_log(DEBUG, "lowering preferred block size to %u B due to %s",
+                 (unsigned) new_size, reason);
+        tuner->block_size = new_size;
+    }
+}
+
+void _anjay_coap_block_size_tuner_block_sent(coap_block_size_tuner_t *tuner,
+                                             uint16_t block_size,
+                                             unsigned retransmissions) {
+    if (!tuner) {
+        return;
+    }
+
+    if (retransmissions) {
+        tuner->clean_streak = 0;
+        if (++tuner->loss_streak >= COAP_BLOCK_SIZE_TUNER_LOSS_STREAK) {
+            tuner->loss_streak = 0;
+            lower_block_size(tuner, block_size, "packet loss");
+        }
+        return;
+    }
+
+    tuner->loss_streak = 0;
+    if (!tuner->block_size
+            || ++tuner->clean_streak < COAP_BLOCK_SIZE_TUNER_CLEAN_STREAK) {
+        return;
+    }
+    tuner->clean_streak = 0;
+    const uint16_t new_size = (uint16_t) (tuner->block_size * 2);
+    if (tuner->block_size_cap && new_size > tuner->block_size_cap) {
+        return;
+    }
+    coap_log(DEBUG, "raising preferred block size to %u B",
+             (unsigned) new_size);
+    tuner->block_size =
+            (uint16_t) (new_size >= ANJAY_COAP_MSG_BLOCK_MAX_SIZE ? 0
+                                                                  : new_size);
+}
+
+void _anjay_coap_block_size_tuner_msg_too_long(coap_block_size_tuner_t *tuner,
+                                               uint16_t block_size) {
+    if (!tuner) {
+        return;
+    }
+    const uint16_t limit = (uint16_t) (block_size / 2);
+    if (limit < ANJAY_COAP_MSG_BLOCK_MIN_SIZE) {
+        return;
+    }
+    lower_block_size(tuner, block_size, "datagram size limit");
+    if (!tuner->block_size_cap || limit < tuner->block_size_cap) {
+        tuner->block_size_cap = limit;
+    }
+    tuner->clean_streak = 0;
+    tuner->loss_streak = 0;
+}
+
+#ifdef ANJAY_TEST
+#include "../test/block_size_tuner.c"
+#endif // ANJAY_TEST
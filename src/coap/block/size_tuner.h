@@ -0,0 +1,83 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_COAP_BLOCK_SIZE_TUNER_H
+#define ANJAY_COAP_BLOCK_SIZE_TUNER_H
+
+#include <stdint.h>
+
+#include "../../utils.h"
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * Per-connection block size preference, adjusted based on how well blocks of
+ * a given size get through:
+ *
+ * - a datagram rejected with EMSGSIZE (path MTU lower than expected) halves
+ *   the block size immediately and caps it for the lifetime of the
+ *   connection,
+ *
+ * - @ref COAP_BLOCK_SIZE_TUNER_LOSS_STREAK consecutive blocks that needed a
+ *   retransmission halve the block size - large datagrams that get fragmented
+ *   on the IP layer are much more likely to be lost,
+ *
+ * - after @ref COAP_BLOCK_SIZE_TUNER_CLEAN_STREAK consecutive blocks delivered
+ *   without retransmissions, the block size is doubled again (up to the cap).
+ *
+ * Block sizes are only ever lowered in the middle of a block-wise transfer;
+ * increased preference is applied to subsequent transfers.
+ *
+ * A zero-initialized tuner is valid and imposes no limit.
+ */
+typedef struct {
+    /* preferred block size; 0 if not limited */
+    uint16_t block_size;
+    /* upper limit learned from EMSGSIZE errors; 0 if not limited */
+    uint16_t block_size_cap;
+    uint16_t clean_streak;
+    uint16_t loss_streak;
+} coap_block_size_tuner_t;
+
+#define COAP_BLOCK_SIZE_TUNER_LOSS_STREAK 2
+#define COAP_BLOCK_SIZE_TUNER_CLEAN_STREAK 16
+
+/**
+ * Returns the block size to use instead of @p block_size, which is always
+ * lower or equal to it.
+ */
+uint16_t _anjay_coap_block_size_tuner_limit(
+        const coap_block_size_tuner_t *tuner,
+        uint16_t block_size);
+
+/**
+ * Records that a block of @p block_size bytes was delivered, after
+ * @p retransmissions retransmissions.
+ */
+void _anjay_coap_block_size_tuner_block_sent(coap_block_size_tuner_t *tuner,
+                                             uint16_t block_size,
+                                             unsigned retransmissions);
+
+/**
+ * Records that sending a block of @p block_size bytes failed because the
+ * datagram was too large.
+ */
+void _anjay_coap_block_size_tuner_msg_too_long(coap_block_size_tuner_t *tuner,
+                                               uint16_t block_size);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // ANJAY_COAP_BLOCK_SIZE_TUNER_H
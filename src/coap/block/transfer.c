@@ -88,6 +88,47 @@ static uint16_t calculate_proposed_block_size(uint16_t original_block_size,
     return original_block_size;
 }
 
+static int overwrite_block_option(anjay_coap_msg_info_t *info,
+                                  const coap_block_info_t *block) {
+    uint16_t opt_num = _anjay_coap_opt_num_from_block_type(block->type);
+
+    _anjay_coap_msg_info_opt_remove_by_number(info, opt_num);
+    return _anjay_coap_msg_info_opt_block(info, block);
+}
+
+static int get_block_headers_storage_size(anjay_coap_msg_info_t *info,
+                                          const coap_block_info_t *block,
+                                          size_t *out_storage_size) {
+    coap_block_info_t temporary_block = *block;
+    temporary_block.seq_num = ANJAY_COAP_BLOCK_MAX_SEQ_NUMBER;
+    int result = overwrite_block_option(info, &temporary_block);
+    if (result) {
+        return result;
+    }
+
+    *out_storage_size = _anjay_coap_msg_info_get_storage_size(info);
+
+    return overwrite_block_option(info, block);
+}
+
+static void reserve_block_headroom(coap_block_transfer_ctx_t *ctx) {
+    size_t headers_size;
+    if (get_block_headers_storage_size(&ctx->info, &ctx->block,
+                                       &headers_size)) {
+        return;
+    }
+
+    /* Leaving space for headers in front of each block lets them be sent
+     * straight from the block builder buffer. The headroom MUST leave enough
+     * space to append some payload after a full block is stored. */
+    size_t headroom = headers_size + sizeof(ANJAY_COAP_PAYLOAD_MARKER);
+    size_t capacity = ctx->block_builder.payload_capacity;
+    if (headroom + ctx->block.size >= capacity) {
+        headroom = capacity - ctx->block.size - 1;
+    }
+    _anjay_coap_block_builder_set_headroom(&ctx->block_builder, headroom);
+}
+
 coap_block_transfer_ctx_t *
 _anjay_coap_block_transfer_new(uint16_t max_block_size,
                                coap_input_buffer_t *in,
@@ -102,8 +143,10 @@ _anjay_coap_block_transfer_new(uint16_t max_block_size,
     assert(id_source);
     assert(block_recv_handler);
 
-    uint16_t block_size_considering_mtu =
-            calculate_proposed_block_size(max_block_size, out);
+    uint16_t block_size_considering_mtu = calculate_proposed_block_size(
+            _anjay_coap_block_size_tuner_limit(in->block_size_tuner,
+                                               max_block_size),
+            out);
     if (block_size_considering_mtu == 0) {
         return NULL;
     }
@@ -133,6 +176,7 @@ _anjay_coap_block_transfer_new(uint16_t max_block_size,
     };
 
     out->info = _anjay_coap_msg_info_init();
+    reserve_block_headroom(ctx);
     return ctx;
 }
 
@@ -150,9 +194,11 @@ typedef struct {
 } block_recv_data_t;
 
 static int block_recv(const anjay_coap_msg_t *msg,
+                      const anjay_coap_opt_index_t *opts,
                       void *data_,
                       bool *out_wait_for_next,
                       uint8_t *out_error_code) {
+    (void) opts;
     block_recv_data_t *data = (block_recv_data_t *)data_;
     return data->ctx->block_recv_handler(msg, data->sent_msg, data->ctx,
                                          out_wait_for_next, out_error_code);
@@ -192,21 +238,31 @@ static int accept_response_with_timeout(coap_block_transfer_ctx_t *ctx,
     return result ? result : handler_retval;
 }
 
+typedef struct {
+    /* block message without payload */
+    const anjay_coap_msg_t *headers;
+    /* payload stored in the block builder buffer */
+    void *payload;
+    size_t payload_size;
+    size_t payload_headroom;
+} block_packet_t;
+
 static int send_block_msg(coap_block_transfer_ctx_t *ctx,
-                          const anjay_coap_msg_t *msg) {
+                          const block_packet_t *packet,
+                          unsigned *out_retransmissions) {
     coap_log(TRACE, "sending block %u (size %u, payload size %lu), has_more=%d\n",
              ctx->block.seq_num, ctx->block.size,
-             (unsigned long)_anjay_coap_msg_payload_length(msg),
+             (unsigned long)packet->payload_size,
              ctx->block.has_more);
 
     coap_retry_state_t retry_state = { .retry_count = 0, .recv_timeout_ms = 0 };
     int result = 0;
     do {
-        _anjay_coap_common_update_retry_state(&retry_state,
-                                              &ctx->in->transmission_params,
-                                              &ctx->in->rand_seed);
+        _anjay_coap_common_update_retry_state(&retry_state, ctx->in);
 
-        if ((result = _anjay_coap_socket_send(ctx->socket, msg))) {
+        if ((result = _anjay_coap_socket_send_with_payload(
+                ctx->socket, packet->headers, packet->payload,
+                packet->payload_size, packet->payload_headroom))) {
             coap_log(ERROR, "cannot send block message");
             break;
         }
@@ -214,7 +270,7 @@ static int send_block_msg(coap_block_transfer_ctx_t *ctx,
         if (!should_wait_for_response(ctx)) {
             break;
         } else {
-            result = accept_response_with_timeout(ctx, msg,
+            result = accept_response_with_timeout(ctx, packet->headers,
                                                   retry_state.recv_timeout_ms);
         }
 
@@ -227,7 +283,13 @@ static int send_block_msg(coap_block_transfer_ctx_t *ctx,
     } while (retry_state.retry_count
                 < ctx->in->transmission_params.max_retransmit);
 
+    *out_retransmissions = retry_state.retry_count - 1;
     if (!result) {
+        if (ctx->block.type == COAP_BLOCK1) {
+            /* only BLOCK1 exchanges are initiated by us, so only these are
+             * meaningful RTT samples */
+            _anjay_coap_common_retry_state_complete(&retry_state, ctx->in);
+        }
         ctx->timed_out = false;
         ctx->num_sent_blocks++;
     }
@@ -235,28 +297,26 @@ static int send_block_msg(coap_block_transfer_ctx_t *ctx,
     return result;
 }
 
-static int overwrite_block_option(anjay_coap_msg_info_t *info,
-                                  const coap_block_info_t *block) {
-    uint16_t opt_num = _anjay_coap_opt_num_from_block_type(block->type);
-
-    _anjay_coap_msg_info_opt_remove_by_number(info, opt_num);
-    return _anjay_coap_msg_info_opt_block(info, block);
-}
-
 static int prepare_block(coap_block_transfer_ctx_t *ctx,
                          anjay_coap_aligned_msg_buffer_t *buffer,
                          size_t buffer_size,
-                         const anjay_coap_msg_t **out_msg) {
+                         block_packet_t *out_packet) {
     ctx->info.identity = _anjay_coap_id_source_get(ctx->id_source);
     int result = overwrite_block_option(&ctx->info, &ctx->block);
     if (result) {
         return result;
     }
 
-    *out_msg = _anjay_coap_block_builder_build(&ctx->block_builder, &ctx->info,
-                                               ctx->block.size,
-                                               buffer, buffer_size);
-    return 0;
+    out_packet->payload_size = _anjay_coap_block_builder_peek(
+            &ctx->block_builder, ctx->block.size, &out_packet->payload,
+            &out_packet->payload_headroom);
+    if (!out_packet->payload_size) {
+        return -1;
+    }
+
+    out_packet->headers = _anjay_coap_msg_build_without_payload(
+            buffer, buffer_size, &ctx->info);
+    return out_packet->headers ? 0 : -1;
 }
 
 static bool has_full_intermediate_block(const coap_block_transfer_ctx_t *ctx) {
@@ -266,27 +326,87 @@ static bool has_full_intermediate_block(const coap_block_transfer_ctx_t *ctx) {
            > ctx->block.size;
 }
 
+/**
+ * Lowers the size of blocks sent from now on. The offset of the next block
+ * stays the same, so it is always valid to do so between blocks.
+ */
+static int shrink_block_size(coap_block_transfer_ctx_t *ctx,
+                             uint16_t new_size) {
+    assert(new_size < ctx->block.size);
+    uint32_t size_ratio = ctx->block.size / new_size;
+    if (new_size < ANJAY_COAP_MSG_BLOCK_MIN_SIZE
+            || ctx->block.seq_num
+                    > ANJAY_COAP_BLOCK_MAX_SEQ_NUMBER / size_ratio) {
+        return -1;
+    }
+
+    coap_log(DEBUG, "lowering block size from %u to %u B",
+             ctx->block.size, new_size);
+    ctx->block.seq_num *= size_ratio;
+    ctx->block.size = new_size;
+    return 0;
+}
+
+static void apply_preferred_block_size(coap_block_transfer_ctx_t *ctx) {
+    uint16_t preferred_size = _anjay_coap_block_size_tuner_limit(
+            ctx->in->block_size_tuner, ctx->block.size);
+    if (preferred_size < ctx->block.size) {
+        shrink_block_size(ctx, preferred_size);
+    }
+}
+
 static int send_next_block(coap_block_transfer_ctx_t *ctx,
                            anjay_coap_aligned_msg_buffer_t *buffer,
                            size_t buffer_size) {
     ctx->info.identity = _anjay_coap_id_source_get(ctx->id_source);
 
-    const anjay_coap_msg_t *msg = NULL;
+    block_packet_t packet;
+    uint16_t block_size;
+    bool waits_for_response;
+    unsigned retransmissions = 0;
     int result;
 
     do {
-        result = prepare_block(ctx, buffer, buffer_size, &msg);
+        apply_preferred_block_size(ctx);
+        if (!ctx->block.has_more && has_full_intermediate_block(ctx)) {
+            /* block size got lowered and what was supposed to be the last
+             * block no longer fits */
+            ctx->block.has_more = true;
+        }
+
+        result = prepare_block(ctx, buffer, buffer_size, &packet);
         if (result) {
             return result;
         }
 
-        assert(msg);
-        result = send_block_msg(ctx, msg);
+        block_size = ctx->block.size;
+        waits_for_response = should_wait_for_response(ctx);
+        unsigned msg_retransmissions;
+        result = send_block_msg(ctx, &packet, &msg_retransmissions);
+        retransmissions += msg_retransmissions;
+
+        if (result == ANJAY_COAP_SOCKET_ERR_MSG_TOO_LONG) {
+            _anjay_coap_block_size_tuner_msg_too_long(
+                    ctx->in->block_size_tuner, block_size);
+            if (!shrink_block_size(ctx, (uint16_t) (block_size / 2))) {
+                result = BLOCK_TRANSFER_RESULT_RETRY;
+            }
+        } else if (result == BLOCK_TRANSFER_RESULT_RETRY
+                && ctx->block.size == block_size) {
+            /* the peer asked for the same block again, so our response got
+             * lost; not to be confused with block size renegotiation */
+            ++retransmissions;
+        }
     } while (result == BLOCK_TRANSFER_RESULT_RETRY);
 
+    if (!result && waits_for_response) {
+        _anjay_coap_block_size_tuner_block_sent(ctx->in->block_size_tuner,
+                                                block_size, retransmissions);
+    }
+
     if (!result) {
         _anjay_coap_block_builder_next(&ctx->block_builder,
-                                       _anjay_coap_msg_payload_length(msg));
+                                       packet.payload_size);
     }
 
     return result;
@@ -309,34 +429,22 @@ static int flush_blocks_with_buffer(coap_block_transfer_ctx_t *ctx,
     }
 
     if (!result && final_block_action == FINAL_BLOCK_SEND) {
-        ctx->block.has_more = false;
-        result = send_next_block(ctx, buffer, buffer_size);
+        /* block size might get lowered while sending, in which case the final
+         * block turns out to be an intermediate one */
+        do {
+            ctx->block.has_more = false;
+            result = send_next_block(ctx, buffer, buffer_size);
+        } while (!result && ctx->block.has_more);
     }
 
     return result;
 }
 
-static int get_block_packet_total_size(anjay_coap_msg_info_t *info,
-                                       const coap_block_info_t *block,
-                                       size_t *out_storage_size) {
-    coap_block_info_t temporary_block = *block;
-    temporary_block.seq_num = ANJAY_COAP_BLOCK_MAX_SEQ_NUMBER;
-    int result = overwrite_block_option(info, &temporary_block);
-    if (result) {
-        return result;
-    }
-
-    *out_storage_size =
-            _anjay_coap_msg_info_get_packet_storage_size(info, block->size);
-
-    return overwrite_block_option(info, block);
-}
-
 static int flush_blocks(coap_block_transfer_ctx_t *ctx,
                         final_block_action_t final_block_action) {
     size_t storage_size;
-    int result = get_block_packet_total_size(&ctx->info, &ctx->block,
-                                             &storage_size);
+    int result = get_block_headers_storage_size(&ctx->info, &ctx->block,
+                                                &storage_size);
     if (result) {
         return result;
     }
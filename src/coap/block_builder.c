@@ -57,18 +57,24 @@ static void *payload_write_ptr(anjay_coap_block_builder_t *builder) {
 }
 
 static void shift_payload(anjay_coap_block_builder_t *builder) {
-    if (builder->read_offset == 0) {
+    if (builder->read_offset <= builder->headroom) {
         return;
     }
 
     size_t unread_bytes = _anjay_coap_block_builder_payload_remaining(builder);
     if (unread_bytes > 0) {
-        memmove(builder->payload_buffer, payload_read_ptr(builder),
-                unread_bytes);
+        memmove((uint8_t*)builder->payload_buffer + builder->headroom,
+                payload_read_ptr(builder), unread_bytes);
     }
 
-    builder->read_offset = 0;
-    builder->write_offset = unread_bytes;
+    builder->read_offset = builder->headroom;
+    builder->write_offset = builder->headroom + unread_bytes;
+}
+
+void _anjay_coap_block_builder_set_headroom(anjay_coap_block_builder_t *builder,
+                                            size_t headroom) {
+    assert(headroom < builder->payload_capacity);
+    builder->headroom = headroom;
 }
 
 size_t
@@ -92,50 +98,22 @@ size_t _anjay_coap_block_builder_payload_remaining(
     return builder->write_offset - builder->read_offset;
 }
 
-const anjay_coap_msg_t *
-_anjay_coap_block_builder_build(anjay_coap_block_builder_t *builder,
-                                const anjay_coap_msg_info_t *info,
-                                size_t block_size,
-                                anjay_coap_aligned_msg_buffer_t *buffer,
-                                size_t buffer_size) {
-    assert(buffer_size
-           >= _anjay_coap_msg_info_get_packet_storage_size(info, block_size));
+size_t _anjay_coap_block_builder_peek(anjay_coap_block_builder_t *builder,
+                                      size_t block_size,
+                                      void **out_payload,
+                                      size_t *out_headroom) {
     assert(block_size < builder->payload_capacity
            && "payload buffer MUST be able to hold more than a single block");
 
-
     if (builder->read_offset == builder->write_offset) {
         coap_log(WARNING, "no payload data to extract!");
-        return NULL;
-    }
-
-    anjay_coap_msg_builder_t msg_builder;
-    if (_anjay_coap_msg_builder_init(&msg_builder, buffer, buffer_size, info)) {
-        assert(0 && "Failed to init msg_builder");
-        return NULL;
-    }
-
-    size_t bytes_available = 0;
-    {
-        size_t block_builder_payload_remaining =
-                _anjay_coap_block_builder_payload_remaining(builder);
-        size_t msg_builder_payload_remaining =
-                _anjay_coap_msg_builder_payload_remaining(&msg_builder);
-        bytes_available = ANJAY_MIN(block_builder_payload_remaining,
-                                    msg_builder_payload_remaining);
-    }
-    size_t bytes_to_write = ANJAY_MIN(bytes_available, block_size);
-    assert(builder->read_offset + bytes_to_write <= builder->write_offset);
-
-    size_t bytes_written = _anjay_coap_msg_builder_payload(
-            &msg_builder, payload_read_ptr(builder), bytes_to_write);
-
-    if (bytes_to_write != bytes_written) {
-        assert(0 && "Could not flush the payload");
-        return NULL;
+        return 0;
     }
 
-    return _anjay_coap_msg_builder_get_msg(&msg_builder);
+    *out_payload = payload_read_ptr(builder);
+    *out_headroom = builder->read_offset;
+    return ANJAY_MIN(_anjay_coap_block_builder_payload_remaining(builder),
+                     block_size);
 }
 
 void _anjay_coap_block_builder_next(anjay_coap_block_builder_t *builder,
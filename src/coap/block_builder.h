@@ -29,6 +29,11 @@ typedef struct anjay_coap_block_builder {
 
     size_t read_offset;
     size_t write_offset;
+
+    /* Number of bytes left unused in front of the payload whenever it is
+     * moved to the beginning of the buffer, so that headers of the next block
+     * can be prepended to it in place. */
+    size_t headroom;
 } anjay_coap_block_builder_t;
 
 /**
@@ -49,30 +54,37 @@ size_t _anjay_coap_block_builder_payload_remaining(
         const anjay_coap_block_builder_t *builder);
 
 /**
- * Retrieves a message containing next payload block.
+ * Sets the number of bytes that shall be kept free in front of the stored
+ * payload when the builder compacts its buffer.
+ *
+ * NOTE: @p headroom MUST be smaller than the free space that remains in the
+ * buffer after storing a single block of payload, otherwise appending payload
+ * would never make progress.
+ */
+void _anjay_coap_block_builder_set_headroom(anjay_coap_block_builder_t *builder,
+                                            size_t headroom);
+
+/**
+ * Retrieves a pointer to the next payload block, without copying it.
  *
- * NOTE: Repeated calls to this function return messages with the same payload
- * until @ref _anjay_coap_block_builder_next is called.
+ * NOTE: Repeated calls to this function return the same payload until
+ * @ref _anjay_coap_block_builder_next is called.
  *
- * @param builder     Block builder object to retrieve payload from.
- * @param info        Message headers to set for the packet.
- * @param block_size  Size of the payload to include in constructed
- *                    message.
- * @param buffer      Storage for the constructed message.
- * @param buffer_size @p buffer capacity in bytes.
- *                    WARNING: @p buffer must be able to hold at least
- *                    <c>_anjay_coap_msg_info_get_packet_storage_size(info)</c>
- *                    bytes.
+ * @param[in]  builder      Block builder object to retrieve payload from.
+ * @param[in]  block_size   Maximum size of the block.
+ * @param[out] out_payload  Set to the start of the next payload block.
+ * @param[out] out_headroom Set to the number of bytes directly preceding
+ *                          @p out_payload that are no longer used by the
+ *                          builder and may be overwritten by the caller, e.g.
+ *                          with message headers.
  *
- * @returns A pointer to the message constructed inside @p buffer on success,
- *          NULL if the builder contains no payload data.
+ * @returns Size of the payload block, 0 if the builder contains no payload
+ *          data.
  */
-const anjay_coap_msg_t *
-_anjay_coap_block_builder_build(anjay_coap_block_builder_t *builder,
-                                const anjay_coap_msg_info_t *info,
-                                size_t block_size,
-                                anjay_coap_aligned_msg_buffer_t *buffer,
-                                size_t buffer_size);
+size_t _anjay_coap_block_builder_peek(anjay_coap_block_builder_t *builder,
+                                      size_t block_size,
+                                      void **out_payload,
+                                      size_t *out_headroom);
 
 /**
  * Discards first @p block_size bytes of stored payload, so that following calls
@@ -93,7 +105,7 @@ void _anjay_coap_block_builder_next(anjay_coap_block_builder_t *builder,
  *
  * @returns Number of bytes successfully written. If the value is not equal to
  *          passed @p payload_size, the builder has to be emptied by calling
- *          @p _anjay_coap_block_builder_build_next before more payload can be
+ *          @ref _anjay_coap_block_builder_next before more payload can be
  *          inserted into @p builder.
  */
 size_t
@@ -285,6 +285,93 @@ bool _anjay_coap_msg_is_valid(const anjay_coap_msg_t *msg) {
                 || msg->length == ANJAY_COAP_MSG_MIN_SIZE);
 }
 
+int _anjay_coap_opt_index_build(anjay_coap_opt_index_t *out_index,
+                                const anjay_coap_msg_t *msg) {
+    out_index->msg = msg;
+    out_index->num_opts = 0;
+
+    anjay_coap_opt_iterator_t optit = _anjay_coap_opt_begin(msg);
+    for (; !_anjay_coap_opt_end(&optit); _anjay_coap_opt_next(&optit)) {
+        if (out_index->num_opts >= ANJAY_ARRAY_SIZE(out_index->entries)) {
+            coap_log(DEBUG, "too many options (more than %u)",
+                     (unsigned) ANJAY_ARRAY_SIZE(out_index->entries));
+            out_index->num_opts = 0;
+            return -1;
+        }
+
+        anjay_coap_opt_index_entry_t *entry =
+                &out_index->entries[out_index->num_opts++];
+        entry->number = (uint16_t) _anjay_coap_opt_number(&optit);
+        entry->offset = (uint32_t) ((const uint8_t *) optit.curr_opt
+                                    - msg->content);
+        entry->length = _anjay_coap_opt_content_length(optit.curr_opt);
+    }
+
+    const uint8_t *end = (const uint8_t *) optit.curr_opt;
+    if (end < (const uint8_t *) &msg->header + msg->length) {
+        assert(*end == ANJAY_COAP_PAYLOAD_MARKER);
+        ++end;
+    }
+    out_index->payload_offset = (uint32_t) (end - msg->content);
+    return 0;
+}
+
+size_t _anjay_coap_opt_index_lower_bound(const anjay_coap_opt_index_t *index,
+                                         uint16_t opt_number) {
+    size_t lo = 0;
+    size_t hi = index->num_opts;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index->entries[mid].number < opt_number) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+int _anjay_coap_opt_index_find_unique(const anjay_coap_opt_index_t *index,
+                                      uint16_t opt_number,
+                                      const anjay_coap_opt_t **out_opt) {
+    size_t entry = _anjay_coap_opt_index_lower_bound(index, opt_number);
+    if (entry >= index->num_opts
+            || index->entries[entry].number != opt_number) {
+        *out_opt = NULL;
+        return -1;
+    }
+
+    *out_opt = _anjay_coap_opt_index_get(index, entry);
+    if (entry + 1 < index->num_opts
+            && index->entries[entry + 1].number == opt_number) {
+        // multiple options with such opt_number
+        return -1;
+    }
+    return 0;
+}
+
+const anjay_coap_opt_t *
+_anjay_coap_opt_index_find_next(const anjay_coap_opt_index_t *index,
+                                uint16_t opt_number,
+                                const anjay_coap_opt_t *prev_opt) {
+    size_t entry = _anjay_coap_opt_index_lower_bound(index, opt_number);
+    if (prev_opt) {
+        uint32_t prev_offset = (uint32_t) ((const uint8_t *) prev_opt
+                                           - index->msg->content);
+        while (entry < index->num_opts
+                && index->entries[entry].number == opt_number
+                && index->entries[entry].offset <= prev_offset) {
+            ++entry;
+        }
+    }
+
+    if (entry >= index->num_opts
+            || index->entries[entry].number != opt_number) {
+        return NULL;
+    }
+    return _anjay_coap_opt_index_get(index, entry);
+}
+
 static const char *msg_type_string(anjay_coap_msg_type_t type) {
      static const char *TYPES[] = {
          "CONFIRMABLE",
@@ -211,6 +211,30 @@ typedef struct anjay_coap_opt_iterator {
         NULL, NULL, 0 \
     }
 
+/**
+ * Maximum number of options in a message that can be indexed, configurable
+ * with the MAX_COAP_OPTIONS CMake option.
+ */
+#define ANJAY_COAP_OPT_INDEX_MAX_OPTS ANJAY_MAX_COAP_OPTIONS
+
+typedef struct anjay_coap_opt_index_entry {
+    uint16_t number;
+    uint32_t offset; // of the option header, relative to msg->content
+    uint32_t length; // of the option value
+} anjay_coap_opt_index_entry_t;
+
+/**
+ * Option table of a received message, built in a single pass over its
+ * options. Entries are sorted by option number, in the order they appear
+ * in the message.
+ */
+typedef struct anjay_coap_opt_index {
+    const anjay_coap_msg_t *msg;
+    size_t num_opts;
+    uint32_t payload_offset; // relative to msg->content
+    anjay_coap_opt_index_entry_t entries[ANJAY_COAP_OPT_INDEX_MAX_OPTS];
+} anjay_coap_opt_index_t;
+
 /**
  * @param msg Message to retrieve ID from.
  * @returns Message ID in the host byte order.
@@ -316,6 +340,81 @@ size_t _anjay_coap_msg_payload_length(const anjay_coap_msg_t *msg);
  */
 bool _anjay_coap_msg_is_valid(const anjay_coap_msg_t *msg);
 
+/**
+ * Builds an option table of @p msg in @p out_index . The index refers to
+ * @p msg memory, so it is only valid as long as @p msg is.
+ *
+ * Note: this function is NOT SAFE to use on invalid messages.
+ *
+ * @param[out] out_index Index to fill.
+ * @param      msg       Message to operate on.
+ *
+ * @returns 0 on success, -1 if @p msg contains more than
+ *          @ref ANJAY_COAP_OPT_INDEX_MAX_OPTS options.
+ */
+int _anjay_coap_opt_index_build(anjay_coap_opt_index_t *out_index,
+                                const anjay_coap_msg_t *msg);
+
+/**
+ * @param index Index to operate on.
+ * @param entry Index of the entry, 0 <= @p entry < index->num_opts.
+ * @returns Pointer to the option described by @p entry.
+ */
+static inline const anjay_coap_opt_t *
+_anjay_coap_opt_index_get(const anjay_coap_opt_index_t *index, size_t entry) {
+    assert(entry < index->num_opts);
+    return (const anjay_coap_opt_t *)
+            (index->msg->content + index->entries[entry].offset);
+}
+
+/**
+ * @param index      Index to operate on.
+ * @param opt_number Option number to look for.
+ * @returns Index of the first entry with number not less than @p opt_number,
+ *          or index->num_opts if there is no such entry.
+ */
+size_t _anjay_coap_opt_index_lower_bound(const anjay_coap_opt_index_t *index,
+                                         uint16_t opt_number);
+
+/**
+ * Equivalent of @ref _anjay_coap_msg_find_unique_opt that uses the option
+ * table instead of scanning the message.
+ */
+int _anjay_coap_opt_index_find_unique(const anjay_coap_opt_index_t *index,
+                                      uint16_t opt_number,
+                                      const anjay_coap_opt_t **out_opt);
+
+/**
+ * @param index      Index to operate on.
+ * @param opt_number Option number to look for.
+ * @param prev_opt   Option previously returned by this function, or NULL to
+ *                   look for the first one.
+ * @returns Next option with number @p opt_number that follows @p prev_opt ,
+ *          or NULL if there are no more such options.
+ */
+const anjay_coap_opt_t *
+_anjay_coap_opt_index_find_next(const anjay_coap_opt_index_t *index,
+                                uint16_t opt_number,
+                                const anjay_coap_opt_t *prev_opt);
+
+/**
+ * @returns Pointer to the start of the payload of the indexed message, or
+ *          end-of-message if it does not contain payload.
+ */
+static inline const void *
+_anjay_coap_opt_index_payload(const anjay_coap_opt_index_t *index) {
+    return index->msg->content + index->payload_offset;
+}
+
+/**
+ * @returns Payload size of the indexed message, in bytes.
+ */
+static inline size_t
+_anjay_coap_opt_index_payload_length(const anjay_coap_opt_index_t *index) {
+    return (size_t)index->msg->length - sizeof(index->msg->header)
+            - index->payload_offset;
+}
+
 /**
  * Prints the @p msg content to standard output.
  *
@@ -200,14 +200,16 @@ _anjay_coap_msg_builder_reset(anjay_coap_msg_builder_t *builder,
         return -1;
     }
 
-    anjay_coap_msg_info_opt_t *opt;
+    const anjay_coap_msg_info_opt_t *opts = _anjay_coap_msg_info_opts(header);
     uint16_t prev_opt_num = 0;
-    AVS_LIST_FOREACH(opt, header->options_) {
+    for (size_t i = 0; i < header->num_options_; ++i) {
+        const anjay_coap_msg_info_opt_t *opt = &opts[i];
         assert(prev_opt_num <= opt->number);
 
         uint16_t delta = (uint16_t)(opt->number - prev_opt_num);
-        if (append_option(&builder->msg_buffer,
-                          delta, opt->data, opt->data_size)) {
+        if (append_option(&builder->msg_buffer, delta,
+                          _anjay_coap_msg_info_opt_data(header, opt),
+                          opt->data_size)) {
             return -1;
         }
         prev_opt_num = opt->number;
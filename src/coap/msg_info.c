@@ -31,18 +31,80 @@ const anjay_coap_msg_t _ANJAY_COAP_EMPTY_MSG_TEMPLATE = {
 
 void
 _anjay_coap_msg_info_reset(anjay_coap_msg_info_t *info) {
-    AVS_LIST_CLEAR(&info->options_);
-
+    free(info->options_heap_);
+    free(info->options_data_heap_);
     *info = _anjay_coap_msg_info_init();
 }
 
-static size_t
-get_options_size_bytes(const AVS_LIST(anjay_coap_msg_info_opt_t) opts) {
+static anjay_coap_msg_info_opt_t *get_opts(anjay_coap_msg_info_t *info) {
+    return info->options_heap_ ? info->options_heap_ : info->options_inline_;
+}
+
+static uint8_t *get_opts_data(anjay_coap_msg_info_t *info) {
+    return info->options_data_heap_ ? info->options_data_heap_
+                                    : info->options_data_inline_;
+}
+
+static size_t next_capacity(size_t capacity, size_t required) {
+    while (capacity < required) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+static int ensure_opts_capacity(anjay_coap_msg_info_t *info) {
+    if (info->num_options_ < (info->options_heap_
+                                      ? info->options_heap_capacity_
+                                      : ANJAY_COAP_MSG_INFO_INLINE_OPTS)) {
+        return 0;
+    }
+    const size_t new_capacity = 2 * info->num_options_;
+    anjay_coap_msg_info_opt_t *new_opts = (anjay_coap_msg_info_opt_t *)
+            realloc(info->options_heap_, new_capacity * sizeof(*new_opts));
+    if (!new_opts) {
+        coap_log(ERROR, "out of memory");
+        return -1;
+    }
+    if (!info->options_heap_) {
+        memcpy(new_opts, info->options_inline_,
+               info->num_options_ * sizeof(*new_opts));
+    }
+    info->options_heap_ = new_opts;
+    info->options_heap_capacity_ = new_capacity;
+    return 0;
+}
+
+static int ensure_opts_data_capacity(anjay_coap_msg_info_t *info,
+                                     size_t required) {
+    const size_t capacity = info->options_data_heap_
+            ? info->options_data_heap_capacity_
+            : ANJAY_COAP_MSG_INFO_INLINE_OPTS_DATA_SIZE;
+    if (required <= capacity) {
+        return 0;
+    }
+    const size_t new_capacity = next_capacity(capacity, required);
+    uint8_t *new_data =
+            (uint8_t *) realloc(info->options_data_heap_, new_capacity);
+    if (!new_data) {
+        coap_log(ERROR, "out of memory");
+        return -1;
+    }
+    if (!info->options_data_heap_) {
+        memcpy(new_data, info->options_data_inline_,
+               info->options_data_size_);
+    }
+    info->options_data_heap_ = new_data;
+    info->options_data_heap_capacity_ = new_capacity;
+    return 0;
+}
+
+static size_t get_options_size_bytes(const anjay_coap_msg_info_t *info) {
+    const anjay_coap_msg_info_opt_t *opts = _anjay_coap_msg_info_opts(info);
     size_t size = 0;
     uint16_t prev_opt_num = 0;
 
-    const anjay_coap_msg_info_opt_t *opt;
-    AVS_LIST_FOREACH(opt, opts) {
+    for (size_t i = 0; i < info->num_options_; ++i) {
+        const anjay_coap_msg_info_opt_t *opt = &opts[i];
         assert(opt->number >= prev_opt_num);
 
         uint16_t delta = (uint16_t)(opt->number - prev_opt_num);
@@ -58,14 +120,14 @@ size_t
 _anjay_coap_msg_info_get_headers_size(const anjay_coap_msg_info_t *info) {
     return sizeof(anjay_coap_msg_header_t)
            + info->identity.token_size
-           + get_options_size_bytes(info->options_);
+           + get_options_size_bytes(info);
 }
 
 size_t
 _anjay_coap_msg_info_get_storage_size(const anjay_coap_msg_info_t *info) {
     return sizeof(anjay_coap_msg_t)
            + ANJAY_COAP_MAX_TOKEN_LENGTH
-           + get_options_size_bytes(info->options_);
+           + get_options_size_bytes(info);
 }
 
 size_t
@@ -76,15 +138,38 @@ _anjay_coap_msg_info_get_packet_storage_size(const anjay_coap_msg_info_t *info,
                            : 0);
 }
 
+static void remove_opt(anjay_coap_msg_info_t *info, size_t index) {
+    assert(index < info->num_options_);
+    anjay_coap_msg_info_opt_t *opts = get_opts(info);
+    uint8_t *data = get_opts_data(info);
+    const anjay_coap_msg_info_opt_t removed = opts[index];
+    const size_t data_end = (size_t) removed.data_offset + removed.data_size;
+
+    memmove(&data[removed.data_offset], &data[data_end],
+            info->options_data_size_ - data_end);
+    info->options_data_size_ -= removed.data_size;
+
+    memmove(&opts[index], &opts[index + 1],
+            (info->num_options_ - index - 1) * sizeof(opts[0]));
+    --info->num_options_;
+
+    for (size_t i = 0; i < info->num_options_; ++i) {
+        if (opts[i].data_offset >= data_end) {
+            opts[i].data_offset =
+                    (uint16_t) (opts[i].data_offset - removed.data_size);
+        }
+    }
+}
+
 void _anjay_coap_msg_info_opt_remove_by_number(anjay_coap_msg_info_t *info,
                                                uint16_t option_number) {
-    anjay_coap_msg_info_opt_t **opt;
-    anjay_coap_msg_info_opt_t *helper;
-    AVS_LIST_DELETABLE_FOREACH_PTR(opt, helper, &info->options_) {
-        if ((*opt)->number == option_number) {
-            AVS_LIST_DELETE(opt);
-        } else if ((*opt)->number > option_number) {
-            return;
+    const anjay_coap_msg_info_opt_t *opts = get_opts(info);
+    size_t i = 0;
+    while (i < info->num_options_ && opts[i].number <= option_number) {
+        if (opts[i].number == option_number) {
+            remove_opt(info, i);
+        } else {
+            ++i;
         }
     }
 }
@@ -155,25 +240,36 @@ int _anjay_coap_msg_info_opt_opaque(anjay_coap_msg_info_t *info,
                                     uint16_t opt_number,
                                     const void *opt_data,
                                     uint16_t opt_data_size) {
-    anjay_coap_msg_info_opt_t *opt = (anjay_coap_msg_info_opt_t*)
-            AVS_LIST_NEW_BUFFER(sizeof(*opt) + opt_data_size);
-    if (!opt) {
-        coap_log(ERROR, "out of memory");
+    if (opt_data_size > UINT16_MAX - info->options_data_size_) {
+        coap_log(ERROR, "not enough space for option %u (%u B)",
+                 opt_number, opt_data_size);
+        return -1;
+    }
+    if (ensure_opts_capacity(info)
+            || ensure_opts_data_capacity(info, info->options_data_size_
+                                                       + opt_data_size)) {
         return -1;
     }
 
+    // options are usually added in ascending order, so search from the end
+    anjay_coap_msg_info_opt_t *opts = get_opts(info);
+    size_t insert_idx = info->num_options_;
+    while (insert_idx > 0 && opts[insert_idx - 1].number > opt_number) {
+        --insert_idx;
+    }
+    memmove(&opts[insert_idx + 1], &opts[insert_idx],
+            (info->num_options_ - insert_idx) * sizeof(opts[0]));
+    ++info->num_options_;
+
+    anjay_coap_msg_info_opt_t *opt = &opts[insert_idx];
     opt->number = opt_number;
     opt->data_size = opt_data_size;
-    memcpy(opt->data, opt_data, opt_data_size);
-
-    anjay_coap_msg_info_opt_t **insert_ptr = NULL;
-    AVS_LIST_FOREACH_PTR(insert_ptr, &info->options_) {
-        if ((*insert_ptr)->number > opt->number) {
-            break;
-        }
+    opt->data_offset = (uint16_t) info->options_data_size_;
+    if (opt_data_size) {
+        memcpy(&get_opts_data(info)[opt->data_offset], opt_data,
+               opt_data_size);
     }
-
-    AVS_LIST_INSERT(insert_ptr, opt);
+    info->options_data_size_ += opt_data_size;
     return 0;
 }
 
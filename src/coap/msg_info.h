@@ -19,13 +19,29 @@
 
 #include <stdlib.h>
 
-#include <avsystem/commons/list.h>
-
 #include "msg.h"
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
-typedef struct anjay_coap_msg_info_opt anjay_coap_msg_info_opt_t;
+/**
+ * Number of options stored inside the info object itself. Further options are
+ * moved to heap-allocated storage.
+ */
+#define ANJAY_COAP_MSG_INFO_INLINE_OPTS 12
+
+/**
+ * Number of bytes of option values stored inside the info object itself.
+ * Enough for typical requests and notifications, e.g. a Register request with
+ * an endpoint name of several dozen characters. Larger option values are
+ * moved to heap-allocated storage.
+ */
+#define ANJAY_COAP_MSG_INFO_INLINE_OPTS_DATA_SIZE 128
+
+typedef struct anjay_coap_msg_info_opt {
+    uint16_t number;
+    uint16_t data_size;
+    uint16_t data_offset; // in option value storage of anjay_coap_msg_info_t
+} anjay_coap_msg_info_opt_t;
 
 typedef struct anjay_coap_msg_info {
     anjay_coap_msg_type_t type;
@@ -34,26 +50,44 @@ typedef struct anjay_coap_msg_info {
 
     /* Fields below are NOT meant to be modified directly. Use provided
      * accessor functions instead. */
-    AVS_LIST(anjay_coap_msg_info_opt_t) options_;
+
+    /* Sorted by option number; options with equal numbers are kept in order
+     * of insertion. Stored in options_inline_ until it gets full, then in
+     * options_heap_. */
+    size_t num_options_;
+    anjay_coap_msg_info_opt_t *options_heap_;
+    size_t options_heap_capacity_;
+    anjay_coap_msg_info_opt_t options_inline_[ANJAY_COAP_MSG_INFO_INLINE_OPTS];
+
+    /* Option values, stored in options_data_inline_ until it gets full, then
+     * in options_data_heap_. */
+    size_t options_data_size_;
+    uint8_t *options_data_heap_;
+    size_t options_data_heap_capacity_;
+    uint8_t options_data_inline_[ANJAY_COAP_MSG_INFO_INLINE_OPTS_DATA_SIZE];
 } anjay_coap_msg_info_t;
 
 /**
- * Initializes a @ref anjay_coap_header_msg_info_t .
+ * Initializes a @ref anjay_coap_header_msg_info_t . Inline option storage is
+ * deliberately left uninitialized, as there is no need to clear it.
  */
-#define _anjay_coap_msg_info_init() \
-    ((anjay_coap_msg_info_t){ \
-        .code = ANJAY_COAP_CODE_EMPTY, \
-        .identity = { \
-            .msg_id = 0, \
-            .token = {{0}}, \
-            .token_size = 0 \
-        }, \
-        .options_ = NULL \
-    })
+static inline anjay_coap_msg_info_t _anjay_coap_msg_info_init(void) {
+    anjay_coap_msg_info_t info;
+    info.type = ANJAY_COAP_MSG_CONFIRMABLE;
+    info.code = ANJAY_COAP_CODE_EMPTY;
+    info.identity = ANJAY_COAP_MSG_IDENTITY_EMPTY;
+    info.num_options_ = 0;
+    info.options_heap_ = NULL;
+    info.options_heap_capacity_ = 0;
+    info.options_data_size_ = 0;
+    info.options_data_heap_ = NULL;
+    info.options_data_heap_capacity_ = 0;
+    return info;
+}
 
 /**
  * Frees any memory allocated for temporary storage required by the info object.
- * Resets all header fields to defaults.
+ * Removes all options and resets all header fields to defaults.
  */
 void _anjay_coap_msg_info_reset(anjay_coap_msg_info_t *info);
 
@@ -100,6 +134,26 @@ size_t
 _anjay_coap_msg_info_get_packet_storage_size(const anjay_coap_msg_info_t *info,
                                              size_t payload_size);
 
+/**
+ * @returns Array of @ref anjay_coap_msg_info_t#num_options_ options stored in
+ *          @p info , sorted by option number.
+ */
+static inline const anjay_coap_msg_info_opt_t *
+_anjay_coap_msg_info_opts(const anjay_coap_msg_info_t *info) {
+    return info->options_heap_ ? info->options_heap_ : info->options_inline_;
+}
+
+/**
+ * @returns Pointer to the value of the @p opt option stored in @p info .
+ */
+static inline const uint8_t *
+_anjay_coap_msg_info_opt_data(const anjay_coap_msg_info_t *info,
+                              const anjay_coap_msg_info_opt_t *opt) {
+    return &(info->options_data_heap_ ? info->options_data_heap_
+                                      : info->options_data_inline_)
+            [opt->data_offset];
+}
+
 /**
  * Removes all options with given @p option_number added to @p info.
  */
@@ -184,7 +238,9 @@ int _anjay_coap_msg_info_opt_block(anjay_coap_msg_info_t *info,
  *
  * @return 0 on success, -1 in case of error:
  *         - the message code is set to @ref ANJAY_COAP_CODE_EMPTY, which must
- *           not contain any options.
+ *           not contain any options,
+ *         - values of all options would exceed 65535 bytes,
+ *         - out of memory.
  */
 int _anjay_coap_msg_info_opt_opaque(anjay_coap_msg_info_t *info,
                                     uint16_t opt_number,
@@ -112,12 +112,6 @@ static inline size_t _anjay_coap_get_opt_header_size(uint16_t opt_number_delta,
     return header_size;
 }
 
-struct anjay_coap_msg_info_opt {
-    uint16_t number;
-    uint16_t data_size;
-    uint8_t data[];
-};
-
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif // ANJAY_COAP_MSG_INTERNAL_H
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <inttypes.h>
+
+#include <anjay_modules/time.h>
+
+#include "rtt.h"
+#include "log.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+/* lower bound protects against timer granularity, upper one is the same as
+ * in CoCoA */
+#define COAP_RTT_MIN_RTO_MS 100
+#define COAP_RTT_MAX_RTO_MS 60000
+
+#define COAP_RTT_STRONG_K 4
+#define COAP_RTT_WEAK_K 1
+
+/* RTO is aged towards the default if it was not updated for 16 * RTO (when
+ * below 1 s, by doubling it) or 4 * RTO (when above 3 s, by halving its
+ * distance from 2 s) */
+#define COAP_RTT_AGING_LOW_THRESHOLD_MS 1000
+#define COAP_RTT_AGING_HIGH_THRESHOLD_MS 3000
+
+static int32_t clamp_rto(int64_t rto_ms) {
+    if (rto_ms < COAP_RTT_MIN_RTO_MS) {
+        return COAP_RTT_MIN_RTO_MS;
+    } else if (rto_ms > COAP_RTT_MAX_RTO_MS) {
+        return COAP_RTT_MAX_RTO_MS;
+    }
+    return (int32_t) rto_ms;
+}
+
+static int32_t aging_period_ms(int32_t rto_ms) {
+    if (rto_ms < COAP_RTT_AGING_LOW_THRESHOLD_MS) {
+        return 16 * rto_ms;
+    } else if (rto_ms > COAP_RTT_AGING_HIGH_THRESHOLD_MS) {
+        return 4 * rto_ms;
+    }
+    return 0;
+}
+
+static void apply_aging(coap_rtt_estimator_t *estimator,
+                        const struct timespec *now) {
+    if (!estimator->rto_ms) {
+        return;
+    }
+    int32_t period_ms;
+    while ((period_ms = aging_period_ms(estimator->rto_ms))
+            && _anjay_time_diff_ms(now, &estimator->last_update)
+                    >= period_ms) {
+        _anjay_time_add_ms(&estimator->last_update, period_ms);
+        if (estimator->rto_ms < COAP_RTT_AGING_LOW_THRESHOLD_MS) {
+            estimator->rto_ms = AVS_MIN(2 * estimator->rto_ms,
+                                        COAP_RTT_AGING_LOW_THRESHOLD_MS);
+        } else {
+            estimator->rto_ms = clamp_rto(1000 + estimator->rto_ms / 2);
+        }
+    }
+}
+
+int32_t _anjay_coap_rtt_current_rto_ms(
+        const coap_rtt_estimator_t *estimator,
+        const coap_transmission_params_t *tx_params) {
+    if (!estimator->rto_ms) {
+        return (int32_t) tx_params->ack_timeout_ms;
+    }
+    coap_rtt_estimator_t aged = *estimator;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    apply_aging(&aged, &now);
+    return aged.rto_ms;
+}
+
+int32_t _anjay_coap_rtt_initial_timeout_ms(
+        coap_rtt_estimator_t *estimator,
+        const coap_transmission_params_t *tx_params,
+        anjay_rand_seed_t *rand_seed) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    apply_aging(estimator, &now);
+
+    const int32_t rto_ms = estimator->rto_ms
+            ? estimator->rto_ms : (int32_t) tx_params->ack_timeout_ms;
+    uint32_t delta = (uint32_t) (rto_ms * (tx_params->ack_random_factor - 1.0));
+    return rto_ms + (delta ? (int32_t) (_anjay_rand32(rand_seed) % delta) : 0);
+}
+
+int32_t _anjay_coap_rtt_backoff_timeout_ms(
+        const coap_rtt_estimator_t *estimator,
+        const coap_transmission_params_t *tx_params,
+        int32_t previous_timeout_ms) {
+    const int32_t rto_ms = _anjay_coap_rtt_current_rto_ms(estimator,
+                                                          tx_params);
+    /* variable backoff factor */
+    if (rto_ms < COAP_RTT_AGING_LOW_THRESHOLD_MS) {
+        return previous_timeout_ms * 3;
+    } else if (rto_ms > COAP_RTT_AGING_HIGH_THRESHOLD_MS) {
+        return previous_timeout_ms + previous_timeout_ms / 2;
+    }
+    return previous_timeout_ms * 2;
+}
+
+static int32_t update_estimate(coap_rtt_estimate_t *estimate,
+                               int32_t rtt_ms,
+                               int k) {
+    if (!estimate->samples) {
+        estimate->srtt_ms = rtt_ms;
+        estimate->rttvar_ms = rtt_ms / 2;
+    } else {
+        int32_t error_ms = estimate->srtt_ms - rtt_ms;
+        if (error_ms < 0) {
+            error_ms = -error_ms;
+        }
+        estimate->rttvar_ms = (3 * estimate->rttvar_ms + error_ms) / 4;
+        estimate->srtt_ms = (7 * estimate->srtt_ms + rtt_ms) / 8;
+    }
+    ++estimate->samples;
+    return estimate->srtt_ms + k * estimate->rttvar_ms;
+}
+
+void _anjay_coap_rtt_update(coap_rtt_estimator_t *estimator,
+                            const coap_transmission_params_t *tx_params,
+                            int32_t rtt_ms,
+                            unsigned retransmissions) {
+    const int32_t previous_rto_ms =
+            _anjay_coap_rtt_current_rto_ms(estimator, tx_params);
+    if (rtt_ms < 0) {
+        rtt_ms = 0;
+    }
+
+    if (retransmissions == 0) {
+        int32_t rto_ms = update_estimate(&estimator->strong, rtt_ms,
+                                         COAP_RTT_STRONG_K);
+        estimator->rto_ms =
+                clamp_rto(((int64_t) rto_ms + previous_rto_ms) / 2);
+    } else if (retransmissions <= 2) {
+        int32_t rto_ms = update_estimate(&estimator->weak, rtt_ms,
+                                         COAP_RTT_WEAK_K);
+        estimator->rto_ms =
+                clamp_rto(((int64_t) rto_ms + 3 * (int64_t) previous_rto_ms)
+                          / 4);
+    } else {
+        /* RTT of such exchanges is too ambiguous to be useful */
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &estimator->last_update);
+
+    coap_log(TRACE, "RTT sample %" PRId32 " ms (%u retransmissions), "
+                    "RTO: %" PRId32 " ms",
+             rtt_ms, retransmissions, estimator->rto_ms);
+}
+
+#ifdef ANJAY_TEST
+#include "test/rtt.c"
+#endif // ANJAY_TEST
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_COAP_RTT_H
+#define ANJAY_COAP_RTT_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include "../utils.h"
+#include "utils.h"
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+typedef struct {
+    uint32_t samples;
+    int32_t srtt_ms;
+    int32_t rttvar_ms;
+} coap_rtt_estimate_t;
+
+/**
+ * Retransmission timeout estimator, following the CoCoA algorithm
+ * (draft-ietf-core-cocoa):
+ *
+ * - "strong" RTT samples come from exchanges completed without
+ *   retransmissions, "weak" ones from exchanges that needed one or two
+ *   retransmissions (measured since the initial transmission); exchanges that
+ *   needed more are not sampled,
+ *
+ * - each estimator is smoothed as in RFC 6298, with K = 4 for the strong and
+ *   K = 1 for the weak one, and blended into the overall RTO with weights
+ *   of 0.5 and 0.25, respectively,
+ *
+ * - backoff uses a variable factor: 3 for RTO < 1 s, 1.5 for RTO > 3 s and
+ *   2 otherwise,
+ *
+ * - an RTO that has not been updated for a long time decays towards the
+ *   default: if below 1 s, it is doubled (up to 1 s) after 16 * RTO; if above
+ *   3 s, it is set to 1 s + RTO / 2 after 4 * RTO.
+ *
+ * A zero-initialized estimator is valid and behaves as if RTO was equal to the
+ * ACK_TIMEOUT transmission parameter.
+ */
+typedef struct {
+    coap_rtt_estimate_t strong;
+    coap_rtt_estimate_t weak;
+    /* 0 until the first sample */
+    int32_t rto_ms;
+    struct timespec last_update;
+} coap_rtt_estimator_t;
+
+/**
+ * Returns the timeout to use after the initial transmission of a Confirmable
+ * message: current RTO multiplied by a random factor from
+ * [1, ACK_RANDOM_FACTOR).
+ */
+int32_t _anjay_coap_rtt_initial_timeout_ms(
+        coap_rtt_estimator_t *estimator,
+        const coap_transmission_params_t *tx_params,
+        anjay_rand_seed_t *rand_seed);
+
+/**
+ * Returns the timeout to use after a retransmission, given the timeout used
+ * after the previous transmission.
+ */
+int32_t _anjay_coap_rtt_backoff_timeout_ms(
+        const coap_rtt_estimator_t *estimator,
+        const coap_transmission_params_t *tx_params,
+        int32_t previous_timeout_ms);
+
+/**
+ * Feeds the estimator with an RTT sample of an exchange that completed after
+ * @p retransmissions retransmissions.
+ */
+void _anjay_coap_rtt_update(coap_rtt_estimator_t *estimator,
+                            const coap_transmission_params_t *tx_params,
+                            int32_t rtt_ms,
+                            unsigned retransmissions);
+
+/**
+ * Returns the current RTO, taking aging into account.
+ */
+int32_t _anjay_coap_rtt_current_rto_ms(
+        const coap_rtt_estimator_t *estimator,
+        const coap_transmission_params_t *tx_params);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // ANJAY_COAP_RTT_H
@@ -22,15 +22,23 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <string.h>
 
 #include <avsystem/commons/list.h>
 
 #include "log.h"
+#include "utils.h"
 
 VISIBILITY_SOURCE_BEGIN
 
 struct anjay_coap_socket {
     avs_net_abstract_socket_t *dtls_socket;
+
+    /* Used to gather headers and payload that cannot be sent in place. Kept
+     * for the whole lifetime of the socket, so that it is allocated only once
+     * for the largest datagram sent. */
+    uint8_t *gather_buffer;
+    size_t gather_buffer_capacity;
 };
 
 int _anjay_coap_socket_create(anjay_coap_socket_t **sock,
@@ -58,6 +66,7 @@ void _anjay_coap_socket_cleanup(anjay_coap_socket_t **sock) {
 
     _anjay_coap_socket_close(*sock);
     avs_net_socket_cleanup(&(*sock)->dtls_socket);
+    free((*sock)->gather_buffer);
     free(*sock);
     *sock = NULL;
 }
@@ -93,6 +102,68 @@ int _anjay_coap_socket_send(anjay_coap_socket_t *sock,
     return map_io_error(sock->dtls_socket, result, "send");
 }
 
+static int send_gathered(anjay_coap_socket_t *sock,
+                         const anjay_coap_msg_t *headers,
+                         const void *payload,
+                         size_t payload_size) {
+    const size_t headers_size = headers->length;
+    const size_t packet_size = headers_size + sizeof(ANJAY_COAP_PAYLOAD_MARKER)
+                               + payload_size;
+    if (packet_size > sock->gather_buffer_capacity) {
+        uint8_t *new_buffer =
+                (uint8_t *) realloc(sock->gather_buffer, packet_size);
+        if (!new_buffer) {
+            coap_log(ERROR, "out of memory");
+            return -1;
+        }
+        sock->gather_buffer = new_buffer;
+        sock->gather_buffer_capacity = packet_size;
+    }
+
+    uint8_t *packet = sock->gather_buffer;
+    memcpy(packet, &headers->header, headers_size);
+    packet[headers_size] = ANJAY_COAP_PAYLOAD_MARKER;
+    memcpy(packet + headers_size + 1, payload, payload_size);
+
+    int result = avs_net_socket_send(sock->dtls_socket, packet, packet_size);
+    return map_io_error(sock->dtls_socket, result, "send");
+}
+
+int _anjay_coap_socket_send_with_payload(anjay_coap_socket_t *sock,
+                                         const anjay_coap_msg_t *headers,
+                                         void *payload,
+                                         size_t payload_size,
+                                         size_t payload_headroom) {
+    assert(sock && sock->dtls_socket);
+    if (!_anjay_coap_msg_is_valid(headers)
+            || _anjay_coap_msg_payload_length(headers) > 0) {
+        coap_log(ERROR, "cannot send an invalid CoAP message\n");
+        return -1;
+    }
+
+    if (payload_size == 0) {
+        return _anjay_coap_socket_send(sock, headers);
+    }
+
+    coap_log(TRACE, "send: %s, payload: %lu B", ANJAY_COAP_MSG_SUMMARY(headers),
+             (unsigned long) payload_size);
+
+    const size_t headers_size = headers->length;
+    if (payload_headroom < headers_size + sizeof(ANJAY_COAP_PAYLOAD_MARKER)) {
+        return send_gathered(sock, headers, payload, payload_size);
+    }
+
+    uint8_t *packet = (uint8_t *) payload - headers_size
+                      - sizeof(ANJAY_COAP_PAYLOAD_MARKER);
+    memcpy(packet, &headers->header, headers_size);
+    packet[headers_size] = ANJAY_COAP_PAYLOAD_MARKER;
+
+    int result = avs_net_socket_send(
+            sock->dtls_socket, packet,
+            headers_size + sizeof(ANJAY_COAP_PAYLOAD_MARKER) + payload_size);
+    return map_io_error(sock->dtls_socket, result, "send");
+}
+
 int _anjay_coap_socket_recv(anjay_coap_socket_t *sock,
                             anjay_coap_msg_t *out_msg,
                             size_t msg_capacity) {
@@ -49,6 +49,25 @@ void _anjay_coap_socket_cleanup(anjay_coap_socket_t **sock);
 int _anjay_coap_socket_send(anjay_coap_socket_t *sock,
                             const anjay_coap_msg_t *msg);
 
+/**
+ * Sends a message consisting of @p headers (a message without payload),
+ * followed by the payload marker and @p payload_size bytes of @p payload.
+ *
+ * If the @p payload_headroom bytes directly preceding @p payload are large
+ * enough to hold serialized @p headers and the payload marker, they are
+ * overwritten with them and the datagram is sent straight from the payload
+ * buffer, without copying the payload. Otherwise, headers and payload are
+ * gathered into a buffer owned by @p sock first. That buffer is allocated on
+ * first use and reused for all further datagrams that fit in it.
+ *
+ * @returns Same values as @ref _anjay_coap_socket_send .
+ */
+int _anjay_coap_socket_send_with_payload(anjay_coap_socket_t *sock,
+                                         const anjay_coap_msg_t *headers,
+                                         void *payload,
+                                         size_t payload_size,
+                                         size_t payload_headroom);
+
 /**
  * @returns 0 on success, a negative value in case of error:
  * - ANJAY_COAP_SOCKET_ERR_TIMEOUT if the socket timeout expired, but no message
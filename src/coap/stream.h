@@ -21,11 +21,32 @@
 
 #include "socket.h"
 #include "msg_builder.h"
+#include "rtt.h"
+#include "block/size_tuner.h"
 #include "../utils.h"
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
 #define ANJAY_COAP_STREAM_EXTENSION 0x436F4150UL /* CoAP */
+#define ANJAY_STREAM_VIEW_EXTENSION 0x56696577UL /* View */
+
+/**
+ * Reads up to @p max_length bytes from @p stream without copying them.
+ * Semantics are the same as of avs_stream_read(), except that instead of
+ * filling a caller-provided buffer, <c>*out_data</c> is set to point to the
+ * data inside the stream's own buffer. That pointer is only valid until the
+ * next operation on the stream.
+ */
+typedef int
+anjay_stream_read_view_t(avs_stream_abstract_t *stream,
+                         const void **out_data,
+                         size_t *out_bytes_read,
+                         char *out_message_finished,
+                         size_t max_length);
+
+typedef struct anjay_stream_view_ext {
+    anjay_stream_read_view_t *read_view;
+} anjay_stream_view_ext_t;
 
 int _anjay_coap_stream_create(avs_stream_abstract_t **stream_,
                               anjay_coap_socket_t *socket,
@@ -68,6 +89,38 @@ int _anjay_coap_stream_set_tx_params(
         avs_stream_abstract_t *stream,
         const coap_transmission_params_t *tx_params);
 
+/**
+ * Sets the RTT estimator used to calculate retransmission timeouts of
+ * Confirmable messages sent through @p stream. The estimator is not owned by
+ * the stream. NULL disables adaptive timeouts - the transmission parameters
+ * are then used as-is.
+ */
+int _anjay_coap_stream_set_rtt_estimator(avs_stream_abstract_t *stream,
+                                         coap_rtt_estimator_t *estimator);
+
+/**
+ * Sets the block size tuner used to adjust sizes of blocks sent through
+ * @p stream. The tuner is not owned by the stream. NULL disables adjusting
+ * block sizes to observed network conditions.
+ */
+int _anjay_coap_stream_set_block_size_tuner(avs_stream_abstract_t *stream,
+                                            coap_block_size_tuner_t *tuner);
+
+/**
+ * Gets the value of the Observe option that a notification sent through
+ * @p stream right now would carry.
+ */
+int _anjay_coap_stream_get_observe_serial(avs_stream_abstract_t *stream,
+                                          uint32_t *out_serial);
+
+/**
+ * Adjusts the Observe option values of notifications sent through @p stream,
+ * so that a notification sent right now would carry @p serial. The values
+ * keep following the monotonic clock afterwards.
+ */
+int _anjay_coap_stream_set_observe_serial(avs_stream_abstract_t *stream,
+                                          uint32_t serial);
+
 int _anjay_coap_stream_setup_response(avs_stream_abstract_t *stream,
                                       const anjay_msg_details_t *details);
 
@@ -77,9 +130,25 @@ int _anjay_coap_stream_setup_request(
         const anjay_coap_token_t *token,
         size_t token_size);
 
+/**
+ * Generates a Message ID and Token using the same source as requests set up
+ * on @p stream, so that requests sent without the stream (see
+ * coap/async_request.h) do not reuse Message IDs of the ones sent through it.
+ */
+anjay_coap_msg_identity_t
+_anjay_coap_stream_next_identity(avs_stream_abstract_t *stream);
+
 int _anjay_coap_stream_set_error(avs_stream_abstract_t *stream,
                                  uint8_t code);
 
+/**
+ * Acknowledges the request currently handled by a server mode @p stream with
+ * an Empty message, so that the actual response may be sent later as a
+ * separate one. Any response set up on the stream is NOT sent - the stream is
+ * expected to be reset afterwards.
+ */
+int _anjay_coap_stream_send_empty_ack(avs_stream_abstract_t *stream);
+
 int _anjay_coap_stream_get_code(avs_stream_abstract_t *stream,
                                 uint8_t *out_code);
 int _anjay_coap_stream_get_msg_type(avs_stream_abstract_t *stream,
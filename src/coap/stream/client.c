@@ -181,9 +181,11 @@ static check_result_t check_response(coap_client_t *client,
 }
 
 static int process_received(const anjay_coap_msg_t *response,
+                            const anjay_coap_opt_index_t *opts,
                             void *client_,
                             bool *out_wait_for_next,
                             uint8_t *out_error_code) {
+    (void) opts;
     (void) out_error_code;
     assert(response);
 
@@ -263,8 +265,7 @@ static int send_and_update_retry_state(anjay_coap_socket_t *socket,
                                        coap_input_buffer_t *in,
                                        coap_retry_state_t *retry_state) {
     int result = _anjay_coap_socket_send(socket, msg);
-    _anjay_coap_common_update_retry_state(retry_state, &in->transmission_params,
-                                          &in->rand_seed);
+    _anjay_coap_common_update_retry_state(retry_state, in);
     return result;
 }
 
@@ -299,6 +300,8 @@ static int send_confirmable_with_retry(coap_client_t *client,
     assert(result <= 0 || result == COAP_CLIENT_RECEIVE_RESET);
     if (result != 0) {
         client->state = COAP_CLIENT_STATE_HAS_REQUEST_HEADER;
+    } else {
+        _anjay_coap_common_retry_state_complete(&retry_state, in);
     }
 
     assert(client->state == COAP_CLIENT_STATE_HAS_REQUEST_HEADER
@@ -367,8 +370,8 @@ int _anjay_coap_client_read(coap_client_t *client,
                             anjay_coap_socket_t *socket,
                             size_t *out_bytes_read,
                             char *out_message_finished,
-                            void *buffer,
-                            size_t buffer_length) {
+                            const void **out_data,
+                            size_t max_length) {
     int result = _anjay_coap_client_get_or_receive_msg(client, in, socket,
                                                        NULL);
     if (result) {
@@ -376,7 +379,7 @@ int _anjay_coap_client_read(coap_client_t *client,
     }
 
     _anjay_coap_in_read(in, out_bytes_read, out_message_finished,
-                        buffer, buffer_length);
+                        out_data, max_length);
     return 0;
 }
 
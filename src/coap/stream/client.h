@@ -131,8 +131,8 @@ int _anjay_coap_client_read(coap_client_t *client,
                             anjay_coap_socket_t *socket,
                             size_t *out_bytes_read,
                             char *out_message_finished,
-                            void *buffer,
-                            size_t buffer_length);
+                            const void **out_data,
+                            size_t max_length);
 
 int _anjay_coap_client_write(coap_client_t *client,
                              coap_input_buffer_t *in,
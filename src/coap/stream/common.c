@@ -38,34 +38,41 @@ static int add_string_options(anjay_coap_msg_info_t *info,
     return 0;
 }
 
+uint32_t _anjay_coap_common_observe_serial(uint32_t offset) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    // A nearly-linear, strictly monotonic timestamp with a precision of
+    // 32.768 us, wrapping every 512 seconds.
+    // Should satisfy the requirements given in OBSERVE 3.4 and 4.4
+    uint32_t ticks = ((uint32_t) now.tv_sec << 15)
+            | (uint32_t) (now.tv_nsec >> 15);
+    return (ticks + offset) & 0xFFFFFF;
+}
+
 static int add_observe_option(anjay_coap_msg_info_t *info,
                               bool observe) {
     if (observe) {
-        struct timespec now;
-        clock_gettime(CLOCK_MONOTONIC, &now);
-        // A nearly-linear, strictly monotonic timestamp with a precision of
-        // 32.768 us, wrapping every 512 seconds.
-        // Should satisfy the requirements given in OBSERVE 3.4 and 4.4
-        uint32_t value = (uint32_t) ((now.tv_sec & 0x1FF) << 15)
-                | (uint32_t) (now.tv_nsec >> 15);
-        return _anjay_coap_msg_info_opt_u32(info,
-                                            ANJAY_COAP_OPT_OBSERVE, value);
+        // messages built here are not sent through a stream, so there is no
+        // offset to apply; none of them are notifications anyway
+        return _anjay_coap_msg_info_opt_u32(
+                info, ANJAY_COAP_OPT_OBSERVE,
+                _anjay_coap_common_observe_serial(0));
     } else {
         return 0;
     }
 }
 
-int _anjay_coap_common_get_block_info(const anjay_coap_msg_t *msg,
+int _anjay_coap_common_get_block_info(const anjay_coap_opt_index_t *opts,
                                       coap_block_type_t type,
                                       coap_block_info_t *out_info) {
-    assert(msg);
+    assert(opts);
     assert(out_info);
     uint16_t opt_number = type == COAP_BLOCK1
             ? ANJAY_COAP_OPT_BLOCK1
             : ANJAY_COAP_OPT_BLOCK2;
     const anjay_coap_opt_t *opt;
     memset(out_info, 0, sizeof(*out_info));
-    if (_anjay_coap_msg_find_unique_opt(msg, opt_number, &opt)) {
+    if (_anjay_coap_opt_index_find_unique(opts, opt_number, &opt)) {
         if (opt) {
             int num = opt_number == ANJAY_COAP_OPT_BLOCK1 ? 1 : 2;
             coap_log(ERROR, "multiple BLOCK%d options found", num);
@@ -239,7 +246,8 @@ int _anjay_coap_common_recv_msg_with_timeout(anjay_coap_socket_t *socket,
             bool wait_for_next = true;
             uint8_t error_code = 0;
 
-            *out_handler_result = handle_msg(msg, handle_msg_data,
+            *out_handler_result = handle_msg(msg, _anjay_coap_in_get_opts(in),
+                                             handle_msg_data,
                                              &wait_for_next, &error_code);
             if (!wait_for_next) {
                 result = -error_code;
@@ -271,17 +279,39 @@ exit:
     return result;
 }
 
-void _anjay_coap_common_update_retry_state(
-        coap_retry_state_t *retry_state,
-        const coap_transmission_params_t *tx_params,
-        anjay_rand_seed_t *rand_seed) {
+void _anjay_coap_common_update_retry_state(coap_retry_state_t *retry_state,
+                                           coap_input_buffer_t *in) {
+    const coap_transmission_params_t *tx_params = &in->transmission_params;
     ++retry_state->retry_count;
     if (retry_state->retry_count == 1) {
-        uint32_t delta = (uint32_t) (tx_params->ack_timeout_ms *
-                (tx_params->ack_random_factor - 1.0));
-        retry_state->recv_timeout_ms = tx_params->ack_timeout_ms +
-                (int32_t) (_anjay_rand32(rand_seed) % delta);
+        clock_gettime(CLOCK_MONOTONIC, &retry_state->first_send_time);
+        if (in->rtt_estimator) {
+            retry_state->recv_timeout_ms = _anjay_coap_rtt_initial_timeout_ms(
+                    in->rtt_estimator, tx_params, &in->rand_seed);
+        } else {
+            uint32_t delta = (uint32_t) (tx_params->ack_timeout_ms *
+                    (tx_params->ack_random_factor - 1.0));
+            retry_state->recv_timeout_ms = tx_params->ack_timeout_ms +
+                    (int32_t) (_anjay_rand32(&in->rand_seed) % delta);
+        }
+    } else if (in->rtt_estimator) {
+        retry_state->recv_timeout_ms = _anjay_coap_rtt_backoff_timeout_ms(
+                in->rtt_estimator, tx_params, retry_state->recv_timeout_ms);
     } else {
         retry_state->recv_timeout_ms *= 2;
     }
 }
+
+void _anjay_coap_common_retry_state_complete(
+        const coap_retry_state_t *retry_state,
+        coap_input_buffer_t *in) {
+    if (!in->rtt_estimator || retry_state->retry_count == 0) {
+        return;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ssize_t rtt_ms = _anjay_time_diff_ms(&now, &retry_state->first_send_time);
+    _anjay_coap_rtt_update(in->rtt_estimator, &in->transmission_params,
+                           (int32_t) AVS_MIN(rtt_ms, (ssize_t) INT32_MAX),
+                           retry_state->retry_count - 1);
+}
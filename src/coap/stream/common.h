@@ -44,10 +44,16 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
  * |      Not present      |       0        |      false      |
  * +-----------------------+----------------+-----------------+
  */
-int _anjay_coap_common_get_block_info(const anjay_coap_msg_t *msg,
+int _anjay_coap_common_get_block_info(const anjay_coap_opt_index_t *opts,
                                       coap_block_type_t type,
                                       coap_block_info_t *out_info);
 
+/**
+ * Returns the Observe option value for a notification sent right now. It is
+ * derived from the monotonic clock, shifted by @p offset.
+ */
+uint32_t _anjay_coap_common_observe_serial(uint32_t offset);
+
 int _anjay_coap_common_fill_msg_info(anjay_coap_msg_info_t *info,
                                      const anjay_msg_details_t *details,
                                      const anjay_coap_msg_identity_t *identity,
@@ -103,6 +109,7 @@ void _anjay_coap_common_send_service_unavailable(anjay_coap_socket_t *socket,
 /**
  * @param      msg               Received message. It is guaranteed to never
  *                               be NULL.
+ * @param      opts              Option table of @p msg .
  * @param      data              Opaque data as passwd to
  *                               @ref _coap_common_with_recv_timeout .
  * @param[out] out_wait_for_next When set to false, the
@@ -120,6 +127,7 @@ void _anjay_coap_common_send_service_unavailable(anjay_coap_socket_t *socket,
  *         @ref _coap_common_with_recv_timeout .
  */
 typedef int recv_msg_handler_t(const anjay_coap_msg_t *msg,
+                               const anjay_coap_opt_index_t *opts,
                                void *data,
                                bool *out_wait_for_next,
                                uint8_t *out_error_code);
@@ -152,12 +160,24 @@ int _anjay_coap_common_recv_msg_with_timeout(anjay_coap_socket_t *socket,
 typedef struct {
     unsigned retry_count;
     int32_t recv_timeout_ms;
+    struct timespec first_send_time;
 } coap_retry_state_t;
 
-void _anjay_coap_common_update_retry_state(
-        coap_retry_state_t *retry_state,
-        const coap_transmission_params_t *tx_params,
-        anjay_rand_seed_t *rand_seed);
+/**
+ * Updates @p retry_state after a transmission of a Confirmable message. If
+ * @p in has an RTT estimator set, timeouts are calculated using it.
+ */
+void _anjay_coap_common_update_retry_state(coap_retry_state_t *retry_state,
+                                           coap_input_buffer_t *in);
+
+/**
+ * Feeds the RTT estimator of @p in (if any) with the time elapsed since the
+ * first transmission tracked by @p retry_state. Shall be called after
+ * receiving a response or an ACK to a message sent with retries.
+ */
+void _anjay_coap_common_retry_state_complete(
+        const coap_retry_state_t *retry_state,
+        coap_input_buffer_t *in);
 
 VISIBILITY_PRIVATE_HEADER_END
 
@@ -47,11 +47,14 @@ int _anjay_coap_in_get_next_message(coap_input_buffer_t *in,
         return result;
     }
 
-    const anjay_coap_msg_t *msg = _anjay_coap_in_get_message(in);
+    if (_anjay_coap_opt_index_build(&in->opts,
+                                    _anjay_coap_in_get_message(in))) {
+        return ANJAY_COAP_SOCKET_ERR_MSG_MALFORMED;
+    }
 
     in->payload_off = 0;
-    in->payload = (const uint8_t *)_anjay_coap_msg_payload(msg);
-    in->payload_size = _anjay_coap_msg_payload_length(msg);
+    in->payload = (const uint8_t *)_anjay_coap_opt_index_payload(&in->opts);
+    in->payload_size = _anjay_coap_opt_index_payload_length(&in->opts);
 
     return 0;
 }
@@ -59,14 +62,14 @@ int _anjay_coap_in_get_next_message(coap_input_buffer_t *in,
 void _anjay_coap_in_read(coap_input_buffer_t *in,
                          size_t *out_bytes_read,
                          char *out_message_finished,
-                         void *buffer,
-                         size_t buffer_length) {
+                         const void **out_data,
+                         size_t max_length) {
     size_t bytes_available = _anjay_coap_in_get_bytes_available(in);
-    size_t bytes_to_copy = ANJAY_MIN(buffer_length, bytes_available);
-    memcpy(buffer, in->payload + in->payload_off, bytes_to_copy);
-    in->payload_off += bytes_to_copy;
+    size_t bytes_to_read = ANJAY_MIN(max_length, bytes_available);
+    *out_data = in->payload + in->payload_off;
+    in->payload_off += bytes_to_read;
 
-    *out_bytes_read = bytes_to_copy;
+    *out_bytes_read = bytes_to_read;
     *out_message_finished = (in->payload_off >= in->payload_size);
 }
 
@@ -21,7 +21,9 @@
 #include <stddef.h>
 
 #include "../../utils.h"
+#include "../block/size_tuner.h"
 #include "../msg.h"
+#include "../rtt.h"
 #include "../socket.h"
 
 #ifndef ANJAY_COAP_STREAM_INTERNALS
@@ -36,8 +38,13 @@ typedef struct coap_input_buffer {
     const uint8_t *payload;
     size_t payload_off;
     size_t payload_size;
+    anjay_coap_opt_index_t opts;
 
     coap_transmission_params_t transmission_params;
+    /* per-server RTT estimator, or NULL to use fixed timeouts */
+    coap_rtt_estimator_t *rtt_estimator;
+    /* per-server block size preference, or NULL to not adjust block sizes */
+    coap_block_size_tuner_t *block_size_tuner;
     anjay_rand_seed_t rand_seed;
 } coap_input_buffer_t;
 
@@ -54,6 +61,12 @@ _anjay_coap_in_get_message(const coap_input_buffer_t *in) {
     return (const anjay_coap_msg_t *)in->buffer;
 }
 
+static inline const anjay_coap_opt_index_t *
+_anjay_coap_in_get_opts(const coap_input_buffer_t *in) {
+    assert(in->opts.msg == _anjay_coap_in_get_message(in));
+    return &in->opts;
+}
+
 static inline size_t
 _anjay_coap_in_get_bytes_available(const coap_input_buffer_t *in) {
     assert(in->payload_off <= in->payload_size);
@@ -62,8 +75,7 @@ _anjay_coap_in_get_bytes_available(const coap_input_buffer_t *in) {
 
 static inline size_t
 _anjay_coap_in_get_payload_size(const coap_input_buffer_t *in) {
-    return _anjay_coap_msg_payload_length(
-            _anjay_coap_in_get_message(in));
+    return _anjay_coap_opt_index_payload_length(_anjay_coap_in_get_opts(in));
 }
 
 /**
@@ -78,11 +90,16 @@ _anjay_coap_in_get_payload_size(const coap_input_buffer_t *in) {
 int _anjay_coap_in_get_next_message(coap_input_buffer_t *in,
                                     anjay_coap_socket_t *socket);
 
+/**
+ * Consumes up to @p max_length bytes of the current message payload without
+ * copying them. On return, <c>*out_data</c> points into the @p in buffer and
+ * remains valid until the next message is received into it.
+ */
 void _anjay_coap_in_read(coap_input_buffer_t *in,
                          size_t *out_bytes_read,
                          char *out_message_finished,
-                         void *buffer,
-                         size_t buffer_length);
+                         const void **out_data,
+                         size_t max_length);
 
 VISIBILITY_PRIVATE_HEADER_END
 
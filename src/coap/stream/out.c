@@ -27,6 +27,8 @@
 #include "../msg_builder.h"
 #include "../log.h"
 
+#include "common.h"
+
 VISIBILITY_SOURCE_BEGIN
 
 coap_output_buffer_t _anjay_coap_out_init(uint8_t *buffer,
@@ -78,16 +80,10 @@ static int add_string_options(anjay_coap_msg_info_t *info,
     return 0;
 }
 
-static int add_observe_option(anjay_coap_msg_info_t *info) {
-    struct timespec now;
-    clock_gettime(CLOCK_MONOTONIC, &now);
-    // A nearly-linear, strictly monotonic timestamp with a precision of
-    // 32.768 us, wrapping every 512 seconds.
-    // Should satisfy the requirements given in OBSERVE 3.4 and 4.4
-    uint32_t value = (uint32_t) ((now.tv_sec & 0x1FF) << 15)
-            | (uint32_t) (now.tv_nsec >> 15);
-    return _anjay_coap_msg_info_opt_u32(info, ANJAY_COAP_OPT_OBSERVE,
-                                        value);
+static int add_observe_option(coap_output_buffer_t *out) {
+    return _anjay_coap_msg_info_opt_u32(
+            &out->info, ANJAY_COAP_OPT_OBSERVE,
+            _anjay_coap_common_observe_serial(out->observe_serial_offset));
 }
 
 static size_t effective_buffer_capacity(const coap_output_buffer_t *out) {
@@ -104,7 +100,7 @@ int _anjay_coap_out_setup_msg(coap_output_buffer_t *out,
     out->info.code = details->msg_code;
     out->info.identity = *id;
 
-    if ((details->observe_serial && add_observe_option(&out->info))
+    if ((details->observe_serial && add_observe_option(out))
             || add_string_options(&out->info, ANJAY_COAP_OPT_LOCATION_PATH,
                                   details->location_path)
             || add_string_options(&out->info, ANJAY_COAP_OPT_URI_PATH,
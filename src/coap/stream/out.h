@@ -52,6 +52,9 @@ typedef struct coap_output_buffer {
 
     anjay_coap_msg_info_t info;
     anjay_coap_msg_builder_t builder;
+
+    /* added to the clock Observe option values are derived from */
+    uint32_t observe_serial_offset;
 } coap_output_buffer_t;
 
 coap_output_buffer_t _anjay_coap_out_init(uint8_t *payload_buffer,
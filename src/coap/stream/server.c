@@ -170,18 +170,17 @@ static bool is_opt_critical(uint32_t opt_number) {
 }
 
 static int block_store_critical_options(AVS_LIST(coap_block_optbuf_t) *out,
-                                        const anjay_coap_msg_t *msg,
+                                        const anjay_coap_opt_index_t *opts,
                                         uint32_t optnum_to_ignore) {
     AVS_LIST(coap_block_optbuf_t) *outptr = out;
     assert(!*outptr);
 
-    for (anjay_coap_opt_iterator_t optit = _anjay_coap_opt_begin(msg);
-            !_anjay_coap_opt_end(&optit); _anjay_coap_opt_next(&optit)) {
-        uint32_t optnum = _anjay_coap_opt_number(&optit);
+    for (size_t i = 0; i < opts->num_opts; ++i) {
+        uint32_t optnum = opts->entries[i].number;
         if (optnum == optnum_to_ignore || !is_opt_critical(optnum)) {
             continue;
         }
-        uint32_t length = _anjay_coap_opt_content_length(optit.curr_opt);
+        uint32_t length = opts->entries[i].length;
         *outptr = (AVS_LIST(coap_block_optbuf_t)) AVS_LIST_NEW_BUFFER(
                 offsetof(coap_block_optbuf_t, content) + length);
         if (!*outptr) {
@@ -189,8 +188,9 @@ static int block_store_critical_options(AVS_LIST(coap_block_optbuf_t) *out,
         }
         (*outptr)->optnum = optnum;
         (*outptr)->length = length;
-        memcpy((*outptr)->content, _anjay_coap_opt_value(optit.curr_opt),
-                length);
+        memcpy((*outptr)->content,
+               _anjay_coap_opt_value(_anjay_coap_opt_index_get(opts, i)),
+               length);
         outptr = AVS_LIST_NEXT_PTR(outptr);
     }
     return 0;
@@ -214,10 +214,13 @@ typedef enum process_result {
     PROCESS_INITIAL_INVALID_REQUEST,
 } process_result_t;
 
-static process_result_t process_initial_request(coap_server_t *server,
-                                                const anjay_coap_msg_t *msg) {
+static process_result_t
+process_initial_request(coap_server_t *server,
+                        const anjay_coap_opt_index_t *opts) {
     assert(is_server_reset(server));
 
+    const anjay_coap_msg_t *msg = opts->msg;
+
     anjay_coap_msg_type_t type = _anjay_coap_msg_header_get_type(&msg->header);
     if (!_anjay_coap_msg_is_request(msg)
             // incoming Reset may still require some kind of reaction,
@@ -230,8 +233,8 @@ static process_result_t process_initial_request(coap_server_t *server,
 
     coap_block_info_t block1;
     coap_block_info_t block2;
-    int result1 = _anjay_coap_common_get_block_info(msg, COAP_BLOCK1, &block1);
-    int result2 = _anjay_coap_common_get_block_info(msg, COAP_BLOCK2, &block2);
+    int result1 = _anjay_coap_common_get_block_info(opts, COAP_BLOCK1, &block1);
+    int result2 = _anjay_coap_common_get_block_info(opts, COAP_BLOCK2, &block2);
     if (result1 || result2) {
         _anjay_coap_server_set_error(server, -ANJAY_ERR_BAD_REQUEST);
         return PROCESS_INITIAL_INVALID_REQUEST;
@@ -267,8 +270,8 @@ static process_result_t process_initial_request(coap_server_t *server,
         }
 
         if (block1.valid
-                && block_store_critical_options(&server->expected_block_opts, msg,
-                                                ANJAY_COAP_OPT_BLOCK1)) {
+                && block_store_critical_options(&server->expected_block_opts,
+                                                opts, ANJAY_COAP_OPT_BLOCK1)) {
             return PROCESS_INITIAL_INVALID_REQUEST;
         }
     }
@@ -308,7 +311,7 @@ static int receive_request(coap_server_t *server,
     }
 
     const anjay_coap_msg_t *msg = _anjay_coap_in_get_message(in);
-    switch (process_initial_request(server, msg)) {
+    switch (process_initial_request(server, _anjay_coap_in_get_opts(in))) {
     case PROCESS_INITIAL_INVALID_REQUEST:
         if (!server->last_error_code) {
             if (_anjay_coap_msg_header_get_type(&msg->header)
@@ -356,19 +359,19 @@ static bool blocks_equal(const coap_block_info_t *a,
         && a->seq_num == b->seq_num;
 }
 
-static int block_validate_critical_options(AVS_LIST(coap_block_optbuf_t) opts,
-                                           const anjay_coap_msg_t *msg,
-                                           uint32_t optnum_to_ignore) {
+static int
+block_validate_critical_options(AVS_LIST(coap_block_optbuf_t) expected_opts,
+                                const anjay_coap_opt_index_t *opts,
+                                uint32_t optnum_to_ignore) {
 #define BVCO_LOG_MSG "critical options mismatch when receiving BLOCK request; "
 #define BVCO_LOG_OPT "%" PRIu32 " length %" PRIu32
-    AVS_LIST(coap_block_optbuf_t) optbuf = opts;
-    for (anjay_coap_opt_iterator_t optit = _anjay_coap_opt_begin(msg);
-            !_anjay_coap_opt_end(&optit); _anjay_coap_opt_next(&optit)) {
-        uint32_t optnum = _anjay_coap_opt_number(&optit);
+    AVS_LIST(coap_block_optbuf_t) optbuf = expected_opts;
+    for (size_t i = 0; i < opts->num_opts; ++i) {
+        uint32_t optnum = opts->entries[i].number;
         if (optnum == optnum_to_ignore || !is_opt_critical(optnum)) {
             continue;
         }
-        uint32_t length = _anjay_coap_opt_content_length(optit.curr_opt);
+        uint32_t length = opts->entries[i].length;
         if (!optbuf) {
             anjay_log(DEBUG, BVCO_LOG_MSG "expected end; got " BVCO_LOG_OPT,
                       optnum, length);
@@ -376,7 +379,8 @@ static int block_validate_critical_options(AVS_LIST(coap_block_optbuf_t) opts,
         }
         if (optnum != optbuf->optnum
                 || length != optbuf->length
-                || memcmp(_anjay_coap_opt_value(optit.curr_opt),
+                || memcmp(_anjay_coap_opt_value(
+                                  _anjay_coap_opt_index_get(opts, i)),
                           optbuf->content, optbuf->length) != 0) {
             anjay_log(DEBUG, BVCO_LOG_MSG
                              "expected " BVCO_LOG_OPT "; got " BVCO_LOG_OPT,
@@ -406,17 +410,17 @@ typedef enum process_block_result {
     PROCESS_BLOCK_REJECT_ABORT,
 } process_block_result_t;
 
-static int retrieve_block_options(const anjay_coap_msg_t *msg,
+static int retrieve_block_options(const anjay_coap_opt_index_t *opts,
                                   coap_block_info_t *out_block1,
                                   coap_block_info_t *out_block2) {
     int result = 0;
 
-    if (_anjay_coap_common_get_block_info(msg, COAP_BLOCK1, out_block1)) {
+    if (_anjay_coap_common_get_block_info(opts, COAP_BLOCK1, out_block1)) {
         coap_log(DEBUG, "block-wise transfer - BLOCK1 invalid");
         result = -1;
     }
 
-    if (_anjay_coap_common_get_block_info(msg, COAP_BLOCK2, out_block2)) {
+    if (_anjay_coap_common_get_block_info(opts, COAP_BLOCK2, out_block2)) {
         coap_log(DEBUG, "block-wise transfer - BLOCK2 invalid");
         result = -1;
     }
@@ -424,9 +428,11 @@ static int retrieve_block_options(const anjay_coap_msg_t *msg,
     return result;
 }
 
-static process_block_result_t process_next_block(coap_server_t *server,
-                                                 const anjay_coap_msg_t *msg,
-                                                 uint8_t *out_error_code) {
+static process_block_result_t
+process_next_block(coap_server_t *server,
+                   const anjay_coap_msg_t *msg,
+                   const anjay_coap_opt_index_t *opts,
+                   uint8_t *out_error_code) {
     if (!_anjay_coap_msg_is_request(msg)) {
         *out_error_code = 0;
         return PROCESS_BLOCK_REJECT_CONTINUE;
@@ -435,7 +441,7 @@ static process_block_result_t process_next_block(coap_server_t *server,
     coap_block_info_t new_block;
     coap_block_info_t block2;
 
-    if (retrieve_block_options(msg, &new_block, &block2)) {
+    if (retrieve_block_options(opts, &new_block, &block2)) {
         // malformed block option(s)
         *out_error_code = ANJAY_COAP_CODE_BAD_REQUEST;
         return PROCESS_BLOCK_REJECT_ABORT;
@@ -471,7 +477,7 @@ static process_block_result_t process_next_block(coap_server_t *server,
         return PROCESS_BLOCK_REJECT_ABORT;
     }
 
-    if (block_validate_critical_options(server->expected_block_opts, msg,
+    if (block_validate_critical_options(server->expected_block_opts, opts,
                                         ANJAY_COAP_OPT_BLOCK1)) {
         *out_error_code = ANJAY_COAP_CODE_SERVICE_UNAVAILABLE;
         return PROCESS_BLOCK_REJECT_CONTINUE;
@@ -523,6 +529,7 @@ cleanup_info:
 }
 
 static int receive_next_block(const anjay_coap_msg_t *msg,
+                              const anjay_coap_opt_index_t *opts,
                               void *server_,
                               bool *out_wait_for_next,
                               uint8_t *out_error_code) {
@@ -533,7 +540,7 @@ static int receive_next_block(const anjay_coap_msg_t *msg,
     assert(server->state == COAP_SERVER_STATE_NEEDS_NEXT_BLOCK);
     assert(server->curr_block.valid);
 
-    process_block_result_t result = process_next_block(server, msg,
+    process_block_result_t result = process_next_block(server, msg, opts,
                                                        out_error_code);
 
     switch (result) {
@@ -603,8 +610,8 @@ int _anjay_coap_server_read(coap_server_t *server,
                             anjay_coap_socket_t *socket,
                             size_t *out_bytes_read,
                             char *out_message_finished,
-                            void *buffer,
-                            size_t buffer_length) {
+                            const void **out_data,
+                            size_t max_length) {
     if (is_server_reset(server)) {
         return -1;
     }
@@ -626,7 +633,7 @@ int _anjay_coap_server_read(coap_server_t *server,
 #endif
 
     _anjay_coap_in_read(in, out_bytes_read, out_message_finished,
-                        buffer, buffer_length);
+                        out_data, max_length);
 
     if (*out_message_finished
             && server->state == COAP_SERVER_STATE_HAS_BLOCK1_REQUEST) {
@@ -133,6 +133,9 @@ int _anjay_coap_server_get_or_receive_msg(coap_server_t *server,
  * In that case the call may send packets through @p socket to acknowledge or
  * reject incoming packets.
  *
+ * The payload is not copied: <c>*out_data</c> is set to point into @p in and
+ * is only valid until the next call.
+ *
  * @returns 0 on success, a negative value in case of error.
  */
 int _anjay_coap_server_read(coap_server_t *server,
@@ -140,8 +143,8 @@ int _anjay_coap_server_read(coap_server_t *server,
                             anjay_coap_socket_t *socket,
                             size_t *out_bytes_read,
                             char *out_message_finished,
-                            void *buffer,
-                            size_t buffer_length);
+                            const void **out_data,
+                            size_t max_length);
 
 int _anjay_coap_server_write(coap_server_t *server,
                              coap_input_buffer_t *in,
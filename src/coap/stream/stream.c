@@ -27,6 +27,8 @@
 
 #include "../id_source/auto.h"
 
+#include "common.h"
+
 VISIBILITY_SOURCE_BEGIN
 
 static coap_client_t *get_client(coap_stream_t *stream) {
@@ -182,9 +184,20 @@ static const avs_stream_v_table_extension_net_t NET_EXT_VTABLE = {
     coap_setsock
 };
 
+static int coap_read_view(avs_stream_abstract_t *stream_,
+                          const void **out_data,
+                          size_t *out_bytes_read,
+                          char *out_message_finished,
+                          size_t max_length);
+
+static const anjay_stream_view_ext_t VIEW_EXT_VTABLE = {
+    .read_view = coap_read_view
+};
+
 static const avs_stream_v_table_extension_t COAP_STREAM_EXT[] = {
     { ANJAY_COAP_STREAM_EXTENSION, &COAP_STREAM_EXT_VTABLE },
     { AVS_STREAM_V_TABLE_EXTENSION_NET, &NET_EXT_VTABLE },
+    { ANJAY_STREAM_VIEW_EXTENSION, &VIEW_EXT_VTABLE },
     AVS_STREAM_V_TABLE_EXTENSION_NULL
 };
 
@@ -227,11 +240,11 @@ static int coap_finish_message(avs_stream_abstract_t *stream_) {
     }
 }
 
-static int coap_read(avs_stream_abstract_t *stream_,
-                     size_t *out_bytes_read,
-                     char *out_message_finished,
-                     void *buffer,
-                     size_t buffer_length) {
+static int coap_read_view(avs_stream_abstract_t *stream_,
+                          const void **out_data,
+                          size_t *out_bytes_read,
+                          char *out_message_finished,
+                          size_t max_length) {
     coap_stream_t *stream = (coap_stream_t *)stream_;
     assert(stream->in.buffer);
 
@@ -246,24 +259,40 @@ static int coap_read(avs_stream_abstract_t *stream_,
             result = _anjay_coap_server_read(get_server(stream), &stream->in,
                                              stream->socket, out_bytes_read,
                                              out_message_finished,
-                                             buffer, buffer_length);
+                                             out_data, max_length);
             break;
         case STREAM_STATE_CLIENT:
             result = _anjay_coap_client_read(get_client(stream), &stream->in,
                                              stream->socket, out_bytes_read,
                                              out_message_finished,
-                                             buffer, buffer_length);
+                                             out_data, max_length);
             break;
         }
     }
 
     if (!result && *out_message_finished) {
+        // NOTE: this only marks the payload as consumed; the data pointed to
+        // by *out_data stays intact until the next message is received
         _anjay_coap_in_reset(&stream->in);
     }
 
     return result;
 }
 
+static int coap_read(avs_stream_abstract_t *stream,
+                     size_t *out_bytes_read,
+                     char *out_message_finished,
+                     void *buffer,
+                     size_t buffer_length) {
+    const void *data = NULL;
+    int result = coap_read_view(stream, &data, out_bytes_read,
+                                out_message_finished, buffer_length);
+    if (!result && *out_bytes_read) {
+        memcpy(buffer, data, *out_bytes_read);
+    }
+    return result;
+}
+
 static int coap_reset(avs_stream_abstract_t *stream_) {
     reset((coap_stream_t *)stream_);
     return 0;
@@ -370,6 +399,40 @@ int _anjay_coap_stream_set_tx_params(
     return 0;
 }
 
+int _anjay_coap_stream_set_rtt_estimator(avs_stream_abstract_t *stream_,
+                                         coap_rtt_estimator_t *estimator) {
+    coap_stream_t *stream = (coap_stream_t*) stream_;
+    assert(stream->vtable == &COAP_STREAM_VTABLE);
+    stream->in.rtt_estimator = estimator;
+    return 0;
+}
+
+int _anjay_coap_stream_set_block_size_tuner(avs_stream_abstract_t *stream_,
+                                            coap_block_size_tuner_t *tuner) {
+    coap_stream_t *stream = (coap_stream_t*) stream_;
+    assert(stream->vtable == &COAP_STREAM_VTABLE);
+    stream->in.block_size_tuner = tuner;
+    return 0;
+}
+
+int _anjay_coap_stream_get_observe_serial(avs_stream_abstract_t *stream_,
+                                          uint32_t *out_serial) {
+    coap_stream_t *stream = (coap_stream_t*) stream_;
+    assert(stream->vtable == &COAP_STREAM_VTABLE);
+    *out_serial = _anjay_coap_common_observe_serial(
+            stream->out.observe_serial_offset);
+    return 0;
+}
+
+int _anjay_coap_stream_set_observe_serial(avs_stream_abstract_t *stream_,
+                                          uint32_t serial) {
+    coap_stream_t *stream = (coap_stream_t*) stream_;
+    assert(stream->vtable == &COAP_STREAM_VTABLE);
+    stream->out.observe_serial_offset =
+            serial - _anjay_coap_common_observe_serial(0);
+    return 0;
+}
+
 int _anjay_coap_stream_setup_response(avs_stream_abstract_t *stream,
                                       const anjay_msg_details_t *details) {
     const anjay_coap_stream_ext_t *coap = (const anjay_coap_stream_ext_t *)
@@ -423,6 +486,13 @@ int _anjay_coap_stream_setup_request(
     return result;
 }
 
+anjay_coap_msg_identity_t
+_anjay_coap_stream_next_identity(avs_stream_abstract_t *stream_) {
+    coap_stream_t *stream = (coap_stream_t*)stream_;
+    assert(stream->vtable == &COAP_STREAM_VTABLE);
+    return _anjay_coap_id_source_get(stream->id_source);
+}
+
 int _anjay_coap_stream_set_error(avs_stream_abstract_t *stream_,
                                  uint8_t code) {
     coap_stream_t *stream = (coap_stream_t*)stream_;
@@ -437,6 +507,24 @@ int _anjay_coap_stream_set_error(avs_stream_abstract_t *stream_,
     return 0;
 }
 
+int _anjay_coap_stream_send_empty_ack(avs_stream_abstract_t *stream_) {
+    coap_stream_t *stream = (coap_stream_t*)stream_;
+    assert(stream->vtable == &COAP_STREAM_VTABLE);
+
+    const anjay_coap_msg_identity_t *id = NULL;
+    if (stream->state == STREAM_STATE_SERVER) {
+        id = _anjay_coap_server_get_request_identity(get_server(stream));
+    }
+    if (!id) {
+        coap_log(ERROR, "send_empty_ack called without a request to confirm");
+        return -1;
+    }
+
+    return _anjay_coap_common_send_empty(stream->socket,
+                                         ANJAY_COAP_MSG_ACKNOWLEDGEMENT,
+                                         id->msg_id);
+}
+
 int _anjay_coap_stream_get_code(avs_stream_abstract_t *stream_,
                                 uint8_t *out_code) {
     coap_stream_t *stream = (coap_stream_t*)stream_;
@@ -482,7 +570,8 @@ int _anjay_coap_stream_get_option_uint(avs_stream_abstract_t *stream_,
     assert(_anjay_coap_msg_is_valid(msg));
 
     const anjay_coap_opt_t *opt;
-    if (_anjay_coap_msg_find_unique_opt(msg, option_number, &opt)) {
+    if (_anjay_coap_opt_index_find_unique(_anjay_coap_in_get_opts(&stream->in),
+                                          option_number, &opt)) {
         if (opt) {
             coap_log(DEBUG, "multiple instances of option %d found",
                      option_number);
@@ -512,18 +601,19 @@ int _anjay_coap_stream_get_option_string_it(avs_stream_abstract_t *stream_,
         }
         anjay_coap_opt_iterator_t begin = _anjay_coap_opt_begin(msg);
         memcpy(it, &begin, sizeof(*it));
-    } else {
-        _anjay_coap_opt_next(it);
+        it->curr_opt = NULL;
     }
 
-    for (; !_anjay_coap_opt_end(it); _anjay_coap_opt_next(it)) {
-        if (_anjay_coap_opt_number(it) == option_number) {
-            return _anjay_coap_opt_string_value(it->curr_opt, out_bytes_read,
-                                                buffer, buffer_size);
-        }
+    const anjay_coap_opt_t *opt = _anjay_coap_opt_index_find_next(
+            _anjay_coap_in_get_opts(&stream->in), option_number, it->curr_opt);
+    if (!opt) {
+        return ANJAY_COAP_OPTION_MISSING;
     }
 
-    return 1;
+    it->curr_opt = opt;
+    it->prev_opt_number = option_number - _anjay_coap_opt_delta(opt);
+    return _anjay_coap_opt_string_value(opt, out_bytes_read,
+                                        buffer, buffer_size);
 }
 
 int _anjay_coap_stream_get_content_format(avs_stream_abstract_t *stream,
@@ -592,20 +682,18 @@ int _anjay_coap_stream_validate_critical_options(
         return -1;
     }
 
-    anjay_coap_opt_iterator_t it = _anjay_coap_opt_begin(msg);
+    const anjay_coap_opt_index_t *opts = _anjay_coap_in_get_opts(&stream->in);
     int result = 0;
 
-    while (!_anjay_coap_opt_end(&it)) {
-        if (is_opt_critical(_anjay_coap_opt_number(&it))) {
-            uint32_t opt_number = _anjay_coap_opt_number(&it);
-
-            if (!is_critical_opt_valid(msg->header.code, opt_number, validator)) {
-                coap_log(DEBUG, "warning: invalid critical option in query %s: %u",
-                         ANJAY_COAP_CODE_STRING(msg->header.code), opt_number);
-                result = -1;
-            }
+    for (size_t i = 0; i < opts->num_opts; ++i) {
+        uint32_t opt_number = opts->entries[i].number;
+        if (is_opt_critical(opt_number)
+                && !is_critical_opt_valid(msg->header.code, opt_number,
+                                          validator)) {
+            coap_log(DEBUG, "warning: invalid critical option in query %s: %u",
+                     ANJAY_COAP_CODE_STRING(msg->header.code), opt_number);
+            result = -1;
         }
-        _anjay_coap_opt_next(&it);
     }
 
     return result;
@@ -0,0 +1,723 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avsystem/commons/socket_v_table.h>
+
+#include "tcp_socket.h"
+
+#include "log.h"
+#include "msg_internal.h"
+#include "opt.h"
+#include "utils.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+/* RFC 8323, 3.2: Len == 15 means a 32-bit Extended Length field */
+#define COAP_TCP_EXT_U32 15
+#define COAP_TCP_EXT_U32_BASE ((uint32_t) 65805)
+
+/* Len/TKL byte + up to 4 bytes of Extended Length + Code */
+#define COAP_TCP_MAX_FRAME_HEADER_SIZE 6
+
+#define COAP_TCP_CODE_CSM     ANJAY_COAP_CODE(7, 1)
+#define COAP_TCP_CODE_PING    ANJAY_COAP_CODE(7, 2)
+#define COAP_TCP_CODE_PONG    ANJAY_COAP_CODE(7, 3)
+#define COAP_TCP_CODE_RELEASE ANJAY_COAP_CODE(7, 4)
+#define COAP_TCP_CODE_ABORT   ANJAY_COAP_CODE(7, 5)
+
+#define COAP_TCP_SIGNALING_CLASS 7
+
+#define COAP_TCP_OPT_MAX_MESSAGE_SIZE 2
+
+#define COAP_TCP_MIN_RECV_BUFFER_SIZE 256
+
+typedef struct {
+    const avs_net_socket_v_table_t *const operations;
+    avs_net_abstract_socket_t *backend;
+
+    /* errno describing the last failure detected by this layer; 0 if the
+     * last failure was reported by the backend socket */
+    int error_code;
+
+    uint32_t peer_max_message_size;
+
+    /* Message ID given to the next incoming message that is not a response
+     * to our request */
+    uint16_t next_msg_id;
+
+    /* last sent Confirmable request, to recognize its response */
+    bool has_request;
+    uint16_t request_id;
+    anjay_coap_token_t request_token;
+    size_t request_token_size;
+
+    /* last sent Confirmable message, to recognize retransmissions */
+    bool has_last_confirmable;
+    uint16_t last_confirmable_id;
+
+    /* Confirmable non-request that has to be reported as acknowledged */
+    bool has_pending_ack;
+    uint16_t pending_ack_id;
+
+    uint8_t *send_buffer;
+    size_t send_buffer_capacity;
+
+    uint8_t *recv_buffer;
+    size_t recv_buffer_size;
+    size_t recv_buffer_capacity;
+    /* bytes of an oversized frame that still need to be skipped */
+    size_t discard_remaining;
+} coap_tcp_socket_t;
+
+typedef struct {
+    uint8_t code;
+    const uint8_t *token;
+    uint8_t token_size;
+    /* options and payload */
+    const uint8_t *body;
+    size_t body_size;
+    /* number of bytes occupied by the frame in recv_buffer */
+    size_t frame_size;
+    bool truncated;
+} coap_tcp_frame_t;
+
+static void reset_connection_state(coap_tcp_socket_t *sock) {
+    sock->peer_max_message_size = ANJAY_COAP_TCP_DEFAULT_MAX_MESSAGE_SIZE;
+    sock->has_request = false;
+    sock->has_last_confirmable = false;
+    sock->has_pending_ack = false;
+    sock->recv_buffer_size = 0;
+    sock->discard_remaining = 0;
+}
+
+static int fail_with_errno(coap_tcp_socket_t *sock, int error_code) {
+    sock->error_code = error_code;
+    return -1;
+}
+
+static size_t extended_length_size(uint8_t len_nibble) {
+    switch (len_nibble) {
+    case ANJAY_COAP_EXT_U8:
+        return 1;
+    case ANJAY_COAP_EXT_U16:
+        return 2;
+    case COAP_TCP_EXT_U32:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+static size_t encode_frame_header(uint8_t *out,
+                                  size_t body_size,
+                                  uint8_t token_size,
+                                  uint8_t code) {
+    uint8_t len_nibble;
+    uint32_t ext_value = 0;
+    if (body_size < ANJAY_COAP_EXT_U8_BASE) {
+        len_nibble = (uint8_t) body_size;
+    } else if (body_size < ANJAY_COAP_EXT_U16_BASE) {
+        len_nibble = ANJAY_COAP_EXT_U8;
+        ext_value = (uint32_t) (body_size - ANJAY_COAP_EXT_U8_BASE);
+    } else if (body_size < COAP_TCP_EXT_U32_BASE) {
+        len_nibble = ANJAY_COAP_EXT_U16;
+        ext_value = (uint32_t) (body_size - ANJAY_COAP_EXT_U16_BASE);
+    } else {
+        assert(body_size - COAP_TCP_EXT_U32_BASE <= UINT32_MAX);
+        len_nibble = COAP_TCP_EXT_U32;
+        ext_value = (uint32_t) (body_size - COAP_TCP_EXT_U32_BASE);
+    }
+
+    const size_t ext_size = extended_length_size(len_nibble);
+    out[0] = (uint8_t) ((len_nibble << 4) | token_size);
+    for (size_t i = 0; i < ext_size; ++i) {
+        out[1 + i] = (uint8_t) (ext_value >> (8 * (ext_size - 1 - i)));
+    }
+    out[1 + ext_size] = code;
+    return 2 + ext_size;
+}
+
+static int send_frame(coap_tcp_socket_t *sock,
+                      uint8_t code,
+                      const uint8_t *token,
+                      uint8_t token_size,
+                      const uint8_t *body,
+                      size_t body_size) {
+    const size_t max_frame_size =
+            COAP_TCP_MAX_FRAME_HEADER_SIZE + token_size + body_size;
+    if (max_frame_size > sock->send_buffer_capacity) {
+        uint8_t *new_buffer = (uint8_t *) realloc(sock->send_buffer,
+                                                  max_frame_size);
+        if (!new_buffer) {
+            coap_log(ERROR, "out of memory");
+            return fail_with_errno(sock, ENOMEM);
+        }
+        sock->send_buffer = new_buffer;
+        sock->send_buffer_capacity = max_frame_size;
+    }
+
+    size_t frame_size = encode_frame_header(sock->send_buffer, body_size,
+                                            token_size, code);
+    if (token_size) {
+        memcpy(sock->send_buffer + frame_size, token, token_size);
+        frame_size += token_size;
+    }
+    if (body_size) {
+        memcpy(sock->send_buffer + frame_size, body, body_size);
+        frame_size += body_size;
+    }
+
+    return avs_net_socket_send(sock->backend, sock->send_buffer, frame_size);
+}
+
+static int send_csm(coap_tcp_socket_t *sock) {
+    return send_frame(sock, COAP_TCP_CODE_CSM, NULL, 0, NULL, 0);
+}
+
+static int tcp_send(avs_net_abstract_socket_t *sock_,
+                    const void *buffer,
+                    size_t buffer_length) {
+    coap_tcp_socket_t *sock = (coap_tcp_socket_t *) sock_;
+    sock->error_code = 0;
+
+    const anjay_coap_msg_header_t *header =
+            (const anjay_coap_msg_header_t *) buffer;
+    if (buffer_length < sizeof(*header)) {
+        return fail_with_errno(sock, EINVAL);
+    }
+    const uint8_t token_size = _anjay_coap_msg_header_get_token_length(header);
+    if (token_size > ANJAY_COAP_MAX_TOKEN_LENGTH
+            || buffer_length < sizeof(*header) + token_size) {
+        return fail_with_errno(sock, EINVAL);
+    }
+
+    if (header->code == ANJAY_COAP_CODE_EMPTY) {
+        /* Empty ACK, Reset and CoAP ping carry no meaning over a reliable
+         * transport (RFC 8323, 2.) */
+        return 0;
+    }
+
+    const uint16_t msg_id = extract_u16(header->message_id);
+    const bool confirmable =
+            _anjay_coap_msg_header_get_type(header) == ANJAY_COAP_MSG_CONFIRMABLE;
+    if (confirmable && sock->has_last_confirmable
+            && sock->last_confirmable_id == msg_id) {
+        coap_log(TRACE, "not retransmitting message %u over TCP",
+                 (unsigned) msg_id);
+        return 0;
+    }
+
+    const uint8_t *token = (const uint8_t *) buffer + sizeof(*header);
+    int result = send_frame(sock, header->code, token, token_size,
+                            token + token_size,
+                            buffer_length - sizeof(*header) - token_size);
+    if (result || !confirmable) {
+        return result;
+    }
+
+    sock->has_last_confirmable = true;
+    sock->last_confirmable_id = msg_id;
+    if (_anjay_coap_msg_code_get_class(&header->code) == 0) {
+        sock->has_request = true;
+        sock->request_id = msg_id;
+        memcpy(sock->request_token.bytes, token, token_size);
+        sock->request_token_size = token_size;
+    } else {
+        sock->has_pending_ack = true;
+        sock->pending_ack_id = msg_id;
+    }
+    return 0;
+}
+
+static void consume_received(coap_tcp_socket_t *sock, size_t size) {
+    assert(size <= sock->recv_buffer_size);
+    sock->recv_buffer_size -= size;
+    memmove(sock->recv_buffer, sock->recv_buffer + size,
+            sock->recv_buffer_size);
+}
+
+static int ensure_received(coap_tcp_socket_t *sock, size_t size) {
+    if (size > sock->recv_buffer_capacity) {
+        size_t new_capacity = AVS_MAX(size, COAP_TCP_MIN_RECV_BUFFER_SIZE);
+        uint8_t *new_buffer = (uint8_t *) realloc(sock->recv_buffer,
+                                                  new_capacity);
+        if (!new_buffer) {
+            coap_log(ERROR, "out of memory");
+            return fail_with_errno(sock, ENOMEM);
+        }
+        sock->recv_buffer = new_buffer;
+        sock->recv_buffer_capacity = new_capacity;
+    }
+
+    /* never read past the requested size, so that data of any subsequent
+     * message stays in the system socket and poll() on it remains reliable */
+    while (sock->recv_buffer_size < size) {
+        size_t bytes_received = 0;
+        if (avs_net_socket_receive(sock->backend, &bytes_received,
+                                   sock->recv_buffer + sock->recv_buffer_size,
+                                   size - sock->recv_buffer_size)) {
+            return -1;
+        }
+        if (!bytes_received) {
+            coap_log(DEBUG, "connection closed by peer");
+            return fail_with_errno(sock, ECONNRESET);
+        }
+        sock->recv_buffer_size += bytes_received;
+    }
+    return 0;
+}
+
+static int discard_oversized_frame(coap_tcp_socket_t *sock) {
+    while (sock->discard_remaining) {
+        if (ensure_received(sock,
+                            AVS_MIN(sock->discard_remaining,
+                                    AVS_MAX(sock->recv_buffer_capacity,
+                                            COAP_TCP_MIN_RECV_BUFFER_SIZE)))) {
+            return -1;
+        }
+        size_t to_discard = AVS_MIN(sock->recv_buffer_size,
+                                    sock->discard_remaining);
+        consume_received(sock, to_discard);
+        sock->discard_remaining -= to_discard;
+    }
+    return 0;
+}
+
+/**
+ * Receives the next frame into sock->recv_buffer. If the frame, once converted
+ * to the UDP format, would not fit in @p max_msg_size bytes, only its header
+ * and token are received, out_frame->truncated is set, and the rest of the
+ * frame is skipped during the next call.
+ */
+static int receive_frame(coap_tcp_socket_t *sock,
+                         size_t max_msg_size,
+                         coap_tcp_frame_t *out_frame) {
+    if (ensure_received(sock, 1)) {
+        return -1;
+    }
+    const uint8_t len_nibble = (uint8_t) (sock->recv_buffer[0] >> 4);
+    const uint8_t token_size = (uint8_t) (sock->recv_buffer[0] & 0x0F);
+    const size_t ext_size = extended_length_size(len_nibble);
+    const size_t header_size = 2 + ext_size;
+    if (token_size > ANJAY_COAP_MAX_TOKEN_LENGTH) {
+        coap_log(ERROR, "invalid CoAP/TCP frame, TKL = %u",
+                 (unsigned) token_size);
+        return fail_with_errno(sock, EPROTO);
+    }
+    if (ensure_received(sock, header_size)) {
+        return -1;
+    }
+
+    size_t body_size = 0;
+    for (size_t i = 0; i < ext_size; ++i) {
+        body_size = (body_size << 8) | sock->recv_buffer[1 + i];
+    }
+    switch (len_nibble) {
+    case ANJAY_COAP_EXT_U8:
+        body_size += ANJAY_COAP_EXT_U8_BASE;
+        break;
+    case ANJAY_COAP_EXT_U16:
+        body_size += ANJAY_COAP_EXT_U16_BASE;
+        break;
+    case COAP_TCP_EXT_U32:
+        body_size += COAP_TCP_EXT_U32_BASE;
+        break;
+    default:
+        body_size = len_nibble;
+        break;
+    }
+
+    out_frame->truncated = (sizeof(anjay_coap_msg_header_t) + token_size
+                            + body_size > max_msg_size);
+    if (out_frame->truncated) {
+        coap_log(ERROR, "CoAP/TCP message too big: %lu B",
+                 (unsigned long) (header_size + token_size + body_size));
+        sock->discard_remaining = body_size;
+        body_size = 0;
+    }
+
+    out_frame->frame_size = header_size + token_size + body_size;
+    if (ensure_received(sock, out_frame->frame_size)) {
+        sock->discard_remaining = 0;
+        return -1;
+    }
+
+    out_frame->code = sock->recv_buffer[1 + ext_size];
+    out_frame->token = sock->recv_buffer + header_size;
+    out_frame->token_size = token_size;
+    out_frame->body = out_frame->token + token_size;
+    out_frame->body_size = body_size;
+    return 0;
+}
+
+static void handle_csm(coap_tcp_socket_t *sock, const coap_tcp_frame_t *csm) {
+    const uint8_t *ptr = csm->body;
+    const uint8_t *end = csm->body + csm->body_size;
+    uint32_t opt_number = 0;
+
+    while (ptr < end && *ptr != ANJAY_COAP_PAYLOAD_MARKER) {
+        const anjay_coap_opt_t *opt = (const anjay_coap_opt_t *) ptr;
+        if (!_anjay_coap_opt_is_valid(opt, (size_t) (end - ptr))) {
+            coap_log(WARNING, "malformed option in CSM");
+            return;
+        }
+        opt_number += _anjay_coap_opt_delta(opt);
+
+        uint32_t max_message_size;
+        if (opt_number == COAP_TCP_OPT_MAX_MESSAGE_SIZE
+                && !_anjay_coap_opt_u32_value(opt, &max_message_size)) {
+            if (max_message_size < COAP_TCP_MAX_FRAME_HEADER_SIZE) {
+                coap_log(WARNING, "ignoring invalid peer Max-Message-Size: %u",
+                         (unsigned) max_message_size);
+            } else {
+                coap_log(DEBUG, "peer Max-Message-Size: %u",
+                         (unsigned) max_message_size);
+                sock->peer_max_message_size = max_message_size;
+            }
+        }
+        ptr += _anjay_coap_opt_sizeof(opt);
+    }
+}
+
+static int handle_signaling(coap_tcp_socket_t *sock,
+                            const coap_tcp_frame_t *frame) {
+    switch (frame->code) {
+    case COAP_TCP_CODE_CSM:
+        handle_csm(sock, frame);
+        return 0;
+    case COAP_TCP_CODE_PING:
+        return send_frame(sock, COAP_TCP_CODE_PONG, frame->token,
+                          frame->token_size, NULL, 0);
+    case COAP_TCP_CODE_RELEASE:
+    case COAP_TCP_CODE_ABORT:
+        coap_log(INFO, "connection %s by peer",
+                 frame->code == COAP_TCP_CODE_RELEASE ? "released"
+                                                      : "aborted");
+        return fail_with_errno(sock, ECONNRESET);
+    default:
+        return 0;
+    }
+}
+
+static void write_udp_header(uint8_t *out,
+                             anjay_coap_msg_type_t type,
+                             uint8_t token_size,
+                             uint8_t code,
+                             uint16_t msg_id) {
+    anjay_coap_msg_header_t header = { 0 };
+    _anjay_coap_msg_header_set_version(&header, 1);
+    _anjay_coap_msg_header_set_type(&header, type);
+    _anjay_coap_msg_header_set_token_length(&header, token_size);
+    header.code = code;
+    header.message_id[0] = (uint8_t) (msg_id >> 8);
+    header.message_id[1] = (uint8_t) msg_id;
+    memcpy(out, &header, sizeof(header));
+}
+
+static bool is_response_to_request(const coap_tcp_socket_t *sock,
+                                   const coap_tcp_frame_t *frame) {
+    return sock->has_request
+            && _anjay_coap_msg_code_get_class(&frame->code) != 0
+            && frame->token_size == sock->request_token_size
+            && !memcmp(frame->token, sock->request_token.bytes,
+                       frame->token_size);
+}
+
+static int tcp_receive(avs_net_abstract_socket_t *sock_,
+                       size_t *out_bytes_received,
+                       void *buffer,
+                       size_t buffer_length) {
+    coap_tcp_socket_t *sock = (coap_tcp_socket_t *) sock_;
+    sock->error_code = 0;
+    *out_bytes_received = 0;
+
+    if (buffer_length
+            < sizeof(anjay_coap_msg_header_t) + ANJAY_COAP_MAX_TOKEN_LENGTH) {
+        return fail_with_errno(sock, EMSGSIZE);
+    }
+
+    if (sock->has_pending_ack) {
+        write_udp_header((uint8_t *) buffer, ANJAY_COAP_MSG_ACKNOWLEDGEMENT,
+                         0, ANJAY_COAP_CODE_EMPTY, sock->pending_ack_id);
+        sock->has_pending_ack = false;
+        *out_bytes_received = sizeof(anjay_coap_msg_header_t);
+        return 0;
+    }
+
+    while (true) {
+        coap_tcp_frame_t frame;
+        if (discard_oversized_frame(sock)
+                || receive_frame(sock, buffer_length, &frame)) {
+            return -1;
+        }
+
+        if (_anjay_coap_msg_code_get_class(&frame.code)
+                == COAP_TCP_SIGNALING_CLASS) {
+            int result = frame.truncated ? 0 : handle_signaling(sock, &frame);
+            consume_received(sock, frame.frame_size);
+            if (result) {
+                return result;
+            }
+            continue;
+        }
+        if (frame.code == ANJAY_COAP_CODE_EMPTY) {
+            /* RFC 8323, 3.3: Empty messages MUST be ignored */
+            consume_received(sock, frame.frame_size);
+            continue;
+        }
+
+        anjay_coap_msg_type_t type = ANJAY_COAP_MSG_CONFIRMABLE;
+        uint16_t msg_id;
+        if (is_response_to_request(sock, &frame)) {
+            type = ANJAY_COAP_MSG_ACKNOWLEDGEMENT;
+            msg_id = sock->request_id;
+            sock->has_request = false;
+        } else {
+            msg_id = sock->next_msg_id++;
+        }
+
+        /* a truncated message is still passed up with its header and token,
+         * like a truncated datagram would, so that it can be responded to */
+        uint8_t *out = (uint8_t *) buffer;
+        write_udp_header(out, type, frame.token_size, frame.code, msg_id);
+        out += sizeof(anjay_coap_msg_header_t);
+        memcpy(out, frame.token, frame.token_size);
+        out += frame.token_size;
+        memcpy(out, frame.body, frame.body_size);
+        *out_bytes_received = (size_t) (out + frame.body_size
+                                        - (uint8_t *) buffer);
+
+        consume_received(sock, frame.frame_size);
+        return frame.truncated ? fail_with_errno(sock, EMSGSIZE) : 0;
+    }
+}
+
+static int tcp_connect(avs_net_abstract_socket_t *sock_,
+                       const char *host,
+                       const char *port) {
+    coap_tcp_socket_t *sock = (coap_tcp_socket_t *) sock_;
+    sock->error_code = 0;
+    reset_connection_state(sock);
+    if (avs_net_socket_connect(sock->backend, host, port)) {
+        return -1;
+    }
+    /* RFC 8323, 5.3: CSM MUST be the first message sent on a connection */
+    return send_csm(sock);
+}
+
+static int tcp_bind(avs_net_abstract_socket_t *sock_,
+                    const char *address,
+                    const char *port) {
+    coap_tcp_socket_t *sock = (coap_tcp_socket_t *) sock_;
+    sock->error_code = 0;
+    return avs_net_socket_bind(sock->backend, address, port);
+}
+
+static int tcp_close(avs_net_abstract_socket_t *sock_) {
+    coap_tcp_socket_t *sock = (coap_tcp_socket_t *) sock_;
+    sock->error_code = 0;
+    reset_connection_state(sock);
+    return avs_net_socket_close(sock->backend);
+}
+
+static int tcp_shutdown(avs_net_abstract_socket_t *sock_) {
+    coap_tcp_socket_t *sock = (coap_tcp_socket_t *) sock_;
+    sock->error_code = 0;
+    return avs_net_socket_shutdown(sock->backend);
+}
+
+static int tcp_cleanup(avs_net_abstract_socket_t **sock_ptr) {
+    coap_tcp_socket_t *sock = (coap_tcp_socket_t *) *sock_ptr;
+    int result = avs_net_socket_cleanup(&sock->backend);
+    free(sock->send_buffer);
+    free(sock->recv_buffer);
+    free(sock);
+    *sock_ptr = NULL;
+    return result;
+}
+
+static const void *tcp_get_system(avs_net_abstract_socket_t *sock_) {
+    return avs_net_socket_get_system(((coap_tcp_socket_t *) sock_)->backend);
+}
+
+static int tcp_get_interface(avs_net_abstract_socket_t *sock_,
+                             avs_net_socket_interface_name_t *if_name) {
+    return avs_net_socket_interface_name(
+            ((coap_tcp_socket_t *) sock_)->backend, if_name);
+}
+
+static int tcp_get_remote_host(avs_net_abstract_socket_t *sock_,
+                               char *out_buffer,
+                               size_t out_buffer_size) {
+    return avs_net_socket_get_remote_host(
+            ((coap_tcp_socket_t *) sock_)->backend,
+            out_buffer, out_buffer_size);
+}
+
+static int tcp_get_remote_hostname(avs_net_abstract_socket_t *sock_,
+                                   char *out_buffer,
+                                   size_t out_buffer_size) {
+    return avs_net_socket_get_remote_hostname(
+            ((coap_tcp_socket_t *) sock_)->backend,
+            out_buffer, out_buffer_size);
+}
+
+static int tcp_get_remote_port(avs_net_abstract_socket_t *sock_,
+                               char *out_buffer,
+                               size_t out_buffer_size) {
+    return avs_net_socket_get_remote_port(
+            ((coap_tcp_socket_t *) sock_)->backend,
+            out_buffer, out_buffer_size);
+}
+
+static int tcp_get_local_port(avs_net_abstract_socket_t *sock_,
+                              char *out_buffer,
+                              size_t out_buffer_size) {
+    return avs_net_socket_get_local_port(
+            ((coap_tcp_socket_t *) sock_)->backend,
+            out_buffer, out_buffer_size);
+}
+
+static int tcp_get_opt(avs_net_abstract_socket_t *sock_,
+                       avs_net_socket_opt_key_t option_key,
+                       avs_net_socket_opt_value_t *out_option_value) {
+    coap_tcp_socket_t *sock = (coap_tcp_socket_t *) sock_;
+    sock->error_code = 0;
+    switch (option_key) {
+    case AVS_NET_SOCKET_OPT_MTU:
+    case AVS_NET_SOCKET_OPT_INNER_MTU:
+        {
+            /* messages are measured in the UDP format; its header may be up
+             * to 2 bytes shorter than the TCP one */
+            const uint32_t overhead = COAP_TCP_MAX_FRAME_HEADER_SIZE
+                                      - sizeof(anjay_coap_msg_header_t);
+            const uint32_t max_message_size =
+                    AVS_MIN(sock->peer_max_message_size, (uint32_t) INT_MAX);
+            assert(max_message_size >= COAP_TCP_MAX_FRAME_HEADER_SIZE);
+            out_option_value->mtu = (int) (max_message_size - overhead);
+            return 0;
+        }
+    default:
+        return avs_net_socket_get_opt(sock->backend, option_key,
+                                      out_option_value);
+    }
+}
+
+static int tcp_set_opt(avs_net_abstract_socket_t *sock_,
+                       avs_net_socket_opt_key_t option_key,
+                       avs_net_socket_opt_value_t option_value) {
+    coap_tcp_socket_t *sock = (coap_tcp_socket_t *) sock_;
+    sock->error_code = 0;
+    return avs_net_socket_set_opt(sock->backend, option_key, option_value);
+}
+
+static int tcp_errno(avs_net_abstract_socket_t *sock_) {
+    coap_tcp_socket_t *sock = (coap_tcp_socket_t *) sock_;
+    return sock->error_code ? sock->error_code
+                            : avs_net_socket_errno(sock->backend);
+}
+
+static int tcp_decorate(avs_net_abstract_socket_t *sock_,
+                        avs_net_abstract_socket_t *backend) {
+    (void) backend;
+    return fail_with_errno((coap_tcp_socket_t *) sock_, ENOTSUP);
+}
+
+static int tcp_send_to(avs_net_abstract_socket_t *sock_,
+                       size_t *out_bytes_sent,
+                       const void *buffer,
+                       size_t buffer_length,
+                       const char *host,
+                       const char *port) {
+    (void) out_bytes_sent; (void) buffer; (void) buffer_length; (void) host;
+    (void) port;
+    return fail_with_errno((coap_tcp_socket_t *) sock_, ENOTSUP);
+}
+
+static int tcp_receive_from(avs_net_abstract_socket_t *sock_,
+                            size_t *out_bytes_received,
+                            void *buffer,
+                            size_t buffer_length,
+                            char *out_host,
+                            size_t out_host_size,
+                            char *out_port,
+                            size_t out_port_size) {
+    (void) out_bytes_received; (void) buffer; (void) buffer_length;
+    (void) out_host; (void) out_host_size; (void) out_port;
+    (void) out_port_size;
+    return fail_with_errno((coap_tcp_socket_t *) sock_, ENOTSUP);
+}
+
+static int tcp_accept(avs_net_abstract_socket_t *server_socket,
+                      avs_net_abstract_socket_t *new_socket) {
+    (void) new_socket;
+    return fail_with_errno((coap_tcp_socket_t *) server_socket, ENOTSUP);
+}
+
+static const avs_net_socket_v_table_t COAP_TCP_SOCKET_VTABLE = {
+    .connect = tcp_connect,
+    .decorate = tcp_decorate,
+    .send = tcp_send,
+    .send_to = tcp_send_to,
+    .receive = tcp_receive,
+    .receive_from = tcp_receive_from,
+    .bind = tcp_bind,
+    .accept = tcp_accept,
+    .close = tcp_close,
+    .shutdown = tcp_shutdown,
+    .cleanup = tcp_cleanup,
+    .get_system_socket = tcp_get_system,
+    .get_interface_name = tcp_get_interface,
+    .get_remote_host = tcp_get_remote_host,
+    .get_remote_hostname = tcp_get_remote_hostname,
+    .get_remote_port = tcp_get_remote_port,
+    .get_local_port = tcp_get_local_port,
+    .get_opt = tcp_get_opt,
+    .set_opt = tcp_set_opt,
+    .get_errno = tcp_errno
+};
+
+int _anjay_coap_tcp_socket_create(avs_net_abstract_socket_t **out_socket,
+                                  avs_net_abstract_socket_t *backend) {
+    const coap_tcp_socket_t initializer = {
+        .operations = &COAP_TCP_SOCKET_VTABLE,
+        .backend = backend
+    };
+    coap_tcp_socket_t *sock =
+            (coap_tcp_socket_t *) malloc(sizeof(coap_tcp_socket_t));
+    if (!sock) {
+        coap_log(ERROR, "out of memory");
+        avs_net_socket_cleanup(&backend);
+        return -1;
+    }
+    memcpy(sock, &initializer, sizeof(*sock));
+    reset_connection_state(sock);
+
+    *out_socket = (avs_net_abstract_socket_t *) sock;
+    return 0;
+}
+
+#ifdef ANJAY_TEST
+#include "test/tcp_socket.c"
+#endif // ANJAY_TEST
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_COAP_TCP_SOCKET_H
+#define ANJAY_COAP_TCP_SOCKET_H
+
+#include <avsystem/commons/net.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * Maximum message size assumed for the peer until it announces its own in
+ * a Capabilities and Settings Message (RFC 8323, 5.3.1).
+ */
+#define ANJAY_COAP_TCP_DEFAULT_MAX_MESSAGE_SIZE 1152
+
+/**
+ * Creates a socket that carries CoAP messages over a reliable, stream-oriented
+ * @p backend (TCP or TLS socket), using the framing defined in RFC 8323.
+ *
+ * The created socket exchanges messages in the RFC 7252 (UDP) format with its
+ * user, so that it may be used by @ref anjay_coap_socket_t unmodified:
+ *
+ * - outgoing messages are stripped of their Type and Message ID; Empty
+ *   messages (ACK, Reset) and retransmissions of Confirmable messages are
+ *   not sent at all, as the transport is reliable,
+ *
+ * - incoming messages are given a Type and Message ID: a response to the last
+ *   Confirmable request becomes a piggybacked ACK of that request, any other
+ *   message becomes a Confirmable one,
+ *
+ * - after sending a Confirmable message that is not a request (e.g.
+ *   a notification), an Empty ACK is reported as received, since reliable
+ *   delivery is already guaranteed by the transport,
+ *
+ * - signaling messages (CSM, Ping, Pong, Release, Abort) are handled
+ *   internally; CSM is sent after connecting and Release/Abort from the peer
+ *   is reported as a receive error.
+ *
+ * The AVS_NET_SOCKET_OPT_MTU and AVS_NET_SOCKET_OPT_INNER_MTU options report
+ * the Max-Message-Size announced by the peer.
+ *
+ * @param out_socket Pointer to a variable to store the created socket in.
+ * @param backend    Connection-oriented socket to wrap. Its ownership is
+ *                   transferred to the created socket, even on failure.
+ *
+ * @returns 0 on success, a negative value in case of error.
+ */
+int _anjay_coap_tcp_socket_create(avs_net_abstract_socket_t **out_socket,
+                                  avs_net_abstract_socket_t *backend);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // ANJAY_COAP_TCP_SOCKET_H
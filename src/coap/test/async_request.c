@@ -0,0 +1,184 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <avsystem/commons/unit/mocksock.h>
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay_test/mock_clock.h>
+
+#include "../../utils.h"
+
+// CON POST /rd, msg id 0x1234, token "ab", payload "</1>"
+static const char REQUEST[] = "\x42\x02\x12\x34" "ab" "\xB2" "rd" "\xFF" "</1>";
+
+typedef struct {
+    avs_net_abstract_socket_t *mocksock;
+    anjay_coap_async_request_t *request;
+} test_env_t;
+
+static test_env_t setup_with_buffer_size(size_t out_buffer_size,
+                                         bool expect_sent) {
+    _anjay_mock_clock_start(&(const struct timespec) { 1000, 0 });
+
+    test_env_t env = { NULL, NULL };
+    avs_unit_mocksock_create(&env.mocksock);
+    avs_unit_mocksock_expect_connect(env.mocksock, "", "");
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(env.mocksock, "", ""));
+    avs_unit_mocksock_enable_recv_timeout_getsetopt(env.mocksock, 1000);
+    avs_unit_mocksock_enable_inner_mtu_getopt(env.mocksock, 1252);
+
+    const anjay_coap_async_request_config_t config = {
+        .socket = env.mocksock,
+        .tx_params = &_anjay_coap_DEFAULT_TX_PARAMS,
+        .rtt_estimator = NULL,
+        .out_buffer_size = out_buffer_size,
+        .in_buffer_size = 4096,
+        .rand_seed = 42
+    };
+    anjay_msg_details_t details = {
+        .msg_type = ANJAY_COAP_MSG_CONFIRMABLE,
+        .msg_code = ANJAY_COAP_CODE_POST,
+        .format = ANJAY_COAP_FORMAT_NONE,
+        .uri_path = _anjay_make_string_list("rd", NULL)
+    };
+    const anjay_coap_msg_identity_t identity = {
+        .msg_id = 0x1234,
+        .token = { "ab" },
+        .token_size = 2
+    };
+
+    if (expect_sent) {
+        avs_unit_mocksock_expect_output(env.mocksock, REQUEST,
+                                        sizeof(REQUEST) - 1);
+    }
+    int result = _anjay_coap_async_request_send(&env.request, &config,
+                                                &details, &identity, "</1>", 4);
+    AVS_LIST_CLEAR(&details.uri_path);
+
+    if (expect_sent) {
+        AVS_UNIT_ASSERT_SUCCESS(result);
+        AVS_UNIT_ASSERT_EQUAL(_anjay_coap_async_request_state(env.request),
+                              ANJAY_COAP_ASYNC_REQUEST_WAITING);
+    } else {
+        AVS_UNIT_ASSERT_EQUAL(result, ANJAY_COAP_ASYNC_REQUEST_TOO_LARGE);
+        AVS_UNIT_ASSERT_NULL(env.request);
+    }
+    return env;
+}
+
+static test_env_t setup(void) {
+    return setup_with_buffer_size(4096, true);
+}
+
+static void teardown(test_env_t *env) {
+    avs_unit_mocksock_assert_expects_met(env->mocksock);
+    _anjay_coap_async_request_cleanup(&env->request);
+    avs_net_socket_cleanup(&env->mocksock);
+    _anjay_mock_clock_finish();
+}
+
+static void receive(test_env_t *env, const char *data, size_t size) {
+    avs_unit_mocksock_input(env->mocksock, data, size);
+    _anjay_coap_async_request_handle_readable(env->request);
+}
+
+#define RECEIVE(Env, Data) receive((Env), (Data), sizeof(Data) - 1)
+
+AVS_UNIT_TEST(coap_async_request, piggybacked_response) {
+    test_env_t env = setup();
+
+    // mismatched message ID
+    RECEIVE(&env, "\x62\x41\x12\x35" "ab");
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_async_request_state(env.request),
+                          ANJAY_COAP_ASYNC_REQUEST_WAITING);
+    AVS_UNIT_ASSERT_NULL(_anjay_coap_async_request_response(env.request));
+
+    RECEIVE(&env, "\x62\x41\x12\x34" "ab");
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_async_request_state(env.request),
+                          ANJAY_COAP_ASYNC_REQUEST_FINISHED);
+    const anjay_coap_msg_t *response =
+            _anjay_coap_async_request_response(env.request);
+    AVS_UNIT_ASSERT_NOT_NULL(response);
+    AVS_UNIT_ASSERT_EQUAL(response->header.code, ANJAY_COAP_CODE_CREATED);
+
+    teardown(&env);
+}
+
+AVS_UNIT_TEST(coap_async_request, separate_response) {
+    test_env_t env = setup();
+
+    RECEIVE(&env, "\x60\x00\x12\x34");
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_async_request_state(env.request),
+                          ANJAY_COAP_ASYNC_REQUEST_WAITING);
+
+    // acknowledged requests are not retransmitted
+    _anjay_mock_clock_advance(&(const struct timespec) { 10, 0 });
+    _anjay_coap_async_request_handle_timeout(env.request);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_async_request_state(env.request),
+                          ANJAY_COAP_ASYNC_REQUEST_WAITING);
+
+    avs_unit_mocksock_expect_output(env.mocksock, "\x60\x00\x56\x78", 4);
+    RECEIVE(&env, "\x42\x41\x56\x78" "ab");
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_async_request_state(env.request),
+                          ANJAY_COAP_ASYNC_REQUEST_FINISHED);
+    AVS_UNIT_ASSERT_EQUAL(
+            _anjay_coap_async_request_response(env.request)->header.code,
+            ANJAY_COAP_CODE_CREATED);
+
+    teardown(&env);
+}
+
+AVS_UNIT_TEST(coap_async_request, reset) {
+    test_env_t env = setup();
+
+    RECEIVE(&env, "\x70\x00\x12\x34");
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_async_request_state(env.request),
+                          ANJAY_COAP_ASYNC_REQUEST_FAILED);
+    AVS_UNIT_ASSERT_NULL(_anjay_coap_async_request_response(env.request));
+
+    teardown(&env);
+}
+
+AVS_UNIT_TEST(coap_async_request, retransmissions) {
+    test_env_t env = setup();
+
+    // nothing happens before the deadline
+    _anjay_coap_async_request_handle_timeout(env.request);
+
+    for (unsigned i = 0; i < _anjay_coap_DEFAULT_TX_PARAMS.max_retransmit;
+            ++i) {
+        _anjay_mock_clock_advance(&(const struct timespec) { 100, 0 });
+        avs_unit_mocksock_expect_output(env.mocksock, REQUEST,
+                                        sizeof(REQUEST) - 1);
+        _anjay_coap_async_request_handle_timeout(env.request);
+        AVS_UNIT_ASSERT_EQUAL(_anjay_coap_async_request_state(env.request),
+                              ANJAY_COAP_ASYNC_REQUEST_WAITING);
+    }
+
+    _anjay_mock_clock_advance(&(const struct timespec) { 100, 0 });
+    _anjay_coap_async_request_handle_timeout(env.request);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_async_request_state(env.request),
+                          ANJAY_COAP_ASYNC_REQUEST_FAILED);
+
+    teardown(&env);
+}
+
+AVS_UNIT_TEST(coap_async_request, too_large) {
+    test_env_t env = setup_with_buffer_size(sizeof(REQUEST) - 2, false);
+    teardown(&env);
+}
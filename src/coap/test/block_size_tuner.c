@@ -0,0 +1,94 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <avsystem/commons/unit/test.h>
+
+AVS_UNIT_TEST(coap_block_size_tuner, no_limit_by_default) {
+    coap_block_size_tuner_t tuner = { .block_size = 0 };
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_block_size_tuner_limit(&tuner, 1024),
+                          1024);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_block_size_tuner_limit(NULL, 1024),
+                          1024);
+
+    for (int i = 0; i < 2 * COAP_BLOCK_SIZE_TUNER_CLEAN_STREAK; ++i) {
+        _anjay_coap_block_size_tuner_block_sent(&tuner, 1024, 0);
+    }
+    // single lost blocks do not matter
+    _anjay_coap_block_size_tuner_block_sent(&tuner, 1024, 1);
+    _anjay_coap_block_size_tuner_block_sent(&tuner, 1024, 0);
+    _anjay_coap_block_size_tuner_block_sent(&tuner, 1024, 2);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_block_size_tuner_limit(&tuner, 1024),
+                          1024);
+}
+
+AVS_UNIT_TEST(coap_block_size_tuner, loss_and_recovery) {
+    coap_block_size_tuner_t tuner = { .block_size = 0 };
+    for (int i = 0; i < COAP_BLOCK_SIZE_TUNER_LOSS_STREAK; ++i) {
+        _anjay_coap_block_size_tuner_block_sent(&tuner, 1024, 1);
+    }
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_block_size_tuner_limit(&tuner, 1024),
+                          512);
+    // smaller sizes requested by the peer are unaffected
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_block_size_tuner_limit(&tuner, 256),
+                          256);
+
+    for (int i = 0; i < COAP_BLOCK_SIZE_TUNER_CLEAN_STREAK - 1; ++i) {
+        _anjay_coap_block_size_tuner_block_sent(&tuner, 512, 0);
+    }
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_block_size_tuner_limit(&tuner, 1024),
+                          512);
+    _anjay_coap_block_size_tuner_block_sent(&tuner, 512, 0);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_block_size_tuner_limit(&tuner, 1024),
+                          1024);
+    AVS_UNIT_ASSERT_EQUAL(tuner.block_size, 0);
+}
+
+AVS_UNIT_TEST(coap_block_size_tuner, msg_too_long_caps_size) {
+    coap_block_size_tuner_t tuner = { .block_size = 0 };
+    _anjay_coap_block_size_tuner_msg_too_long(&tuner, 1024);
+    _anjay_coap_block_size_tuner_msg_too_long(&tuner, 512);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_block_size_tuner_limit(&tuner, 1024),
+                          256);
+
+    for (int i = 0; i < COAP_BLOCK_SIZE_TUNER_LOSS_STREAK; ++i) {
+        _anjay_coap_block_size_tuner_block_sent(&tuner, 256, 1);
+    }
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_block_size_tuner_limit(&tuner, 1024),
+                          128);
+
+    // recovers from loss, but never above the cap
+    for (int i = 0; i < 4 * COAP_BLOCK_SIZE_TUNER_CLEAN_STREAK; ++i) {
+        _anjay_coap_block_size_tuner_block_sent(&tuner, 128, 0);
+    }
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_block_size_tuner_limit(&tuner, 1024),
+                          256);
+}
+
+AVS_UNIT_TEST(coap_block_size_tuner, min_size) {
+    coap_block_size_tuner_t tuner = { .block_size = 0 };
+    _anjay_coap_block_size_tuner_msg_too_long(&tuner, 16);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_block_size_tuner_limit(&tuner, 1024),
+                          1024);
+
+    _anjay_coap_block_size_tuner_msg_too_long(&tuner, 32);
+    for (int i = 0; i < COAP_BLOCK_SIZE_TUNER_LOSS_STREAK; ++i) {
+        _anjay_coap_block_size_tuner_block_sent(&tuner, 16, 1);
+    }
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_block_size_tuner_limit(&tuner, 1024),
+                          16);
+}
@@ -514,3 +514,86 @@ AVS_UNIT_TEST(coap_msg, fuzz_3_token_and_options) {
     AVS_UNIT_ASSERT_FALSE(_anjay_coap_msg_is_valid(msg));
 }
 
+
+AVS_UNIT_TEST(coap_msg, opt_index) {
+    uint8_t content[] = "\x01\x02"                  // token
+                        "\xb1" "a"                  // Uri-Path
+                        "\x02" "bc"                 // Uri-Path
+                        "\x11" "\x00"               // Content-Format
+                        "\x31" "x"                  // Uri-Query
+                        PAYLOAD_MARKER "foo";
+    anjay_coap_msg_t *msg =
+            (anjay_coap_msg_t *) alloca(sizeof(*msg) + sizeof(content) - 1);
+    setup_msg(msg, content, sizeof(content) - 1);
+    msg->header.version_type_token_length = VTTL(1, 0, 2);
+    AVS_UNIT_ASSERT_TRUE(_anjay_coap_msg_is_valid(msg));
+
+    anjay_coap_opt_index_t index;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_opt_index_build(&index, msg));
+    AVS_UNIT_ASSERT_TRUE(index.msg == msg);
+    AVS_UNIT_ASSERT_EQUAL(index.num_opts, 4);
+
+    AVS_UNIT_ASSERT_EQUAL(index.entries[0].number, ANJAY_COAP_OPT_URI_PATH);
+    AVS_UNIT_ASSERT_EQUAL(index.entries[0].offset, 2);
+    AVS_UNIT_ASSERT_EQUAL(index.entries[0].length, 1);
+    AVS_UNIT_ASSERT_EQUAL(index.entries[1].number, ANJAY_COAP_OPT_URI_PATH);
+    AVS_UNIT_ASSERT_EQUAL(index.entries[1].offset, 4);
+    AVS_UNIT_ASSERT_EQUAL(index.entries[1].length, 2);
+    AVS_UNIT_ASSERT_EQUAL(index.entries[2].number,
+                          ANJAY_COAP_OPT_CONTENT_FORMAT);
+    AVS_UNIT_ASSERT_EQUAL(index.entries[3].number, ANJAY_COAP_OPT_URI_QUERY);
+
+    AVS_UNIT_ASSERT_TRUE(_anjay_coap_opt_index_payload(&index)
+                         == _anjay_coap_msg_payload(msg));
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_opt_index_payload_length(&index), 3);
+
+    const anjay_coap_opt_t *opt;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_opt_index_find_unique(
+            &index, ANJAY_COAP_OPT_CONTENT_FORMAT, &opt));
+    AVS_UNIT_ASSERT_TRUE(opt == _anjay_coap_opt_index_get(&index, 2));
+
+    AVS_UNIT_ASSERT_FAILED(_anjay_coap_opt_index_find_unique(
+            &index, ANJAY_COAP_OPT_URI_PATH, &opt));
+    AVS_UNIT_ASSERT_TRUE(opt == _anjay_coap_opt_index_get(&index, 0));
+
+    AVS_UNIT_ASSERT_FAILED(_anjay_coap_opt_index_find_unique(
+            &index, ANJAY_COAP_OPT_ACCEPT, &opt));
+    AVS_UNIT_ASSERT_NULL(opt);
+
+    opt = _anjay_coap_opt_index_find_next(&index, ANJAY_COAP_OPT_URI_PATH,
+                                          NULL);
+    AVS_UNIT_ASSERT_TRUE(opt == _anjay_coap_opt_index_get(&index, 0));
+    opt = _anjay_coap_opt_index_find_next(&index, ANJAY_COAP_OPT_URI_PATH,
+                                          opt);
+    AVS_UNIT_ASSERT_TRUE(opt == _anjay_coap_opt_index_get(&index, 1));
+    AVS_UNIT_ASSERT_NULL(_anjay_coap_opt_index_find_next(
+            &index, ANJAY_COAP_OPT_URI_PATH, opt));
+}
+
+AVS_UNIT_TEST(coap_msg, opt_index_no_options) {
+    uint8_t content[] = PAYLOAD_MARKER "foo";
+    anjay_coap_msg_t *msg =
+            (anjay_coap_msg_t *) alloca(sizeof(*msg) + sizeof(content) - 1);
+    setup_msg(msg, content, sizeof(content) - 1);
+
+    anjay_coap_opt_index_t index;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_opt_index_build(&index, msg));
+    AVS_UNIT_ASSERT_EQUAL(index.num_opts, 0);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_opt_index_lower_bound(&index, 0), 0);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_opt_index_payload_length(&index), 3);
+}
+
+AVS_UNIT_TEST(coap_msg, opt_index_too_many_options) {
+    uint8_t content[ANJAY_COAP_OPT_INDEX_MAX_OPTS + 1];
+    memset(content, 0, sizeof(content)); // empty options with number 0
+    anjay_coap_msg_t *msg =
+            (anjay_coap_msg_t *) alloca(sizeof(*msg) + sizeof(content));
+    setup_msg(msg, content, sizeof(content) - 1);
+
+    anjay_coap_opt_index_t index;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_opt_index_build(&index, msg));
+    AVS_UNIT_ASSERT_EQUAL(index.num_opts, ANJAY_COAP_OPT_INDEX_MAX_OPTS);
+
+    setup_msg(msg, content, sizeof(content));
+    AVS_UNIT_ASSERT_FAILED(_anjay_coap_opt_index_build(&index, msg));
+}
@@ -19,6 +19,12 @@
 #include <sys/types.h>
 #include <alloca.h>
 
+#if defined(__GLIBC__) \
+        && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define HAVE_MALLINFO2
+#endif
+
 #include <avsystem/commons/unit/test.h>
 
 #define RANDOM_MSGID ((uint16_t)4)
@@ -439,3 +445,116 @@ AVS_UNIT_TEST(coap_builder, payload_call_with_zero_size_then_nonzero) {
 }
 
 #undef PAYLOAD
+
+AVS_UNIT_TEST(coap_info, remove_by_number) {
+    anjay_coap_msg_info_t info = INFO_WITH_DUMMY_HEADER;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_msg_info_opt_string(
+            &info, ANJAY_COAP_OPT_URI_QUERY, "query"));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_msg_info_opt_u32(
+            &info, ANJAY_COAP_OPT_BLOCK2, 0x12345));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_msg_info_opt_string(
+            &info, ANJAY_COAP_OPT_URI_PATH, "path"));
+
+    _anjay_coap_msg_info_opt_remove_by_number(&info, ANJAY_COAP_OPT_BLOCK2);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_msg_info_opt_u32(
+            &info, ANJAY_COAP_OPT_BLOCK2, 0x23456));
+    _anjay_coap_msg_info_opt_remove_by_number(&info, ANJAY_COAP_OPT_BLOCK2);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_msg_info_opt_u32(
+            &info, ANJAY_COAP_OPT_BLOCK2, 0x34567));
+    AVS_UNIT_ASSERT_EQUAL(info.num_options_, 3);
+    AVS_UNIT_ASSERT_EQUAL(info.options_data_size_,
+                          sizeof("query") - 1 + sizeof("path") - 1 + 3);
+
+    static const char EXPECTED[] = "\xb4" "path"
+                                   "\x45" "query"
+                                   "\x83" "\x03\x45\x67";
+    uint8_t storage[64] __attribute__((aligned(_ANJAY_COAP_MSG_ALIGNMENT)));
+    const anjay_coap_msg_t *msg = _anjay_coap_msg_build_without_payload(
+            _anjay_coap_ensure_aligned_buffer(storage), sizeof(storage), &info);
+    AVS_UNIT_ASSERT_NOT_NULL(msg);
+    AVS_UNIT_ASSERT_EQUAL(msg->length,
+                          sizeof(msg->header) + sizeof(EXPECTED) - 1);
+    AVS_UNIT_ASSERT_EQUAL_BYTES(msg->content, EXPECTED);
+}
+
+AVS_UNIT_TEST(coap_info, inline_storage_exhausted) {
+    enum { NUM_OPTS = 3 * ANJAY_COAP_MSG_INFO_INLINE_OPTS };
+    anjay_coap_msg_info_t info = INFO_WITH_DUMMY_HEADER;
+    for (size_t i = 0; i < NUM_OPTS; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_msg_info_opt_u16(
+                &info, (uint16_t) (NUM_OPTS - i), (uint16_t) i));
+    }
+    AVS_UNIT_ASSERT_EQUAL(info.num_options_, NUM_OPTS);
+    AVS_UNIT_ASSERT_NOT_NULL(info.options_heap_);
+
+    const anjay_coap_msg_info_opt_t *opts = _anjay_coap_msg_info_opts(&info);
+    for (size_t i = 0; i < NUM_OPTS; ++i) {
+        uint8_t expected = (uint8_t) (NUM_OPTS - 1 - i);
+        AVS_UNIT_ASSERT_EQUAL(opts[i].number, i + 1);
+        AVS_UNIT_ASSERT_EQUAL(opts[i].data_size, expected ? 1 : 0);
+        if (expected) {
+            AVS_UNIT_ASSERT_EQUAL(
+                    *_anjay_coap_msg_info_opt_data(&info, &opts[i]), expected);
+        }
+    }
+    _anjay_coap_msg_info_reset(&info);
+    AVS_UNIT_ASSERT_NULL(info.options_heap_);
+
+    enum { DATA_SIZE = 3 * ANJAY_COAP_MSG_INFO_INLINE_OPTS_DATA_SIZE };
+    char *data = (char *) malloc(DATA_SIZE);
+    AVS_UNIT_ASSERT_NOT_NULL(data);
+    memset(data, 'x', DATA_SIZE);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_msg_info_opt_string(
+            &info, ANJAY_COAP_OPT_URI_PATH, "rd"));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_msg_info_opt_opaque(
+            &info, ANJAY_COAP_OPT_URI_QUERY, data, DATA_SIZE));
+    AVS_UNIT_ASSERT_NOT_NULL(info.options_data_heap_);
+    AVS_UNIT_ASSERT_EQUAL(info.options_data_size_, DATA_SIZE + 2);
+
+    opts = _anjay_coap_msg_info_opts(&info);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(
+            _anjay_coap_msg_info_opt_data(&info, &opts[0]), "rd", 2);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(
+            _anjay_coap_msg_info_opt_data(&info, &opts[1]), data, DATA_SIZE);
+    _anjay_coap_msg_info_reset(&info);
+    AVS_UNIT_ASSERT_NULL(info.options_data_heap_);
+    free(data);
+}
+
+AVS_UNIT_TEST(coap_info, no_heap_allocations) {
+#ifdef HAVE_MALLINFO2
+    const size_t heap_in_use = mallinfo2().uordblks;
+#endif
+
+    anjay_coap_msg_info_t info = INFO_WITH_DUMMY_HEADER;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_msg_info_opt_u32(
+            &info, ANJAY_COAP_OPT_OBSERVE, 42));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_msg_info_opt_string(
+            &info, ANJAY_COAP_OPT_URI_PATH, "rd"));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_msg_info_opt_string(
+            &info, ANJAY_COAP_OPT_URI_PATH, "5a3f"));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_msg_info_opt_string(
+            &info, ANJAY_COAP_OPT_URI_QUERY, "lt=86400"));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_msg_info_opt_content_format(
+            &info, ANJAY_COAP_FORMAT_TLV));
+    AVS_UNIT_ASSERT_NULL(info.options_data_heap_);
+    // sampled before reset, which would free anything the options allocated
+#ifdef HAVE_MALLINFO2
+    AVS_UNIT_ASSERT_EQUAL(mallinfo2().uordblks, heap_in_use);
+#endif
+
+    uint8_t storage[256] __attribute__((aligned(_ANJAY_COAP_MSG_ALIGNMENT)));
+    AVS_UNIT_ASSERT_TRUE(_anjay_coap_msg_info_get_storage_size(&info)
+                         <= sizeof(storage));
+    AVS_UNIT_ASSERT_NOT_NULL(_anjay_coap_msg_build_without_payload(
+            _anjay_coap_ensure_aligned_buffer(storage), sizeof(storage),
+            &info));
+#ifdef HAVE_MALLINFO2
+    AVS_UNIT_ASSERT_EQUAL(mallinfo2().uordblks, heap_in_use);
+#endif
+
+    _anjay_coap_msg_info_reset(&info);
+#ifdef HAVE_MALLINFO2
+    AVS_UNIT_ASSERT_EQUAL(mallinfo2().uordblks, heap_in_use);
+#endif
+}
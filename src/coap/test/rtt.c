@@ -0,0 +1,152 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay_test/mock_clock.h>
+
+#define TX_PARAMS (&_anjay_coap_DEFAULT_TX_PARAMS)
+
+AVS_UNIT_TEST(coap_rtt, no_samples_use_tx_params) {
+    coap_rtt_estimator_t estimator = { .rto_ms = 0 };
+    anjay_rand_seed_t seed = 42;
+
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_rtt_current_rto_ms(&estimator,
+                                                         TX_PARAMS),
+                          2000);
+    for (int i = 0; i < 16; ++i) {
+        int32_t timeout_ms =
+                _anjay_coap_rtt_initial_timeout_ms(&estimator, TX_PARAMS,
+                                                   &seed);
+        AVS_UNIT_ASSERT_TRUE(timeout_ms >= 2000 && timeout_ms < 3000);
+    }
+    AVS_UNIT_ASSERT_EQUAL(
+            _anjay_coap_rtt_backoff_timeout_ms(&estimator, TX_PARAMS, 2500),
+            5000);
+}
+
+AVS_UNIT_TEST(coap_rtt, strong_sample) {
+    coap_rtt_estimator_t estimator = { .rto_ms = 0 };
+
+    // SRTT = 400, RTTVAR = 200 -> strong RTO = 1200, blended with 2000
+    _anjay_coap_rtt_update(&estimator, TX_PARAMS, 400, 0);
+    AVS_UNIT_ASSERT_EQUAL(estimator.strong.samples, 1);
+    AVS_UNIT_ASSERT_EQUAL(estimator.strong.srtt_ms, 400);
+    AVS_UNIT_ASSERT_EQUAL(estimator.strong.rttvar_ms, 200);
+    AVS_UNIT_ASSERT_EQUAL(estimator.weak.samples, 0);
+    AVS_UNIT_ASSERT_EQUAL(estimator.rto_ms, 1600);
+
+    // SRTT = (7 * 400 + 480) / 8 = 410, RTTVAR = (3 * 200 + 80) / 4 = 170
+    _anjay_coap_rtt_update(&estimator, TX_PARAMS, 480, 0);
+    AVS_UNIT_ASSERT_EQUAL(estimator.strong.srtt_ms, 410);
+    AVS_UNIT_ASSERT_EQUAL(estimator.strong.rttvar_ms, 170);
+    AVS_UNIT_ASSERT_EQUAL(estimator.rto_ms, (410 + 4 * 170 + 1600) / 2);
+}
+
+AVS_UNIT_TEST(coap_rtt, weak_sample) {
+    coap_rtt_estimator_t estimator = { .rto_ms = 0 };
+
+    // SRTT = 3000, RTTVAR = 1500 -> weak RTO = 4500, weighted 1/4
+    _anjay_coap_rtt_update(&estimator, TX_PARAMS, 3000, 1);
+    AVS_UNIT_ASSERT_EQUAL(estimator.strong.samples, 0);
+    AVS_UNIT_ASSERT_EQUAL(estimator.weak.samples, 1);
+    AVS_UNIT_ASSERT_EQUAL(estimator.rto_ms, (4500 + 3 * 2000) / 4);
+}
+
+AVS_UNIT_TEST(coap_rtt, ambiguous_sample_ignored) {
+    coap_rtt_estimator_t estimator = { .rto_ms = 0 };
+
+    _anjay_coap_rtt_update(&estimator, TX_PARAMS, 3000, 3);
+    AVS_UNIT_ASSERT_EQUAL(estimator.strong.samples, 0);
+    AVS_UNIT_ASSERT_EQUAL(estimator.weak.samples, 0);
+    AVS_UNIT_ASSERT_EQUAL(estimator.rto_ms, 0);
+}
+
+AVS_UNIT_TEST(coap_rtt, clamp_and_variable_backoff) {
+    coap_rtt_estimator_t estimator = { .rto_ms = 0 };
+
+    for (int i = 0; i < 16; ++i) {
+        _anjay_coap_rtt_update(&estimator, TX_PARAMS, 0, 0);
+    }
+    AVS_UNIT_ASSERT_EQUAL(estimator.rto_ms, 100);
+    // RTO < 1 s: backoff factor 3
+    AVS_UNIT_ASSERT_EQUAL(
+            _anjay_coap_rtt_backoff_timeout_ms(&estimator, TX_PARAMS, 120),
+            360);
+
+    for (int i = 0; i < 32; ++i) {
+        _anjay_coap_rtt_update(&estimator, TX_PARAMS, 100000, 0);
+    }
+    AVS_UNIT_ASSERT_EQUAL(estimator.rto_ms, 60000);
+    // RTO > 3 s: backoff factor 1.5
+    AVS_UNIT_ASSERT_EQUAL(
+            _anjay_coap_rtt_backoff_timeout_ms(&estimator, TX_PARAMS, 60000),
+            90000);
+}
+
+AVS_UNIT_TEST(coap_rtt, aging) {
+    _anjay_mock_clock_start(&(const struct timespec) { 1000, 0 });
+
+    coap_rtt_estimator_t estimator = { .rto_ms = 0 };
+    for (int i = 0; i < 16; ++i) {
+        _anjay_coap_rtt_update(&estimator, TX_PARAMS, 0, 0);
+    }
+    AVS_UNIT_ASSERT_EQUAL(estimator.rto_ms, 100);
+
+    // not aged before 16 * RTO
+    _anjay_mock_clock_advance(&(const struct timespec) { 1, 0 });
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_rtt_current_rto_ms(&estimator,
+                                                         TX_PARAMS),
+                          100);
+
+    // below 1 s, RTO is doubled after each 16 * RTO
+    _anjay_mock_clock_advance(&(const struct timespec) { 1, 0 });
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_rtt_current_rto_ms(&estimator,
+                                                         TX_PARAMS),
+                          200);
+
+    // ...but not above 1 s; no further aging in the 1-3 s range
+    _anjay_mock_clock_advance(&(const struct timespec) { 60, 0 });
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_rtt_current_rto_ms(&estimator,
+                                                         TX_PARAMS),
+                          1000);
+
+    anjay_rand_seed_t seed = 42;
+    int32_t timeout_ms = _anjay_coap_rtt_initial_timeout_ms(&estimator,
+                                                            TX_PARAMS, &seed);
+    AVS_UNIT_ASSERT_EQUAL(estimator.rto_ms, 1000);
+    AVS_UNIT_ASSERT_TRUE(timeout_ms >= 1000 && timeout_ms < 1500);
+
+    // above 3 s, RTO = 1 s + RTO / 2 after each 4 * RTO
+    estimator.rto_ms = 5000;
+    clock_gettime(CLOCK_MONOTONIC, &estimator.last_update);
+    _anjay_mock_clock_advance(&(const struct timespec) { 19, 0 });
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_rtt_current_rto_ms(&estimator,
+                                                         TX_PARAMS),
+                          5000);
+    _anjay_mock_clock_advance(&(const struct timespec) { 1, 0 });
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_rtt_current_rto_ms(&estimator,
+                                                         TX_PARAMS),
+                          3500);
+    _anjay_mock_clock_advance(&(const struct timespec) { 60, 0 });
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_rtt_current_rto_ms(&estimator,
+                                                         TX_PARAMS),
+                          2750);
+
+    _anjay_mock_clock_finish();
+}
@@ -127,3 +127,60 @@ AVS_UNIT_TEST(coap_socket, coap_socket) {
         free(storage);
     }
 }
+
+AVS_UNIT_TEST(coap_socket, send_with_payload) {
+    anjay_coap_socket_t *socket =
+            _anjay_test_setup_udp_echo_socket(TEST_PORT_UDP);
+
+    anjay_coap_msg_info_t info = _anjay_coap_msg_info_init();
+    info.type = ANJAY_COAP_MSG_CONFIRMABLE;
+    info.code = ANJAY_COAP_CODE_CONTENT;
+    info.identity.msg_id = 4;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_msg_info_opt_u16(&info, 12, 42));
+
+    static const char PAYLOAD[] = "Hello, world!";
+
+    size_t storage_size = COAP_MSG_MAX_SIZE;
+    void *storage = malloc(storage_size);
+    anjay_coap_msg_builder_t builder;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_msg_builder_init(
+            &builder, _anjay_coap_ensure_aligned_buffer(storage),
+            storage_size, &info));
+    AVS_UNIT_ASSERT_EQUAL(_anjay_coap_msg_builder_payload(
+                                  &builder, PAYLOAD, sizeof(PAYLOAD)),
+                          sizeof(PAYLOAD));
+    const anjay_coap_msg_t *expected = _anjay_coap_msg_builder_get_msg(&builder);
+
+    size_t headers_storage_size = _anjay_coap_msg_info_get_storage_size(&info);
+    void *headers_storage = malloc(headers_storage_size);
+    const anjay_coap_msg_t *headers = _anjay_coap_msg_build_without_payload(
+            _anjay_coap_ensure_aligned_buffer(headers_storage),
+            headers_storage_size, &info);
+    AVS_UNIT_ASSERT_NOT_NULL(headers);
+
+    anjay_coap_msg_t *recv_msg = (anjay_coap_msg_t *) alloca(COAP_MSG_MAX_SIZE);
+    char packet[64];
+    for (size_t headroom = 0; headroom < sizeof(packet) - sizeof(PAYLOAD);
+            ++headroom) {
+        memcpy(packet + headroom, PAYLOAD, sizeof(PAYLOAD));
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_socket_send_with_payload(
+                socket, headers, packet + headroom, sizeof(PAYLOAD),
+                headroom));
+
+        memset(recv_msg, 0, COAP_MSG_MAX_SIZE);
+        AVS_UNIT_ASSERT_SUCCESS(
+                _anjay_coap_socket_recv(socket, recv_msg, COAP_MSG_MAX_SIZE));
+        AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(recv_msg, expected,
+                                          expected->length);
+        /* payload is never modified */
+        AVS_UNIT_ASSERT_EQUAL_BYTES(packet + headroom, PAYLOAD);
+    }
+
+    /* message with payload is not a valid set of headers */
+    AVS_UNIT_ASSERT_FAILED(_anjay_coap_socket_send_with_payload(
+            socket, expected, packet, sizeof(PAYLOAD), 0));
+
+    _anjay_coap_socket_cleanup(&socket);
+    free(headers_storage);
+    free(storage);
+}
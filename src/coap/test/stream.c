@@ -514,6 +514,27 @@ AVS_UNIT_TEST(coap_stream, add_observe_option) {
         AVS_UNIT_ASSERT_SUCCESS(avs_stream_finish_message(stream));
         _anjay_mock_clock_finish();
     }
+    {
+        // the sequence may be continued from a previous run of the client
+        details.observe_serial = true;
+        _anjay_mock_clock_start(&(const struct timespec){ 777, 514 << 15 });
+        AVS_UNIT_ASSERT_SUCCESS(
+                _anjay_coap_stream_set_observe_serial(stream, 0x030201));
+        uint32_t serial;
+        AVS_UNIT_ASSERT_SUCCESS(
+                _anjay_coap_stream_get_observe_serial(stream, &serial));
+        AVS_UNIT_ASSERT_EQUAL(serial, 0x030201);
+        avs_unit_mocksock_expect_get_opt(mocksock, AVS_NET_SOCKET_OPT_INNER_MTU,
+                                         (avs_net_socket_opt_value_t)(int)1252);
+        AVS_UNIT_ASSERT_SUCCESS(
+                _anjay_coap_stream_setup_request(stream, &details, NULL, 0));
+        static const char RESPONSE[] = "\x50\x45\x69\xEF" // CoAP header
+                                       "\x63\x03\x02\x01";
+        avs_unit_mocksock_expect_output(mocksock, RESPONSE,
+                                        sizeof(RESPONSE) - 1);
+        AVS_UNIT_ASSERT_SUCCESS(avs_stream_finish_message(stream));
+        _anjay_mock_clock_finish();
+    }
     avs_unit_mocksock_assert_io_clean(mocksock);
     avs_stream_cleanup(&stream);
 }
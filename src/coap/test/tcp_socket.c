@@ -0,0 +1,205 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <avsystem/commons/unit/mocksock.h>
+#include <avsystem/commons/unit/test.h>
+
+#define CSM "\x00\xE1"
+
+static avs_net_abstract_socket_t *setup_tcp_socket(
+        avs_net_abstract_socket_t **out_mocksock) {
+    avs_unit_mocksock_create(out_mocksock);
+
+    avs_net_abstract_socket_t *sock = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_tcp_socket_create(&sock,
+                                                          *out_mocksock));
+
+    avs_unit_mocksock_expect_connect(*out_mocksock, "", "");
+    avs_unit_mocksock_expect_output(*out_mocksock, CSM, sizeof(CSM) - 1);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(sock, "", ""));
+    return sock;
+}
+
+#define ASSERT_RECEIVED(Sock, Expected)                                       \
+    do {                                                                      \
+        char buf[256];                                                        \
+        size_t received;                                                      \
+        AVS_UNIT_ASSERT_SUCCESS(                                              \
+                avs_net_socket_receive((Sock), &received, buf, sizeof(buf))); \
+        AVS_UNIT_ASSERT_EQUAL(received, sizeof(Expected) - 1);                \
+        AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, (Expected), received);         \
+    } while (0)
+
+AVS_UNIT_TEST(coap_tcp_socket, request_response) {
+    avs_net_abstract_socket_t *mocksock = NULL;
+    avs_net_abstract_socket_t *sock = setup_tcp_socket(&mocksock);
+
+    // CON GET, ID 0x1234, token "ab"
+    static const char REQUEST[] = "\x42\x01\x12\x34" "ab";
+    avs_unit_mocksock_expect_output(mocksock, "\x02\x01" "ab", 4);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_send(sock, REQUEST, sizeof(REQUEST) - 1));
+    // retransmission is not sent
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_send(sock, REQUEST, sizeof(REQUEST) - 1));
+
+    // 2.05 Content, payload "hi" -> piggybacked ACK with the request's ID
+    avs_unit_mocksock_input(mocksock, "\x32\x45" "ab" "\xFF" "hi", 7);
+    ASSERT_RECEIVED(sock, "\x62\x45\x12\x34" "ab" "\xFF" "hi");
+
+    avs_unit_mocksock_assert_expects_met(mocksock);
+    avs_net_socket_cleanup(&sock);
+}
+
+AVS_UNIT_TEST(coap_tcp_socket, incoming_request) {
+    avs_net_abstract_socket_t *mocksock = NULL;
+    avs_net_abstract_socket_t *sock = setup_tcp_socket(&mocksock);
+
+    // Empty messages are ignored, requests become Confirmable
+    avs_unit_mocksock_input(mocksock, "\x00\x00" "\x01\x01" "x", 5);
+    ASSERT_RECEIVED(sock, "\x41\x01\x00\x00" "x");
+
+    // Empty ACK is not sent, piggybacked response is
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(sock, "\x60\x00\x00\x00", 4));
+    avs_unit_mocksock_expect_output(mocksock, "\x01\x44" "x", 3);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_send(sock, "\x61\x44\x00\x00" "x", 5));
+
+    avs_unit_mocksock_assert_expects_met(mocksock);
+    avs_net_socket_cleanup(&sock);
+}
+
+AVS_UNIT_TEST(coap_tcp_socket, notification_is_acknowledged) {
+    avs_net_abstract_socket_t *mocksock = NULL;
+    avs_net_abstract_socket_t *sock = setup_tcp_socket(&mocksock);
+
+    avs_unit_mocksock_expect_output(mocksock, "\x21\x45" "x" "\xFF" "!", 5);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_send(sock, "\x41\x45\x00\x07" "x" "\xFF" "!", 7));
+    ASSERT_RECEIVED(sock, "\x60\x00\x00\x07");
+
+    avs_unit_mocksock_assert_expects_met(mocksock);
+    avs_net_socket_cleanup(&sock);
+}
+
+AVS_UNIT_TEST(coap_tcp_socket, extended_length) {
+    avs_net_abstract_socket_t *mocksock = NULL;
+    avs_net_abstract_socket_t *sock = setup_tcp_socket(&mocksock);
+
+    // 20 bytes of options and payload: Len = 13, Extended Length = 7
+    avs_unit_mocksock_expect_output(mocksock,
+                                    "\xD0\x07\x45" "\xFF"
+                                    "0123456789012345678", 23);
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_send(
+            sock, "\x50\x45\x00\x01" "\xFF" "0123456789012345678", 24));
+
+    avs_unit_mocksock_input(mocksock, "\xD0\x07\x02" "\xFF"
+                                      "0123456789012345678", 23);
+    ASSERT_RECEIVED(sock, "\x40\x02\x00\x00" "\xFF" "0123456789012345678");
+
+    avs_unit_mocksock_assert_expects_met(mocksock);
+    avs_net_socket_cleanup(&sock);
+}
+
+AVS_UNIT_TEST(coap_tcp_socket, signaling) {
+    avs_net_abstract_socket_t *mocksock = NULL;
+    avs_net_abstract_socket_t *sock = setup_tcp_socket(&mocksock);
+
+    avs_net_socket_opt_value_t mtu;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_opt(sock, AVS_NET_SOCKET_OPT_INNER_MTU, &mtu));
+    AVS_UNIT_ASSERT_EQUAL(mtu.mtu,
+                          ANJAY_COAP_TCP_DEFAULT_MAX_MESSAGE_SIZE - 2);
+
+    // CSM with Max-Message-Size = 1024, then Ping, then a request
+    avs_unit_mocksock_input(mocksock, "\x30\xE1" "\x22\x04\x00", 5);
+    avs_unit_mocksock_input(mocksock, "\x01\xE2" "p", 3);
+    avs_unit_mocksock_expect_output(mocksock, "\x01\xE3" "p", 3);
+    avs_unit_mocksock_input(mocksock, "\x00\x01", 2);
+    ASSERT_RECEIVED(sock, "\x40\x01\x00\x00");
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_opt(sock, AVS_NET_SOCKET_OPT_INNER_MTU, &mtu));
+    AVS_UNIT_ASSERT_EQUAL(mtu.mtu, 1022);
+
+    // Abort
+    avs_unit_mocksock_input(mocksock, "\x00\xE5", 2);
+    char buf[64];
+    size_t received;
+    AVS_UNIT_ASSERT_FAILED(
+            avs_net_socket_receive(sock, &received, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(avs_net_socket_errno(sock), ECONNRESET);
+
+    avs_unit_mocksock_assert_expects_met(mocksock);
+    avs_net_socket_cleanup(&sock);
+}
+
+AVS_UNIT_TEST(coap_tcp_socket, max_message_size_bounds) {
+    avs_net_abstract_socket_t *mocksock = NULL;
+    avs_net_abstract_socket_t *sock = setup_tcp_socket(&mocksock);
+
+    // CSM with Max-Message-Size = 1 is ignored
+    avs_unit_mocksock_input(mocksock, "\x20\xE1" "\x21\x01", 4);
+    avs_unit_mocksock_input(mocksock, "\x00\x01", 2);
+    ASSERT_RECEIVED(sock, "\x40\x01\x00\x00");
+
+    avs_net_socket_opt_value_t mtu;
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_opt(sock, AVS_NET_SOCKET_OPT_INNER_MTU, &mtu));
+    AVS_UNIT_ASSERT_EQUAL(mtu.mtu,
+                          ANJAY_COAP_TCP_DEFAULT_MAX_MESSAGE_SIZE - 2);
+
+    // CSM with Max-Message-Size = 2^32 - 1
+    avs_unit_mocksock_input(mocksock, "\x50\xE1" "\x24\xFF\xFF\xFF\xFF", 7);
+    avs_unit_mocksock_input(mocksock, "\x00\x01", 2);
+    ASSERT_RECEIVED(sock, "\x40\x01\x00\x01");
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_get_opt(sock, AVS_NET_SOCKET_OPT_INNER_MTU, &mtu));
+    AVS_UNIT_ASSERT_EQUAL(mtu.mtu, INT_MAX - 2);
+
+    avs_unit_mocksock_assert_expects_met(mocksock);
+    avs_net_socket_cleanup(&sock);
+}
+
+AVS_UNIT_TEST(coap_tcp_socket, message_too_big) {
+    avs_net_abstract_socket_t *mocksock = NULL;
+    avs_net_abstract_socket_t *sock = setup_tcp_socket(&mocksock);
+
+    // 32-byte body does not fit in a 20-byte buffer; header and token are
+    // still passed up, the rest of the frame is skipped
+    avs_unit_mocksock_input(mocksock, "\xD1\x13\x02" "t" "\xFF"
+                                      "0123456789012345678901234567890", 36);
+    avs_unit_mocksock_input(mocksock, "\x00\x01", 2);
+
+    char buf[20];
+    size_t received;
+    AVS_UNIT_ASSERT_FAILED(
+            avs_net_socket_receive(sock, &received, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(avs_net_socket_errno(sock), EMSGSIZE);
+    AVS_UNIT_ASSERT_EQUAL(received, 5);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "\x41\x02\x00\x00" "t", 5);
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_net_socket_receive(sock, &received, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(received, 4);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "\x40\x01\x00\x01", 4);
+
+    avs_unit_mocksock_assert_expects_met(mocksock);
+    avs_net_socket_cleanup(&sock);
+}
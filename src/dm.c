@@ -32,6 +32,7 @@
 #include "coap/msg.h"
 #include "dm.h"
 #include "dm/discover.h"
+#include "dm/deferred.h"
 #include "dm/execute.h"
 #include "dm/query.h"
 #include "io.h"
@@ -482,6 +483,7 @@ static int dm_read(anjay_t *anjay,
                    const anjay_dm_read_args_t *details,
                    anjay_output_ctx_t *out_ctx) {
     anjay_log(DEBUG, "Read %s", ANJAY_DEBUG_MAKE_PATH(details));
+    _anjay_read_deferral_set_output(anjay, out_ctx);
     int result = 0;
     if (details->has_iid) {
         const anjay_action_info_t info = {
@@ -507,7 +509,9 @@ static int dm_read(anjay_t *anjay,
 
     int finish_result = _anjay_output_ctx_destroy(&out_ctx);
 
-    if (result) {
+    if (result == ANJAY_READ_DEFERRED) {
+        return _anjay_read_deferral_result(anjay);
+    } else if (result) {
         return result;
     } else if (finish_result == ANJAY_OUTCTXERR_ANJAY_RET_NOT_CALLED) {
         anjay_log(ERROR, "unable to determine resource type: anjay_ret_* not "
@@ -606,10 +610,10 @@ static int dm_observe(anjay_t *anjay,
                    ANJAY_DEBUG_MAKE_PATH(details)), ANJAY_ERR_NOT_IMPLEMENTED)
 #endif // WITH_OBSERVE
 
-static int dm_read_or_observe(anjay_t *anjay,
-                              const anjay_dm_object_def_t *const *obj,
-                              const anjay_request_details_t *details,
-                              avs_stream_abstract_t *stream) {
+static int dm_read_or_observe_impl(anjay_t *anjay,
+                                   const anjay_dm_object_def_t *const *obj,
+                                   const anjay_request_details_t *details,
+                                   avs_stream_abstract_t *stream) {
     if (details->observe == ANJAY_COAP_OBSERVE_REGISTER) {
         return dm_observe(anjay, obj, details, stream);
     } else {
@@ -636,6 +640,62 @@ static int dm_read_or_observe(anjay_t *anjay,
     }
 }
 
+static int dm_read_or_observe(anjay_t *anjay,
+                              const anjay_dm_object_def_t *const *obj,
+                              const anjay_request_details_t *details,
+                              avs_stream_abstract_t *stream) {
+    anjay_read_deferral_t deferral;
+    _anjay_read_deferral_begin_request(anjay, &deferral, details);
+    int result = dm_read_or_observe_impl(anjay, obj, details, stream);
+    _anjay_read_deferral_end(anjay, &deferral, result);
+    return result == ANJAY_DM_READ_DEFERRED ? ANJAY_DM_RESPONSE_DEFERRED
+                                            : result;
+}
+
+#ifdef WITH_OBSERVE
+int _anjay_dm_read_resume(anjay_t *anjay,
+                          const anjay_request_details_t *details,
+                          anjay_msg_details_t *out_details,
+                          char *buffer,
+                          size_t size,
+                          size_t *out_size) {
+    const anjay_dm_object_def_t *const *obj =
+            _anjay_dm_find_object_by_oid(anjay, details->oid);
+    if (!obj || !*obj) {
+        anjay_log(ERROR, "Object not found: %u", details->oid);
+        return ANJAY_ERR_NOT_FOUND;
+    }
+
+    anjay_read_deferral_t deferral;
+    _anjay_read_deferral_begin_request(anjay, &deferral, details);
+    double numeric = NAN;
+    ssize_t result = _anjay_dm_read_for_observe(
+            anjay, obj, &DETAILS_TO_DM_READ_ARGS(details), out_details,
+            &numeric, buffer, size);
+    _anjay_read_deferral_end(anjay, &deferral,
+                             result < 0 ? (int) result : 0);
+    if (result == ANJAY_DM_READ_DEFERRED) {
+        return ANJAY_DM_RESPONSE_DEFERRED;
+    } else if (result < 0) {
+        return (int) result;
+    }
+
+    if (details->observe == ANJAY_COAP_OBSERVE_REGISTER) {
+        anjay_observe_key_t key;
+        build_observe_key(&key, details);
+        int put_result = _anjay_observe_put_entry(anjay, &key, out_details,
+                                                  &details->request_identity,
+                                                  numeric, buffer,
+                                                  (size_t) result);
+        if (put_result) {
+            return put_result;
+        }
+    }
+    *out_size = (size_t) result;
+    return 0;
+}
+#endif // WITH_OBSERVE
+
 static inline bool resource_specific_request_attrs_empty(
         const anjay_request_attributes_t *attrs) {
     return !attrs->has_greater_than
@@ -955,8 +1015,14 @@ static int dm_execute(anjay_t *anjay,
         }
 
         anjay_execute_ctx_t* execute_ctx = _anjay_execute_ctx_create(in_ctx);
+        if (!execute_ctx) {
+            return ANJAY_ERR_INTERNAL;
+        }
+        execute_ctx->anjay = anjay;
+        execute_ctx->request = details;
         retval = _anjay_dm_resource_execute(anjay, obj, details->iid,
                                             details->rid, execute_ctx, NULL);
+        retval = _anjay_execute_ctx_finish(execute_ctx, retval);
         _anjay_execute_ctx_destroy(&execute_ctx);
     }
     return retval;
@@ -162,8 +162,37 @@ ssize_t _anjay_dm_read_for_observe(anjay_t *anjay,
                                    double *out_numeric,
                                    char *buffer,
                                    size_t size);
+
+/**
+ * Performs the Read or Observe request described by @p details again, after it
+ * has been deferred by one of the handlers. Details and payload of the response
+ * are written to @p out_details and @p buffer.
+ *
+ * @returns 0 on success, ANJAY_DM_RESPONSE_DEFERRED if the Read has been
+ *          deferred again, or a negative value in case of error.
+ */
+int _anjay_dm_read_resume(anjay_t *anjay,
+                          const anjay_request_details_t *details,
+                          anjay_msg_details_t *out_details,
+                          char *buffer,
+                          size_t size,
+                          size_t *out_size);
 #endif // WITH_OBSERVE
 
+/**
+ * Returned by Read functions if one of the resource_read handlers deferred the
+ * Read using anjay_read_defer(). Negative, so that it cannot be confused with
+ * a payload size.
+ */
+#define ANJAY_DM_READ_DEFERRED (-0xDEF)
+
+/**
+ * Returned by _anjay_dm_perform_action() if the request needs to be
+ * acknowledged with an Empty message, as its response is going to be sent
+ * separately. Distinct from all values that handlers may return.
+ */
+#define ANJAY_DM_RESPONSE_DEFERRED (-0xDEE)
+
 int _anjay_dm_perform_action(anjay_t *anjay,
                              avs_stream_abstract_t *stream,
                              const anjay_request_details_t *details);
@@ -0,0 +1,271 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <assert.h>
+
+#include "deferred.h"
+
+#include "../anjay.h"
+#include "../io.h"
+#include "../servers.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+void _anjay_deferred_response_init(anjay_deferred_response_t *response,
+                                   const anjay_request_details_t *details) {
+    response->ssid = details->ssid;
+    response->conn_type = details->conn_type;
+    response->request_msg_type = details->msg_type;
+    response->request_identity = details->request_identity;
+}
+
+int _anjay_deferred_response_send(anjay_t *anjay,
+                                  const anjay_deferred_response_t *response,
+                                  const anjay_msg_details_t *details,
+                                  const void *payload,
+                                  size_t payload_size) {
+    anjay_active_server_info_t *server =
+            _anjay_servers_find_active(&anjay->servers, response->ssid);
+    if (!server) {
+        anjay_log(WARNING, "server %u no longer active, dropping separate "
+                  "response", response->ssid);
+        return -1;
+    }
+    const anjay_connection_ref_t ref = {
+        .server = server,
+        .conn_type = response->conn_type
+    };
+    avs_stream_abstract_t *stream = _anjay_get_server_stream(anjay, ref);
+    if (!stream) {
+        return -1;
+    }
+
+    anjay_msg_details_t separate_details = *details;
+    separate_details.msg_type =
+            response->request_msg_type == ANJAY_COAP_MSG_CONFIRMABLE
+                    ? ANJAY_COAP_MSG_CONFIRMABLE
+                    : ANJAY_COAP_MSG_NON_CONFIRMABLE;
+    int result;
+    (void) ((result = _anjay_coap_stream_setup_request(
+                    stream, &separate_details,
+                    &response->request_identity.token,
+                    response->request_identity.token_size))
+            || (result = avs_stream_write(stream, payload, payload_size))
+            || (result = avs_stream_finish_message(stream)));
+
+    avs_stream_reset(stream);
+    _anjay_release_server_stream(anjay, ref);
+
+    if (result == ANJAY_COAP_SOCKET_ERR_NETWORK) {
+        anjay_log(ERROR, "network communication error while sending separate "
+                  "response");
+        _anjay_schedule_server_reconnect(anjay, server);
+    } else if (result) {
+        anjay_log(ERROR, "could not send separate response");
+    }
+    return result;
+}
+
+#ifdef WITH_OBSERVE
+static void read_deferral_begin(anjay_t *anjay,
+                                anjay_read_deferral_t *deferral) {
+    assert(!anjay->current_read);
+    anjay->current_read = deferral;
+}
+
+void _anjay_read_deferral_begin_request(anjay_t *anjay,
+                                        anjay_read_deferral_t *deferral,
+                                        const anjay_request_details_t *request) {
+    *deferral = (anjay_read_deferral_t) {
+        .request = request
+    };
+    read_deferral_begin(anjay, deferral);
+}
+
+void _anjay_read_deferral_begin_notification(anjay_t *anjay,
+                                             anjay_read_deferral_t *deferral,
+                                             const anjay_observe_key_t *key) {
+    *deferral = (anjay_read_deferral_t) {
+        .observe_key = key
+    };
+    read_deferral_begin(anjay, deferral);
+}
+
+void _anjay_read_deferral_set_output(anjay_t *anjay,
+                                     anjay_output_ctx_t *out_ctx) {
+    if (anjay->current_read && !anjay->current_read->out_ctx_errno_ptr) {
+        anjay->current_read->out_ctx_errno_ptr =
+                _anjay_output_ctx_errno_ptr(out_ctx);
+    }
+}
+
+int _anjay_read_deferral_result(anjay_t *anjay) {
+    if (!anjay->current_read || !anjay->current_read->deferred) {
+        anjay_log(ERROR, "ANJAY_READ_DEFERRED returned without calling "
+                  "anjay_read_defer()");
+        return ANJAY_ERR_INTERNAL;
+    }
+    return ANJAY_DM_READ_DEFERRED;
+}
+
+void _anjay_read_deferral_end(anjay_t *anjay,
+                              anjay_read_deferral_t *deferral,
+                              int result) {
+    assert(anjay->current_read == deferral);
+    anjay->current_read = NULL;
+    if (deferral->deferred && result != ANJAY_DM_READ_DEFERRED) {
+        // one of the handlers deferred the Read, but it failed anyway
+        deferral->deferred->abandoned = true;
+    }
+}
+
+anjay_read_deferred_t *anjay_read_defer(anjay_t *anjay,
+                                        anjay_output_ctx_t *ctx) {
+    anjay_read_deferral_t *deferral = anjay->current_read;
+    if (!deferral || !deferral->out_ctx_errno_ptr
+            || _anjay_output_ctx_errno_ptr(ctx)
+                    != deferral->out_ctx_errno_ptr) {
+        anjay_log(ERROR, "Read cannot be deferred in this context");
+        return NULL;
+    }
+    if (deferral->deferred) {
+        anjay_log(ERROR, "Read already deferred");
+        return NULL;
+    }
+
+    AVS_LIST(anjay_read_deferred_t) handle =
+            AVS_LIST_NEW_ELEMENT(anjay_read_deferred_t);
+    if (!handle) {
+        anjay_log(ERROR, "out of memory");
+        return NULL;
+    }
+    if (deferral->request) {
+        handle->request = *deferral->request;
+    } else {
+        assert(deferral->observe_key);
+        handle->is_notification = true;
+        handle->observe_key = *deferral->observe_key;
+    }
+    AVS_LIST_INSERT(&anjay->read_deferred, handle);
+    deferral->deferred = handle;
+    return handle;
+}
+
+static void remove_read_deferred(anjay_t *anjay,
+                                 anjay_read_deferred_t *handle) {
+    AVS_LIST(anjay_read_deferred_t) *handle_ptr =
+            AVS_LIST_FIND_PTR(&anjay->read_deferred, handle);
+    assert(handle_ptr);
+    AVS_LIST_DELETE(handle_ptr);
+}
+
+static void resume_request(anjay_t *anjay,
+                           const anjay_request_details_t *request,
+                           int result) {
+    char buf[ANJAY_MAX_OBSERVABLE_RESOURCE_SIZE];
+    size_t size = 0;
+    anjay_msg_details_t details;
+    if (!result) {
+        result = _anjay_dm_read_resume(anjay, request, &details,
+                                       buf, sizeof(buf), &size);
+        if (result && result != ANJAY_DM_RESPONSE_DEFERRED) {
+            // the response is not sent block-wise, so the whole value needs
+            // to fit in buf; running out of space is reported as an error
+            anjay_log(ERROR, "deferred Read failed: %d (note: resumed values "
+                      "are limited to %u bytes)", result,
+                      (unsigned) sizeof(buf));
+        }
+    }
+    if (result == ANJAY_DM_RESPONSE_DEFERRED) {
+        // deferred again, a new handle has been created
+        return;
+    } else if (result) {
+        details = (const anjay_msg_details_t) {
+            .msg_code = _anjay_make_error_response_code(result),
+            .format = ANJAY_COAP_FORMAT_NONE
+        };
+        size = 0;
+    }
+
+    anjay_deferred_response_t response;
+    _anjay_deferred_response_init(&response, request);
+    if (_anjay_deferred_response_send(anjay, &response, &details, buf, size)) {
+        anjay_log(ERROR, "could not send deferred Read response");
+    }
+}
+
+static int resume_read_job(anjay_t *anjay, void *handle_) {
+    anjay_read_deferred_t *handle = (anjay_read_deferred_t *) handle_;
+    // the handle is released before resuming, so that the handler may defer
+    // the Read again
+    anjay_read_deferred_t deferred = *handle;
+    remove_read_deferred(anjay, handle);
+
+    if (deferred.is_notification) {
+        _anjay_observe_resume(anjay, &deferred.observe_key, deferred.result);
+    } else {
+        resume_request(anjay, &deferred.request, deferred.result);
+    }
+    return 0;
+}
+
+int anjay_read_deferred_complete(anjay_t *anjay,
+                                 anjay_read_deferred_t *handle,
+                                 int result) {
+    assert(handle);
+    assert(!handle->resume_job && "Read completed twice");
+    if (handle->abandoned) {
+        remove_read_deferred(anjay, handle);
+        return 0;
+    }
+
+    handle->result = result;
+    if (_anjay_sched_now(anjay->sched, &handle->resume_job,
+                         resume_read_job, handle)) {
+        anjay_log(ERROR, "could not schedule deferred Read");
+        remove_read_deferred(anjay, handle);
+        return -1;
+    }
+    return 0;
+}
+
+void _anjay_read_deferred_cleanup(anjay_t *anjay) {
+    AVS_LIST_CLEAR(&anjay->read_deferred) {
+        if (anjay->read_deferred->resume_job) {
+            _anjay_sched_del(anjay->sched, &anjay->read_deferred->resume_job);
+        }
+    }
+}
+#else // WITH_OBSERVE
+anjay_read_deferred_t *anjay_read_defer(anjay_t *anjay,
+                                        anjay_output_ctx_t *ctx) {
+    (void) anjay;
+    (void) ctx;
+    anjay_log(ERROR, "Deferred Reads require Observe support");
+    return NULL;
+}
+
+int anjay_read_deferred_complete(anjay_t *anjay,
+                                 anjay_read_deferred_t *handle,
+                                 int result) {
+    (void) anjay;
+    (void) handle;
+    (void) result;
+    return -1;
+}
+#endif // WITH_OBSERVE
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_DM_DEFERRED_H
+#define ANJAY_DM_DEFERRED_H
+
+#include "../dm.h"
+#include "../observe.h"
+#include "../sched.h"
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * Information necessary to respond to a request after it has been
+ * acknowledged with an Empty message, using a separate response (RFC 7252,
+ * 5.2.2).
+ */
+typedef struct {
+    anjay_ssid_t ssid;
+    anjay_connection_type_t conn_type;
+    anjay_coap_msg_type_t request_msg_type;
+    anjay_coap_msg_identity_t request_identity;
+} anjay_deferred_response_t;
+
+void _anjay_deferred_response_init(anjay_deferred_response_t *response,
+                                   const anjay_request_details_t *details);
+
+/**
+ * Sends a separate response described by @p details, with @p payload of
+ * @p payload_size bytes. Message type set in @p details is ignored - the
+ * response is Confirmable if the request was Confirmable, and Non-confirmable
+ * otherwise.
+ *
+ * Must not be called while the communication stream is in use, i.e. from
+ * within data model handlers - it is meant to be called from scheduler jobs.
+ *
+ * @returns 0 on success, a negative value in case of error, in particular if
+ *          the server that sent the request is no longer active.
+ */
+int _anjay_deferred_response_send(anjay_t *anjay,
+                                  const anjay_deferred_response_t *response,
+                                  const anjay_msg_details_t *details,
+                                  const void *payload,
+                                  size_t payload_size);
+
+#ifdef WITH_OBSERVE
+struct anjay_read_deferred_struct {
+    bool is_notification;
+    // valid if !is_notification
+    anjay_request_details_t request;
+    // valid if is_notification
+    anjay_observe_key_t observe_key;
+
+    // the Read failed after deferring and an error has already been reported
+    bool abandoned;
+    int result;
+    anjay_sched_handle_t resume_job;
+};
+
+/**
+ * State of a Read operation that may be deferred by resource_read handlers,
+ * see @ref anjay_read_defer .
+ */
+typedef struct anjay_read_deferral_struct {
+    const anjay_request_details_t *request;
+    const anjay_observe_key_t *observe_key;
+    int *out_ctx_errno_ptr;
+    anjay_read_deferred_t *deferred;
+} anjay_read_deferral_t;
+
+/**
+ * Allows resource_read handlers called until the matching
+ * _anjay_read_deferral_end() to defer the Read performed on behalf of
+ * @p request.
+ */
+void _anjay_read_deferral_begin_request(anjay_t *anjay,
+                                        anjay_read_deferral_t *deferral,
+                                        const anjay_request_details_t *request);
+
+/**
+ * Same as @ref _anjay_read_deferral_begin_request, for Reads that check
+ * whether a notification for the observation identified by @p key needs to be
+ * sent.
+ */
+void _anjay_read_deferral_begin_notification(anjay_t *anjay,
+                                             anjay_read_deferral_t *deferral,
+                                             const anjay_observe_key_t *key);
+
+/**
+ * Associates the Read in progress (if any) with its root output context, so
+ * that only handlers writing to it are allowed to defer the Read.
+ */
+void _anjay_read_deferral_set_output(anjay_t *anjay,
+                                     anjay_output_ctx_t *out_ctx);
+
+/**
+ * Called by the Read implementation if a handler returned ANJAY_READ_DEFERRED.
+ * Returns ANJAY_DM_READ_DEFERRED if the Read has actually been deferred, or an
+ * error code otherwise.
+ */
+int _anjay_read_deferral_result(anjay_t *anjay);
+
+void _anjay_read_deferral_end(anjay_t *anjay,
+                              anjay_read_deferral_t *deferral,
+                              int result);
+
+void _anjay_read_deferred_cleanup(anjay_t *anjay);
+#else // WITH_OBSERVE
+typedef struct {
+    char dummy;
+} anjay_read_deferral_t;
+
+#define _anjay_read_deferral_begin_request(Anjay, Deferral, Request) \
+        ((void) (Deferral))
+#define _anjay_read_deferral_begin_notification(Anjay, Deferral, Key) \
+        ((void) (Deferral))
+#define _anjay_read_deferral_set_output(...) ((void) 0)
+#define _anjay_read_deferral_result(Anjay) \
+        (anjay_log(ERROR, "Deferred Reads require Observe support"), \
+         ANJAY_ERR_INTERNAL)
+#define _anjay_read_deferral_end(...) ((void) 0)
+#define _anjay_read_deferred_cleanup(Anjay) ((void) 0)
+#endif // WITH_OBSERVE
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // ANJAY_DM_DEFERRED_H
@@ -22,6 +22,8 @@
 
 #include "execute.h"
 
+#include "../anjay.h"
+
 VISIBILITY_SOURCE_BEGIN
 
 static anjay_execute_state_t state_read_value(anjay_execute_ctx_t* ctx, int ch);
@@ -162,6 +164,96 @@ void _anjay_execute_ctx_destroy(anjay_execute_ctx_t **ctx) {
     }
 }
 
+anjay_execute_deferred_t *anjay_execute_defer(anjay_execute_ctx_t *ctx) {
+    if (!ctx->anjay || !ctx->request) {
+        anjay_log(ERROR, "Execute response cannot be deferred in this context");
+        return NULL;
+    }
+    if (ctx->deferred) {
+        anjay_log(ERROR, "Execute response already deferred");
+        return NULL;
+    }
+
+    AVS_LIST(anjay_execute_deferred_t) handle =
+            AVS_LIST_NEW_ELEMENT(anjay_execute_deferred_t);
+    if (!handle) {
+        anjay_log(ERROR, "out of memory");
+        return NULL;
+    }
+    _anjay_deferred_response_init(&handle->response, ctx->request);
+    AVS_LIST_INSERT(&ctx->anjay->execute_deferred, handle);
+    ctx->deferred = handle;
+    return handle;
+}
+
+int _anjay_execute_ctx_finish(anjay_execute_ctx_t *ctx, int handler_result) {
+    if (handler_result == ANJAY_DM_RESPONSE_DEFERRED) {
+        anjay_log(ERROR, "invalid Execute handler result: %d", handler_result);
+        handler_result = ANJAY_ERR_INTERNAL;
+    }
+    if (!ctx->deferred) {
+        return handler_result;
+    }
+    if (handler_result) {
+        ctx->deferred->request_failed = true;
+        return handler_result;
+    }
+    return ANJAY_DM_RESPONSE_DEFERRED;
+}
+
+static void remove_deferred(anjay_t *anjay, anjay_execute_deferred_t *handle) {
+    AVS_LIST(anjay_execute_deferred_t) *handle_ptr =
+            AVS_LIST_FIND_PTR(&anjay->execute_deferred, handle);
+    assert(handle_ptr);
+    AVS_LIST_DELETE(handle_ptr);
+}
+
+static int send_deferred_response_job(anjay_t *anjay, void *handle_) {
+    anjay_execute_deferred_t *handle = (anjay_execute_deferred_t *) handle_;
+    if (!handle->request_failed) {
+        const anjay_msg_details_t details = {
+            .msg_code = handle->result
+                    ? _anjay_make_error_response_code(handle->result)
+                    : ANJAY_COAP_CODE_CHANGED,
+            .format = ANJAY_COAP_FORMAT_NONE
+        };
+        if (_anjay_deferred_response_send(anjay, &handle->response, &details,
+                                          NULL, 0)) {
+            anjay_log(ERROR, "could not send deferred Execute response");
+        }
+    }
+    remove_deferred(anjay, handle);
+    return 0;
+}
+
+int anjay_execute_deferred_complete(anjay_t *anjay,
+                                    anjay_execute_deferred_t *handle,
+                                    int result) {
+    assert(handle);
+    assert(!handle->send_job && "Execute response completed twice");
+    if (handle->request_failed) {
+        remove_deferred(anjay, handle);
+        return 0;
+    }
+
+    handle->result = result;
+    if (_anjay_sched_now(anjay->sched, &handle->send_job,
+                         send_deferred_response_job, handle)) {
+        anjay_log(ERROR, "could not schedule deferred Execute response");
+        remove_deferred(anjay, handle);
+        return -1;
+    }
+    return 0;
+}
+
+void _anjay_execute_deferred_cleanup(anjay_t *anjay) {
+    AVS_LIST_CLEAR(&anjay->execute_deferred) {
+        if (anjay->execute_deferred->send_job) {
+            _anjay_sched_del(anjay->sched, &anjay->execute_deferred->send_job);
+        }
+    }
+}
+
 static anjay_execute_state_t expect_separator_or_eof(anjay_execute_ctx_t* ctx,
                                                      int ch) {
     (void)ctx;
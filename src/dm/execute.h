@@ -19,6 +19,9 @@
 
 #include <anjay_modules/dm/execute.h>
 
+#include "../sched.h"
+#include "deferred.h"
+
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
 typedef enum {
@@ -36,8 +39,32 @@ struct anjay_execute_ctx_struct {
     int arg;
     bool arg_has_value;
     int num_delimiters;
+
+    // only set when handling a request from a server
+    anjay_t *anjay;
+    const anjay_request_details_t *request;
+    anjay_execute_deferred_t *deferred;
+};
+
+struct anjay_execute_deferred_struct {
+    anjay_deferred_response_t response;
+    // the handler failed and an error response has already been sent
+    bool request_failed;
+    int result;
+    anjay_sched_handle_t send_job;
 };
 
+/**
+ * Translates the result of an Execute handler called with @p ctx into the
+ * result of the Execute action: ANJAY_DM_RESPONSE_DEFERRED if the handler
+ * deferred the response and succeeded, @p handler_result otherwise. The
+ * handler itself can never cause ANJAY_DM_RESPONSE_DEFERRED to be returned
+ * without a deferred response handle having been created.
+ */
+int _anjay_execute_ctx_finish(anjay_execute_ctx_t *ctx, int handler_result);
+
+void _anjay_execute_deferred_cleanup(anjay_t *anjay);
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif	// ANJAY_EXECUTE_H 
@@ -0,0 +1,359 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <config.h>
+
+#include <string.h>
+
+#include <anjay_modules/time.h>
+
+#include "anjay.h"
+#include "dns_cache.h"
+#include "utils.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+struct anjay_dns_cache_entry {
+    anjay_ssid_t ssid;
+    char host[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    char port[ANJAY_MAX_URL_PORT_SIZE];
+    /* monotonic clock; the addresses are stale once it is reached */
+    struct timespec expire_time;
+    size_t address_count;
+    /* index of the address to use for the next connection attempt */
+    size_t current_address;
+    /* family of the address the server last responded at, tried first after
+     * resolving */
+    avs_net_af_t preferred_family;
+    char addresses[ANJAY_DNS_CACHE_MAX_ADDRESSES][ANJAY_MAX_URL_HOSTNAME_SIZE];
+};
+
+static AVS_LIST(anjay_dns_cache_entry_t) *
+find_entry_insert_ptr(anjay_dns_cache_t *cache, anjay_ssid_t ssid) {
+    AVS_LIST(anjay_dns_cache_entry_t) *entry_ptr;
+    AVS_LIST_FOREACH_PTR(entry_ptr, &cache->entries) {
+        if ((*entry_ptr)->ssid >= ssid) {
+            break;
+        }
+    }
+    return entry_ptr;
+}
+
+anjay_dns_cache_entry_t *_anjay_dns_cache_get(anjay_t *anjay,
+                                              anjay_ssid_t ssid,
+                                              const char *host,
+                                              const char *port) {
+    anjay_dns_cache_t *cache = &anjay->dns_cache;
+    if (!cache->ttl_s
+            || strlen(host) >= ANJAY_MAX_URL_HOSTNAME_SIZE
+            || strlen(port) >= ANJAY_MAX_URL_PORT_SIZE) {
+        return NULL;
+    }
+
+    AVS_LIST(anjay_dns_cache_entry_t) *entry_ptr =
+            find_entry_insert_ptr(cache, ssid);
+    if (!*entry_ptr || (*entry_ptr)->ssid != ssid) {
+        AVS_LIST(anjay_dns_cache_entry_t) entry =
+                AVS_LIST_NEW_ELEMENT(anjay_dns_cache_entry_t);
+        if (!entry) {
+            anjay_log(ERROR, "Out of memory");
+            return NULL;
+        }
+        entry->ssid = ssid;
+        AVS_LIST_INSERT(entry_ptr, entry);
+    }
+
+    anjay_dns_cache_entry_t *entry = *entry_ptr;
+    if (strcmp(entry->host, host) || strcmp(entry->port, port)) {
+        entry->address_count = 0;
+        entry->current_address = 0;
+        entry->preferred_family = AVS_NET_AF_UNSPEC;
+        strcpy(entry->host, host);
+        strcpy(entry->port, port);
+    }
+    return entry;
+}
+
+const char *_anjay_dns_cache_hostname(const anjay_dns_cache_entry_t *entry) {
+    return entry->host;
+}
+
+const char *_anjay_dns_cache_port(const anjay_dns_cache_entry_t *entry) {
+    return entry->port;
+}
+
+static bool entry_valid(const anjay_dns_cache_entry_t *entry,
+                        const struct timespec *now) {
+    return entry->address_count > 0
+            && _anjay_time_before(now, &entry->expire_time);
+}
+
+static void set_expire_time(anjay_t *anjay,
+                            anjay_dns_cache_entry_t *entry,
+                            const struct timespec *now) {
+    entry->expire_time = *now;
+    _anjay_time_add(&entry->expire_time,
+                    &(const struct timespec) { anjay->dns_cache.ttl_s, 0 });
+}
+
+static avs_net_af_t address_family(const char *address) {
+    // only numeric addresses are cached
+    return strchr(address, ':') ? AVS_NET_AF_INET6 : AVS_NET_AF_INET4;
+}
+
+static avs_net_af_t other_family(avs_net_af_t family) {
+    return family == AVS_NET_AF_INET6 ? AVS_NET_AF_INET4 : AVS_NET_AF_INET6;
+}
+
+static size_t family_index(avs_net_af_t family) {
+    return family == AVS_NET_AF_INET6 ? 1 : 0;
+}
+
+/**
+ * Reorders the addresses so that address families alternate, starting with
+ * @p first_family, as recommended by RFC 8305, Section 4. The order of
+ * addresses within each family is preserved.
+ */
+static void interleave_families(anjay_dns_cache_entry_t *entry,
+                                avs_net_af_t first_family) {
+    char sorted[ANJAY_DNS_CACHE_MAX_ADDRESSES][ANJAY_MAX_URL_HOSTNAME_SIZE];
+    bool used[ANJAY_DNS_CACHE_MAX_ADDRESSES] = { false };
+    avs_net_af_t family = first_family;
+    for (size_t i = 0; i < entry->address_count; ++i) {
+        size_t next = entry->address_count;
+        for (size_t j = 0; j < entry->address_count; ++j) {
+            if (!used[j]) {
+                if (address_family(entry->addresses[j]) == family) {
+                    next = j;
+                    break;
+                } else if (next == entry->address_count) {
+                    next = j;
+                }
+            }
+        }
+        used[next] = true;
+        strcpy(sorted[i], entry->addresses[next]);
+        family = other_family(address_family(sorted[i]));
+    }
+    memcpy(entry->addresses, sorted,
+           entry->address_count * sizeof(sorted[0]));
+}
+
+static int resolve(anjay_t *anjay,
+                   anjay_dns_cache_entry_t *entry,
+                   avs_net_socket_type_t socket_type,
+                   const struct timespec *now) {
+    avs_net_addrinfo_t *info =
+            avs_net_addrinfo_resolve(socket_type, AVS_NET_AF_UNSPEC,
+                                     entry->host, entry->port, NULL);
+    if (!info) {
+        anjay_log(WARNING, "could not resolve %s", entry->host);
+        return -1;
+    }
+
+    // the cached addresses are only replaced if resolving succeeds, as stale
+    // ones are still used otherwise
+    char addresses[ANJAY_DNS_CACHE_MAX_ADDRESSES][ANJAY_MAX_URL_HOSTNAME_SIZE];
+
+    // addresses of one family shall not push all addresses of the other one
+    // out of the cache, so that the other family can be fallen back to;
+    // the first pass only counts them
+    size_t available[2] = { 0, 0 };
+    avs_net_resolved_endpoint_t endpoint;
+    while (!avs_net_addrinfo_next(info, &endpoint)) {
+        if (!avs_net_resolved_endpoint_get_host(&endpoint, addresses[0],
+                                                sizeof(addresses[0]))) {
+            ++available[family_index(address_family(addresses[0]))];
+        }
+    }
+    const size_t max = ANJAY_DNS_CACHE_MAX_ADDRESSES;
+    size_t quota[2];
+    quota[0] = AVS_MIN(available[0], max - AVS_MIN(available[1], max / 2));
+    quota[1] = AVS_MIN(available[1], max - quota[0]);
+
+    avs_net_addrinfo_rewind(info);
+    size_t count = 0;
+    while (count < ANJAY_DNS_CACHE_MAX_ADDRESSES
+            && !avs_net_addrinfo_next(info, &endpoint)) {
+        if (!avs_net_resolved_endpoint_get_host(&endpoint, addresses[count],
+                                                sizeof(addresses[count]))) {
+            size_t *family_quota =
+                    &quota[family_index(address_family(addresses[count]))];
+            if (*family_quota) {
+                --*family_quota;
+                ++count;
+            }
+        }
+    }
+    avs_net_addrinfo_delete(&info);
+
+    if (!count) {
+        anjay_log(WARNING, "no usable addresses for %s", entry->host);
+        return -1;
+    }
+    memcpy(entry->addresses, addresses, count * sizeof(addresses[0]));
+    entry->address_count = count;
+    entry->current_address = 0;
+    // the resolver sorts addresses according to RFC 6724, so the first one
+    // determines the preferred family until the server responds
+    interleave_families(entry,
+                        entry->preferred_family != AVS_NET_AF_UNSPEC
+                                ? entry->preferred_family
+                                : address_family(entry->addresses[0]));
+    set_expire_time(anjay, entry, now);
+    anjay_log(DEBUG, "%s resolved to %lu address(es)", entry->host,
+              (unsigned long) count);
+    return 0;
+}
+
+static void copy_host(char *out_host,
+                      size_t out_host_size,
+                      const char *host) {
+    if (_anjay_snprintf(out_host, out_host_size, "%s", host) < 0) {
+        // caller buffers are large enough for any hostname; just in case
+        *out_host = '\0';
+    }
+}
+
+void _anjay_dns_cache_lookup(anjay_t *anjay,
+                             anjay_dns_cache_entry_t *entry,
+                             avs_net_socket_type_t socket_type,
+                             bool may_resolve,
+                             char *out_host,
+                             size_t out_host_size) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (entry_valid(entry, &now)) {
+        ++anjay->dns_cache.stats.hits;
+    } else {
+        ++anjay->dns_cache.stats.misses;
+        // if resolving fails, stale addresses are still better than nothing
+        if (!may_resolve
+                || (resolve(anjay, entry, socket_type, &now)
+                        && !entry->address_count)) {
+            copy_host(out_host, out_host_size, entry->host);
+            return;
+        }
+    }
+    copy_host(out_host, out_host_size,
+              entry->addresses[entry->current_address]);
+}
+
+bool _anjay_dns_cache_fallback(const anjay_dns_cache_entry_t *entry,
+                               char *out_host,
+                               size_t out_host_size) {
+    if (!entry) {
+        return false;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (!entry_valid(entry, &now)) {
+        return false;
+    }
+    avs_net_af_t family = other_family(
+            address_family(entry->addresses[entry->current_address]));
+    for (size_t i = entry->current_address + 1; i < entry->address_count;
+            ++i) {
+        if (address_family(entry->addresses[i]) == family) {
+            copy_host(out_host, out_host_size, entry->addresses[i]);
+            return true;
+        }
+    }
+    return false;
+}
+
+void _anjay_dns_cache_connected(anjay_t *anjay,
+                                anjay_dns_cache_entry_t *entry,
+                                avs_net_abstract_socket_t *socket) {
+    if (!entry) {
+        return;
+    }
+    char remote_host[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (avs_net_socket_get_remote_host(socket, remote_host,
+                                       sizeof(remote_host))) {
+        anjay_log(DEBUG, "could not get remote address of %s", entry->host);
+        if (!entry_valid(entry, &now)) {
+            entry->address_count = 0;
+        }
+        return;
+    }
+
+    if (entry_valid(entry, &now)) {
+        // the connection may have been raced against another address
+        for (size_t i = 0; i < entry->address_count; ++i) {
+            if (!strcmp(entry->addresses[i], remote_host)) {
+                entry->current_address = i;
+                break;
+            }
+        }
+        return;
+    }
+    // the hostname has been resolved by the socket itself; remember the
+    // address that turned out to work
+    strcpy(entry->addresses[0], remote_host);
+    entry->address_count = 1;
+    entry->current_address = 0;
+    set_expire_time(anjay, entry, &now);
+}
+
+void _anjay_dns_cache_responded(anjay_t *anjay,
+                                anjay_dns_cache_entry_t *entry) {
+    if (!entry || !entry->address_count) {
+        return;
+    }
+    avs_net_af_t family =
+            address_family(entry->addresses[entry->current_address]);
+    if (entry->preferred_family != AVS_NET_AF_UNSPEC
+            && entry->preferred_family != family) {
+        anjay_log(DEBUG, "%s reached over IPv%d", entry->host,
+                  family == AVS_NET_AF_INET6 ? 6 : 4);
+        ++anjay->dns_cache.stats.family_switches;
+    }
+    entry->preferred_family = family;
+}
+
+void _anjay_dns_cache_connect_failed(anjay_t *anjay,
+                                     anjay_dns_cache_entry_t *entry) {
+    if (!entry || !entry->address_count) {
+        return;
+    }
+    ++anjay->dns_cache.stats.failovers;
+    if (++entry->current_address >= entry->address_count) {
+        anjay_log(DEBUG, "all cached addresses of %s failed", entry->host);
+        entry->address_count = 0;
+        entry->current_address = 0;
+    }
+}
+
+void _anjay_dns_cache_cleanup(anjay_dns_cache_t *cache) {
+    AVS_LIST_CLEAR(&cache->entries);
+}
+
+int anjay_get_dns_cache_stats(anjay_t *anjay,
+                              anjay_dns_cache_stats_t *out_stats) {
+    if (!anjay->dns_cache.ttl_s) {
+        return -1;
+    }
+    *out_stats = anjay->dns_cache.stats;
+    return 0;
+}
+
+#ifdef ANJAY_TEST
+#include "test/dns_cache.c"
+#endif // ANJAY_TEST
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ANJAY_DNS_CACHE_H
+#define ANJAY_DNS_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <avsystem/commons/list.h>
+#include <avsystem/commons/net.h>
+
+#include <anjay/anjay.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+typedef struct anjay_dns_cache_entry anjay_dns_cache_entry_t;
+
+/**
+ * Per-server cache of addresses the server hostname resolves to, so that
+ * reconnecting - e.g. after the socket has been closed in queue mode - does
+ * not need to wait for the resolver.
+ *
+ * The system resolver does not report the TTL of DNS records, so addresses are
+ * cached for a configured amount of time instead. If connecting to an address
+ * fails, the next one is used for the next attempt; once all of them fail, the
+ * hostname is resolved again.
+ *
+ * Addresses of both families are interleaved as described in RFC 8305, so that
+ * a connection attempt to the other family can be raced against the first one
+ * (see @ref _anjay_dns_cache_fallback). The family over which the server has
+ * last responded is remembered and tried first after resolving again. Merely
+ * connecting is not enough, as connecting a plain UDP socket does not involve
+ * any exchange with the server.
+ */
+typedef struct {
+    AVS_LIST(anjay_dns_cache_entry_t) entries;
+    /* 0 if caching is disabled */
+    time_t ttl_s;
+    anjay_dns_cache_stats_t stats;
+} anjay_dns_cache_t;
+
+/**
+ * Returns the cache entry for server @p ssid, creating it if necessary. If the
+ * server was previously reached at a different @p host : @p port, the cached
+ * addresses are discarded.
+ *
+ * @returns Pointer to the entry, valid until the cache is cleaned up, or NULL
+ *          if caching is disabled or in case of an out-of-memory condition.
+ */
+anjay_dns_cache_entry_t *_anjay_dns_cache_get(anjay_t *anjay,
+                                              anjay_ssid_t ssid,
+                                              const char *host,
+                                              const char *port);
+
+const char *_anjay_dns_cache_hostname(const anjay_dns_cache_entry_t *entry);
+
+const char *_anjay_dns_cache_port(const anjay_dns_cache_entry_t *entry);
+
+/**
+ * Determines the host to pass to <c>avs_net_socket_connect()</c>: a cached
+ * numeric address if there is one, or the hostname itself otherwise.
+ *
+ * If @p may_resolve is true and there is no valid cached address, the
+ * hostname is resolved right away, which may block for a long time. Otherwise,
+ * the socket resolves the hostname itself, and the address it connects to is
+ * cached by @ref _anjay_dns_cache_connected.
+ */
+void _anjay_dns_cache_lookup(anjay_t *anjay,
+                             anjay_dns_cache_entry_t *entry,
+                             avs_net_socket_type_t socket_type,
+                             bool may_resolve,
+                             char *out_host,
+                             size_t out_host_size);
+
+/**
+ * Finds an address to race against the one returned by
+ * @ref _anjay_dns_cache_lookup: the next cached address of the other address
+ * family.
+ *
+ * @returns true if such an address has been copied to @p out_host, false if
+ *          there is none or @p entry is NULL.
+ */
+bool _anjay_dns_cache_fallback(const anjay_dns_cache_entry_t *entry,
+                               char *out_host,
+                               size_t out_host_size);
+
+/**
+ * Shall be called after successfully connecting @p socket to a host returned
+ * by @ref _anjay_dns_cache_lookup or @ref _anjay_dns_cache_fallback, so that
+ * the address actually connected to is the current one. Does nothing if
+ * @p entry is NULL.
+ */
+void _anjay_dns_cache_connected(anjay_t *anjay,
+                                anjay_dns_cache_entry_t *entry,
+                                avs_net_abstract_socket_t *socket);
+
+/**
+ * Shall be called after the server responds to a request sent to the current
+ * address, which makes its family the preferred one. Does nothing if @p entry
+ * is NULL.
+ */
+void _anjay_dns_cache_responded(anjay_t *anjay,
+                                anjay_dns_cache_entry_t *entry);
+
+/**
+ * Shall be called after connecting to a host returned by
+ * @ref _anjay_dns_cache_lookup fails, or the server does not respond to
+ * a request sent there, so that the next attempt uses another address. Does
+ * nothing if @p entry is NULL.
+ */
+void _anjay_dns_cache_connect_failed(anjay_t *anjay,
+                                     anjay_dns_cache_entry_t *entry);
+
+void _anjay_dns_cache_cleanup(anjay_dns_cache_t *cache);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_DNS_CACHE_H */
@@ -0,0 +1,314 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <config.h>
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <anjay_modules/time.h>
+
+#include "anjay.h"
+#include "dtls_session_cache.h"
+#include "utils.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#ifdef WITH_DTLS_SESSION_CACHE
+
+struct anjay_dtls_session {
+    anjay_ssid_t ssid;
+    char host[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    char port[ANJAY_MAX_URL_PORT_SIZE];
+    /* hash of the socket configuration, including credentials */
+    uint32_t config_hash;
+    anjay_dtls_handshake_stats_t stats;
+    struct timespec handshake_start;
+    /* only accessed from the event loop thread, never passed to avs_net */
+    char buffer[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+};
+
+static AVS_LIST(anjay_dtls_session_t) *
+find_session_insert_ptr(anjay_dtls_session_cache_t *cache,
+                        anjay_ssid_t ssid) {
+    AVS_LIST(anjay_dtls_session_t) *session_ptr;
+    AVS_LIST_FOREACH_PTR(session_ptr, &cache->sessions) {
+        if ((*session_ptr)->ssid >= ssid) {
+            break;
+        }
+    }
+    return session_ptr;
+}
+
+static anjay_dtls_session_t *find_session(anjay_dtls_session_cache_t *cache,
+                                          anjay_ssid_t ssid) {
+    AVS_LIST(anjay_dtls_session_t) *session_ptr =
+            find_session_insert_ptr(cache, ssid);
+    return (*session_ptr && (*session_ptr)->ssid == ssid) ? *session_ptr : NULL;
+}
+
+static anjay_dtls_session_t *get_session(anjay_dtls_session_cache_t *cache,
+                                         anjay_ssid_t ssid,
+                                         const char *host,
+                                         const char *port,
+                                         uint32_t config_hash) {
+    if (strlen(host) >= ANJAY_MAX_URL_HOSTNAME_SIZE
+            || strlen(port) >= ANJAY_MAX_URL_PORT_SIZE) {
+        return NULL;
+    }
+
+    AVS_LIST(anjay_dtls_session_t) *session_ptr =
+            find_session_insert_ptr(cache, ssid);
+    if (!*session_ptr || (*session_ptr)->ssid != ssid) {
+        AVS_LIST(anjay_dtls_session_t) session =
+                AVS_LIST_NEW_ELEMENT(anjay_dtls_session_t);
+        if (!session) {
+            anjay_log(ERROR, "Out of memory");
+            return NULL;
+        }
+        session->ssid = ssid;
+        AVS_LIST_INSERT(session_ptr, session);
+    }
+
+    anjay_dtls_session_t *session = *session_ptr;
+    if (strcmp(session->host, host) || strcmp(session->port, port)
+            || session->config_hash != config_hash) {
+        // a session established with another server, or using other
+        // credentials, must not be resumed
+        memset(session->buffer, 0, sizeof(session->buffer));
+        strcpy(session->host, host);
+        strcpy(session->port, port);
+        session->config_hash = config_hash;
+    }
+    return session;
+}
+
+anjay_dtls_session_t *_anjay_dtls_session_get(anjay_t *anjay,
+                                              anjay_ssid_t ssid,
+                                              const char *host,
+                                              const char *port,
+                                              uint32_t config_hash) {
+    return get_session(&anjay->dtls_sessions, ssid, host, port, config_hash);
+}
+
+void _anjay_dtls_session_invalidate(anjay_t *anjay, anjay_ssid_t ssid) {
+    anjay_dtls_session_t *session = find_session(&anjay->dtls_sessions, ssid);
+    if (session) {
+        memset(session->buffer, 0, sizeof(session->buffer));
+    }
+}
+
+void *_anjay_dtls_session_buffer_new(void) {
+    void *buffer = calloc(1, ANJAY_DTLS_SESSION_BUFFER_SIZE);
+    if (!buffer) {
+        anjay_log(ERROR, "Out of memory");
+    }
+    return buffer;
+}
+
+void _anjay_dtls_session_configure(void *socket_buffer,
+                                   avs_net_ssl_configuration_t *config) {
+    config->session_resumption_buffer = socket_buffer;
+    config->session_resumption_buffer_size =
+            socket_buffer ? ANJAY_DTLS_SESSION_BUFFER_SIZE : 0;
+}
+
+void _anjay_dtls_session_handshake_started(anjay_dtls_session_t *session,
+                                           void *socket_buffer) {
+    if (!session) {
+        return;
+    }
+    if (socket_buffer) {
+        memcpy(socket_buffer, session->buffer, sizeof(session->buffer));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &session->handshake_start);
+}
+
+void _anjay_dtls_session_handshake_finished(anjay_dtls_session_t *session,
+                                            const void *socket_buffer,
+                                            avs_net_abstract_socket_t *socket,
+                                            int result) {
+    if (!session) {
+        return;
+    }
+    if (result) {
+        ++session->stats.failed_handshakes;
+        return;
+    }
+    // the connection attempt is over, so the backend is done writing to it
+    if (socket_buffer) {
+        memcpy(session->buffer, socket_buffer, sizeof(session->buffer));
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ssize_t duration_ms = _anjay_time_diff_ms(&now, &session->handshake_start);
+    session->stats.last_duration_ms = (int32_t) duration_ms;
+
+    avs_net_socket_opt_value_t resumed;
+    if (!avs_net_socket_get_opt(socket, AVS_NET_SOCKET_OPT_SESSION_RESUMED,
+                                &resumed)
+            && resumed.flag) {
+        anjay_log(DEBUG, "resumed (D)TLS session with server %" PRIu16
+                         " in %ld ms", session->ssid, (long) duration_ms);
+        ++session->stats.resumed_handshakes;
+        session->stats.resumed_duration_ms += duration_ms;
+    } else {
+        anjay_log(DEBUG, "established new (D)TLS session with server %" PRIu16
+                         " in %ld ms", session->ssid, (long) duration_ms);
+        ++session->stats.full_handshakes;
+        session->stats.full_duration_ms += duration_ms;
+    }
+}
+
+void _anjay_dtls_session_cache_cleanup(anjay_dtls_session_cache_t *cache) {
+    AVS_LIST_CLEAR(&cache->sessions);
+}
+
+int _anjay_dtls_session_cache_foreach(anjay_t *anjay,
+                                      anjay_dtls_session_visitor_t *visitor,
+                                      void *arg) {
+    AVS_LIST(anjay_dtls_session_t) session;
+    AVS_LIST_FOREACH(session, anjay->dtls_sessions.sessions) {
+        int result = visitor(session->ssid, session->host, session->port,
+                             session->config_hash, session->buffer,
+                             sizeof(session->buffer), arg);
+        if (result) {
+            return result;
+        }
+    }
+    return 0;
+}
+
+int _anjay_dtls_session_cache_put(anjay_t *anjay,
+                                  anjay_ssid_t ssid,
+                                  const char *host,
+                                  const char *port,
+                                  uint32_t config_hash,
+                                  const void *data,
+                                  size_t data_size) {
+    if (data_size > ANJAY_DTLS_SESSION_BUFFER_SIZE) {
+        anjay_log(ERROR, "(D)TLS session state too large: %lu bytes",
+                  (unsigned long) data_size);
+        return -1;
+    }
+    anjay_dtls_session_t *session =
+            get_session(&anjay->dtls_sessions, ssid, host, port, config_hash);
+    if (!session) {
+        return -1;
+    }
+    memcpy(session->buffer, data, data_size);
+    memset(session->buffer + data_size, 0, sizeof(session->buffer) - data_size);
+    return 0;
+}
+
+void _anjay_dtls_session_cache_clear(anjay_t *anjay) {
+    AVS_LIST(anjay_dtls_session_t) session;
+    AVS_LIST_FOREACH(session, anjay->dtls_sessions.sessions) {
+        memset(session->buffer, 0, sizeof(session->buffer));
+    }
+}
+
+int anjay_get_dtls_handshake_stats(anjay_t *anjay,
+                                   anjay_ssid_t ssid,
+                                   anjay_dtls_handshake_stats_t *out_stats) {
+    const anjay_dtls_session_t *session =
+            find_session(&anjay->dtls_sessions, ssid);
+    if (!session) {
+        return -1;
+    }
+    *out_stats = session->stats;
+    return 0;
+}
+
+#ifdef ANJAY_TEST
+#include "test/dtls_session_cache.c"
+#endif // ANJAY_TEST
+
+#else // WITH_DTLS_SESSION_CACHE
+
+anjay_dtls_session_t *_anjay_dtls_session_get(anjay_t *anjay,
+                                              anjay_ssid_t ssid,
+                                              const char *host,
+                                              const char *port,
+                                              uint32_t config_hash) {
+    (void) anjay; (void) ssid; (void) host; (void) port; (void) config_hash;
+    return NULL;
+}
+
+void _anjay_dtls_session_invalidate(anjay_t *anjay, anjay_ssid_t ssid) {
+    (void) anjay; (void) ssid;
+}
+
+void *_anjay_dtls_session_buffer_new(void) {
+    return NULL;
+}
+
+void _anjay_dtls_session_configure(void *socket_buffer,
+                                   avs_net_ssl_configuration_t *config) {
+    (void) socket_buffer; (void) config;
+}
+
+void _anjay_dtls_session_handshake_started(anjay_dtls_session_t *session,
+                                           void *socket_buffer) {
+    (void) session; (void) socket_buffer;
+}
+
+void _anjay_dtls_session_handshake_finished(anjay_dtls_session_t *session,
+                                            const void *socket_buffer,
+                                            avs_net_abstract_socket_t *socket,
+                                            int result) {
+    (void) session; (void) socket_buffer; (void) socket; (void) result;
+}
+
+void _anjay_dtls_session_cache_cleanup(anjay_dtls_session_cache_t *cache) {
+    (void) cache;
+}
+
+int _anjay_dtls_session_cache_foreach(anjay_t *anjay,
+                                      anjay_dtls_session_visitor_t *visitor,
+                                      void *arg) {
+    (void) anjay; (void) visitor; (void) arg;
+    return 0;
+}
+
+int _anjay_dtls_session_cache_put(anjay_t *anjay,
+                                  anjay_ssid_t ssid,
+                                  const char *host,
+                                  const char *port,
+                                  uint32_t config_hash,
+                                  const void *data,
+                                  size_t data_size) {
+    (void) anjay; (void) ssid; (void) host; (void) port; (void) config_hash;
+    (void) data; (void) data_size;
+    anjay_log(DEBUG, "(D)TLS session cache not supported, ignoring session");
+    return 0;
+}
+
+void _anjay_dtls_session_cache_clear(anjay_t *anjay) {
+    (void) anjay;
+}
+
+int anjay_get_dtls_handshake_stats(anjay_t *anjay,
+                                   anjay_ssid_t ssid,
+                                   anjay_dtls_handshake_stats_t *out_stats) {
+    (void) anjay; (void) ssid; (void) out_stats;
+    return -1;
+}
+
+#endif // WITH_DTLS_SESSION_CACHE
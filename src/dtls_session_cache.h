@@ -0,0 +1,114 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ANJAY_DTLS_SESSION_CACHE_H
+#define ANJAY_DTLS_SESSION_CACHE_H
+
+#include <time.h>
+
+#include <avsystem/commons/list.h>
+#include <avsystem/commons/net.h>
+
+#include <anjay/anjay.h>
+#include <anjay_modules/dtls_session_cache.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+typedef struct anjay_dtls_session anjay_dtls_session_t;
+
+/**
+ * Per-server (D)TLS session resumption state, so that reconnecting - e.g.
+ * after the socket has been closed in queue mode - may use an abbreviated
+ * handshake.
+ *
+ * Sockets do not use the cached state directly, as they may be connected on
+ * background threads. Each of them gets a private session resumption buffer
+ * instead, which is synchronized with the cache on the event loop thread
+ * before and after each handshake.
+ *
+ * If avs_commons does not support session resumption, the cache is compiled
+ * out and no entries are ever created.
+ */
+typedef struct {
+    AVS_LIST(anjay_dtls_session_t) sessions;
+} anjay_dtls_session_cache_t;
+
+/**
+ * Returns the cache entry for server @p ssid, creating it if necessary. If the
+ * server was previously reached at a different @p host : @p port, or with
+ * a socket configuration other than the one hashed into @p config_hash (which
+ * shall cover the credentials), the cached session state is discarded.
+ *
+ * @returns Pointer to the entry, valid until the cache is cleaned up, or NULL
+ *          in case of an out-of-memory condition.
+ */
+anjay_dtls_session_t *_anjay_dtls_session_get(anjay_t *anjay,
+                                              anjay_ssid_t ssid,
+                                              const char *host,
+                                              const char *port,
+                                              uint32_t config_hash);
+
+/**
+ * Discards the session state cached for server @p ssid, e.g. because its
+ * security configuration changed. Handshake statistics are retained.
+ */
+void _anjay_dtls_session_invalidate(anjay_t *anjay, anjay_ssid_t ssid);
+
+/**
+ * Allocates a session resumption buffer for a single socket. It shall be
+ * freed with <c>free()</c> after the socket is cleaned up.
+ *
+ * @returns Newly allocated buffer, or NULL in case of an out-of-memory
+ *          condition or if session resumption is not supported.
+ */
+void *_anjay_dtls_session_buffer_new(void);
+
+/**
+ * Fills the session resumption fields of @p config. @p socket_buffer shall be
+ * allocated with @ref _anjay_dtls_session_buffer_new or NULL, in which case
+ * session resumption is not used.
+ */
+void _anjay_dtls_session_configure(void *socket_buffer,
+                                   avs_net_ssl_configuration_t *config);
+
+/**
+ * Shall be called right before connecting a socket configured with
+ * @p socket_buffer, while no other thread uses it. Loads the session state
+ * cached in @p session into @p socket_buffer. Does nothing if @p session is
+ * NULL; @p socket_buffer may be NULL.
+ */
+void _anjay_dtls_session_handshake_started(anjay_dtls_session_t *session,
+                                           void *socket_buffer);
+
+/**
+ * Updates handshake statistics after a connection attempt started with
+ * @ref _anjay_dtls_session_handshake_started finishes and, if it succeeded,
+ * stores the session state from @p socket_buffer in @p session. Does nothing
+ * if @p session is NULL; @p socket_buffer may be NULL.
+ *
+ * @param result Value returned by <c>avs_net_socket_connect()</c>.
+ */
+void _anjay_dtls_session_handshake_finished(anjay_dtls_session_t *session,
+                                            const void *socket_buffer,
+                                            avs_net_abstract_socket_t *socket,
+                                            int result);
+
+void _anjay_dtls_session_cache_cleanup(anjay_dtls_session_cache_t *cache);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_DTLS_SESSION_CACHE_H */
@@ -0,0 +1,347 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef WITH_EVENT_LOOP
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#endif // WITH_EVENT_LOOP
+
+#include "anjay.h"
+#include "event_loop.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#ifdef WITH_EVENT_LOOP
+
+/* maximum number of events handled in a single loop iteration */
+#define EVENT_LOOP_MAX_EVENTS 16
+/* maximum number of messages handled per readable socket per iteration */
+#define EVENT_LOOP_SERVE_BATCH_SIZE 16
+
+static void close_fd(int *fd_ptr) {
+    if (*fd_ptr >= 0) {
+        close(*fd_ptr);
+        *fd_ptr = -1;
+    }
+}
+
+void _anjay_event_loop_cleanup(anjay_event_loop_t *loop) {
+    assert(!loop->running);
+    if (!loop->initialized) {
+        return;
+    }
+    AVS_LIST_CLEAR(&loop->sockets);
+    close_fd(&loop->interrupt_fd);
+    close_fd(&loop->timer_fd);
+    close_fd(&loop->epoll_fd);
+    loop->initialized = false;
+}
+
+static int register_fd(anjay_event_loop_t *loop, int fd, void *data) {
+    struct epoll_event event = {
+        .events = EPOLLIN,
+        .data = {
+            .ptr = data
+        }
+    };
+    return epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+}
+
+static int init_loop(anjay_t *anjay, anjay_event_loop_t *loop) {
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    loop->timer_fd = timerfd_create(CLOCK_MONOTONIC,
+                                    TFD_NONBLOCK | TFD_CLOEXEC);
+    loop->interrupt_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    loop->initialized = true;
+
+    int notify_fd = anjay_get_notify_wakeup_fd(anjay);
+    if (loop->epoll_fd < 0 || loop->timer_fd < 0 || loop->interrupt_fd < 0
+            || register_fd(loop, loop->timer_fd, &loop->timer_fd)
+            || register_fd(loop, loop->interrupt_fd, &loop->interrupt_fd)
+            || (notify_fd >= 0
+                    && register_fd(loop, notify_fd, &anjay->notify_inbox))) {
+        anjay_log(ERROR, "could not initialize event loop: %s",
+                  strerror(errno));
+        _anjay_event_loop_cleanup(loop);
+        return -1;
+    }
+    return 0;
+}
+
+static int get_socket_fd(avs_net_abstract_socket_t *socket) {
+    const int *fd_ptr = (const int *) avs_net_socket_get_system(socket);
+    return fd_ptr ? *fd_ptr : -1;
+}
+
+static int mark_socket(anjay_t *anjay,
+                       void *loop_,
+                       avs_net_abstract_socket_t *socket,
+                       uint32_t socket_generation) {
+    (void) anjay;
+    anjay_event_loop_t *loop = (anjay_event_loop_t *) loop_;
+    int fd = get_socket_fd(socket);
+    if (fd < 0) {
+        return 0;
+    }
+
+    AVS_LIST(anjay_event_loop_socket_t) *entry_ptr;
+    AVS_LIST_FOREACH_PTR(entry_ptr, &loop->sockets) {
+        if ((*entry_ptr)->socket == socket && (*entry_ptr)->fd == fd
+                && (*entry_ptr)->socket_generation == socket_generation) {
+            (*entry_ptr)->seen = true;
+            return 0;
+        }
+    }
+
+    AVS_LIST(anjay_event_loop_socket_t) entry =
+            AVS_LIST_NEW_ELEMENT(anjay_event_loop_socket_t);
+    if (!entry) {
+        anjay_log(ERROR, "Out of memory");
+        return 0;
+    }
+    entry->socket = socket;
+    entry->fd = fd;
+    entry->socket_generation = socket_generation;
+    entry->seen = true;
+    AVS_LIST_INSERT(AVS_LIST_APPEND_PTR(&loop->sockets), entry);
+    return 0;
+}
+
+static void socket_removed(anjay_event_loop_t *loop,
+                           anjay_event_loop_socket_t *entry) {
+    // the descriptor may have already been closed, which removes it from the
+    // epoll set automatically - errors are expected here
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, entry->fd, NULL);
+}
+
+static int socket_added(anjay_event_loop_t *loop,
+                        anjay_event_loop_socket_t *entry) {
+    if (register_fd(loop, entry->fd, entry)) {
+        if (errno != EEXIST) {
+            anjay_log(ERROR, "could not register socket in epoll: %s",
+                      strerror(errno));
+            return -1;
+        }
+        struct epoll_event event = {
+            .events = EPOLLIN,
+            .data = {
+                .ptr = entry
+            }
+        };
+        if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, entry->fd, &event)) {
+            return -1;
+        }
+    }
+    entry->registered = true;
+    return 0;
+}
+
+/**
+ * Updates the epoll set to match the set of sockets that would be returned by
+ * anjay_get_sockets(). Does not allocate memory or issue any system calls
+ * unless the set of sockets changed.
+ *
+ * Removals are processed before additions, as a descriptor number of a closed
+ * socket may have been reused by a new one.
+ */
+static void sync_sockets(anjay_t *anjay, anjay_event_loop_t *loop) {
+    _anjay_servers_foreach_online_socket(anjay, mark_socket, loop);
+
+    AVS_LIST(anjay_event_loop_socket_t) *entry_ptr;
+    AVS_LIST(anjay_event_loop_socket_t) helper;
+    AVS_LIST_DELETABLE_FOREACH_PTR(entry_ptr, helper, &loop->sockets) {
+        if (!(*entry_ptr)->seen) {
+            if ((*entry_ptr)->registered) {
+                socket_removed(loop, *entry_ptr);
+            }
+            AVS_LIST_DELETE(entry_ptr);
+        }
+    }
+
+    AVS_LIST(anjay_event_loop_socket_t) entry;
+    AVS_LIST_FOREACH(entry, loop->sockets) {
+        if (!entry->registered) {
+            // on failure, registration will be retried in the next iteration
+            socket_added(loop, entry);
+        }
+        entry->seen = false;
+    }
+}
+
+static int arm_timer(anjay_t *anjay, anjay_event_loop_t *loop) {
+    struct itimerspec timer;
+    memset(&timer, 0, sizeof(timer));
+    if (!anjay_sched_time_to_next(anjay, &timer.it_value)
+            && timer.it_value.tv_sec == 0 && timer.it_value.tv_nsec == 0) {
+        // zero it_value disarms the timer
+        timer.it_value.tv_nsec = 1;
+    }
+    // if there are no scheduled jobs, it_value is left zeroed
+    return timerfd_settime(loop->timer_fd, 0, &timer, NULL);
+}
+
+static void drain_fd(int fd) {
+    uint64_t value;
+    while (read(fd, &value, sizeof(value)) > 0) {
+    }
+}
+
+static bool is_tracked(anjay_event_loop_t *loop,
+                       anjay_event_loop_socket_t *entry) {
+    anjay_event_loop_socket_t *it;
+    AVS_LIST_FOREACH(it, loop->sockets) {
+        if (it == entry) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int find_online_socket(anjay_t *anjay,
+                              void *entry_,
+                              avs_net_abstract_socket_t *socket,
+                              uint32_t socket_generation) {
+    (void) anjay;
+    const anjay_event_loop_socket_t *entry =
+            (const anjay_event_loop_socket_t *) entry_;
+    return socket == entry->socket
+            && socket_generation == entry->socket_generation;
+}
+
+/**
+ * Checks whether @p entry still refers to a socket that would be returned by
+ * anjay_get_sockets(). The socket itself is not dereferenced, as it might have
+ * already been freed.
+ */
+static bool is_online(anjay_t *anjay, anjay_event_loop_socket_t *entry) {
+    return _anjay_servers_foreach_online_socket(anjay, find_online_socket,
+                                                entry) > 0;
+}
+
+static void handle_event(anjay_t *anjay,
+                         anjay_event_loop_t *loop,
+                         void *data) {
+    if (data == &loop->timer_fd) {
+        drain_fd(loop->timer_fd);
+    } else if (data == &loop->interrupt_fd) {
+        drain_fd(loop->interrupt_fd);
+        loop->interrupted = true;
+    } else if (data == &anjay->notify_inbox) {
+        // drained by anjay_sched_run()
+    } else {
+        anjay_event_loop_socket_t *entry = (anjay_event_loop_socket_t *) data;
+        // handling a previous event might have closed or freed this socket;
+        // anjay_serve() routes it to its owner, which may also be a server
+        // that is still being activated
+        if (is_tracked(loop, entry) && is_online(anjay, entry)
+                && get_socket_fd(entry->socket) == entry->fd) {
+            int result = anjay_serve_batch(anjay, entry->socket,
+                                           EVENT_LOOP_SERVE_BATCH_SIZE);
+            anjay_log(TRACE, "anjay_serve_batch returned %d", result);
+        }
+    }
+}
+
+int anjay_event_loop_run(anjay_t *anjay) {
+    anjay_event_loop_t *loop = &anjay->event_loop;
+    if (loop->running) {
+        anjay_log(ERROR, "event loop is already running");
+        return -1;
+    }
+    if (!loop->initialized && init_loop(anjay, loop)) {
+        return -1;
+    }
+
+    loop->running = true;
+    loop->interrupted = false;
+    int result = 0;
+    while (!loop->interrupted) {
+        sync_sockets(anjay, loop);
+        if (arm_timer(anjay, loop)) {
+            anjay_log(ERROR, "could not arm scheduler timer: %s",
+                      strerror(errno));
+            result = -1;
+            break;
+        }
+
+        struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+        int count = epoll_wait(loop->epoll_fd, events,
+                               EVENT_LOOP_MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            anjay_log(ERROR, "epoll_wait failed: %s", strerror(errno));
+            result = -1;
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            handle_event(anjay, loop, events[i].data.ptr);
+        }
+
+        if (anjay_sched_run(anjay)) {
+            result = -1;
+            break;
+        }
+    }
+    loop->running = false;
+    return result;
+}
+
+int anjay_event_loop_interrupt(anjay_t *anjay) {
+    anjay_event_loop_t *loop = &anjay->event_loop;
+    loop->interrupted = true;
+    if (loop->initialized) {
+        uint64_t value = 1;
+        if (write(loop->interrupt_fd, &value, sizeof(value)) < 0
+                && errno != EAGAIN) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+#ifdef ANJAY_TEST
+#include "test/event_loop.c"
+#endif // ANJAY_TEST
+
+#else // WITH_EVENT_LOOP
+
+void _anjay_event_loop_cleanup(anjay_event_loop_t *loop) {
+    (void) loop;
+}
+
+int anjay_event_loop_run(anjay_t *anjay) {
+    (void) anjay;
+    anjay_log(ERROR, "event loop support not compiled in");
+    return -1;
+}
+
+int anjay_event_loop_interrupt(anjay_t *anjay) {
+    (void) anjay;
+    return -1;
+}
+
+#endif // WITH_EVENT_LOOP
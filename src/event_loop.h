@@ -0,0 +1,59 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_EVENT_LOOP_H
+#define ANJAY_EVENT_LOOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <avsystem/commons/list.h>
+#include <avsystem/commons/net.h>
+
+#include <anjay/anjay.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+typedef struct {
+    avs_net_abstract_socket_t *socket;
+    int fd;
+    uint32_t socket_generation;
+    /* used while synchronizing the socket set */
+    bool seen;
+    bool registered;
+} anjay_event_loop_socket_t;
+
+/**
+ * State of the built-in event loop. System resources are allocated on the
+ * first call to @ref anjay_event_loop_run and kept until @ref anjay_delete, so
+ * that restarting the loop does not re-register all the descriptors.
+ */
+typedef struct {
+    bool initialized;
+    bool running;
+    volatile bool interrupted;
+    int epoll_fd;
+    int timer_fd;
+    int interrupt_fd;
+    /* sockets currently registered in epoll_fd */
+    AVS_LIST(anjay_event_loop_socket_t) sockets;
+} anjay_event_loop_t;
+
+void _anjay_event_loop_cleanup(anjay_event_loop_t *loop);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_EVENT_LOOP_H */
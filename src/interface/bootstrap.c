@@ -632,7 +632,9 @@ cleanup:
 static int request_bootstrap(anjay_t *anjay, void *dummy);
 
 static int schedule_request_bootstrap(anjay_t *anjay, time_t holdoff_s) {
-    struct timespec delay = { holdoff_s, 0 };
+    struct timespec delay =
+            _anjay_random_delay(anjay, anjay->reconnect_jitter_ms);
+    _anjay_time_add(&delay, &(const struct timespec) { holdoff_s, 0 });
     anjay_sched_retryable_backoff_t backoff = {
         .delay = { 3, 0 },
         .max_delay = { 120, 0 }
@@ -17,20 +17,39 @@
 #include <config.h>
 
 #include <inttypes.h>
+#include <stdlib.h>
 
 #include <avsystem/commons/stream.h>
 
 #include <anjay_modules/time.h>
 
 #include "register.h"
+#include "register_cache.h"
 #include "../dm.h"
 #include "../dm/query.h"
 #include "../utils.h"
+#include "../coap/async_request.h"
 #include "../coap/msg.h"
 #include "../coap/stream.h"
 
 VISIBILITY_SOURCE_BEGIN
 
+static int append_path_segment(AVS_LIST(const anjay_string_t) *path,
+                               const char *segment_data,
+                               size_t segment_size) {
+    AVS_LIST(anjay_string_t) segment =
+            (AVS_LIST(anjay_string_t))AVS_LIST_NEW_BUFFER(segment_size + 1);
+    if (!segment) {
+        anjay_log(ERROR, "out of memory");
+        return -1;
+    }
+
+    memcpy(segment, segment_data, segment_size);
+    segment->c_str[segment_size] = '\0';
+    AVS_LIST_APPEND(path, segment);
+    return 0;
+}
+
 static AVS_LIST(const anjay_string_t)
 get_endpoint_path(avs_stream_abstract_t *stream) {
     anjay_coap_opt_iterator_t it = ANJAY_COAP_OPT_ITERATOR_EMPTY;
@@ -43,17 +62,9 @@ get_endpoint_path(avs_stream_abstract_t *stream) {
     while ((result = _anjay_coap_stream_get_option_string_it(
                     stream, ANJAY_COAP_OPT_LOCATION_PATH, &it,
                     &attr_size, buffer, sizeof(buffer) - 1)) == 0) {
-        buffer[attr_size] = '\0';
-
-        AVS_LIST(anjay_string_t) segment =
-                (AVS_LIST(anjay_string_t))AVS_LIST_NEW_BUFFER(attr_size + 1);
-        if (!segment) {
-            anjay_log(ERROR, "out of memory");
+        if (append_path_segment(&path, buffer, attr_size)) {
             goto fail;
         }
-
-        memcpy(segment, buffer, attr_size + 1);
-        AVS_LIST_APPEND(&path, segment);
     }
 
     if (result == ANJAY_COAP_OPTION_MISSING) {
@@ -65,6 +76,30 @@ fail:
     return NULL;
 }
 
+static AVS_LIST(const anjay_string_t)
+get_endpoint_path_from_msg(const anjay_coap_msg_t *msg) {
+    AVS_LIST(const anjay_string_t) path = NULL;
+
+    char buffer[ANJAY_MAX_URI_SEGMENT_SIZE];
+    size_t attr_size;
+
+    for (anjay_coap_opt_iterator_t it = _anjay_coap_opt_begin(msg);
+            !_anjay_coap_opt_end(&it);
+            _anjay_coap_opt_next(&it)) {
+        if (_anjay_coap_opt_number(&it) != ANJAY_COAP_OPT_LOCATION_PATH) {
+            continue;
+        }
+        if (_anjay_coap_opt_string_value(it.curr_opt, &attr_size,
+                                         buffer, sizeof(buffer) - 1)
+                || append_path_segment(&path, buffer, attr_size)) {
+            AVS_LIST_CLEAR(&path);
+            return NULL;
+        }
+    }
+
+    return path;
+}
+
 static const char *assemble_endpoint_path(char *buffer,
                                           size_t buffer_size,
                                           AVS_LIST(const anjay_string_t) path) {
@@ -82,37 +117,6 @@ static const char *assemble_endpoint_path(char *buffer,
     return buffer;
 }
 
-static int send_objects_list(avs_stream_abstract_t *stream,
-                             AVS_LIST(anjay_dm_cache_object_t) dm) {
-    // TODO: (LwM2M 5.2.1) </>;rt="oma.lwm2m";ct=100 when JSON is implemented
-    bool is_first_path = true;
-
-    anjay_dm_cache_object_t *object;
-    AVS_LIST_FOREACH(object, dm) {
-        if (object->instances) {
-            anjay_iid_t *iid;
-            AVS_LIST_FOREACH(iid, object->instances) {
-                int result = avs_stream_write_f(stream, "%s</%u/%u>",
-                                                is_first_path ? "" : ",",
-                                                object->oid, *iid);
-                if (result) {
-                    return result;
-                }
-                is_first_path = false;
-            }
-        } else {
-            int result = avs_stream_write_f(stream, "%s</%u>",
-                                            is_first_path ? "" : ",",
-                                            object->oid);
-            if (result) {
-                return result;
-            }
-            is_first_path = false;
-        }
-    }
-    return 0;
-}
-
 static int get_server_lifetime(anjay_t *anjay,
                                anjay_ssid_t ssid,
                                int64_t *out_lifetime) {
@@ -140,11 +144,11 @@ static int get_server_lifetime(anjay_t *anjay,
     return 0;
 }
 
-static int send_register(avs_stream_abstract_t *stream,
-                         const char *endpoint_name,
-                         const char *sms_msisdn,
-                         const anjay_update_parameters_t *params) {
-    anjay_msg_details_t details = {
+static int init_register_details(anjay_msg_details_t *out_details,
+                                 const char *endpoint_name,
+                                 const char *sms_msisdn,
+                                 const anjay_update_parameters_t *params) {
+    *out_details = (anjay_msg_details_t) {
         .msg_type = ANJAY_COAP_MSG_CONFIRMABLE,
         .msg_code = ANJAY_COAP_CODE_POST,
         .format = ANJAY_COAP_FORMAT_APPLICATION_LINK,
@@ -157,15 +161,33 @@ static int send_register(avs_stream_abstract_t *stream,
                 sms_msisdn)
     };
 
-    int result = -1;
-    if (!details.uri_path || !details.uri_query) {
+    if (!out_details->uri_path || !out_details->uri_query) {
         anjay_log(ERROR, "could not initialize request headers");
+        return -1;
+    }
+    return 0;
+}
+
+static void cleanup_register_details(anjay_msg_details_t *details) {
+    AVS_LIST_CLEAR(&details->uri_path);
+    AVS_LIST_CLEAR(&details->uri_query);
+}
+
+static int send_register(anjay_t *anjay,
+                         avs_stream_abstract_t *stream,
+                         const char *endpoint_name,
+                         const char *sms_msisdn,
+                         const anjay_update_parameters_t *params) {
+    anjay_msg_details_t details;
+    int result = -1;
+    if (init_register_details(&details, endpoint_name, sms_msisdn, params)) {
         goto cleanup;
     }
 
-    if (_anjay_coap_stream_setup_request(stream, &details, NULL, 0)
-            || send_objects_list(stream, params->dm)
-            || avs_stream_finish_message(stream)) {
+    if ((result = _anjay_coap_stream_setup_request(stream, &details, NULL, 0))
+            || (result = _anjay_register_cache_write_payload(
+                    &anjay->register_cache, stream))
+            || (result = avs_stream_finish_message(stream))) {
         anjay_log(ERROR, "could not send Register message");
     } else {
         anjay_log(INFO, "Register sent");
@@ -173,28 +195,23 @@ static int send_register(avs_stream_abstract_t *stream,
     }
 
 cleanup:
-    AVS_LIST_CLEAR(&details.uri_path);
-    AVS_LIST_CLEAR(&details.uri_query);
+    cleanup_register_details(&details);
     return result;
 }
 
-static int
-check_register_response(avs_stream_abstract_t *stream,
-                        AVS_LIST(const anjay_string_t) *out_endpoint_path) {
-    uint8_t response_code;
-    if (_anjay_coap_stream_get_code(stream, &response_code)) {
-        anjay_log(ERROR, "could not get response code");
-        return -1;
-    }
-
+static int check_register_response_code(uint8_t response_code) {
     if (response_code != ANJAY_COAP_CODE_CREATED) {
         anjay_log(ERROR, "server responded with %s (expected %s)",
                   ANJAY_COAP_CODE_STRING(response_code),
                   ANJAY_COAP_CODE_STRING(ANJAY_COAP_CODE_CREATED));
         return -1;
     }
+    return 0;
+}
 
-    AVS_LIST(const anjay_string_t) endpoint_path = get_endpoint_path(stream);
+static int
+accept_endpoint_path(AVS_LIST(const anjay_string_t) endpoint_path,
+                     AVS_LIST(const anjay_string_t) *out_endpoint_path) {
     if (!endpoint_path) {
         anjay_log(ERROR, "server did not specify a location");
         return -1;
@@ -219,86 +236,19 @@ check_register_response(avs_stream_abstract_t *stream,
     return 0;
 }
 
-static void clear_dm_cache(AVS_LIST(anjay_dm_cache_object_t) *cache_ptr) {
-    AVS_LIST_CLEAR(cache_ptr) {
-        AVS_LIST_CLEAR(&(*cache_ptr)->instances);
-    }
-}
-
-static int query_dm_instance(anjay_t *anjay,
-                             const anjay_dm_object_def_t *const *obj,
-                             anjay_iid_t iid,
-                             void *cache_instance_insert_ptr_) {
-    (void) anjay; (void) obj;
-    AVS_LIST(anjay_iid_t) **cache_instance_insert_ptr =
-            (AVS_LIST(anjay_iid_t) **) cache_instance_insert_ptr_;
-
-    AVS_LIST(anjay_iid_t) new_instance = AVS_LIST_NEW_ELEMENT(anjay_iid_t);
-    if (!new_instance) {
-        anjay_log(ERROR, "out of memory");
-        return -1;
-    }
-    AVS_LIST_INSERT(*cache_instance_insert_ptr, new_instance);
-    *cache_instance_insert_ptr = AVS_LIST_NEXT_PTR(*cache_instance_insert_ptr);
-
-    *new_instance = iid;
-    return 0;
-}
-
-static int compare_iids(const void *left_, const void *right_, size_t size) {
-    (void) size;
-    anjay_iid_t left = *(const anjay_iid_t *) left_;
-    anjay_iid_t right = *(const anjay_iid_t *) right_;
-    if (left < right) {
+static int
+check_register_response(avs_stream_abstract_t *stream,
+                        AVS_LIST(const anjay_string_t) *out_endpoint_path) {
+    uint8_t response_code;
+    if (_anjay_coap_stream_get_code(stream, &response_code)) {
+        anjay_log(ERROR, "could not get response code");
         return -1;
-    } else if (left == right) {
-        return 0;
-    } else {
-        return 1;
-    }
-}
-
-static int query_dm_object(anjay_t *anjay,
-                           const anjay_dm_object_def_t *const *obj,
-                           void *cache_object_insert_ptr_) {
-    if ((*obj)->oid == ANJAY_DM_OID_SECURITY) {
-        /* LwM2M spec, 2016-09-08 update says that Register/Update must not
-         * include Security object instances */
-        return 0;
     }
 
-    AVS_LIST(anjay_dm_cache_object_t) **cache_object_insert_ptr =
-            (AVS_LIST(anjay_dm_cache_object_t) **) cache_object_insert_ptr_;
-
-    AVS_LIST(anjay_dm_cache_object_t) new_object =
-            AVS_LIST_NEW_ELEMENT(anjay_dm_cache_object_t);
-    if (!new_object) {
-        anjay_log(ERROR, "out of memory");
+    if (check_register_response_code(response_code)) {
         return -1;
     }
-    AVS_LIST_INSERT(*cache_object_insert_ptr, new_object);
-    *cache_object_insert_ptr = AVS_LIST_NEXT_PTR(*cache_object_insert_ptr);
-
-    new_object->oid = (*obj)->oid;
-    AVS_LIST(anjay_iid_t) *instance_insert_ptr = &new_object->instances;
-    int retval = _anjay_dm_foreach_instance(anjay, obj, query_dm_instance,
-                                            &instance_insert_ptr);
-    if (!retval) {
-        AVS_LIST_SORT(&new_object->instances, compare_iids);
-    }
-    return retval;
-}
-
-static int query_dm(anjay_t *anjay, AVS_LIST(anjay_dm_cache_object_t) *out) {
-    *out = NULL;
-    AVS_LIST(anjay_dm_cache_object_t) *insert_ptr = out;
-    int retval = _anjay_dm_foreach_object(anjay, query_dm_object, &insert_ptr);
-    if (retval) {
-        anjay_log(ERROR, "could not enumerate objects");
-        clear_dm_cache(out);
-    }
-    // objects in Anjay DM are kept sorted, there's no need to sort here
-    return retval;
+    return accept_endpoint_path(get_endpoint_path(stream), out_endpoint_path);
 }
 
 static struct timespec get_registration_expire_time(int64_t lifetime_s) {
@@ -308,39 +258,36 @@ static struct timespec get_registration_expire_time(int64_t lifetime_s) {
     return expire_time;
 }
 
-static void cleanup_update_parameters(anjay_update_parameters_t *params) {
-    clear_dm_cache(&params->dm);
-}
-
+/**
+ * @param full_dm_refresh If true, Instances of all Objects are enumerated,
+ *                        which makes Register immune to data model changes the
+ *                        user forgot to report. Updates rely on the notification
+ *                        queue, so that they do not need to query the data
+ *                        model at all if nothing changed.
+ */
 static int init_update_parameters(anjay_t *anjay,
                                   anjay_active_server_info_t *server,
+                                  bool full_dm_refresh,
                                   anjay_update_parameters_t *out_params) {
-    if (query_dm(anjay, &out_params->dm)) {
-        goto error;
+    if (_anjay_register_cache_refresh(anjay, full_dm_refresh)) {
+        return -1;
     }
+    out_params->dm_version = anjay->register_cache.version;
     if (get_server_lifetime(anjay, server->ssid, &out_params->lifetime_s)) {
-        goto error;
+        return -1;
     }
     out_params->binding_mode = _anjay_server_cached_binding_mode(server);
     if (out_params->binding_mode == ANJAY_BINDING_NONE) {
-        goto error;
+        return -1;
     }
     return 0;
-error:
-    cleanup_update_parameters(out_params);
-    return -1;
 }
 
 static void
 update_registration_info(anjay_registration_info_t *info,
-                         anjay_update_parameters_t *move_params) {
-    clear_dm_cache(&info->last_update_params.dm);
-    info->last_update_params.dm = move_params->dm;
-    move_params->dm = NULL;
-
-    assert(move_params->lifetime_s >= 0);
-    info->last_update_params.lifetime_s = move_params->lifetime_s;
-    info->last_update_params.binding_mode = move_params->binding_mode;
+                         const anjay_update_parameters_t *params) {
+    assert(params->lifetime_s >= 0);
+    info->last_update_params = *params;
 
     info->expire_time =
             get_registration_expire_time(info->last_update_params.lifetime_s);
@@ -349,8 +296,8 @@ update_registration_info(anjay_registration_info_t *info,
 static void
 registration_info_init(anjay_registration_info_t *info,
                        AVS_LIST(const anjay_string_t) *move_endpoint_path,
-                       anjay_update_parameters_t *move_params) {
-    update_registration_info(info, move_params);
+                       const anjay_update_parameters_t *params) {
+    update_registration_info(info, params);
 
     info->endpoint_path = *move_endpoint_path;
     *move_endpoint_path = NULL;
@@ -358,7 +305,7 @@ registration_info_init(anjay_registration_info_t *info,
 
 void _anjay_registration_info_cleanup(anjay_registration_info_t *info) {
     AVS_LIST_CLEAR(&info->endpoint_path);
-    cleanup_update_parameters(&info->last_update_params);
+    memset(&info->last_update_params, 0, sizeof(info->last_update_params));
 }
 
 int _anjay_register(anjay_t *anjay,
@@ -366,16 +313,14 @@ int _anjay_register(anjay_t *anjay,
                     anjay_active_server_info_t *server,
                     const char *endpoint_name) {
     anjay_update_parameters_t new_params;
-    if (init_update_parameters(anjay, server, &new_params)) {
+    if (init_update_parameters(anjay, server, true, &new_params)) {
         return -1;
     }
 
     AVS_LIST(const anjay_string_t) endpoint_path = NULL;
-    int result = -1;
-
-    if (send_register(stream, endpoint_name, _anjay_local_msisdn(anjay),
-                      &new_params)
-            || check_register_response(stream, &endpoint_path)) {
+    int result = send_register(anjay, stream, endpoint_name,
+                               _anjay_local_msisdn(anjay), &new_params);
+    if (result || (result = check_register_response(stream, &endpoint_path))) {
         anjay_log(ERROR, "could not register to server %u", server->ssid);
         goto fail;
     }
@@ -386,40 +331,145 @@ int _anjay_register(anjay_t *anjay,
     result = 0;
 
 fail:
-    cleanup_update_parameters(&new_params);
     AVS_LIST_CLEAR(&endpoint_path);
     return result;
 }
 
-static bool iid_lists_equal(AVS_LIST(anjay_iid_t) left,
-                            AVS_LIST(anjay_iid_t) right) {
-    while (left && right) {
-        if (*left != *right) {
-            return false;
-        }
-        left = AVS_LIST_NEXT(left);
-        right = AVS_LIST_NEXT(right);
+struct anjay_register_async {
+    anjay_active_server_info_t *server;
+    anjay_update_parameters_t params;
+    anjay_coap_async_request_t *request;
+    /* true for an Update sent by _anjay_update_async_send() */
+    bool update;
+};
+
+static int check_update_response_code(uint8_t response_code);
+
+int _anjay_register_async_send(anjay_register_async_t **out_async,
+                               anjay_t *anjay,
+                               anjay_active_server_info_t *server,
+                               const char *endpoint_name,
+                               const anjay_coap_msg_identity_t *identity,
+                               const anjay_coap_async_request_config_t *config) {
+    anjay_register_async_t *async =
+            (anjay_register_async_t *) calloc(1, sizeof(*async));
+    if (!async) {
+        anjay_log(ERROR, "out of memory");
+        return -1;
     }
-    return !(left || right);
+    async->server = server;
+
+    anjay_msg_details_t details = {
+        .uri_path = NULL
+    };
+    int result = -1;
+    if (init_update_parameters(anjay, server, false, &async->params)
+            || init_register_details(&details, endpoint_name,
+                                     _anjay_local_msisdn(anjay),
+                                     &async->params)) {
+        goto finish;
+    }
+
+    size_t payload_size;
+    const void *payload =
+            _anjay_register_cache_get_payload(&anjay->register_cache,
+                                              &payload_size);
+    result = _anjay_coap_async_request_send(&async->request, config, &details,
+                                            identity, payload, payload_size);
+    if (!result) {
+        anjay_log(INFO, "Register sent");
+        *out_async = async;
+        async = NULL;
+    } else if (result < 0) {
+        anjay_log(ERROR, "could not send Register message");
+    }
+
+finish:
+    cleanup_register_details(&details);
+    free(async);
+    return result;
 }
 
-static bool dm_caches_equal(AVS_LIST(anjay_dm_cache_object_t) left,
-                            AVS_LIST(anjay_dm_cache_object_t) right) {
-    while (left && right) {
-        if (left->oid != right->oid
-                || !iid_lists_equal(left->instances, right->instances)) {
-            return false;
-        }
-        left = AVS_LIST_NEXT(left);
-        right = AVS_LIST_NEXT(right);
+anjay_coap_async_request_t *
+_anjay_register_async_request(anjay_register_async_t *async) {
+    return async->request;
+}
+
+bool _anjay_register_async_is_update(const anjay_register_async_t *async) {
+    return async->update;
+}
+
+static int process_register_response(anjay_register_async_t *async,
+                                     const anjay_coap_msg_t *response) {
+    AVS_LIST(const anjay_string_t) endpoint_path = NULL;
+    if (check_register_response_code(response->header.code)
+            || accept_endpoint_path(get_endpoint_path_from_msg(response),
+                                    &endpoint_path)) {
+        anjay_log(ERROR, "could not register to server %u",
+                  async->server->ssid);
+        AVS_LIST_CLEAR(&endpoint_path);
+        return -1;
     }
-    return !(left || right);
+    _anjay_registration_info_cleanup(&async->server->registration_info);
+    registration_info_init(&async->server->registration_info,
+                           &endpoint_path, &async->params);
+    return 0;
 }
 
-static int send_update(avs_stream_abstract_t *stream,
-                       AVS_LIST(const anjay_string_t) endpoint_path,
-                       const anjay_update_parameters_t *old_params,
-                       const anjay_update_parameters_t *new_params) {
+static int process_update_response(anjay_register_async_t *async,
+                                   const anjay_coap_msg_t *response) {
+    int result = check_update_response_code(response->header.code);
+    if (result) {
+        anjay_log(ERROR, "could not update registration");
+        return result;
+    }
+    update_registration_info(&async->server->registration_info,
+                             &async->params);
+    return 0;
+}
+
+int _anjay_register_async_finish(anjay_register_async_t **async_ptr) {
+    anjay_register_async_t *async = *async_ptr;
+    const anjay_coap_msg_t *response =
+            _anjay_coap_async_request_response(async->request);
+
+    int result;
+    if (!response) {
+        anjay_log(ERROR, "no response to %s from server %u",
+                  async->update ? "Update" : "Register", async->server->ssid);
+        // the request fails only if it could not be delivered or was never
+        // answered - in both cases the server is unreachable at its address
+        result = ANJAY_COAP_SOCKET_ERR_TIMEOUT;
+    } else if (async->update) {
+        result = process_update_response(async, response);
+    } else {
+        result = process_register_response(async, response);
+    }
+
+    _anjay_register_async_cleanup(async_ptr);
+    return result;
+}
+
+void _anjay_register_async_cleanup(anjay_register_async_t **async_ptr) {
+    if (*async_ptr) {
+        _anjay_coap_async_request_cleanup(&(*async_ptr)->request);
+        free(*async_ptr);
+        *async_ptr = NULL;
+    }
+}
+
+/**
+ * Fills @p out_details with the headers of an Update that changes the
+ * registration from @p old_params to @p new_params. <c>uri_query</c> shall be
+ * freed by the caller.
+ *
+ * @returns Whether the Update needs to carry the list of Objects and Instances.
+ */
+static bool
+init_update_details(anjay_msg_details_t *out_details,
+                    AVS_LIST(const anjay_string_t) endpoint_path,
+                    const anjay_update_parameters_t *old_params,
+                    const anjay_update_parameters_t *new_params) {
     const int64_t *lifetime_s_ptr = NULL;
     assert(new_params->lifetime_s >= 0);
     if (new_params->lifetime_s != old_params->lifetime_s) {
@@ -431,8 +481,8 @@ static int send_update(avs_stream_abstract_t *stream,
                     ? ANJAY_BINDING_NONE : new_params->binding_mode;
 
     bool dm_changed_since_last_update =
-            !dm_caches_equal(old_params->dm, new_params->dm);
-    anjay_msg_details_t details = {
+            (old_params->dm_version != new_params->dm_version);
+    *out_details = (anjay_msg_details_t) {
         .msg_type = ANJAY_COAP_MSG_CONFIRMABLE,
         .msg_code = ANJAY_COAP_CODE_POST,
         .format = dm_changed_since_last_update
@@ -442,11 +492,24 @@ static int send_update(avs_stream_abstract_t *stream,
         .uri_query = _anjay_make_query_string_list(NULL, NULL, lifetime_s_ptr,
                                                    binding_mode, NULL)
     };
+    return dm_changed_since_last_update;
+}
+
+static int send_update(anjay_t *anjay,
+                       avs_stream_abstract_t *stream,
+                       AVS_LIST(const anjay_string_t) endpoint_path,
+                       const anjay_update_parameters_t *old_params,
+                       const anjay_update_parameters_t *new_params) {
+    anjay_msg_details_t details;
+    bool dm_changed_since_last_update =
+            init_update_details(&details, endpoint_path, old_params,
+                                new_params);
 
     int result = -1;
     if ((result = _anjay_coap_stream_setup_request(stream, &details, NULL, 0))
             || (dm_changed_since_last_update
-                && (result = send_objects_list(stream, new_params->dm)))
+                && (result = _anjay_register_cache_write_payload(
+                        &anjay->register_cache, stream)))
             || (result = avs_stream_finish_message(stream))) {
         anjay_log(ERROR, "could not send Update message");
     } else {
@@ -459,13 +522,7 @@ static int send_update(avs_stream_abstract_t *stream,
     return result;
 }
 
-static int check_update_response(avs_stream_abstract_t *stream) {
-    uint8_t response_code;
-    if (_anjay_coap_stream_get_code(stream, &response_code)) {
-        anjay_log(ERROR, "could not get response code");
-        return -1;
-    }
-
+static int check_update_response_code(uint8_t response_code) {
     if (response_code == ANJAY_COAP_CODE_CHANGED) {
         anjay_log(INFO, "registration successfully updated");
         return 0;
@@ -497,29 +554,78 @@ static int check_update_response(avs_stream_abstract_t *stream) {
     }
 }
 
+static int check_update_response(avs_stream_abstract_t *stream) {
+    uint8_t response_code;
+    if (_anjay_coap_stream_get_code(stream, &response_code)) {
+        anjay_log(ERROR, "could not get response code");
+        return -1;
+    }
+    return check_update_response_code(response_code);
+}
+
 int _anjay_update_registration(anjay_t *anjay,
                                avs_stream_abstract_t *stream,
                                anjay_active_server_info_t *server) {
     anjay_update_parameters_t new_params;
-    if (init_update_parameters(anjay, server, &new_params)) {
+    if (init_update_parameters(anjay, server, false, &new_params)) {
         return -1;
     }
 
     int retval = -1;
-    if ((retval = send_update(stream, server->registration_info.endpoint_path,
+    if ((retval = send_update(anjay, stream, server->registration_info.endpoint_path,
                               &server->registration_info.last_update_params,
                               &new_params))
             || (retval = check_update_response(stream))) {
         anjay_log(ERROR, "could not update registration");
-        goto finish;
+        return retval;
     }
 
     update_registration_info(&server->registration_info, &new_params);
-    retval = 0;
+    return 0;
+}
 
-finish:
-    cleanup_update_parameters(&new_params);
-    return retval;
+int _anjay_update_async_send(anjay_register_async_t **out_async,
+                             anjay_t *anjay,
+                             anjay_active_server_info_t *server,
+                             const anjay_coap_msg_identity_t *identity,
+                             const anjay_coap_async_request_config_t *config) {
+    anjay_register_async_t *async =
+            (anjay_register_async_t *) calloc(1, sizeof(*async));
+    if (!async) {
+        anjay_log(ERROR, "out of memory");
+        return -1;
+    }
+    async->server = server;
+    async->update = true;
+    if (init_update_parameters(anjay, server, false, &async->params)) {
+        free(async);
+        return -1;
+    }
+
+    anjay_msg_details_t details;
+    const void *payload = NULL;
+    size_t payload_size = 0;
+    if (init_update_details(&details, server->registration_info.endpoint_path,
+                            &server->registration_info.last_update_params,
+                            &async->params)) {
+        payload = _anjay_register_cache_get_payload(&anjay->register_cache,
+                                                    &payload_size);
+    }
+    int result = _anjay_coap_async_request_send(&async->request, config,
+                                                &details, identity, payload,
+                                                payload_size);
+    if (!result) {
+        anjay_log(INFO, "Update sent");
+        *out_async = async;
+        async = NULL;
+    } else if (result < 0) {
+        anjay_log(ERROR, "could not send Update message");
+    }
+
+    // uri_path is owned by the registration info
+    AVS_LIST_CLEAR(&details.uri_query);
+    free(async);
+    return result;
 }
 
 static int check_deregister_response(avs_stream_abstract_t *stream) {
@@ -18,18 +18,85 @@
 #define ANJAY_INTERFACE_REGISTER_H
 
 #include "../anjay.h"
+#include "../coap/async_request.h"
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
 void _anjay_registration_info_cleanup(anjay_registration_info_t *info);
 
+/**
+ * Sends a Register message to @p server and waits for the response.
+ *
+ * @returns 0 on success, @ref ANJAY_COAP_SOCKET_ERR_TIMEOUT if the server did
+ *          not respond, or another negative value in case of error.
+ */
 int _anjay_register(anjay_t *anjay,
                     avs_stream_abstract_t *stream,
                     anjay_active_server_info_t *server,
                     const char *endpoint_name);
 
+/**
+ * Sends a Register message to @p server without waiting for the response.
+ *
+ * Unlike @ref _anjay_register, does not enumerate the data model - the caller
+ * is expected to call @ref _anjay_register_cache_refresh beforehand, which
+ * allows doing that once for multiple servers registered at the same time.
+ *
+ * @returns 0 on success, @ref ANJAY_COAP_ASYNC_REQUEST_TOO_LARGE if the
+ *          Register message needs to be sent with @ref _anjay_register
+ *          instead, or a negative value in case of error.
+ */
+int _anjay_register_async_send(anjay_register_async_t **out_async,
+                               anjay_t *anjay,
+                               anjay_active_server_info_t *server,
+                               const char *endpoint_name,
+                               const anjay_coap_msg_identity_t *identity,
+                               const anjay_coap_async_request_config_t *config);
+
+/**
+ * Sends an Update message to @p server without waiting for the response. It
+ * is processed just like a Register sent by @ref _anjay_register_async_send .
+ *
+ * @returns 0 on success, @ref ANJAY_COAP_ASYNC_REQUEST_TOO_LARGE if the
+ *          Update message needs to be sent with @ref _anjay_update_registration
+ *          instead, or a negative value in case of error.
+ */
+int _anjay_update_async_send(anjay_register_async_t **out_async,
+                             anjay_t *anjay,
+                             anjay_active_server_info_t *server,
+                             const anjay_coap_msg_identity_t *identity,
+                             const anjay_coap_async_request_config_t *config);
+
+anjay_coap_async_request_t *
+_anjay_register_async_request(anjay_register_async_t *async);
+
+/**
+ * @returns Whether @p async has been sent by @ref _anjay_update_async_send .
+ */
+bool _anjay_register_async_is_update(const anjay_register_async_t *async);
+
 #define ANJAY_REGISTRATION_UPDATE_REJECTED 1
 
+/**
+ * Processes the response to a Register sent by
+ * @ref _anjay_register_async_send or an Update sent by
+ * @ref _anjay_update_async_send , and frees @p *async_ptr . Shall be called
+ * after the request is no longer in the WAITING state.
+ *
+ * @returns 0 if the registration succeeded or has been updated,
+ *          @ref ANJAY_REGISTRATION_UPDATE_REJECTED if the server rejected the
+ *          Update, @ref ANJAY_COAP_SOCKET_ERR_TIMEOUT if the server did not
+ *          respond, or another negative value in case of error.
+ */
+int _anjay_register_async_finish(anjay_register_async_t **async_ptr);
+
+/**
+ * Abandons a request sent by @ref _anjay_register_async_send or
+ * @ref _anjay_update_async_send , regardless of its state, and frees
+ * @p *async_ptr .
+ */
+void _anjay_register_async_cleanup(anjay_register_async_t **async_ptr);
+
 /**
  * @returns:
  * - 0 on success,
@@ -0,0 +1,456 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <anjay_modules/dm.h>
+
+#include "register_cache.h"
+#include "../anjay.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+/* longest possible link, including the trailing comma and terminating NUL */
+#define MAX_LINK_SIZE sizeof("</65535/65535>,")
+
+static size_t num_digits(unsigned value) {
+    size_t result = 1;
+    while (value >= 10) {
+        value /= 10;
+        ++result;
+    }
+    return result;
+}
+
+/**
+ * @returns Length of the "</oid/iid>," link, or "</oid>," if @p iid is
+ *          ANJAY_IID_INVALID.
+ */
+static size_t link_length(anjay_oid_t oid, anjay_iid_t iid) {
+    if (iid == ANJAY_IID_INVALID) {
+        return sizeof("</>,") - 1 + num_digits(oid);
+    }
+    return sizeof("<//>,") - 1 + num_digits(oid) + num_digits(iid);
+}
+
+static size_t format_link(char (*buffer)[MAX_LINK_SIZE],
+                          anjay_oid_t oid,
+                          anjay_iid_t iid) {
+    ssize_t result;
+    if (iid == ANJAY_IID_INVALID) {
+        result = _anjay_snprintf(*buffer, sizeof(*buffer), "</%u>,", oid);
+    } else {
+        result = _anjay_snprintf(*buffer, sizeof(*buffer), "</%u/%u>,",
+                                 oid, iid);
+    }
+    assert(result > 0 && (size_t) result == link_length(oid, iid));
+    return (size_t) result;
+}
+
+/**
+ * Replaces @p removed bytes at @p offset with @p size bytes of @p data.
+ */
+static int payload_splice(anjay_raw_buffer_t *payload,
+                          size_t offset,
+                          size_t removed,
+                          const void *data,
+                          size_t size) {
+    assert(offset + removed <= payload->size);
+    size_t new_size = payload->size - removed + size;
+    if (new_size > payload->capacity) {
+        size_t new_capacity = payload->capacity ? payload->capacity : 64;
+        while (new_capacity < new_size) {
+            new_capacity *= 2;
+        }
+        void *new_data = realloc(payload->data, new_capacity);
+        if (!new_data) {
+            anjay_log(ERROR, "Out of memory");
+            return -1;
+        }
+        payload->data = new_data;
+        payload->capacity = new_capacity;
+    }
+    char *base = (char *) payload->data;
+    memmove(base + offset + size, base + offset + removed,
+            payload->size - offset - removed);
+    if (size) {
+        memcpy(base + offset, data, size);
+    }
+    payload->size = new_size;
+    return 0;
+}
+
+static int payload_append_link(anjay_raw_buffer_t *payload,
+                               anjay_oid_t oid,
+                               anjay_iid_t iid) {
+    char link[MAX_LINK_SIZE];
+    size_t size = format_link(&link, oid, iid);
+    return payload_splice(payload, payload->size, 0, link, size);
+}
+
+static void clear_object(AVS_LIST(anjay_register_cache_object_t) *object_ptr) {
+    AVS_LIST_CLEAR(&(*object_ptr)->instances);
+    AVS_LIST_DELETE(object_ptr);
+}
+
+void _anjay_register_cache_cleanup(anjay_register_cache_t *cache) {
+    while (cache->objects) {
+        clear_object(&cache->objects);
+    }
+    _anjay_raw_buffer_clear(&cache->payload);
+    cache->initialized = false;
+}
+
+static AVS_LIST(anjay_register_cache_object_t) *
+find_object(anjay_register_cache_t *cache, anjay_oid_t oid, size_t *out_offset) {
+    size_t offset = 0;
+    AVS_LIST(anjay_register_cache_object_t) *object_ptr;
+    AVS_LIST_FOREACH_PTR(object_ptr, &cache->objects) {
+        if ((*object_ptr)->oid >= oid) {
+            break;
+        }
+        offset += (*object_ptr)->payload_size;
+    }
+    if (out_offset) {
+        *out_offset = offset;
+    }
+    return object_ptr;
+}
+
+/**
+ * Returns the cache entry for @p oid. If there was none, a new stale entry is
+ * created - it will be added to the payload by the next refresh.
+ */
+static AVS_LIST(anjay_register_cache_object_t) *
+find_or_create_object(anjay_register_cache_t *cache,
+                      anjay_oid_t oid,
+                      size_t *out_offset) {
+    AVS_LIST(anjay_register_cache_object_t) *object_ptr =
+            find_object(cache, oid, out_offset);
+    if (!*object_ptr || (*object_ptr)->oid != oid) {
+        AVS_LIST(anjay_register_cache_object_t) object =
+                AVS_LIST_NEW_ELEMENT(anjay_register_cache_object_t);
+        if (!object) {
+            anjay_log(ERROR, "Out of memory");
+            return NULL;
+        }
+        object->oid = oid;
+        object->stale = true;
+        AVS_LIST_INSERT(object_ptr, object);
+    }
+    return object_ptr;
+}
+
+static size_t find_instance(anjay_register_cache_object_t *object,
+                            anjay_iid_t iid,
+                            AVS_LIST(anjay_iid_t) **out_iid_ptr) {
+    size_t offset = 0;
+    AVS_LIST(anjay_iid_t) *iid_ptr;
+    AVS_LIST_FOREACH_PTR(iid_ptr, &object->instances) {
+        if (**iid_ptr >= iid) {
+            break;
+        }
+        offset += link_length(object->oid, **iid_ptr);
+    }
+    *out_iid_ptr = iid_ptr;
+    return offset;
+}
+
+static int add_instance(anjay_register_cache_t *cache,
+                        anjay_register_cache_object_t *object,
+                        size_t object_offset,
+                        anjay_iid_t iid) {
+    AVS_LIST(anjay_iid_t) *iid_ptr;
+    size_t offset = object_offset + find_instance(object, iid, &iid_ptr);
+    if (*iid_ptr && **iid_ptr == iid) {
+        return 0;
+    }
+
+    AVS_LIST(anjay_iid_t) new_iid = AVS_LIST_NEW_ELEMENT(anjay_iid_t);
+    if (!new_iid) {
+        anjay_log(ERROR, "Out of memory");
+        return -1;
+    }
+    *new_iid = iid;
+
+    // the first Instance replaces the "</oid>," link
+    size_t removed = object->instances ? 0 : object->payload_size;
+    char link[MAX_LINK_SIZE];
+    size_t size = format_link(&link, object->oid, iid);
+    if (payload_splice(&cache->payload, offset, removed, link, size)) {
+        AVS_LIST_DELETE(&new_iid);
+        return -1;
+    }
+    AVS_LIST_INSERT(iid_ptr, new_iid);
+    object->payload_size = object->payload_size - removed + size;
+    ++cache->version;
+    return 0;
+}
+
+static int remove_instance(anjay_register_cache_t *cache,
+                           anjay_register_cache_object_t *object,
+                           size_t object_offset,
+                           anjay_iid_t iid) {
+    AVS_LIST(anjay_iid_t) *iid_ptr;
+    size_t offset = object_offset + find_instance(object, iid, &iid_ptr);
+    if (!*iid_ptr || **iid_ptr != iid) {
+        return 0;
+    }
+
+    size_t removed = link_length(object->oid, iid);
+    char link[MAX_LINK_SIZE] = "";
+    size_t size = 0;
+    if (!AVS_LIST_NEXT(object->instances)) {
+        // the last Instance is replaced with the "</oid>," link
+        size = format_link(&link, object->oid, ANJAY_IID_INVALID);
+    }
+    if (payload_splice(&cache->payload, offset, removed, link, size)) {
+        return -1;
+    }
+    AVS_LIST_DELETE(iid_ptr);
+    object->payload_size = object->payload_size - removed + size;
+    ++cache->version;
+    return 0;
+}
+
+static int apply_known_changes(anjay_register_cache_t *cache,
+                               anjay_register_cache_object_t *object,
+                               size_t object_offset,
+                               const anjay_notify_queue_instance_entry_t *changes) {
+    AVS_LIST(anjay_iid_t) iid;
+    AVS_LIST_FOREACH(iid, changes->known_removed_iids) {
+        if (remove_instance(cache, object, object_offset, *iid)) {
+            return -1;
+        }
+    }
+    AVS_LIST_FOREACH(iid, changes->known_added_iids) {
+        if (add_instance(cache, object, object_offset, *iid)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void _anjay_register_cache_update(anjay_register_cache_t *cache,
+                                  anjay_notify_queue_t queue) {
+    if (!cache->initialized) {
+        // everything will be enumerated anyway
+        return;
+    }
+    AVS_LIST(anjay_notify_queue_object_entry_t) entry;
+    AVS_LIST_FOREACH(entry, queue) {
+        if (entry->oid == ANJAY_DM_OID_SECURITY
+                || !entry->instance_set_changes.instance_set_changed) {
+            continue;
+        }
+        size_t offset;
+        AVS_LIST(anjay_register_cache_object_t) *object_ptr =
+                find_or_create_object(cache, entry->oid, &offset);
+        if (!object_ptr) {
+            cache->initialized = false;
+            return;
+        }
+        if ((*object_ptr)->stale
+                || entry->instance_set_changes.unknown_change
+                || apply_known_changes(cache, *object_ptr, offset,
+                                       &entry->instance_set_changes)) {
+            (*object_ptr)->stale = true;
+        }
+    }
+}
+
+static int enumerate_instance(anjay_t *anjay,
+                              const anjay_dm_object_def_t *const *obj,
+                              anjay_iid_t iid,
+                              void *insert_ptr_) {
+    (void) anjay; (void) obj;
+    AVS_LIST(anjay_iid_t) **insert_ptr = (AVS_LIST(anjay_iid_t) **) insert_ptr_;
+    AVS_LIST(anjay_iid_t) new_instance = AVS_LIST_NEW_ELEMENT(anjay_iid_t);
+    if (!new_instance) {
+        anjay_log(ERROR, "Out of memory");
+        return -1;
+    }
+    *new_instance = iid;
+    AVS_LIST_INSERT(*insert_ptr, new_instance);
+    *insert_ptr = AVS_LIST_NEXT_PTR(*insert_ptr);
+    return 0;
+}
+
+static int compare_iids(const void *left_, const void *right_, size_t size) {
+    (void) size;
+    anjay_iid_t left = *(const anjay_iid_t *) left_;
+    anjay_iid_t right = *(const anjay_iid_t *) right_;
+    if (left < right) {
+        return -1;
+    } else if (left == right) {
+        return 0;
+    } else {
+        return 1;
+    }
+}
+
+static int render_object(anjay_raw_buffer_t *out,
+                         anjay_oid_t oid,
+                         AVS_LIST(anjay_iid_t) instances) {
+    if (!instances) {
+        return payload_append_link(out, oid, ANJAY_IID_INVALID);
+    }
+    AVS_LIST(anjay_iid_t) iid;
+    AVS_LIST_FOREACH(iid, instances) {
+        if (payload_append_link(out, oid, *iid)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int refresh_object(anjay_t *anjay,
+                          anjay_register_cache_t *cache,
+                          const anjay_dm_object_def_t *const *obj,
+                          anjay_register_cache_object_t *object,
+                          size_t object_offset) {
+    AVS_LIST(anjay_iid_t) instances = NULL;
+    AVS_LIST(anjay_iid_t) *insert_ptr = &instances;
+    anjay_raw_buffer_t rendered = ANJAY_RAW_BUFFER_EMPTY;
+    int result = _anjay_dm_foreach_instance(anjay, obj, enumerate_instance,
+                                            &insert_ptr);
+    if (!result) {
+        AVS_LIST_SORT(&instances, compare_iids);
+        result = render_object(&rendered, object->oid, instances);
+    }
+    if (!result
+            && (rendered.size != object->payload_size
+                    || memcmp((const char *) cache->payload.data
+                                      + object_offset,
+                              rendered.data, rendered.size))) {
+        result = payload_splice(&cache->payload, object_offset,
+                                object->payload_size, rendered.data,
+                                rendered.size);
+        if (!result) {
+            object->payload_size = rendered.size;
+            ++cache->version;
+        }
+    }
+    if (!result) {
+        AVS_LIST_CLEAR(&object->instances);
+        object->instances = instances;
+        instances = NULL;
+        object->stale = false;
+    }
+    AVS_LIST_CLEAR(&instances);
+    _anjay_raw_buffer_clear(&rendered);
+    return result;
+}
+
+static int refresh_stale_objects(anjay_t *anjay,
+                                 anjay_register_cache_t *cache) {
+    size_t offset = 0;
+    AVS_LIST(anjay_register_cache_object_t) *object_ptr = &cache->objects;
+    while (*object_ptr) {
+        if ((*object_ptr)->stale) {
+            const anjay_dm_object_def_t *const *obj =
+                    _anjay_dm_find_object_by_oid(anjay, (*object_ptr)->oid);
+            if (!obj) {
+                // Object has been unregistered
+                if ((*object_ptr)->payload_size) {
+                    if (payload_splice(&cache->payload, offset,
+                                       (*object_ptr)->payload_size, NULL, 0)) {
+                        return -1;
+                    }
+                    ++cache->version;
+                }
+                clear_object(object_ptr);
+                continue;
+            }
+            if (refresh_object(anjay, cache, obj, *object_ptr, offset)) {
+                return -1;
+            }
+        }
+        offset += (*object_ptr)->payload_size;
+        object_ptr = AVS_LIST_NEXT_PTR(object_ptr);
+    }
+    return 0;
+}
+
+static int mark_object_stale(anjay_t *anjay,
+                             const anjay_dm_object_def_t *const *obj,
+                             void *cache_) {
+    (void) anjay;
+    if ((*obj)->oid == ANJAY_DM_OID_SECURITY) {
+        /* LwM2M spec, 2016-09-08 update says that Register/Update must not
+         * include Security object instances */
+        return 0;
+    }
+    AVS_LIST(anjay_register_cache_object_t) *object_ptr =
+            find_or_create_object((anjay_register_cache_t *) cache_,
+                                  (*obj)->oid, NULL);
+    if (!object_ptr) {
+        return -1;
+    }
+    (*object_ptr)->stale = true;
+    return 0;
+}
+
+int _anjay_register_cache_refresh(anjay_t *anjay, bool full) {
+    anjay_register_cache_t *cache = &anjay->register_cache;
+    // changes reported by the user, but not flushed yet
+    _anjay_register_cache_update(cache, anjay->scheduled_notify.queue);
+
+    if (full || !cache->initialized) {
+        anjay_register_cache_object_t *object;
+        AVS_LIST_FOREACH(object, cache->objects) {
+            object->stale = true;
+        }
+        if (_anjay_dm_foreach_object(anjay, mark_object_stale, cache)) {
+            anjay_log(ERROR, "could not enumerate objects");
+            return -1;
+        }
+        cache->initialized = true;
+    }
+
+    if (refresh_stale_objects(anjay, cache)) {
+        anjay_log(ERROR, "could not enumerate instances");
+        return -1;
+    }
+    return 0;
+}
+
+const void *
+_anjay_register_cache_get_payload(const anjay_register_cache_t *cache,
+                                  size_t *out_size) {
+    // TODO: (LwM2M 5.2.1) </>;rt="oma.lwm2m";ct=100 when JSON is implemented
+    // skip the trailing comma
+    *out_size = cache->payload.size ? cache->payload.size - 1 : 0;
+    return cache->payload.data;
+}
+
+int _anjay_register_cache_write_payload(const anjay_register_cache_t *cache,
+                                        avs_stream_abstract_t *stream) {
+    size_t size;
+    const void *data = _anjay_register_cache_get_payload(cache, &size);
+    if (!size) {
+        return 0;
+    }
+    return avs_stream_write(stream, data, size);
+}
+
+#ifdef ANJAY_TEST
+#include "test/register_cache.c"
+#endif // ANJAY_TEST
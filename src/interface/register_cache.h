@@ -0,0 +1,102 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_INTERFACE_REGISTER_CACHE_H
+#define ANJAY_INTERFACE_REGISTER_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <avsystem/commons/list.h>
+#include <avsystem/commons/stream.h>
+
+#include <anjay/anjay.h>
+
+#include <anjay_modules/notify.h>
+#include <anjay_modules/utils.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+typedef struct {
+    anjay_oid_t oid;
+    /* set if Instances need to be enumerated again to know the current set */
+    bool stale;
+    /* sorted in ascending order */
+    AVS_LIST(anjay_iid_t) instances;
+    /* number of bytes occupied by links to this Object in the payload */
+    size_t payload_size;
+} anjay_register_cache_object_t;
+
+/**
+ * Set of Objects and Instances reported in Register and Update messages, kept
+ * up to date using the notification queue, so that checking whether the data
+ * model changed since the last Update does not require enumerating it.
+ *
+ * The link-format payload is kept pre-rendered, with every link followed by a
+ * comma - this way, adding or removing an Instance is a matter of inserting or
+ * removing a single link, without touching the neighboring ones. The trailing
+ * comma is not sent.
+ */
+typedef struct {
+    /* false until the data model is enumerated for the first time */
+    bool initialized;
+    /* sorted by OID; the Security Object is never included */
+    AVS_LIST(anjay_register_cache_object_t) objects;
+    anjay_raw_buffer_t payload;
+    /* incremented each time the payload changes */
+    uint32_t version;
+} anjay_register_cache_t;
+
+void _anjay_register_cache_cleanup(anjay_register_cache_t *cache);
+
+/**
+ * Applies Instance set changes listed in @p queue. Changes with exactly known
+ * sets of added and removed Instances are applied directly to the cache.
+ * Objects with other changes are marked stale and will be enumerated during
+ * the next @ref _anjay_register_cache_refresh call.
+ *
+ * Applying the same queue more than once is harmless.
+ */
+void _anjay_register_cache_update(anjay_register_cache_t *cache,
+                                  anjay_notify_queue_t queue);
+
+/**
+ * Makes sure that the cache reflects the current state of the data model:
+ * applies changes not yet flushed from the scheduled notification queue and
+ * enumerates Instances of stale Objects.
+ *
+ * @param full If true, Instances of all Objects are enumerated, as if all of
+ *             them were stale.
+ */
+int _anjay_register_cache_refresh(anjay_t *anjay, bool full);
+
+/**
+ * @returns Pointer to the link-format list of Objects and Instances, valid
+ *          until the cache is modified. Its length is stored in @p out_size .
+ */
+const void *
+_anjay_register_cache_get_payload(const anjay_register_cache_t *cache,
+                                  size_t *out_size);
+
+/**
+ * Writes the link-format list of Objects and Instances to @p stream.
+ */
+int _anjay_register_cache_write_payload(const anjay_register_cache_t *cache,
+                                        avs_stream_abstract_t *stream);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // ANJAY_INTERFACE_REGISTER_CACHE_H
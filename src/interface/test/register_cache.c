@@ -0,0 +1,112 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay_test/dm.h>
+
+#define ASSERT_PAYLOAD(Anjay, Expected) do { \
+    AVS_UNIT_ASSERT_EQUAL((Anjay)->register_cache.payload.size, \
+                          sizeof(Expected) - 1); \
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED((Anjay)->register_cache.payload.data, \
+                                      Expected, sizeof(Expected) - 1); \
+} while (0)
+
+AVS_UNIT_TEST(register_cache, incremental_update) {
+    DM_TEST_INIT_WITH_OBJECTS(&OBJ, &FAKE_SECURITY2, &FAKE_SERVER);
+    // drop notifications about registering the objects
+    _anjay_notify_clear_queue(&anjay->scheduled_notify.queue);
+
+    // initial enumeration; Security is never queried
+    _anjay_mock_dm_expect_instance_it(anjay, &FAKE_SERVER, 0, 0, 1);
+    _anjay_mock_dm_expect_instance_it(anjay, &FAKE_SERVER, 1, 0,
+                                      ANJAY_IID_INVALID);
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 0, 0, 7);
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 1, 0, 3);
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 2, 0, ANJAY_IID_INVALID);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_register_cache_refresh(anjay, false));
+    ASSERT_PAYLOAD(anjay, "</1/1>,</42/3>,</42/7>,");
+    uint32_t version = anjay->register_cache.version;
+
+    // nothing changed - no data model calls at all
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_register_cache_refresh(anjay, false));
+    AVS_UNIT_ASSERT_EQUAL(anjay->register_cache.version, version);
+
+    anjay_notify_queue_t queue = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_notify_queue_instance_created(&queue, 42, 5));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_notify_queue_instance_removed(&queue, 42, 3));
+    _anjay_register_cache_update(&anjay->register_cache, queue);
+    // applying the same changes again is a no-op
+    _anjay_register_cache_update(&anjay->register_cache, queue);
+    _anjay_notify_clear_queue(&queue);
+    ASSERT_PAYLOAD(anjay, "</1/1>,</42/5>,</42/7>,");
+    AVS_UNIT_ASSERT_NOT_EQUAL(anjay->register_cache.version, version);
+    version = anjay->register_cache.version;
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_notify_queue_instance_removed(&queue, 42, 5));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_notify_queue_instance_removed(&queue, 42, 7));
+    _anjay_register_cache_update(&anjay->register_cache, queue);
+    _anjay_notify_clear_queue(&queue);
+    ASSERT_PAYLOAD(anjay, "</1/1>,</42>,");
+
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_notify_queue_instance_created(&queue, 42, 65534));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_notify_queue_instance_created(&queue, 0, 1));
+    _anjay_register_cache_update(&anjay->register_cache, queue);
+    _anjay_notify_clear_queue(&queue);
+    ASSERT_PAYLOAD(anjay, "</1/1>,</42/65534>,");
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_register_cache_refresh(anjay, false));
+    version = anjay->register_cache.version;
+
+    // unknown changes are resolved by enumerating only the affected Object
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_notify_queue_instance_set_unknown_change(&queue, 1));
+    _anjay_register_cache_update(&anjay->register_cache, queue);
+    _anjay_notify_clear_queue(&queue);
+    _anjay_mock_dm_expect_instance_it(anjay, &FAKE_SERVER, 0, 0, 1);
+    _anjay_mock_dm_expect_instance_it(anjay, &FAKE_SERVER, 1, 0,
+                                      ANJAY_IID_INVALID);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_register_cache_refresh(anjay, false));
+    ASSERT_PAYLOAD(anjay, "</1/1>,</42/65534>,");
+    AVS_UNIT_ASSERT_EQUAL(anjay->register_cache.version, version);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(register_cache, unregistered_object) {
+    DM_TEST_INIT_WITH_OBJECTS(&OBJ, &FAKE_SERVER);
+    _anjay_notify_clear_queue(&anjay->scheduled_notify.queue);
+
+    _anjay_mock_dm_expect_instance_it(anjay, &FAKE_SERVER, 0, 0,
+                                      ANJAY_IID_INVALID);
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 0, 0, 4);
+    _anjay_mock_dm_expect_instance_it(anjay, &OBJ, 1, 0, ANJAY_IID_INVALID);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_register_cache_refresh(anjay, false));
+    ASSERT_PAYLOAD(anjay, "</1>,</42/4>,");
+
+    AVS_UNIT_ASSERT_SUCCESS(anjay_unregister_object(anjay, &OBJ));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_register_cache_refresh(anjay, false));
+    ASSERT_PAYLOAD(anjay, "</1>,");
+
+    DM_TEST_FINISH;
+}
@@ -315,6 +315,48 @@ int anjay_get_bytes(anjay_input_ctx_t *ctx,
     }
 }
 
+int _anjay_stream_read_view(avs_stream_abstract_t *stream,
+                            const void **out_data,
+                            size_t *out_bytes_read,
+                            char *out_message_finished,
+                            size_t max_length,
+                            void *fallback_buf,
+                            size_t fallback_buf_size) {
+    const anjay_stream_view_ext_t *ext = (const anjay_stream_view_ext_t *)
+            avs_stream_v_table_find_extension(stream,
+                                              ANJAY_STREAM_VIEW_EXTENSION);
+    if (ext) {
+        return ext->read_view(stream, out_data, out_bytes_read,
+                              out_message_finished, max_length);
+    }
+    *out_data = fallback_buf;
+    return avs_stream_read(stream, out_bytes_read, out_message_finished,
+                           fallback_buf,
+                           ANJAY_MIN(max_length, fallback_buf_size));
+}
+
+int _anjay_input_get_some_bytes_view(anjay_input_ctx_t *ctx,
+                                     size_t *out_bytes_read,
+                                     bool *out_message_finished,
+                                     const void **out_data,
+                                     size_t max_length) {
+    if (!ctx->vtable->some_bytes_view) {
+        return -1;
+    }
+    return ctx->vtable->some_bytes_view(ctx, out_bytes_read,
+                                        out_message_finished, out_data,
+                                        max_length);
+}
+
+int anjay_get_bytes_view(anjay_input_ctx_t *ctx,
+                         size_t *out_bytes_read,
+                         bool *out_message_finished,
+                         const void **out_data) {
+    return _anjay_input_get_some_bytes_view(ctx, out_bytes_read,
+                                            out_message_finished, out_data,
+                                            SIZE_MAX);
+}
+
 typedef struct {
     const avs_stream_v_table_t * const vtable;
     anjay_input_ctx_t *backend;
@@ -324,6 +366,29 @@ static int unimplemented() {
     return -1;
 }
 
+static int bytes_stream_read_view(avs_stream_abstract_t *stream,
+                                  const void **out_data,
+                                  size_t *out_bytes_read,
+                                  char *out_message_finished,
+                                  size_t max_length) {
+    anjay_input_ctx_t **backend_ptr = &((bytes_stream_t *) stream)->backend;
+    if (*backend_ptr) {
+        bool message_finished;
+        int retval = _anjay_input_get_some_bytes_view(*backend_ptr,
+                                                      out_bytes_read,
+                                                      &message_finished,
+                                                      out_data, max_length);
+        if (!retval && (*out_message_finished = message_finished)) {
+            *backend_ptr = NULL;
+        }
+        return retval;
+    } else {
+        *out_bytes_read = 0;
+        *out_message_finished = 1;
+        return 0;
+    }
+}
+
 static int bytes_stream_read(avs_stream_abstract_t *stream,
                              size_t *out_bytes_read,
                              char *out_message_finished,
@@ -356,6 +421,13 @@ static int bytes_stream_close(avs_stream_abstract_t *stream) {
 }
 
 avs_stream_abstract_t *_anjay_input_bytes_stream(anjay_input_ctx_t *ctx) {
+    static const anjay_stream_view_ext_t VIEW_EXT = {
+        .read_view = bytes_stream_read_view
+    };
+    static const avs_stream_v_table_extension_t EXTENSIONS[] = {
+        { ANJAY_STREAM_VIEW_EXTENSION, &VIEW_EXT },
+        AVS_STREAM_V_TABLE_EXTENSION_NULL
+    };
     static const avs_stream_v_table_t VTABLE = {
         (avs_stream_write_t) unimplemented,
         (avs_stream_finish_message_t) unimplemented,
@@ -364,7 +436,7 @@ avs_stream_abstract_t *_anjay_input_bytes_stream(anjay_input_ctx_t *ctx) {
         (avs_stream_reset_t) unimplemented,
         bytes_stream_close,
         (avs_stream_errno_t) unimplemented,
-        NULL
+        EXTENSIONS
     };
     bytes_stream_t specimen = { &VTABLE, ctx };
     bytes_stream_t *out = (bytes_stream_t *) malloc(sizeof(bytes_stream_t));
@@ -104,6 +104,28 @@ int _anjay_output_set_id(anjay_output_ctx_t *ctx,
                          anjay_id_type_t type, uint16_t id);
 int _anjay_output_ctx_destroy(anjay_output_ctx_t **ctx_ptr);
 
+/* Size of the buffer used for anjay_get_bytes_view() if the underlying stream
+ * does not support zero-copy reads */
+#define ANJAY_INPUT_VIEW_FALLBACK_BUFFER_SIZE 256
+
+/**
+ * Performs a zero-copy read from @p stream if it supports the
+ * ANJAY_STREAM_VIEW_EXTENSION, or reads into @p fallback_buf otherwise.
+ */
+int _anjay_stream_read_view(avs_stream_abstract_t *stream,
+                            const void **out_data,
+                            size_t *out_bytes_read,
+                            char *out_message_finished,
+                            size_t max_length,
+                            void *fallback_buf,
+                            size_t fallback_buf_size);
+
+int _anjay_input_get_some_bytes_view(anjay_input_ctx_t *ctx,
+                                     size_t *out_bytes_read,
+                                     bool *out_message_finished,
+                                     const void **out_data,
+                                     size_t max_length);
+
 avs_stream_abstract_t *_anjay_input_bytes_stream(anjay_input_ctx_t *ctx);
 int _anjay_input_attach_child(anjay_input_ctx_t *ctx,
                               anjay_input_ctx_t *child);
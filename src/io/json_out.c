@@ -25,6 +25,8 @@
 #include <avsystem/commons/log.h>
 #include <avsystem/commons/list.h>
 #include <avsystem/commons/stream.h>
+#include <avsystem/commons/base64.h>
+#include <avsystem/commons/stream/stream_outbuf.h>
 
 #include "../io.h"
 #include "base64_out.h"
@@ -66,10 +68,16 @@ static const char *data_type_to_string(json_data_type_t type) {
     }
 }
 
+/**
+ * Header of a buffered element. In the entry buffer, each header is directly
+ * followed by @ref json_entry_t#value_length bytes of the serialized value,
+ * including the key - e.g. "v":42
+ */
 typedef struct {
-    json_id_t id;
-    json_data_type_t type;
-    const void *value;
+    /* Full path of the element, starting from the Object ID. */
+    json_id_t path[4];
+    size_t num_path_elems;
+    size_t value_length;
 } json_entry_t;
 
 typedef enum {
@@ -96,10 +104,18 @@ typedef struct json_out_struct {
     /* Number of elements in the node_path which form a basename */
     size_t num_base_path_elems;
 
-    bool needs_separator;
+    /* Elements are buffered until the context is closed, so that the longest
+       common path prefix of all of them can be used as the basename. All of
+       them are stored in a single growable buffer, as a sequence of
+       json_entry_t headers, each followed by the serialized value. */
+    char *entries;
+    size_t entries_size;
+    size_t entries_capacity;
+
     json_out_array_t array_ctx;
     bool returning_array;
     anjay_ret_bytes_ctx_t *bytes;
+    avs_stream_outbuf_t bytes_outbuf;
     json_id_t next_id;
 } json_out_t;
 
@@ -160,37 +176,27 @@ update_node_path(json_out_t *ctx, anjay_id_type_t type, uint16_t id) {
     }
 }
 
-#define MAX_CHILD_PATH_LEN sizeof("/65535/65535/65535")
-
-static size_t
-count_child_path_elems(json_out_t *ctx) {
-    return ctx->num_path_elems - ctx->num_base_path_elems;
-}
-
-static ssize_t child_path_to_string(json_out_t *ctx, char *dest, size_t size) {
-    switch (count_child_path_elems(ctx)) {
-    case 1:
-        return _anjay_snprintf(dest, size, "/%"PRId32,
-                               ctx->path[ctx->num_base_path_elems].id);
-    case 2:
-        return _anjay_snprintf(dest, size, "/%"PRId32"/%"PRId32,
-                               ctx->path[ctx->num_base_path_elems].id,
-                               ctx->path[ctx->num_base_path_elems + 1].id);
-    case 3:
-        return _anjay_snprintf(dest, size, "/%"PRId32"/%"PRId32"/%"PRId32,
-                               ctx->path[ctx->num_base_path_elems].id,
-                               ctx->path[ctx->num_base_path_elems + 1].id,
-                               ctx->path[ctx->num_base_path_elems + 2].id);
-    default:
-        return -1;
-    }
-}
-
 typedef struct {
     anjay_oid_t oid;
     anjay_iid_t iid;
 } packed_objlnk_t;
 
+static size_t quoted_string_length(const char *value) {
+    size_t result = 2; /* opening and closing quotation marks */
+    for (; *value; ++value) {
+        if (*value == '\\' || *value == '"'
+                || *value == '\b' || *value == '\f' || *value == '\n'
+                || *value == '\r' || *value == '\t') {
+            result += 2;
+        } else if ((uint8_t) *value < 0x20) {
+            result += sizeof("\\u00XX") - 1;
+        } else {
+            ++result;
+        }
+    }
+    return result;
+}
+
 static int write_quoted_string(avs_stream_abstract_t *stream,
                                const char *value) {
     int retval = avs_stream_write(stream, "\"", 1);
@@ -255,9 +261,19 @@ static int write_variable(avs_stream_abstract_t *stream,
     case JSON_DATA_I64:
         return avs_stream_write_f(stream, "%" PRIi64, *(const int64_t *) value);
     case JSON_DATA_F32:
-        return avs_stream_write_f(stream, "%f", *(const float *) value);
     case JSON_DATA_F64:
-        return avs_stream_write_f(stream, "%f", *(const double *) value);
+        {
+            char buf[ANJAY_DOUBLE_STRING_SIZE];
+            ssize_t length = (type == JSON_DATA_F32)
+                    ? _anjay_float_to_string(buf, sizeof(buf),
+                                             *(const float *) value)
+                    : _anjay_double_to_string(buf, sizeof(buf),
+                                              *(const double *) value);
+            if (length < 0) {
+                return -1;
+            }
+            return avs_stream_write(stream, buf, (size_t) length);
+        }
     case JSON_DATA_BOOL:
         return avs_stream_write_f(stream, "%s",
                                   (*(const bool *) value) ? "true" : "false");
@@ -275,44 +291,75 @@ static int write_variable(avs_stream_abstract_t *stream,
     }
 }
 
-static int write_uri(avs_stream_abstract_t *stream,
-                     const anjay_uri_path_t *path) {
-    int retval = avs_stream_write_f(stream, "/%d", path->oid);
-    if (!retval && path->has_iid) {
-        retval = avs_stream_write_f(stream, "/%d", path->iid);
-    }
-    if (!retval && path->has_rid) {
-        retval = avs_stream_write_f(stream, "/%d", path->rid);
-    }
-    return retval;
+static json_entry_t read_entry(const json_out_t *ctx, size_t offset) {
+    json_entry_t entry;
+    assert(offset + sizeof(entry) <= ctx->entries_size);
+    memcpy(&entry, ctx->entries + offset, sizeof(entry));
+    return entry;
 }
 
-static int write_element_name(json_out_t *ctx) {
-    const char *name = NULL;
-    char buf[MAX_CHILD_PATH_LEN];
-    if (count_child_path_elems(ctx)) {
-        if (child_path_to_string(ctx, buf, sizeof(buf)) < 0) {
-            return -1;
+/**
+ * Reserves space for an element with a value of at most @p value_capacity
+ * bytes at the end of the entry buffer. The element is not a part of the
+ * response until @ref commit_entry is called.
+ *
+ * @returns Pointer to the space reserved for the value, valid until the next
+ *          call to @ref begin_entry, or NULL in case of error.
+ */
+static char *begin_entry(json_out_t *ctx, size_t value_capacity) {
+    const size_t required =
+            ctx->entries_size + sizeof(json_entry_t) + value_capacity;
+    if (required > ctx->entries_capacity) {
+        size_t new_capacity =
+                ctx->entries_capacity ? ctx->entries_capacity : 256;
+        while (new_capacity < required) {
+            new_capacity *= 2;
+        }
+        char *new_entries = (char *) realloc(ctx->entries, new_capacity);
+        if (!new_entries) {
+            json_log(ERROR, "out of memory");
+            return NULL;
         }
-        name = buf;
+        ctx->entries = new_entries;
+        ctx->entries_capacity = new_capacity;
     }
+    return ctx->entries + ctx->entries_size + sizeof(json_entry_t);
+}
 
-    int retval;
-    if (name) {
-        retval = avs_stream_write_f(ctx->stream, "{\"n\":\"%s\",", name);
-    } else {
-        retval = avs_stream_write(ctx->stream, "{", 1);
-    }
-    return retval;
+static void commit_entry(json_out_t *ctx, size_t value_length) {
+    json_entry_t entry;
+    memcpy(entry.path, ctx->path, sizeof(entry.path));
+    entry.num_path_elems = ctx->num_path_elems;
+    entry.value_length = value_length;
+    assert(ctx->entries_size + sizeof(entry) + value_length
+                   <= ctx->entries_capacity);
+    memcpy(ctx->entries + ctx->entries_size, &entry, sizeof(entry));
+    ctx->entries_size += sizeof(entry) + value_length;
 }
 
+/* Large enough for the key and any non-string value */
+#define MAX_SIMPLE_VALUE_SIZE (sizeof("\"v\":") + ANJAY_DOUBLE_STRING_SIZE)
+
 static int write_response_element(json_out_t *ctx,
                                   json_data_type_t type,
                                   const void *value) {
-    int retval;
-    (void) ((retval = write_element_name(ctx))
-            || (retval = write_variable(ctx->stream, type, value))
-            || (retval = avs_stream_write(ctx->stream, "}", 1)));
+    const size_t key_length =
+            strlen(data_type_to_string(type)) + sizeof("\"\":") - 1;
+    const size_t capacity = (type == JSON_DATA_STRING)
+            ? key_length + quoted_string_length((const char *) value)
+            : MAX_SIMPLE_VALUE_SIZE;
+    char *buffer = begin_entry(ctx, capacity);
+    if (!buffer) {
+        return -1;
+    }
+
+    avs_stream_outbuf_t outbuf = AVS_STREAM_OUTBUF_STATIC_INITIALIZER;
+    avs_stream_outbuf_set_buffer(&outbuf, buffer, capacity);
+    int retval = write_variable((avs_stream_abstract_t *) &outbuf,
+                                type, value);
+    if (!retval) {
+        commit_entry(ctx, avs_stream_outbuf_offset(&outbuf));
+    }
     return retval;
 }
 
@@ -343,26 +390,22 @@ static int finish_ret_bytes(json_out_t *ctx) {
     if (!ctx->bytes) {
         return -1;
     }
+    avs_stream_abstract_t *outbuf =
+            (avs_stream_abstract_t *) &ctx->bytes_outbuf;
     int result;
     (void) ((result = _anjay_base64_ret_bytes_ctx_close(ctx->bytes))
-            || (result = avs_stream_write(ctx->stream, "\"}", 2)));
+            || (result = avs_stream_write(outbuf, "\"", 1)));
+    if (!result) {
+        commit_entry(ctx, avs_stream_outbuf_offset(&ctx->bytes_outbuf));
+    }
     _anjay_base64_ret_bytes_ctx_delete(&ctx->bytes);
     return result;
 }
 
-static int maybe_write_separator(json_out_t *ctx) {
-    if (ctx->needs_separator
-            && avs_stream_write(ctx->stream, ",", 1)) {
-        return -1;
-    }
-    ctx->needs_separator = true;
-    return 0;
-}
-
 static int process_single_entry(json_out_t *ctx,
                                 json_data_type_t type,
                                 const void *value) {
-    if (ctx->bytes || maybe_write_separator(ctx)) {
+    if (ctx->bytes) {
         return -1;
     }
 
@@ -385,16 +428,24 @@ static anjay_ret_bytes_ctx_t *json_ret_bytes(anjay_output_ctx_t *ctx_,
         return NULL;
     }
 
-    int retval;
-    (void) ((retval = maybe_write_separator(ctx))
-            || (retval = write_element_name(ctx))
-            || (retval = avs_stream_write_f(ctx->stream, "\"%s\":\"",
-                                            data_type_to_string(
-                                                    JSON_DATA_STRING))));
-    if (retval) {
+    const char *key = data_type_to_string(JSON_DATA_STRING);
+    /* "key":"<base64>" */
+    const size_t capacity = strlen(key) + sizeof("\"\":\"\"") - 1
+            + avs_base64_encoded_size(length) - 1;
+    /* no other element may be added until the bytes are finished, so the
+       buffer will not be reallocated in the meantime */
+    char *buffer = begin_entry(ctx, capacity);
+    if (!buffer) {
         return NULL;
     }
-    ctx->bytes = _anjay_base64_ret_bytes_ctx_new(ctx->stream, length);
+    ctx->bytes_outbuf = AVS_STREAM_OUTBUF_STATIC_INITIALIZER;
+    avs_stream_outbuf_set_buffer(&ctx->bytes_outbuf, buffer, capacity);
+    avs_stream_abstract_t *outbuf =
+            (avs_stream_abstract_t *) &ctx->bytes_outbuf;
+    if (avs_stream_write_f(outbuf, "\"%s\":\"", key)) {
+        return NULL;
+    }
+    ctx->bytes = _anjay_base64_ret_bytes_ctx_new(outbuf, length);
     if (ctx->bytes && ctx->returning_array) {
         ctx->array_ctx.expected_write = EXPECT_INDEX;
     }
@@ -501,33 +552,130 @@ static int json_set_id(anjay_output_ctx_t *ctx_,
                        anjay_id_type_t type,
                        uint16_t id) {
     json_out_t *ctx = (json_out_t *) ctx_;
-    ctx->next_id.type = type;
-    ctx->next_id.id = id;
-    update_node_path(ctx, type, id);
+    // the pending bytes value belongs to the path set before this call
     if (ctx->bytes) {
         int result = finish_ret_bytes(ctx);
         if (result) {
             return result;
         }
     }
+    ctx->next_id.type = type;
+    ctx->next_id.id = id;
+    update_node_path(ctx, type, id);
     json_log(INFO, "set_id(%p, type=%d, id=%d)", (void *) ctx_, (int) type,
              (int) id);
     return 0;
 }
 
-static int write_response_finish(avs_stream_abstract_t *stream) {
-    return avs_stream_write(stream, "]}", 2);
+static size_t common_prefix_length(const json_entry_t *entry,
+                                   const json_id_t *path,
+                                   size_t path_length) {
+    size_t result = 0;
+    while (result < path_length
+            && result < entry->num_path_elems
+            && entry->path[result].type == path[result].type
+            && entry->path[result].id == path[result].id) {
+        ++result;
+    }
+    return result;
+}
+
+/**
+ * Finds the basename that minimizes the size of the response. Every path
+ * element moved into the basename is written once instead of once per
+ * element, so the longest prefix shared by all elements is optimal.
+ */
+static size_t find_base_path_length(const json_out_t *ctx,
+                                    const json_entry_t *first) {
+    size_t result = first->num_path_elems;
+    for (size_t offset = 0; offset < ctx->entries_size;) {
+        const json_entry_t entry = read_entry(ctx, offset);
+        result = common_prefix_length(&entry, first->path, result);
+        offset += sizeof(entry) + entry.value_length;
+    }
+    assert(result >= ctx->num_base_path_elems);
+    return result;
+}
+
+static int write_path(avs_stream_abstract_t *stream,
+                      const json_id_t *path,
+                      size_t length) {
+    int retval = 0;
+    for (size_t i = 0; !retval && i < length; ++i) {
+        retval = avs_stream_write_f(stream, "/%" PRId32, path[i].id);
+    }
+    return retval;
+}
+
+static int write_entry(avs_stream_abstract_t *stream,
+                       const json_entry_t *entry,
+                       const char *value,
+                       size_t base_path_length) {
+    int retval = avs_stream_write(stream, "{", 1);
+    if (!retval && entry->num_path_elems > base_path_length) {
+        (void) ((retval = avs_stream_write(stream, "\"n\":\"", 5))
+                || (retval = write_path(stream,
+                                        &entry->path[base_path_length],
+                                        entry->num_path_elems
+                                                - base_path_length))
+                || (retval = avs_stream_write(stream, "\",", 2)));
+    }
+    if (!retval) {
+        (void) ((retval = avs_stream_write(stream, value,
+                                           entry->value_length))
+                || (retval = avs_stream_write(stream, "}", 1)));
+    }
+    return retval;
+}
+
+static int write_response(json_out_t *ctx) {
+    const json_id_t *base_path = ctx->path;
+    size_t base_path_length = ctx->num_base_path_elems;
+    json_entry_t first;
+    if (ctx->entries_size) {
+        first = read_entry(ctx, 0);
+        base_path = first.path;
+        base_path_length = find_base_path_length(ctx, &first);
+    }
+
+    int retval;
+    (void) ((retval = avs_stream_write(ctx->stream, "{\"bn\":\"", 7))
+            || (retval = write_path(ctx->stream, base_path,
+                                    base_path_length))
+            || (retval = avs_stream_write(ctx->stream, "\",\"e\":[", 7)));
+
+    for (size_t offset = 0; !retval && offset < ctx->entries_size;) {
+        const json_entry_t entry = read_entry(ctx, offset);
+        if (offset) {
+            retval = avs_stream_write(ctx->stream, ",", 1);
+        }
+        offset += sizeof(entry);
+        if (!retval) {
+            retval = write_entry(ctx->stream, &entry, ctx->entries + offset,
+                                 base_path_length);
+        }
+        offset += entry.value_length;
+    }
+    if (!retval) {
+        retval = avs_stream_write(ctx->stream, "]}", 2);
+    }
+    return retval;
 }
 
 static int json_output_close(anjay_output_ctx_t *ctx_) {
     json_out_t *ctx = (json_out_t *) ctx_;
+    int result = 0;
     if (ctx->bytes) {
-        int result = finish_ret_bytes(ctx);
-        if (result) {
-            return result;
-        }
+        result = finish_ret_bytes(ctx);
+    }
+    if (!result) {
+        result = write_response(ctx);
     }
-    return write_response_finish(ctx->stream);
+    free(ctx->entries);
+    ctx->entries = NULL;
+    ctx->entries_size = 0;
+    ctx->entries_capacity = 0;
+    return result;
 }
 
 static const anjay_output_ctx_vtable_t JSON_OUT_VTABLE = {
@@ -549,20 +697,9 @@ static const anjay_output_ctx_vtable_t JSON_OUT_VTABLE = {
     json_output_close
 };
 
-static int write_response_preamble(avs_stream_abstract_t *stream,
-                                   const anjay_uri_path_t *base) {
-    int retval;
-    (void) ((retval = avs_stream_write_f(stream, "%s", "{\"bn\":\""))
-            || (retval = write_uri(stream, base))
-            || (retval = avs_stream_write_f(stream, "%s", "\",\"e\":[")));
-    return retval;
-}
-
-anjay_output_ctx_t *
-_anjay_output_json_create(avs_stream_abstract_t *stream,
-                          int *errno_ptr,
-                          anjay_msg_details_t *inout_details,
-                          const anjay_uri_path_t *uri) {
+static json_out_t *json_out_new(avs_stream_abstract_t *stream,
+                                int *errno_ptr,
+                                const anjay_uri_path_t *uri) {
     json_out_t *ctx = (json_out_t *) calloc(1, sizeof(json_out_t));
     if (ctx) {
         ctx->vtable = &JSON_OUT_VTABLE;
@@ -582,16 +719,22 @@ _anjay_output_json_create(avs_stream_abstract_t *stream,
             update_node_path(ctx, ANJAY_ID_RID, uri->rid);
             ++ctx->num_base_path_elems;
         }
+    }
+    return ctx;
+}
 
+anjay_output_ctx_t *
+_anjay_output_json_create(avs_stream_abstract_t *stream,
+                          int *errno_ptr,
+                          anjay_msg_details_t *inout_details,
+                          const anjay_uri_path_t *uri) {
+    json_out_t *ctx = json_out_new(stream, errno_ptr, uri);
+    if (ctx) {
         if ((*errno_ptr = _anjay_handle_requested_format(
                      &inout_details->format, ANJAY_COAP_FORMAT_JSON))
             || _anjay_coap_stream_setup_response(stream, inout_details)) {
             goto error;
         }
-        if (write_response_preamble(stream, uri)) {
-            json_log(ERROR, "cannot write response preamble");
-            goto error;
-        }
         json_log(INFO, "created json context");
     }
     return (anjay_output_ctx_t *) ctx;
@@ -599,3 +742,7 @@ error:
     free(ctx);
     return NULL;
 }
+
+#ifdef ANJAY_TEST
+#include "test/json_out.c"
+#endif
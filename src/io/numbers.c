@@ -0,0 +1,736 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../utils.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+/////////////////////////////////////////////////////////////////// FORMATTING
+
+/*
+ * Shortest round-trip formatting of floating-point numbers, based on the
+ * Grisu2 algorithm by Florian Loitsch ("Printing Floating-Point Numbers
+ * Quickly and Accurately with Integers", PLDI 2010).
+ *
+ * Grisu2 always generates digits that read back to exactly the same value.
+ * The generated representation is the shortest possible one for the vast
+ * majority (more than 99.9%) of inputs, and at most one digit longer
+ * otherwise. Only integer arithmetic is used, so the output does not depend
+ * on the platform's libc or floating-point environment.
+ */
+
+typedef struct {
+    uint64_t f;
+    int e;
+} diyfp_t;
+
+static diyfp_t diyfp_sub(diyfp_t x, diyfp_t y) {
+    assert(x.e == y.e);
+    assert(x.f >= y.f);
+    return (diyfp_t) { x.f - y.f, x.e };
+}
+
+/* Returns the upper 64 bits of the 128-bit product, rounded. */
+static diyfp_t diyfp_mul(diyfp_t x, diyfp_t y) {
+    const uint64_t u_lo = x.f & UINT32_MAX;
+    const uint64_t u_hi = x.f >> 32;
+    const uint64_t v_lo = y.f & UINT32_MAX;
+    const uint64_t v_hi = y.f >> 32;
+
+    const uint64_t p0 = u_lo * v_lo;
+    const uint64_t p1 = u_lo * v_hi;
+    const uint64_t p2 = u_hi * v_lo;
+    const uint64_t p3 = u_hi * v_hi;
+
+    uint64_t q = (p0 >> 32) + (p1 & UINT32_MAX) + (p2 & UINT32_MAX);
+    q += UINT64_C(1) << 31;
+
+    return (diyfp_t) {
+        p3 + (p1 >> 32) + (p2 >> 32) + (q >> 32),
+        x.e + y.e + 64
+    };
+}
+
+static diyfp_t diyfp_normalize(diyfp_t x) {
+    assert(x.f);
+    while (!(x.f >> 63)) {
+        x.f <<= 1;
+        --x.e;
+    }
+    return x;
+}
+
+static diyfp_t diyfp_normalize_to(diyfp_t x, int target_exponent) {
+    const int delta = x.e - target_exponent;
+    assert(delta >= 0);
+    assert(((x.f << delta) >> delta) == x.f);
+    return (diyfp_t) { x.f << delta, target_exponent };
+}
+
+typedef struct {
+    diyfp_t w;
+    diyfp_t minus;
+    diyfp_t plus;
+} boundaries_t;
+
+/**
+ * Computes the normalized value @p significand * 2^@p exponent together with
+ * the boundaries of its rounding interval, i.e. the midpoints between the
+ * value and its floating-point neighbours.
+ */
+static boundaries_t compute_boundaries(uint64_t significand,
+                                       int exponent,
+                                       bool lower_boundary_is_closer) {
+    const diyfp_t v = { significand, exponent };
+    const diyfp_t plus = diyfp_normalize((diyfp_t) { 2 * v.f + 1, v.e - 1 });
+    const diyfp_t minus = lower_boundary_is_closer
+            ? (diyfp_t) { 4 * v.f - 1, v.e - 2 }
+            : (diyfp_t) { 2 * v.f - 1, v.e - 1 };
+    return (boundaries_t) {
+        .w = diyfp_normalize(v),
+        .minus = diyfp_normalize_to(minus, plus.e),
+        .plus = plus
+    };
+}
+
+static boundaries_t double_boundaries(double value) {
+    enum {
+        PRECISION = 53, /* including the hidden bit */
+        BIAS = 1023 + (PRECISION - 1),
+        MIN_EXP = 1 - BIAS
+    };
+    AVS_STATIC_ASSERT(sizeof(double) == sizeof(uint64_t), double_is_64bit);
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint64_t hidden_bit = UINT64_C(1) << (PRECISION - 1);
+    const uint64_t raw_significand = bits & (hidden_bit - 1);
+    const int raw_exponent = (int) ((bits >> (PRECISION - 1)) & 0x7FF);
+
+    if (!raw_exponent) {
+        return compute_boundaries(raw_significand, MIN_EXP, false);
+    }
+    return compute_boundaries(raw_significand + hidden_bit,
+                              raw_exponent - BIAS,
+                              !raw_significand && raw_exponent > 1);
+}
+
+static boundaries_t float_boundaries(float value) {
+    enum {
+        PRECISION = 24, /* including the hidden bit */
+        BIAS = 127 + (PRECISION - 1),
+        MIN_EXP = 1 - BIAS
+    };
+    AVS_STATIC_ASSERT(sizeof(float) == sizeof(uint32_t), float_is_32bit);
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint32_t hidden_bit = UINT32_C(1) << (PRECISION - 1);
+    const uint32_t raw_significand = bits & (hidden_bit - 1);
+    const int raw_exponent = (int) ((bits >> (PRECISION - 1)) & 0xFF);
+
+    if (!raw_exponent) {
+        return compute_boundaries(raw_significand, MIN_EXP, false);
+    }
+    return compute_boundaries(raw_significand + hidden_bit,
+                              raw_exponent - BIAS,
+                              !raw_significand && raw_exponent > 1);
+}
+
+/* Target range of the binary exponent of the scaled value; see the paper. */
+#define GRISU_ALPHA (-60)
+#define GRISU_GAMMA (-32)
+
+typedef struct {
+    uint64_t f;
+    int e;
+    int k;
+} cached_power_t;
+
+#define CACHED_POWERS_MIN_DEC_EXP (-300)
+#define CACHED_POWERS_DEC_STEP 8
+
+/* Normalized 64-bit approximations of 10^k for k = -300, -292, ..., 324 */
+static const cached_power_t CACHED_POWERS[] = {
+    { UINT64_C(0xAB70FE17C79AC6CA), -1060, -300 },
+    { UINT64_C(0xFF77B1FCBEBCDC4F), -1034, -292 },
+    { UINT64_C(0xBE5691EF416BD60C), -1007, -284 },
+    { UINT64_C(0x8DD01FAD907FFC3C),  -980, -276 },
+    { UINT64_C(0xD3515C2831559A83),  -954, -268 },
+    { UINT64_C(0x9D71AC8FADA6C9B5),  -927, -260 },
+    { UINT64_C(0xEA9C227723EE8BCB),  -901, -252 },
+    { UINT64_C(0xAECC49914078536D),  -874, -244 },
+    { UINT64_C(0x823C12795DB6CE57),  -847, -236 },
+    { UINT64_C(0xC21094364DFB5637),  -821, -228 },
+    { UINT64_C(0x9096EA6F3848984F),  -794, -220 },
+    { UINT64_C(0xD77485CB25823AC7),  -768, -212 },
+    { UINT64_C(0xA086CFCD97BF97F4),  -741, -204 },
+    { UINT64_C(0xEF340A98172AACE5),  -715, -196 },
+    { UINT64_C(0xB23867FB2A35B28E),  -688, -188 },
+    { UINT64_C(0x84C8D4DFD2C63F3B),  -661, -180 },
+    { UINT64_C(0xC5DD44271AD3CDBA),  -635, -172 },
+    { UINT64_C(0x936B9FCEBB25C996),  -608, -164 },
+    { UINT64_C(0xDBAC6C247D62A584),  -582, -156 },
+    { UINT64_C(0xA3AB66580D5FDAF6),  -555, -148 },
+    { UINT64_C(0xF3E2F893DEC3F126),  -529, -140 },
+    { UINT64_C(0xB5B5ADA8AAFF80B8),  -502, -132 },
+    { UINT64_C(0x87625F056C7C4A8B),  -475, -124 },
+    { UINT64_C(0xC9BCFF6034C13053),  -449, -116 },
+    { UINT64_C(0x964E858C91BA2655),  -422, -108 },
+    { UINT64_C(0xDFF9772470297EBD),  -396, -100 },
+    { UINT64_C(0xA6DFBD9FB8E5B88F),  -369,  -92 },
+    { UINT64_C(0xF8A95FCF88747D94),  -343,  -84 },
+    { UINT64_C(0xB94470938FA89BCF),  -316,  -76 },
+    { UINT64_C(0x8A08F0F8BF0F156B),  -289,  -68 },
+    { UINT64_C(0xCDB02555653131B6),  -263,  -60 },
+    { UINT64_C(0x993FE2C6D07B7FAC),  -236,  -52 },
+    { UINT64_C(0xE45C10C42A2B3B06),  -210,  -44 },
+    { UINT64_C(0xAA242499697392D3),  -183,  -36 },
+    { UINT64_C(0xFD87B5F28300CA0E),  -157,  -28 },
+    { UINT64_C(0xBCE5086492111AEB),  -130,  -20 },
+    { UINT64_C(0x8CBCCC096F5088CC),  -103,  -12 },
+    { UINT64_C(0xD1B71758E219652C),   -77,   -4 },
+    { UINT64_C(0x9C40000000000000),   -50,    4 },
+    { UINT64_C(0xE8D4A51000000000),   -24,   12 },
+    { UINT64_C(0xAD78EBC5AC620000),     3,   20 },
+    { UINT64_C(0x813F3978F8940984),    30,   28 },
+    { UINT64_C(0xC097CE7BC90715B3),    56,   36 },
+    { UINT64_C(0x8F7E32CE7BEA5C70),    83,   44 },
+    { UINT64_C(0xD5D238A4ABE98068),   109,   52 },
+    { UINT64_C(0x9F4F2726179A2245),   136,   60 },
+    { UINT64_C(0xED63A231D4C4FB27),   162,   68 },
+    { UINT64_C(0xB0DE65388CC8ADA8),   189,   76 },
+    { UINT64_C(0x83C7088E1AAB65DB),   216,   84 },
+    { UINT64_C(0xC45D1DF942711D9A),   242,   92 },
+    { UINT64_C(0x924D692CA61BE758),   269,  100 },
+    { UINT64_C(0xDA01EE641A708DEA),   295,  108 },
+    { UINT64_C(0xA26DA3999AEF774A),   322,  116 },
+    { UINT64_C(0xF209787BB47D6B85),   348,  124 },
+    { UINT64_C(0xB454E4A179DD1877),   375,  132 },
+    { UINT64_C(0x865B86925B9BC5C2),   402,  140 },
+    { UINT64_C(0xC83553C5C8965D3D),   428,  148 },
+    { UINT64_C(0x952AB45CFA97A0B3),   455,  156 },
+    { UINT64_C(0xDE469FBD99A05FE3),   481,  164 },
+    { UINT64_C(0xA59BC234DB398C25),   508,  172 },
+    { UINT64_C(0xF6C69A72A3989F5C),   534,  180 },
+    { UINT64_C(0xB7DCBF5354E9BECE),   561,  188 },
+    { UINT64_C(0x88FCF317F22241E2),   588,  196 },
+    { UINT64_C(0xCC20CE9BD35C78A5),   614,  204 },
+    { UINT64_C(0x98165AF37B2153DF),   641,  212 },
+    { UINT64_C(0xE2A0B5DC971F303A),   667,  220 },
+    { UINT64_C(0xA8D9D1535CE3B396),   694,  228 },
+    { UINT64_C(0xFB9B7CD9A4A7443C),   720,  236 },
+    { UINT64_C(0xBB764C4CA7A44410),   747,  244 },
+    { UINT64_C(0x8BAB8EEFB6409C1A),   774,  252 },
+    { UINT64_C(0xD01FEF10A657842C),   800,  260 },
+    { UINT64_C(0x9B10A4E5E9913129),   827,  268 },
+    { UINT64_C(0xE7109BFBA19C0C9D),   853,  276 },
+    { UINT64_C(0xAC2820D9623BF429),   880,  284 },
+    { UINT64_C(0x80444B5E7AA7CF85),   907,  292 },
+    { UINT64_C(0xBF21E44003ACDD2D),   933,  300 },
+    { UINT64_C(0x8E679C2F5E44FF8F),   960,  308 },
+    { UINT64_C(0xD433179D9C8CB841),   986,  316 },
+    { UINT64_C(0x9E19DB92B4E31BA9),  1013,  324 }};
+
+/**
+ * Returns a cached power of ten c = 10^(-k) such that the binary exponent of
+ * w * c is within [GRISU_ALPHA, GRISU_GAMMA] for a normalized w with binary
+ * exponent @p e.
+ */
+static cached_power_t get_cached_power(int e) {
+    const int f = GRISU_ALPHA - e - 1;
+    /* ceil(f * log10(2)) */
+    const int k = (f * 78913) / (1 << 18) + (f > 0);
+    const int index = (-CACHED_POWERS_MIN_DEC_EXP + k
+                       + (CACHED_POWERS_DEC_STEP - 1))
+                      / CACHED_POWERS_DEC_STEP;
+    assert(index >= 0 && (size_t) index < ANJAY_ARRAY_SIZE(CACHED_POWERS));
+    const cached_power_t cached = CACHED_POWERS[index];
+    assert(GRISU_ALPHA <= cached.e + e + 64);
+    assert(GRISU_GAMMA >= cached.e + e + 64);
+    return cached;
+}
+
+static int find_largest_pow10(uint32_t n, uint32_t *out_pow10) {
+    static const uint32_t POWERS[] = {
+        1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u,
+        100000000u, 1000000000u
+    };
+    int i = (int) ANJAY_ARRAY_SIZE(POWERS) - 1;
+    while (i > 0 && n < POWERS[i]) {
+        --i;
+    }
+    *out_pow10 = POWERS[i];
+    return i + 1;
+}
+
+static void grisu2_round(char *digits, size_t length, uint64_t dist,
+                         uint64_t delta, uint64_t rest, uint64_t ten_k) {
+    assert(length >= 1);
+    assert(dist <= delta);
+    assert(rest <= delta);
+    assert(ten_k > 0);
+    /* Move the last digit towards w as long as it stays within the rounding
+     * interval and gets closer to w. */
+    while (rest < dist
+            && delta - rest >= ten_k
+            && (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+        assert(digits[length - 1] != '0');
+        --digits[length - 1];
+        rest += ten_k;
+    }
+}
+
+/**
+ * Generates the digits of a number V within (M_minus, M_plus), so that
+ * V = digits * 10^decimal_exponent, as close as possible to w.
+ */
+static size_t grisu2_digit_gen(char *digits, int *decimal_exponent,
+                               diyfp_t m_minus, diyfp_t w, diyfp_t m_plus) {
+    assert(m_plus.e >= GRISU_ALPHA);
+    assert(m_plus.e <= GRISU_GAMMA);
+
+    uint64_t delta = diyfp_sub(m_plus, m_minus).f;
+    uint64_t dist = diyfp_sub(m_plus, w).f;
+
+    const diyfp_t one = { UINT64_C(1) << -m_plus.e, m_plus.e };
+    uint32_t p1 = (uint32_t) (m_plus.f >> -one.e);
+    uint64_t p2 = m_plus.f & (one.f - 1);
+    size_t length = 0;
+
+    assert(p1 > 0);
+    uint32_t pow10;
+    int n = find_largest_pow10(p1, &pow10);
+
+    /* integral part */
+    while (n > 0) {
+        const uint32_t d = p1 / pow10;
+        p1 %= pow10;
+        assert(d <= 9);
+        digits[length++] = (char) ('0' + d);
+        --n;
+
+        const uint64_t rest = ((uint64_t) p1 << -one.e) + p2;
+        if (rest <= delta) {
+            *decimal_exponent += n;
+            grisu2_round(digits, length, dist, delta, rest,
+                         (uint64_t) pow10 << -one.e);
+            return length;
+        }
+        pow10 /= 10;
+    }
+
+    /* fractional part */
+    int m = 0;
+    for (;;) {
+        assert(p2 <= UINT64_MAX / 10);
+        p2 *= 10;
+        const uint64_t d = p2 >> -one.e;
+        p2 &= one.f - 1;
+        assert(d <= 9);
+        digits[length++] = (char) ('0' + d);
+        ++m;
+
+        delta *= 10;
+        dist *= 10;
+        if (p2 <= delta) {
+            break;
+        }
+    }
+    *decimal_exponent -= m;
+    grisu2_round(digits, length, dist, delta, p2, one.f);
+    return length;
+}
+
+static size_t grisu2(char *digits, int *decimal_exponent,
+                     const boundaries_t *b) {
+    assert(b->plus.e == b->minus.e);
+    assert(b->plus.e == b->w.e);
+
+    const cached_power_t cached = get_cached_power(b->plus.e);
+    const diyfp_t c_minus_k = { cached.f, cached.e };
+
+    const diyfp_t w = diyfp_mul(b->w, c_minus_k);
+    const diyfp_t w_minus = diyfp_mul(b->minus, c_minus_k);
+    const diyfp_t w_plus = diyfp_mul(b->plus, c_minus_k);
+
+    /* Shrink the interval by 1 ulp on each side to account for the
+     * imprecision of the cached power and the multiplication. */
+    const diyfp_t m_minus = { w_minus.f + 1, w_minus.e };
+    const diyfp_t m_plus = { w_plus.f - 1, w_plus.e };
+
+    *decimal_exponent = -cached.k;
+    return grisu2_digit_gen(digits, decimal_exponent, m_minus, w, m_plus);
+}
+
+static char *write_exponent(char *out, int exponent) {
+    *out++ = 'e';
+    if (exponent < 0) {
+        *out++ = '-';
+        exponent = -exponent;
+    } else {
+        *out++ = '+';
+    }
+    if (exponent >= 100) {
+        *out++ = (char) ('0' + exponent / 100);
+        exponent %= 100;
+        *out++ = (char) ('0' + exponent / 10);
+    } else if (exponent >= 10) {
+        *out++ = (char) ('0' + exponent / 10);
+    }
+    *out++ = (char) ('0' + exponent % 10);
+    return out;
+}
+
+/**
+ * Lays out @p length digits with the given @p decimal_exponent, using the
+ * rules of ECMAScript's Number.prototype.toString(): plain decimal notation
+ * for values in [1e-6, 1e21) and exponential notation otherwise.
+ */
+static size_t format_digits(char *out, const char *digits, size_t length,
+                            int decimal_exponent) {
+    const int k = (int) length;
+    /* position of the decimal point relative to the first digit */
+    const int n = k + decimal_exponent;
+    char *ptr = out;
+
+    if (k <= n && n <= 21) {
+        memcpy(ptr, digits, length);
+        ptr += length;
+        memset(ptr, '0', (size_t) (n - k));
+        ptr += n - k;
+    } else if (0 < n && n <= 21) {
+        memcpy(ptr, digits, (size_t) n);
+        ptr += n;
+        *ptr++ = '.';
+        memcpy(ptr, digits + n, (size_t) (k - n));
+        ptr += k - n;
+    } else if (-6 < n && n <= 0) {
+        *ptr++ = '0';
+        *ptr++ = '.';
+        memset(ptr, '0', (size_t) -n);
+        ptr += -n;
+        memcpy(ptr, digits, length);
+        ptr += length;
+    } else {
+        *ptr++ = digits[0];
+        if (k > 1) {
+            *ptr++ = '.';
+            memcpy(ptr, digits + 1, length - 1);
+            ptr += length - 1;
+        }
+        ptr = write_exponent(ptr, n - 1);
+    }
+    return (size_t) (ptr - out);
+}
+
+static ssize_t format_special(char *out, size_t size, double value) {
+    const char *str;
+    if (isnan(value)) {
+        str = "nan";
+    } else if (isinf(value)) {
+        str = value < 0 ? "-inf" : "inf";
+    } else {
+        assert(value == 0.0);
+        str = signbit(value) ? "-0" : "0";
+    }
+    const size_t length = strlen(str);
+    if (length >= size) {
+        return -1;
+    }
+    memcpy(out, str, length + 1);
+    return (ssize_t) length;
+}
+
+static ssize_t format_finite(char *out, size_t size, bool negative,
+                             const boundaries_t *b) {
+    /* Grisu2 never generates more than 17 digits */
+    char digits[24];
+    int decimal_exponent;
+    const size_t length = grisu2(digits, &decimal_exponent, b);
+    assert(length <= 17);
+
+    char buf[ANJAY_DOUBLE_STRING_SIZE];
+    char *ptr = buf;
+    if (negative) {
+        *ptr++ = '-';
+    }
+    ptr += format_digits(ptr, digits, length, decimal_exponent);
+    assert(ptr < buf + sizeof(buf));
+
+    const size_t result = (size_t) (ptr - buf);
+    if (result >= size) {
+        return -1;
+    }
+    memcpy(out, buf, result);
+    out[result] = '\0';
+    return (ssize_t) result;
+}
+
+ssize_t _anjay_double_to_string(char *out, size_t size, double value) {
+    if (!isfinite(value) || value == 0.0) {
+        return format_special(out, size, value);
+    }
+    const boundaries_t b = double_boundaries(fabs(value));
+    return format_finite(out, size, value < 0, &b);
+}
+
+ssize_t _anjay_float_to_string(char *out, size_t size, float value) {
+    if (!isfinite(value) || value == 0.0f) {
+        return format_special(out, size, value);
+    }
+    const boundaries_t b = float_boundaries(fabsf(value));
+    return format_finite(out, size, value < 0, &b);
+}
+
+////////////////////////////////////////////////////////////////////// PARSING
+
+/*
+ * The parsers below handle the common case - plain decimal numbers - without
+ * calling into libc. Anything else is delegated to strtoll()/strtod(), which
+ * guarantees that exactly the same set of inputs is accepted, with exactly
+ * the same results.
+ */
+
+static int parse_sign(const char **in) {
+    if (**in == '-') {
+        ++*in;
+        return -1;
+    }
+    if (**in == '+') {
+        ++*in;
+    }
+    return 1;
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static int libc_strtoll(const char *in, long long *value) {
+    char *endptr = NULL;
+    errno = 0;
+    long long tmp = strtoll(in, &endptr, 0);
+    if (errno || !endptr || *endptr) {
+        return -1;
+    }
+    *value = tmp;
+    return 0;
+}
+
+int _anjay_safe_strtoll(const char *in, long long *value) {
+    if (!*in || isspace((unsigned char) *in)) {
+        return -1;
+    }
+    const char *ptr = in;
+    const int sign = parse_sign(&ptr);
+    if (!is_digit(*ptr) || (ptr[0] == '0' && ptr[1])) {
+        /* possibly octal or hexadecimal, as strtoll() is called with base 0 */
+        return libc_strtoll(in, value);
+    }
+
+    const unsigned long long limit = sign < 0
+            ? (unsigned long long) LLONG_MAX + 1
+            : (unsigned long long) LLONG_MAX;
+    unsigned long long result = 0;
+    for (; is_digit(*ptr); ++ptr) {
+        const unsigned digit = (unsigned) (*ptr - '0');
+        if (result > (limit - digit) / 10) {
+            return -1;
+        }
+        result = 10 * result + digit;
+    }
+    if (*ptr) {
+        return -1;
+    }
+    if (sign < 0) {
+        *value = result ? -(long long) (result - 1) - 1 : 0;
+    } else {
+        *value = (long long) result;
+    }
+    return 0;
+}
+
+typedef struct {
+    bool negative;
+    /* up to 19 significant decimal digits */
+    uint64_t mantissa;
+    int exponent;
+} decimal_t;
+
+/**
+ * Parses a plain decimal number: [+-]digits[.digits][(e|E)[+-]digits].
+ *
+ * @returns 0 if the input has been parsed, and its mantissa fits in the
+ *          decimal_t structure, or -1 if the input needs to be handled by
+ *          the libc fallback.
+ */
+static int parse_decimal(const char *in, decimal_t *out) {
+    out->negative = (parse_sign(&in) < 0);
+    out->mantissa = 0;
+    out->exponent = 0;
+
+    int significant_digits = 0;
+    bool has_digits = false;
+    for (; is_digit(*in); ++in) {
+        has_digits = true;
+        if (out->mantissa || *in != '0') {
+            if (++significant_digits > 19) {
+                return -1;
+            }
+            out->mantissa = 10 * out->mantissa + (uint64_t) (*in - '0');
+        }
+    }
+    if (*in == '.') {
+        for (++in; is_digit(*in); ++in) {
+            has_digits = true;
+            if (out->mantissa || *in != '0') {
+                if (++significant_digits > 19) {
+                    return -1;
+                }
+                out->mantissa = 10 * out->mantissa + (uint64_t) (*in - '0');
+            }
+            --out->exponent;
+        }
+    }
+    if (!has_digits) {
+        return -1;
+    }
+    if (*in == 'e' || *in == 'E') {
+        ++in;
+        const int sign = parse_sign(&in);
+        if (!is_digit(*in)) {
+            return -1;
+        }
+        int exponent = 0;
+        for (; is_digit(*in); ++in) {
+            if (exponent > 9999) {
+                return -1;
+            }
+            exponent = 10 * exponent + (*in - '0');
+        }
+        out->exponent += sign * exponent;
+    }
+    return *in ? -1 : 0;
+}
+
+/*
+ * Clinger's fast path: if both the mantissa and the power of ten are exactly
+ * representable, a single IEEE 754 multiplication or division yields the
+ * correctly rounded result - the same one strtod() is required to return.
+ * This only holds if intermediate results are not kept in higher precision.
+ */
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD >= 0 && FLT_EVAL_METHOD <= 1
+#define WITH_DOUBLE_FAST_PATH
+#endif
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+#define WITH_FLOAT_FAST_PATH
+#endif
+
+#ifdef WITH_DOUBLE_FAST_PATH
+static const double EXACT_POWERS_OF_TEN[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+#endif
+
+static int decimal_to_double(const decimal_t *decimal, double *out) {
+#ifdef WITH_DOUBLE_FAST_PATH
+    if (!decimal->mantissa) {
+        *out = decimal->negative ? -0.0 : 0.0;
+        return 0;
+    }
+    if (decimal->mantissa <= (UINT64_C(1) << 53)
+            && decimal->exponent >= -22 && decimal->exponent <= 22) {
+        double value = (double) decimal->mantissa;
+        if (decimal->exponent < 0) {
+            value /= EXACT_POWERS_OF_TEN[-decimal->exponent];
+        } else {
+            value *= EXACT_POWERS_OF_TEN[decimal->exponent];
+        }
+        *out = decimal->negative ? -value : value;
+        return 0;
+    }
+#else
+    (void) decimal; (void) out;
+#endif
+    return -1;
+}
+
+static int decimal_to_float(const decimal_t *decimal, float *out) {
+#ifdef WITH_FLOAT_FAST_PATH
+    static const float EXACT_POWERS_OF_TEN_F[] = {
+        1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+    };
+    if (!decimal->mantissa) {
+        *out = decimal->negative ? -0.0f : 0.0f;
+        return 0;
+    }
+    if (decimal->mantissa <= (UINT64_C(1) << 24)
+            && decimal->exponent >= -10 && decimal->exponent <= 10) {
+        float value = (float) decimal->mantissa;
+        if (decimal->exponent < 0) {
+            value /= EXACT_POWERS_OF_TEN_F[-decimal->exponent];
+        } else {
+            value *= EXACT_POWERS_OF_TEN_F[decimal->exponent];
+        }
+        *out = decimal->negative ? -value : value;
+        return 0;
+    }
+#else
+    (void) decimal; (void) out;
+#endif
+    return -1;
+}
+
+#define DEF_SAFE_STRTO(Name, Type, Libc) \
+int Name(const char *in, Type *value) { \
+    if (!*in || isspace((unsigned char) *in)) { \
+        return -1; \
+    } \
+    decimal_t decimal; \
+    if (!parse_decimal(in, &decimal) \
+            && !decimal_to_##Type(&decimal, value)) { \
+        return 0; \
+    } \
+    char *endptr = NULL; \
+    errno = 0; \
+    Type tmp = Libc(in, &endptr); \
+    /* ERANGE is also reported for subnormal results; those are accepted, \
+     * as they are what _anjay_(float|double)_to_string() emits for them */ \
+    if ((errno && (errno != ERANGE || !isfinite(tmp) || tmp == 0)) \
+            || !endptr || *endptr) { \
+        return -1; \
+    } \
+    *value = tmp; \
+    return 0; \
+}
+
+DEF_SAFE_STRTO(_anjay_safe_strtod, double, strtod)
+DEF_SAFE_STRTO(_anjay_safe_strtof, float, strtof)
+
+#ifdef ANJAY_TEST
+#include "test/numbers.c"
+#endif
@@ -100,6 +100,7 @@ typedef struct {
     const anjay_input_ctx_vtable_t *vtable;
     avs_stream_abstract_t *stream;
     bool autoclose;
+    char view_fallback_buf[ANJAY_INPUT_VIEW_FALLBACK_BUFFER_SIZE];
 } opaque_in_t;
 
 static int opaque_get_some_bytes(anjay_input_ctx_t *ctx,
@@ -114,6 +115,21 @@ static int opaque_get_some_bytes(anjay_input_ctx_t *ctx,
     return retval;
 }
 
+static int opaque_get_some_bytes_view(anjay_input_ctx_t *ctx_,
+                                      size_t *out_bytes_read,
+                                      bool *out_message_finished,
+                                      const void **out_data,
+                                      size_t max_length) {
+    opaque_in_t *ctx = (opaque_in_t *) ctx_;
+    char message_finished;
+    int retval = _anjay_stream_read_view(ctx->stream, out_data,
+                                         out_bytes_read, &message_finished,
+                                         max_length, ctx->view_fallback_buf,
+                                         sizeof(ctx->view_fallback_buf));
+    *out_message_finished = message_finished;
+    return retval;
+}
+
 static int opaque_in_close(anjay_input_ctx_t *ctx_) {
     opaque_in_t *ctx = (opaque_in_t *) ctx_;
     if (ctx->autoclose) {
@@ -124,6 +140,7 @@ static int opaque_in_close(anjay_input_ctx_t *ctx_) {
 
 static const anjay_input_ctx_vtable_t OPAQUE_IN_VTABLE = {
     .some_bytes = opaque_get_some_bytes,
+    .some_bytes_view = opaque_get_some_bytes_view,
     .close = opaque_in_close
 };
 
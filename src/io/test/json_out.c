@@ -0,0 +1,164 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <avsystem/commons/unit/test.h>
+
+#define TEST_ENV(Size, ...) \
+    char buf[Size]; \
+    avs_stream_outbuf_t outbuf = AVS_STREAM_OUTBUF_STATIC_INITIALIZER; \
+    avs_stream_outbuf_set_buffer(&outbuf, buf, sizeof(buf)); \
+    int outctx_errno = 0; \
+    const anjay_uri_path_t uri = { __VA_ARGS__ }; \
+    anjay_output_ctx_t *out = (anjay_output_ctx_t *) json_out_new( \
+            (avs_stream_abstract_t *) &outbuf, &outctx_errno, &uri); \
+    AVS_UNIT_ASSERT_NOT_NULL(out)
+
+#define VERIFY_BYTES(Data) do { \
+    AVS_UNIT_ASSERT_EQUAL(avs_stream_outbuf_offset(&outbuf), sizeof(Data) - 1);\
+    AVS_UNIT_ASSERT_EQUAL_BYTES(buf, Data); \
+} while (0)
+
+AVS_UNIT_TEST(json_out, single_resource) {
+    TEST_ENV(256, .has_oid = true, .oid = 3, .has_iid = true, .iid = 0,
+             .has_rid = true, .rid = 1);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 1));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_string(out, "Hello \"world\""));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("{\"bn\":\"/3/0/1\",\"e\":["
+                 "{\"sv\":\"Hello \\\"world\\\"\"}]}");
+}
+
+AVS_UNIT_TEST(json_out, instance) {
+    TEST_ENV(256, .has_oid = true, .oid = 3, .has_iid = true, .iid = 0);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 1));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(out, 42));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 2));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_bool(out, true));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 3));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_objlnk(out, 4, 5));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("{\"bn\":\"/3/0\",\"e\":["
+                 "{\"n\":\"/1\",\"v\":42},"
+                 "{\"n\":\"/2\",\"bv\":true},"
+                 "{\"n\":\"/3\",\"ov\":\"4:5\"}]}");
+}
+
+AVS_UNIT_TEST(json_out, bytes) {
+    TEST_ENV(256, .has_oid = true, .oid = 3, .has_iid = true, .iid = 0);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 1));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_bytes(out, "foobar", 6));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 2));
+    anjay_ret_bytes_ctx_t *bytes = anjay_ret_bytes_begin(out, 4);
+    AVS_UNIT_ASSERT_NOT_NULL(bytes);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_bytes_append(bytes, "ab", 2));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_bytes_append(bytes, "cd", 2));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("{\"bn\":\"/3/0\",\"e\":["
+                 "{\"n\":\"/1\",\"sv\":\"Zm9vYmFy\"},"
+                 "{\"n\":\"/2\",\"sv\":\"YWJjZA==\"}]}");
+}
+
+AVS_UNIT_TEST(json_out, array) {
+    TEST_ENV(256, .has_oid = true, .oid = 3, .has_iid = true, .iid = 0,
+             .has_rid = true, .rid = 6);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 6));
+    anjay_output_ctx_t *array = anjay_ret_array_start(out);
+    AVS_UNIT_ASSERT_NOT_NULL(array);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_index(array, 0));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(array, 1));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_index(array, 7));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(array, 5));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_finish(array));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("{\"bn\":\"/3/0/6\",\"e\":["
+                 "{\"n\":\"/0\",\"v\":1},"
+                 "{\"n\":\"/7\",\"v\":5}]}");
+}
+
+AVS_UNIT_TEST(json_out, empty) {
+    TEST_ENV(256, .has_oid = true, .oid = 42);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("{\"bn\":\"/42\",\"e\":[]}");
+}
+
+AVS_UNIT_TEST(json_out, object_single_instance_extends_basename) {
+    TEST_ENV(256, .has_oid = true, .oid = 42);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_IID, 69));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 1));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(out, 1));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 2));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(out, 2));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("{\"bn\":\"/42/69\",\"e\":["
+                 "{\"n\":\"/1\",\"v\":1},"
+                 "{\"n\":\"/2\",\"v\":2}]}");
+}
+
+AVS_UNIT_TEST(json_out, object_multiple_instances) {
+    TEST_ENV(256, .has_oid = true, .oid = 42);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_IID, 1));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 3));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(out, 1));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_IID, 2));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 3));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(out, 2));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("{\"bn\":\"/42\",\"e\":["
+                 "{\"n\":\"/1/3\",\"v\":1},"
+                 "{\"n\":\"/2/3\",\"v\":2}]}");
+}
+
+AVS_UNIT_TEST(json_out, object_single_resource_has_no_names) {
+    TEST_ENV(256, .has_oid = true, .oid = 42);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_IID, 7));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 8));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(out, 9));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("{\"bn\":\"/42/7/8\",\"e\":[{\"v\":9}]}");
+}
+
+AVS_UNIT_TEST(json_out, wide_object_size) {
+    enum { NUM_RESOURCES = 100 };
+    TEST_ENV(4096, .has_oid = true, .oid = 10241);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_IID, 65534));
+    for (anjay_rid_t rid = 0; rid < NUM_RESOURCES; ++rid) {
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, rid));
+        AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(out, 0));
+    }
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+
+    /* {"bn":"/10241/65534","e":[ ... ]} */
+    size_t expected_size = sizeof("{\"bn\":\"/10241/65534\",\"e\":[]}") - 1;
+    /* {"n":"/X","v":0}, - basename without the Instance ID would require
+     * additional 6 bytes ("/65534") per element */
+    for (anjay_rid_t rid = 0; rid < NUM_RESOURCES; ++rid) {
+        expected_size += sizeof("{\"n\":\"/\",\"v\":0},") - 1
+                + (rid < 10 ? 1 : 2);
+    }
+    --expected_size; /* no trailing comma */
+    AVS_UNIT_ASSERT_EQUAL(avs_stream_outbuf_offset(&outbuf), expected_size);
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <avsystem/commons/unit/test.h>
+
+#define TEST_DOUBLE(Val, Expected) do { \
+    char buf[ANJAY_DOUBLE_STRING_SIZE]; \
+    AVS_UNIT_ASSERT_EQUAL(_anjay_double_to_string(buf, sizeof(buf), (Val)), \
+                          (ssize_t) strlen(Expected)); \
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, (Expected)); \
+} while (0)
+
+AVS_UNIT_TEST(numbers, double_to_string) {
+    TEST_DOUBLE(0.0, "0");
+    TEST_DOUBLE(-0.0, "-0");
+    TEST_DOUBLE(1.0, "1");
+    TEST_DOUBLE(-1.5, "-1.5");
+    TEST_DOUBLE(0.1, "0.1");
+    TEST_DOUBLE(0.3, "0.3");
+    TEST_DOUBLE(0.1 + 0.2, "0.30000000000000004");
+    TEST_DOUBLE(1.2, "1.2");
+    TEST_DOUBLE(10000000000000.5, "10000000000000.5");
+    TEST_DOUBLE(123456789012345680000.0, "123456789012345680000");
+    TEST_DOUBLE(1e21, "1e+21");
+    TEST_DOUBLE(0.000001, "0.000001");
+    TEST_DOUBLE(0.0000001, "1e-7");
+    TEST_DOUBLE(1.2345e-7, "1.2345e-7");
+    TEST_DOUBLE(3.26e+218, "3.26e+218");
+    TEST_DOUBLE(DBL_MAX, "1.7976931348623157e+308");
+    TEST_DOUBLE(DBL_MIN, "2.2250738585072014e-308");
+    TEST_DOUBLE(5e-324, "5e-324");
+    TEST_DOUBLE(NAN, "nan");
+    TEST_DOUBLE(INFINITY, "inf");
+    TEST_DOUBLE(-INFINITY, "-inf");
+}
+
+#undef TEST_DOUBLE
+
+#define TEST_FLOAT(Val, Expected) do { \
+    char buf[ANJAY_DOUBLE_STRING_SIZE]; \
+    AVS_UNIT_ASSERT_EQUAL(_anjay_float_to_string(buf, sizeof(buf), (Val)), \
+                          (ssize_t) strlen(Expected)); \
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, (Expected)); \
+} while (0)
+
+AVS_UNIT_TEST(numbers, float_to_string) {
+    TEST_FLOAT(0.0f, "0");
+    TEST_FLOAT(1.0f, "1");
+    TEST_FLOAT(0.1f, "0.1");
+    TEST_FLOAT(1.3125f, "1.3125");
+    TEST_FLOAT(-10000.5f, "-10000.5");
+    TEST_FLOAT(16777216.0f, "16777216");
+    TEST_FLOAT(4.223e+37f, "4.223e+37");
+    TEST_FLOAT(FLT_MAX, "3.4028235e+38");
+    TEST_FLOAT(FLT_MIN, "1.1754944e-38");
+    TEST_FLOAT(1e-45f, "1e-45");
+}
+
+#undef TEST_FLOAT
+
+AVS_UNIT_TEST(numbers, buffer_too_short) {
+    char buf[4];
+    AVS_UNIT_ASSERT_EQUAL(_anjay_double_to_string(buf, sizeof(buf), 1.5), 3);
+    AVS_UNIT_ASSERT_FAILED(_anjay_double_to_string(buf, sizeof(buf), 1.25));
+    AVS_UNIT_ASSERT_FAILED(_anjay_double_to_string(buf, sizeof(buf), -INFINITY));
+}
+
+static double random_double(anjay_rand_seed_t *seed) {
+    uint64_t bits;
+    double value;
+    do {
+        bits = ((uint64_t) _anjay_rand32(seed) << 32) | _anjay_rand32(seed);
+        memcpy(&value, &bits, sizeof(value));
+    } while (!isfinite(value));
+    return value;
+}
+
+static float random_float(anjay_rand_seed_t *seed) {
+    uint32_t bits;
+    float value;
+    do {
+        bits = _anjay_rand32(seed);
+        memcpy(&value, &bits, sizeof(value));
+    } while (!isfinite(value));
+    return value;
+}
+
+enum { NUM_RANDOM_VALUES = 100000 };
+
+AVS_UNIT_TEST(numbers, double_round_trip) {
+    anjay_rand_seed_t seed = 42;
+    for (int i = 0; i < NUM_RANDOM_VALUES; ++i) {
+        const double value = random_double(&seed);
+        char buf[ANJAY_DOUBLE_STRING_SIZE];
+        AVS_UNIT_ASSERT_TRUE(_anjay_double_to_string(buf, sizeof(buf),
+                                                     value) > 0);
+        AVS_UNIT_ASSERT_EQUAL(strtod(buf, NULL), value);
+
+        double parsed;
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_safe_strtod(buf, &parsed));
+        AVS_UNIT_ASSERT_EQUAL(memcmp(&parsed, &value, sizeof(value)), 0);
+    }
+}
+
+AVS_UNIT_TEST(numbers, float_round_trip) {
+    anjay_rand_seed_t seed = 42;
+    for (int i = 0; i < NUM_RANDOM_VALUES; ++i) {
+        const float value = random_float(&seed);
+        char buf[ANJAY_DOUBLE_STRING_SIZE];
+        AVS_UNIT_ASSERT_TRUE(_anjay_float_to_string(buf, sizeof(buf),
+                                                    value) > 0);
+        AVS_UNIT_ASSERT_EQUAL(strtof(buf, NULL), value);
+
+        float parsed;
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_safe_strtof(buf, &parsed));
+        AVS_UNIT_ASSERT_EQUAL(memcmp(&parsed, &value, sizeof(value)), 0);
+    }
+}
+
+AVS_UNIT_TEST(numbers, fast_path_matches_libc) {
+    anjay_rand_seed_t seed = 7;
+    for (int i = 0; i < NUM_RANDOM_VALUES; ++i) {
+        char buf[64];
+        /* short decimals with small exponents, i.e. typical sensor values */
+        snprintf(buf, sizeof(buf), "%s%" PRIu32 ".%" PRIu32 "e%d",
+                 (_anjay_rand32(&seed) & 1) ? "-" : "",
+                 _anjay_rand32(&seed) % 100000, _anjay_rand32(&seed) % 10000,
+                 (int) (_anjay_rand32(&seed) % 31) - 15);
+        double d;
+        float f;
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_safe_strtod(buf, &d));
+        AVS_UNIT_ASSERT_EQUAL(d, strtod(buf, NULL));
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_safe_strtof(buf, &f));
+        AVS_UNIT_ASSERT_EQUAL(f, strtof(buf, NULL));
+    }
+}
+
+AVS_UNIT_TEST(numbers, parse) {
+    long long ll;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_safe_strtoll("0", &ll));
+    AVS_UNIT_ASSERT_EQUAL(ll, 0);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_safe_strtoll("-42", &ll));
+    AVS_UNIT_ASSERT_EQUAL(ll, -42);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_safe_strtoll("+42", &ll));
+    AVS_UNIT_ASSERT_EQUAL(ll, 42);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_safe_strtoll("0x10", &ll));
+    AVS_UNIT_ASSERT_EQUAL(ll, 16);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_safe_strtoll("010", &ll));
+    AVS_UNIT_ASSERT_EQUAL(ll, 8);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_safe_strtoll("9223372036854775807", &ll));
+    AVS_UNIT_ASSERT_EQUAL(ll, LLONG_MAX);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_safe_strtoll("-9223372036854775808", &ll));
+    AVS_UNIT_ASSERT_EQUAL(ll, LLONG_MIN);
+    AVS_UNIT_ASSERT_FAILED(_anjay_safe_strtoll("9223372036854775808", &ll));
+    AVS_UNIT_ASSERT_FAILED(_anjay_safe_strtoll("-9223372036854775809", &ll));
+    AVS_UNIT_ASSERT_FAILED(_anjay_safe_strtoll("", &ll));
+    AVS_UNIT_ASSERT_FAILED(_anjay_safe_strtoll(" 1", &ll));
+    AVS_UNIT_ASSERT_FAILED(_anjay_safe_strtoll("1 ", &ll));
+    AVS_UNIT_ASSERT_FAILED(_anjay_safe_strtoll("-", &ll));
+
+    double d;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_safe_strtod("-0", &d));
+    AVS_UNIT_ASSERT_TRUE(d == 0.0 && signbit(d));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_safe_strtod(".5", &d));
+    AVS_UNIT_ASSERT_EQUAL(d, 0.5);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_safe_strtod("5.", &d));
+    AVS_UNIT_ASSERT_EQUAL(d, 5.0);
+    AVS_UNIT_ASSERT_FAILED(_anjay_safe_strtod("1e400", &d));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_safe_strtod("0x1p3", &d));
+    AVS_UNIT_ASSERT_EQUAL(d, 8.0);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_safe_strtod("12345678901234567890123", &d));
+    AVS_UNIT_ASSERT_EQUAL(d, 12345678901234567890123.0);
+    AVS_UNIT_ASSERT_FAILED(_anjay_safe_strtod("", &d));
+    AVS_UNIT_ASSERT_FAILED(_anjay_safe_strtod(".", &d));
+    AVS_UNIT_ASSERT_FAILED(_anjay_safe_strtod("1e", &d));
+    AVS_UNIT_ASSERT_FAILED(_anjay_safe_strtod(" 1", &d));
+    AVS_UNIT_ASSERT_FAILED(_anjay_safe_strtod("wat", &d));
+}
@@ -115,6 +115,7 @@ AVS_UNIT_TEST(text_out, f32) {
     TEST_FLOAT(1.3125);
     TEST_FLOAT(10000.5);
     TEST_FLOAT(4.223e+37);
+    TEST_FLOAT(0.1);
 }
 
 #undef TEST_FLOAT
@@ -132,6 +133,7 @@ AVS_UNIT_TEST(text_out, f64) {
     TEST_DOUBLE(1.2);
     TEST_DOUBLE(10000000000000.5);
     TEST_DOUBLE(3.26e+218);
+    TEST_DOUBLE(0.1);
 }
 
 #undef TEST_DOUBLE
@@ -410,3 +410,144 @@ AVS_UNIT_TEST(tlv_in_types, invalid_read) {
 
     TEST_TEARDOWN;
 }
+
+#undef TEST_TEARDOWN
+#undef TEST_ENV
+
+typedef struct {
+    const avs_stream_v_table_t *vtable;
+    const char *data;
+    size_t size;
+    size_t offset;
+} view_stream_t;
+
+static int view_stream_read_view(avs_stream_abstract_t *stream_,
+                                 const void **out_data,
+                                 size_t *out_bytes_read,
+                                 char *out_message_finished,
+                                 size_t max_length) {
+    view_stream_t *stream = (view_stream_t *) stream_;
+    *out_data = stream->data + stream->offset;
+    *out_bytes_read = ANJAY_MIN(max_length, stream->size - stream->offset);
+    stream->offset += *out_bytes_read;
+    *out_message_finished = (stream->offset == stream->size);
+    return 0;
+}
+
+static int view_stream_read(avs_stream_abstract_t *stream,
+                            size_t *out_bytes_read,
+                            char *out_message_finished,
+                            void *buffer,
+                            size_t buffer_length) {
+    const void *data;
+    view_stream_read_view(stream, &data, out_bytes_read, out_message_finished,
+                          buffer_length);
+    memcpy(buffer, data, *out_bytes_read);
+    return 0;
+}
+
+static const anjay_stream_view_ext_t VIEW_STREAM_VIEW_EXT = {
+    .read_view = view_stream_read_view
+};
+
+static const avs_stream_v_table_extension_t VIEW_STREAM_EXTENSIONS[] = {
+    { ANJAY_STREAM_VIEW_EXTENSION, &VIEW_STREAM_VIEW_EXT },
+    AVS_STREAM_V_TABLE_EXTENSION_NULL
+};
+
+static const avs_stream_v_table_t VIEW_STREAM_VTABLE = {
+    .read = view_stream_read,
+    .extension_list = VIEW_STREAM_EXTENSIONS
+};
+
+#define TEST_ENV(Data) \
+    view_stream_t view_stream = { \
+        .vtable = &VIEW_STREAM_VTABLE, \
+        .data = (Data), \
+        .size = sizeof(Data) - 1 \
+    }; \
+    avs_stream_abstract_t *stream = (avs_stream_abstract_t *) &view_stream; \
+    anjay_input_ctx_t *in; \
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_tlv_create(&in, &stream, false))
+
+AVS_UNIT_TEST(tlv_in_view, zero_copy) {
+    static const char DATA[] = "\xC3\x01" "foo" "\xC3\x02" "bar";
+    TEST_ENV(DATA);
+
+    const void *data;
+    size_t bytes_read;
+    bool message_finished;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_bytes_view(in, &bytes_read,
+                                                 &message_finished, &data));
+    AVS_UNIT_ASSERT_TRUE(data == DATA + 2);
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 3);
+    AVS_UNIT_ASSERT_TRUE(message_finished);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_bytes_view(in, &bytes_read,
+                                                 &message_finished, &data));
+    AVS_UNIT_ASSERT_TRUE(data == DATA + 7);
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 3);
+    AVS_UNIT_ASSERT_TRUE(message_finished);
+
+    _anjay_input_ctx_destroy(&in);
+}
+
+AVS_UNIT_TEST(tlv_in_view, nested_zero_copy) {
+    /* RID 1 array: RIID 5 = "abcd" */
+    static const char DATA[] = "\x86\x01" "\x44\x05" "abcd";
+    TEST_ENV(DATA);
+
+    anjay_input_ctx_t *array = anjay_get_array(in);
+    AVS_UNIT_ASSERT_NOT_NULL(array);
+    anjay_riid_t riid;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_array_index(array, &riid));
+    AVS_UNIT_ASSERT_EQUAL(riid, 5);
+
+    const void *data;
+    size_t bytes_read;
+    bool message_finished;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_bytes_view(array, &bytes_read,
+                                                 &message_finished, &data));
+    AVS_UNIT_ASSERT_TRUE(data == DATA + 4);
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 4);
+    AVS_UNIT_ASSERT_TRUE(message_finished);
+
+    _anjay_input_ctx_destroy(&in);
+}
+
+#undef TEST_ENV
+
+AVS_UNIT_TEST(tlv_in_view, fallback_copy) {
+    char data[2 * ANJAY_INPUT_VIEW_FALLBACK_BUFFER_SIZE];
+    for (size_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (char) i;
+    }
+    avs_stream_abstract_t *stream = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(avs_unit_memstream_alloc(&stream,
+                                                     sizeof(data) + 4));
+    /* RID 1, 16-bit length */
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "\xD0\x01\x02\x00", 4));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, data, sizeof(data)));
+    anjay_input_ctx_t *in;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_tlv_create(&in, &stream, false));
+
+    size_t offset = 0;
+    bool message_finished = false;
+    while (!message_finished) {
+        const void *chunk;
+        size_t bytes_read;
+        AVS_UNIT_ASSERT_SUCCESS(anjay_get_bytes_view(in, &bytes_read,
+                                                     &message_finished,
+                                                     &chunk));
+        AVS_UNIT_ASSERT_TRUE(bytes_read
+                             <= ANJAY_INPUT_VIEW_FALLBACK_BUFFER_SIZE);
+        AVS_UNIT_ASSERT_TRUE(offset + bytes_read <= sizeof(data));
+        AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(chunk, data + offset, bytes_read);
+        offset += bytes_read;
+    }
+    AVS_UNIT_ASSERT_EQUAL(offset, sizeof(data));
+
+    _anjay_input_ctx_destroy(&in);
+    avs_stream_cleanup(&stream);
+}
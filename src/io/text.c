@@ -16,8 +16,6 @@
 
 #include <config.h>
 
-#include <ctype.h>
-#include <errno.h>
 #include <inttypes.h>
 #include <limits.h>
 #include <stdlib.h>
@@ -100,30 +98,34 @@ static int text_ret_i64(anjay_output_ctx_t *ctx_, int64_t value) {
     return retval;
 }
 
-static inline int text_ret_floating_point(text_out_t *ctx, double value,
-                                          int precision) {
+static int text_ret_formatted(text_out_t *ctx, const char *buf,
+                              ssize_t length) {
     if (ctx->bytes) {
         return -1;
     }
     int retval = -1;
     // FIXME: The spec calls for a "decimal" representation, which, in my
-    // understanding, excludes exponential representation.
-    // As printing floating-point numbers in C as pure decimal with sane
-    // precision is tricky, let's take the spec a bit loosely for now.
-    if (!ctx->finished
-            && !(retval = avs_stream_write_f(ctx->stream, "%.*g",
-                                             precision, value))) {
+    // understanding, excludes exponential representation. The shortest
+    // round-trip formatter only uses it for very large and very small
+    // magnitudes, so let's take the spec a bit loosely for those.
+    if (!ctx->finished && length >= 0
+            && !(retval = avs_stream_write(ctx->stream, buf,
+                                           (size_t) length))) {
         ctx->finished = true;
     }
     return retval;
 }
 
 static int text_ret_float(anjay_output_ctx_t *ctx, float value) {
-    return text_ret_floating_point((text_out_t *) ctx, value, 9);
+    char buf[ANJAY_DOUBLE_STRING_SIZE];
+    return text_ret_formatted((text_out_t *) ctx, buf,
+                              _anjay_float_to_string(buf, sizeof(buf), value));
 }
 
 static int text_ret_double(anjay_output_ctx_t *ctx, double value) {
-    return text_ret_floating_point((text_out_t *) ctx, value, 17);
+    char buf[ANJAY_DOUBLE_STRING_SIZE];
+    return text_ret_formatted((text_out_t *) ctx, buf,
+                              _anjay_double_to_string(buf, sizeof(buf), value));
 }
 
 static int text_ret_bool(anjay_output_ctx_t *ctx, bool value) {
@@ -200,6 +202,8 @@ typedef struct {
     uint8_t bytes_cached[3];
     size_t num_bytes_cached;
     char msg_finished;
+    // base64 needs to be decoded, so views are always served from here
+    uint8_t view_buf[ANJAY_INPUT_VIEW_FALLBACK_BUFFER_SIZE];
 } text_in_t;
 
 static int has_valid_padding(const char *buffer,
@@ -272,6 +276,18 @@ static int text_get_some_bytes(anjay_input_ctx_t *ctx_,
     return 0;
 }
 
+static int text_get_some_bytes_view(anjay_input_ctx_t *ctx_,
+                                    size_t *out_bytes_read,
+                                    bool *out_message_finished,
+                                    const void **out_data,
+                                    size_t max_length) {
+    text_in_t *ctx = (text_in_t *) ctx_;
+    *out_data = ctx->view_buf;
+    return text_get_some_bytes(ctx_, out_bytes_read, out_message_finished,
+                               ctx->view_buf,
+                               ANJAY_MIN(max_length, sizeof(ctx->view_buf)));
+}
+
 static int text_get_string(anjay_input_ctx_t *ctx,
                            char *out_buf,
                            size_t buf_size) {
@@ -295,28 +311,14 @@ static int text_get_string(anjay_input_ctx_t *ctx,
     return message_finished ? 0 : ANJAY_BUFFER_TOO_SHORT;
 }
 
-#define DEF_GETNUM(Type, Bufsize, ...) \
-static int safe_strto##Type (const char *in, TYPE##Type *value) { \
-    char *endptr = NULL; \
-    if (!*in || isspace(*in)) { \
-        return -1; \
-    } \
-    errno = 0; \
-    TYPE##Type tmp = strto##Type (in, &endptr __VA_ARGS__); \
-    if (errno || !endptr || *endptr) { \
-        return -1; \
-    } \
-    *value = tmp; \
-    return 0; \
-} \
-\
+#define DEF_GETNUM(Type, Bufsize, Parser) \
 static int text_get_##Type (anjay_input_ctx_t *ctx, TYPE##Type *value) { \
     char buf[Bufsize]; \
     int retval = anjay_get_string(ctx, buf, sizeof(buf)); \
     if (retval) { \
         return retval; \
     } \
-    return safe_strto##Type (buf, value); \
+    return Parser(buf, value); \
 }
 
 #if LLONG_MAX == INT64_MAX
@@ -328,22 +330,18 @@ static int text_get_##Type (anjay_input_ctx_t *ctx, TYPE##Type *value) { \
 #define TYPEf float
 #define TYPEd double
 
-DEF_GETNUM(ll, 32,, 0)
-DEF_GETNUM(f, ANJAY_MAX_FLOAT_STRING_SIZE, )
-DEF_GETNUM(d, ANJAY_MAX_DOUBLE_STRING_SIZE, )
-
-int _anjay_safe_strtoll(const char *in, long long *value) {
-    TYPEll out;
-    if (safe_strtoll(in, &out)) {
+static int safe_strtoll(const char *in, TYPEll *value) {
+    long long out;
+    if (_anjay_safe_strtoll(in, &out)) {
         return -1;
     }
-    *value = (long long)out;
+    *value = (TYPEll) out;
     return 0;
 }
 
-int _anjay_safe_strtod(const char *in, double *value) {
-    return safe_strtod(in, value);
-}
+DEF_GETNUM(ll, 32, safe_strtoll)
+DEF_GETNUM(f, ANJAY_MAX_FLOAT_STRING_SIZE, _anjay_safe_strtof)
+DEF_GETNUM(d, ANJAY_MAX_DOUBLE_STRING_SIZE, _anjay_safe_strtod)
 
 #define DEF_GETI(Bits) \
 static int text_get_i##Bits (anjay_input_ctx_t *ctx, int##Bits##_t *value) { \
@@ -421,6 +419,7 @@ static int text_in_close(anjay_input_ctx_t *ctx_) {
 
 static const anjay_input_ctx_vtable_t TEXT_IN_VTABLE = {
     .some_bytes = text_get_some_bytes,
+    .some_bytes_view = text_get_some_bytes_view,
     .string = text_get_string,
     .i32 = text_get_i32,
     .i64 = text_get_i64,
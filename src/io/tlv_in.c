@@ -30,6 +30,7 @@ typedef struct {
     const avs_stream_v_table_t * vtable;
     avs_stream_abstract_t *backend;
     char finished;
+    char view_fallback_buf[ANJAY_INPUT_VIEW_FALLBACK_BUFFER_SIZE];
 } tlv_single_msg_stream_wrapper_t;
 
 typedef struct {
@@ -43,36 +44,78 @@ typedef struct {
     size_t bytes_read;
 } tlv_in_t;
 
+static int tlv_safe_read_view(tlv_single_msg_stream_wrapper_t *stream,
+                              const void **out_data,
+                              size_t *out_bytes_read,
+                              char *out_message_finished,
+                              size_t max_length);
+
+static int ensure_entry_started(anjay_input_ctx_t *ctx) {
+    if (((tlv_in_t *) ctx)->id < 0) {
+        anjay_id_type_t placeholder_type;
+        uint16_t placeholder_id;
+        return _anjay_input_get_id(ctx, &placeholder_type, &placeholder_id);
+    }
+    return 0;
+}
+
+static int finish_some_bytes(tlv_in_t *ctx,
+                             size_t bytes_read,
+                             char stream_finished,
+                             bool *out_message_finished) {
+    ctx->bytes_read += bytes_read;
+    if (!(*out_message_finished = (ctx->bytes_read == ctx->length))
+            && stream_finished) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    return 0;
+}
+
 static int tlv_get_some_bytes(anjay_input_ctx_t *ctx_,
                               size_t *out_bytes_read,
                               bool *out_message_finished,
                               void *out_buf,
                               size_t buf_size) {
     tlv_in_t *ctx = (tlv_in_t *) ctx_;
-    if (ctx->id < 0) {
-        anjay_id_type_t placeholder_type;
-        uint16_t placeholder_id;
-        int retval =
-                _anjay_input_get_id(ctx_, &placeholder_type, &placeholder_id);
-        if (retval) {
-            return retval;
-        }
+    int retval = ensure_entry_started(ctx_);
+    if (retval) {
+        return retval;
     }
     char stream_finished;
     *out_bytes_read = 0;
     buf_size = ANJAY_MIN(buf_size, ctx->length - ctx->bytes_read);
-    int retval = avs_stream_read((avs_stream_abstract_t *) &ctx->stream,
-                                 out_bytes_read, &stream_finished,
-                                 out_buf, buf_size);
-    ctx->bytes_read += *out_bytes_read;
+    retval = avs_stream_read((avs_stream_abstract_t *) &ctx->stream,
+                             out_bytes_read, &stream_finished,
+                             out_buf, buf_size);
     if (retval) {
+        ctx->bytes_read += *out_bytes_read;
         return retval;
     }
-    if (!(*out_message_finished = (ctx->bytes_read == ctx->length))
-            && stream_finished) {
-        return ANJAY_ERR_BAD_REQUEST;
+    return finish_some_bytes(ctx, *out_bytes_read, stream_finished,
+                             out_message_finished);
+}
+
+static int tlv_get_some_bytes_view(anjay_input_ctx_t *ctx_,
+                                   size_t *out_bytes_read,
+                                   bool *out_message_finished,
+                                   const void **out_data,
+                                   size_t max_length) {
+    tlv_in_t *ctx = (tlv_in_t *) ctx_;
+    int retval = ensure_entry_started(ctx_);
+    if (retval) {
+        return retval;
     }
-    return 0;
+    char stream_finished;
+    *out_bytes_read = 0;
+    max_length = ANJAY_MIN(max_length, ctx->length - ctx->bytes_read);
+    retval = tlv_safe_read_view(&ctx->stream, out_data, out_bytes_read,
+                                &stream_finished, max_length);
+    if (retval) {
+        ctx->bytes_read += *out_bytes_read;
+        return retval;
+    }
+    return finish_some_bytes(ctx, *out_bytes_read, stream_finished,
+                             out_message_finished);
 }
 
 static int tlv_read_to_end(anjay_input_ctx_t *ctx_,
@@ -326,7 +369,8 @@ static const anjay_input_ctx_vtable_t TLV_IN_VTABLE = {
     tlv_in_attach_child,
     tlv_get_id,
     tlv_next_entry,
-    tlv_in_close
+    tlv_in_close,
+    tlv_get_some_bytes_view
 };
 
 static int tlv_safe_read(avs_stream_abstract_t *stream_,
@@ -347,6 +391,24 @@ static int tlv_safe_read(avs_stream_abstract_t *stream_,
     return result;
 }
 
+static int tlv_safe_read_view(tlv_single_msg_stream_wrapper_t *stream,
+                              const void **out_data,
+                              size_t *out_bytes_read,
+                              char *out_message_finished,
+                              size_t max_length) {
+    int result = 0;
+    if (stream->finished) {
+        *out_bytes_read = 0;
+    } else {
+        result = _anjay_stream_read_view(stream->backend, out_data,
+                                         out_bytes_read, &stream->finished,
+                                         max_length, stream->view_fallback_buf,
+                                         sizeof(stream->view_fallback_buf));
+    }
+    *out_message_finished = stream->finished;
+    return result;
+}
+
 static const avs_stream_v_table_t TLV_SINGLE_MSG_STREAM_WRAPPER_VTABLE = {
     .read = tlv_safe_read
 };
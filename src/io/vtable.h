@@ -90,6 +90,9 @@ typedef int (*anjay_input_ctx_get_id_t)(anjay_input_ctx_t *,
                                         anjay_id_type_t *, uint16_t *);
 typedef int (*anjay_input_ctx_next_entry_t)(anjay_input_ctx_t *);
 typedef int (*anjay_input_ctx_close_t)(anjay_input_ctx_t *);
+typedef int (*anjay_input_ctx_bytes_view_t)(anjay_input_ctx_t *,
+                                            size_t *, bool *, const void **,
+                                            size_t);
 
 typedef struct {
     anjay_input_ctx_bytes_t some_bytes;
@@ -104,6 +107,7 @@ typedef struct {
     anjay_input_ctx_get_id_t get_id;
     anjay_input_ctx_next_entry_t next_entry;
     anjay_input_ctx_close_t close;
+    anjay_input_ctx_bytes_view_t some_bytes_view;
 } anjay_input_ctx_vtable_t;
 
 VISIBILITY_PRIVATE_HEADER_END
@@ -114,6 +114,7 @@ int _anjay_notify_perform(anjay_t *anjay,
     if (!queue) {
         return 0;
     }
+    _anjay_register_cache_update(&anjay->register_cache, queue);
     int ret = 0;
     AVS_LIST(anjay_notify_queue_object_entry_t) it;
     AVS_LIST_FOREACH(it, queue) {
@@ -208,6 +209,15 @@ static void delete_notify_queue_object_entry_if_empty(
     AVS_LIST_DELETE(entry_ptr);
 }
 
+static void
+mark_unknown_change_if_not_empty(anjay_notify_queue_object_entry_t *entry) {
+    // the lists of known changes could not be updated, so they are no longer
+    // exhaustive
+    if (entry->instance_set_changes.instance_set_changed) {
+        entry->instance_set_changes.unknown_change = true;
+    }
+}
+
 int _anjay_notify_queue_instance_created(anjay_notify_queue_t *out_queue,
                                          anjay_oid_t oid,
                                          anjay_iid_t iid) {
@@ -220,6 +230,7 @@ int _anjay_notify_queue_instance_created(anjay_notify_queue_t *out_queue,
     if (add_entry_to_iid_set(
             &(*entry_ptr)->instance_set_changes.known_added_iids, iid)) {
         anjay_log(ERROR, "Out of memory");
+        mark_unknown_change_if_not_empty(*entry_ptr);
         delete_notify_queue_object_entry_if_empty(entry_ptr);
         return -1;
     }
@@ -241,6 +252,7 @@ int _anjay_notify_queue_instance_removed(anjay_notify_queue_t *out_queue,
     if (add_entry_to_iid_set(
             &(*entry_ptr)->instance_set_changes.known_removed_iids, iid)) {
         anjay_log(ERROR, "Out of memory");
+        mark_unknown_change_if_not_empty(*entry_ptr);
         delete_notify_queue_object_entry_if_empty(entry_ptr);
         return -1;
     }
@@ -260,6 +272,7 @@ int _anjay_notify_queue_instance_set_unknown_change(
         return -1;
     }
     (*entry_ptr)->instance_set_changes.instance_set_changed = true;
+    (*entry_ptr)->instance_set_changes.unknown_change = true;
     return 0;
 }
 
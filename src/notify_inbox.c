@@ -0,0 +1,279 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <anjay_modules/notify.h>
+
+#include "anjay.h"
+#include "notify_inbox.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#ifdef WITH_NOTIFY_INBOX
+
+static int set_nonblocking_cloexec(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK)) {
+        return -1;
+    }
+    flags = fcntl(fd, F_GETFD);
+    if (flags < 0 || fcntl(fd, F_SETFD, flags | FD_CLOEXEC)) {
+        return -1;
+    }
+    return 0;
+}
+
+int _anjay_notify_inbox_init(anjay_notify_inbox_t *inbox, size_t capacity) {
+    inbox->wakeup_fds[0] = -1;
+    inbox->wakeup_fds[1] = -1;
+    if (!capacity) {
+        return 0;
+    }
+
+    size_t size = 1;
+    while (size < capacity) {
+        if (size > SIZE_MAX / 2) {
+            return -1;
+        }
+        size *= 2;
+    }
+
+    inbox->cells = (anjay_notify_inbox_cell_t *)
+            calloc(size, sizeof(*inbox->cells));
+    if (!inbox->cells) {
+        anjay_log(ERROR, "Out of memory");
+        return -1;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        inbox->cells[i].sequence = i;
+    }
+    inbox->mask = size - 1;
+
+    if (pipe(inbox->wakeup_fds)) {
+        anjay_log(ERROR, "could not create notify inbox wakeup pipe: %s",
+                  strerror(errno));
+        inbox->wakeup_fds[0] = -1;
+        inbox->wakeup_fds[1] = -1;
+        _anjay_notify_inbox_cleanup(inbox);
+        return -1;
+    }
+    if (set_nonblocking_cloexec(inbox->wakeup_fds[0])
+            || set_nonblocking_cloexec(inbox->wakeup_fds[1])) {
+        anjay_log(ERROR, "could not configure notify inbox wakeup pipe");
+        _anjay_notify_inbox_cleanup(inbox);
+        return -1;
+    }
+    return 0;
+}
+
+void _anjay_notify_inbox_cleanup(anjay_notify_inbox_t *inbox) {
+    if (!inbox->cells) {
+        // never initialized, or disabled - wakeup_fds are not valid
+        return;
+    }
+    for (size_t i = 0; i < 2; ++i) {
+        if (inbox->wakeup_fds[i] >= 0) {
+            close(inbox->wakeup_fds[i]);
+            inbox->wakeup_fds[i] = -1;
+        }
+    }
+    free(inbox->cells);
+    inbox->cells = NULL;
+    inbox->mask = 0;
+}
+
+static void wakeup(anjay_notify_inbox_t *inbox) {
+    if (__atomic_exchange_n(&inbox->wakeup_pending, 1, __ATOMIC_ACQ_REL)) {
+        return;
+    }
+    // EAGAIN means that the pipe is full, i.e. already readable
+    ssize_t written;
+    do {
+        written = write(inbox->wakeup_fds[1], "", 1);
+    } while (written < 0 && errno == EINTR);
+}
+
+int _anjay_notify_inbox_push(anjay_notify_inbox_t *inbox,
+                             anjay_oid_t oid,
+                             anjay_iid_t iid,
+                             anjay_rid_t rid) {
+    if (!inbox->cells) {
+        return -1;
+    }
+
+    anjay_notify_inbox_cell_t *cell;
+    size_t pos = __atomic_load_n(&inbox->enqueue_pos, __ATOMIC_RELAXED);
+    for (;;) {
+        cell = &inbox->cells[pos & inbox->mask];
+        size_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&inbox->enqueue_pos, &pos, pos + 1,
+                                            true, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                break;
+            }
+            // pos has been updated by the failed compare-exchange
+        } else if (diff < 0) {
+            // the consumer did not free this cell yet - inbox is full
+            __atomic_add_fetch(&inbox->dropped, 1, __ATOMIC_RELAXED);
+            wakeup(inbox);
+            return -1;
+        } else {
+            // another producer claimed this position in the meantime
+            pos = __atomic_load_n(&inbox->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->oid = oid;
+    cell->iid = iid;
+    cell->rid = rid;
+    __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+
+    wakeup(inbox);
+    return 0;
+}
+
+bool _anjay_notify_inbox_pop(anjay_notify_inbox_t *inbox,
+                             anjay_notify_inbox_cell_t *out_cell) {
+    if (!inbox->cells) {
+        return false;
+    }
+
+    size_t pos = inbox->dequeue_pos;
+    anjay_notify_inbox_cell_t *cell = &inbox->cells[pos & inbox->mask];
+    size_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+    if ((intptr_t) seq - (intptr_t) (pos + 1) < 0) {
+        // empty, or the producer of this cell did not finish writing yet
+        return false;
+    }
+
+    *out_cell = *cell;
+    inbox->dequeue_pos = pos + 1;
+    __atomic_store_n(&cell->sequence, pos + inbox->mask + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static void clear_wakeup(anjay_notify_inbox_t *inbox) {
+    // Exchange rather than a plain store, so that entries pushed by producers
+    // that saw wakeup_pending set are visible to the subsequent pops.
+    // wakeup_pending only spares producers redundant writes; the pipe is
+    // drained unconditionally, as a producer may have set the flag before we
+    // cleared it, but written its byte only afterwards.
+    (void) __atomic_exchange_n(&inbox->wakeup_pending, 0, __ATOMIC_ACQ_REL);
+    char buf[64];
+    ssize_t result;
+    do {
+        result = read(inbox->wakeup_fds[0], buf, sizeof(buf));
+    } while (result > 0 || (result < 0 && errno == EINTR));
+}
+
+int _anjay_notify_inbox_drain(anjay_t *anjay) {
+    anjay_notify_inbox_t *inbox = &anjay->notify_inbox;
+    if (!inbox->cells) {
+        return 0;
+    }
+
+    clear_wakeup(inbox);
+
+    uint32_t dropped = __atomic_exchange_n(&inbox->dropped, 0,
+                                           __ATOMIC_RELAXED);
+    if (dropped) {
+        anjay_log(WARNING, "notify inbox full, %" PRIu32 " changes dropped",
+                  dropped);
+    }
+
+    int result = 0;
+    anjay_notify_inbox_cell_t cell;
+    while (_anjay_notify_inbox_pop(inbox, &cell)) {
+        int partial = (cell.iid == ANJAY_IID_INVALID)
+                ? anjay_notify_instances_changed(anjay, cell.oid)
+                : anjay_notify_changed(anjay, cell.oid, cell.iid, cell.rid);
+        if (!result) {
+            result = partial;
+        }
+    }
+    return result;
+}
+
+#else // WITH_NOTIFY_INBOX
+
+int _anjay_notify_inbox_init(anjay_notify_inbox_t *inbox, size_t capacity) {
+    inbox->wakeup_fds[0] = -1;
+    inbox->wakeup_fds[1] = -1;
+    if (capacity) {
+        anjay_log(ERROR, "notify inbox support not compiled in");
+        return -1;
+    }
+    return 0;
+}
+
+void _anjay_notify_inbox_cleanup(anjay_notify_inbox_t *inbox) {
+    (void) inbox;
+}
+
+int _anjay_notify_inbox_push(anjay_notify_inbox_t *inbox,
+                             anjay_oid_t oid,
+                             anjay_iid_t iid,
+                             anjay_rid_t rid) {
+    (void) inbox; (void) oid; (void) iid; (void) rid;
+    return -1;
+}
+
+bool _anjay_notify_inbox_pop(anjay_notify_inbox_t *inbox,
+                             anjay_notify_inbox_cell_t *out_cell) {
+    (void) inbox; (void) out_cell;
+    return false;
+}
+
+int _anjay_notify_inbox_drain(anjay_t *anjay) {
+    (void) anjay;
+    return 0;
+}
+
+#endif // WITH_NOTIFY_INBOX
+
+int anjay_notify_changed_threadsafe(anjay_t *anjay,
+                                    anjay_oid_t oid,
+                                    anjay_iid_t iid,
+                                    anjay_rid_t rid) {
+    if (iid == ANJAY_IID_INVALID) {
+        return -1;
+    }
+    return _anjay_notify_inbox_push(&anjay->notify_inbox, oid, iid, rid);
+}
+
+int anjay_notify_instances_changed_threadsafe(anjay_t *anjay,
+                                              anjay_oid_t oid) {
+    return _anjay_notify_inbox_push(&anjay->notify_inbox, oid,
+                                    ANJAY_IID_INVALID, 0);
+}
+
+int anjay_get_notify_wakeup_fd(anjay_t *anjay) {
+    return anjay->notify_inbox.wakeup_fds[0];
+}
+
+#ifdef ANJAY_TEST
+#include "test/notify_inbox.c"
+#endif // ANJAY_TEST
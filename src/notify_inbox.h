@@ -0,0 +1,101 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_NOTIFY_INBOX_H
+#define ANJAY_NOTIFY_INBOX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <anjay/anjay.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+#define ANJAY_NOTIFY_INBOX_CACHE_LINE_SIZE 64
+
+typedef struct {
+    /* see _anjay_notify_inbox_push() for the meaning of this counter */
+    size_t sequence;
+    anjay_oid_t oid;
+    /* ANJAY_IID_INVALID if the set of Instances changed */
+    anjay_iid_t iid;
+    anjay_rid_t rid;
+} anjay_notify_inbox_cell_t;
+
+/**
+ * Bounded multi-producer, single-consumer queue of data model changes reported
+ * from threads other than the one running the event loop.
+ *
+ * Each cell carries a sequence number that tells whether it is free for the
+ * producer claiming position N (sequence == N) or holds a value ready for the
+ * consumer reading position N (sequence == N + 1). Producers claim positions
+ * with a compare-and-swap on @ref enqueue_pos, so pushing never blocks; the
+ * consumer is the only one that touches @ref dequeue_pos.
+ *
+ * The first push after the consumer drains the queue writes a single byte to
+ * a non-blocking pipe, so that the event loop can poll() on the read end.
+ */
+typedef struct {
+    anjay_notify_inbox_cell_t *cells;
+    size_t mask;
+    int wakeup_fds[2];
+
+    char pad0_[ANJAY_NOTIFY_INBOX_CACHE_LINE_SIZE];
+    size_t enqueue_pos;
+    int wakeup_pending;
+    uint32_t dropped;
+
+    char pad1_[ANJAY_NOTIFY_INBOX_CACHE_LINE_SIZE];
+    size_t dequeue_pos;
+} anjay_notify_inbox_t;
+
+/**
+ * Allocates an inbox able to hold at least @p capacity entries (rounded up to
+ * a power of two) and creates its wakeup pipe. Passing 0 leaves the inbox
+ * disabled.
+ */
+int _anjay_notify_inbox_init(anjay_notify_inbox_t *inbox, size_t capacity);
+
+void _anjay_notify_inbox_cleanup(anjay_notify_inbox_t *inbox);
+
+/**
+ * Enqueues a change. May be called from any thread.
+ *
+ * @returns 0 on success, -1 if the inbox is disabled or full.
+ */
+int _anjay_notify_inbox_push(anjay_notify_inbox_t *inbox,
+                             anjay_oid_t oid,
+                             anjay_iid_t iid,
+                             anjay_rid_t rid);
+
+/**
+ * Dequeues a single change. Must only be called from the event loop thread.
+ *
+ * @returns true if @p out_cell has been filled, false if the inbox is empty.
+ */
+bool _anjay_notify_inbox_pop(anjay_notify_inbox_t *inbox,
+                             anjay_notify_inbox_cell_t *out_cell);
+
+/**
+ * Moves all changes from the inbox into the regular notification queue and
+ * clears the wakeup descriptor.
+ */
+int _anjay_notify_inbox_drain(anjay_t *anjay);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_NOTIFY_INBOX_H */
@@ -17,12 +17,14 @@
 #include <config.h>
 
 #include <math.h>
+#include <stdlib.h>
 
 #include <avsystem/commons/stream_v_table.h>
 
 #include <anjay_modules/time.h>
 
 #include "anjay.h"
+#include "dm/deferred.h"
 #include "dm/query.h"
 #include "observe.h"
 
@@ -220,15 +222,36 @@ newest_value(const anjay_observe_entry_t *entry) {
     }
 }
 
+/**
+ * Returns the number of seconds by which a notification triggered by a pmin or
+ * pmax period may be moved, to let the scheduler coalesce it with other jobs.
+ */
+static time_t period_slack_s(anjay_t *anjay, time_t period) {
+    if (period <= 0 || !_anjay_sched_slack_enabled(anjay->sched)) {
+        return 0;
+    }
+    return period / ANJAY_SCHED_DEFAULT_SLACK_DIVISOR;
+}
+
+/**
+ * Schedules trigger_observe() @p period seconds after the newest value.
+ *
+ * pmin is a lower bound, so the notification may be sent a bit later than
+ * requested. pmax is an upper bound, so if @p is_max_period is true, the job is
+ * scheduled a bit earlier instead, with the slack window ending exactly at
+ * pmax - see also notify_is_forced().
+ */
 static int schedule_trigger(anjay_t *anjay,
                             anjay_observe_entry_t *entry,
-                            time_t period) {
+                            time_t period,
+                            bool is_max_period) {
     struct timespec realtime_now;
     clock_gettime(CLOCK_REALTIME, &realtime_now);
 
+    time_t slack_s = period_slack_s(anjay, period);
     struct timespec delay;
     _anjay_time_diff(&delay, &newest_value(entry)->timestamp, &realtime_now);
-    delay.tv_sec += period;
+    delay.tv_sec += is_max_period ? period - slack_s : period;
     if (delay.tv_sec < 0) {
         delay.tv_sec = 0;
         delay.tv_nsec = 0;
@@ -236,8 +259,9 @@ static int schedule_trigger(anjay_t *anjay,
 
     if (period >= 0) {
         _anjay_sched_del(anjay->sched, &entry->notify_task);
-        if (_anjay_sched(anjay->sched, &entry->notify_task, delay,
-                         trigger_observe, entry)) {
+        if (_anjay_sched_with_slack(anjay->sched, &entry->notify_task, delay,
+                                    (struct timespec) { slack_s, 0 },
+                                    trigger_observe, entry)) {
             return -1;
         }
     }
@@ -385,7 +409,7 @@ static int insert_initial_value(
                     create_resource_value(details, entry, identity,
                                           numeric, data, size))
             && !(result = schedule_trigger(anjay, entry,
-                                           attrs.common.max_period))) {
+                                           attrs.common.max_period, true))) {
         entry->last_confirmable = realtime_now;
     } else {
         clear_entry(anjay, conn_state, entry);
@@ -552,7 +576,8 @@ void _anjay_observe_gc(anjay_t *anjay) {
     }
 }
 
-static bool notify_is_forced(const anjay_observe_resource_value_t *value,
+static bool notify_is_forced(anjay_t *anjay,
+                             const anjay_observe_resource_value_t *value,
                              const anjay_dm_attributes_t *attrs) {
     if (attrs->max_period >= 0) {
         struct timespec realtime_now;
@@ -560,7 +585,9 @@ static bool notify_is_forced(const anjay_observe_resource_value_t *value,
 
         struct timespec since_update;
         _anjay_time_diff(&since_update, &realtime_now, &value->timestamp);
-        return since_update.tv_sec >= attrs->max_period;
+        // trigger jobs for pmax may be executed early, see schedule_trigger()
+        return since_update.tv_sec
+                >= attrs->max_period - period_slack_s(anjay, attrs->max_period);
     }
     return false;
 }
@@ -611,14 +638,16 @@ static bool should_update(const anjay_observe_resource_value_t *previous,
             || fabs(numeric - previous->numeric) >= attrs->step);
 }
 
-static inline ssize_t read_new_value(anjay_t *anjay,
-                                     const anjay_dm_object_def_t *const *obj,
-                                     const anjay_observe_entry_t *entry,
-                                     anjay_msg_details_t *out_details,
-                                     double *out_numeric,
-                                     char *buffer,
-                                     size_t size) {
-    return _anjay_dm_read_for_observe(
+static ssize_t read_new_value(anjay_t *anjay,
+                              const anjay_dm_object_def_t *const *obj,
+                              const anjay_observe_entry_t *entry,
+                              anjay_msg_details_t *out_details,
+                              double *out_numeric,
+                              char *buffer,
+                              size_t size) {
+    anjay_read_deferral_t deferral;
+    _anjay_read_deferral_begin_notification(anjay, &deferral, &entry->key);
+    ssize_t result = _anjay_dm_read_for_observe(
             anjay, obj,
             &(const anjay_dm_read_args_t) {
                 .ssid = entry->key.connection.ssid,
@@ -630,6 +659,8 @@ static inline ssize_t read_new_value(anjay_t *anjay,
                 .requested_format = entry->key.format,
                 .observe_serial = true
             }, out_details, out_numeric, buffer, size);
+    _anjay_read_deferral_end(anjay, &deferral, result < 0 ? (int) result : 0);
+    return result;
 }
 
 static avs_stream_abstract_t *
@@ -817,7 +848,7 @@ static void schedule_all_triggers(anjay_t *anjay,
             anjay_dm_resource_attributes_t attrs;
             if (get_attrs(anjay, &attrs, &entry->key)
                     || schedule_trigger(anjay, entry,
-                                        attrs.common.max_period)) {
+                                        attrs.common.max_period, true)) {
                 anjay_log(ERROR,
                           "Could not schedule automatic notification trigger");
             }
@@ -842,6 +873,16 @@ static int flush_send_queue(anjay_t *anjay, void *conn_) {
                 break;
             }
         }
+        if (_anjay_connection_is_connecting((anjay_connection_ref_t) {
+                    .server = _anjay_servers_find_active(
+                            &anjay->servers, key.connection.ssid),
+                    .conn_type = key.connection.type
+                })) {
+            // flushed again once the connection is established
+            anjay_log(TRACE, "SSID %u is reconnecting, notifications kept",
+                      key.connection.ssid);
+            break;
+        }
         if ((result = handle_send_queue_entry(anjay, conn,
                                               observe_state)) > 0) {
             _anjay_observe_remove_entry(anjay, &key);
@@ -908,13 +949,16 @@ update_notification_value(anjay_t *anjay,
         return result;
     }
 
-    bool force = notify_is_forced(newest_value(entry), &attrs.common);
+    bool force = notify_is_forced(anjay, newest_value(entry), &attrs.common);
     char buf[ANJAY_MAX_OBSERVABLE_RESOURCE_SIZE];
     anjay_msg_details_t observe_details;
     double numeric = NAN;
     ssize_t size = read_new_value(anjay, obj, entry, &observe_details, &numeric,
                                   buf, sizeof(buf));
-    if (size < 0) {
+    if (size == ANJAY_DM_READ_DEFERRED) {
+        // _anjay_observe_resume() will trigger the notification again
+        return 0;
+    } else if (size < 0) {
         return (int) size;
     }
     observe_details.msg_type = ANJAY_COAP_MSG_NON_CONFIRMABLE;
@@ -926,7 +970,7 @@ update_notification_value(anjay_t *anjay,
                                   buf, (size_t) size);
     }
 
-    if (schedule_trigger(anjay, entry, attrs.common.max_period)) {
+    if (schedule_trigger(anjay, entry, attrs.common.max_period, true)) {
         anjay_log(ERROR, "Could not schedule automatic notification trigger");
     }
 
@@ -959,6 +1003,33 @@ static int trigger_observe(anjay_t *anjay, void *entry_) {
     return result;
 }
 
+void _anjay_observe_resume(anjay_t *anjay,
+                           const anjay_observe_key_t *key,
+                           int result) {
+    AVS_RBTREE_ELEM(anjay_observe_connection_entry_t) conn =
+            AVS_RBTREE_FIND(anjay->observe.connection_entries,
+                            connection_query(&key->connection));
+    AVS_RBTREE_ELEM(anjay_observe_entry_t) entry = NULL;
+    if (conn) {
+        entry = AVS_RBTREE_FIND(conn->entries, entry_query(key));
+    }
+    if (!entry) {
+        // observation cancelled in the meantime
+        return;
+    }
+
+    if (!result) {
+        if (schedule_trigger(anjay, entry, 0, false)) {
+            anjay_log(ERROR, "Could not schedule notification trigger");
+        }
+    } else if (insert_error(anjay, conn, entry, &newest_value(entry)->identity,
+                            result)) {
+        anjay_log(ERROR, "Could not store notification error");
+    } else if (server_state(anjay, key->connection.ssid).server_active) {
+        sched_flush_send_queue(anjay, conn);
+    }
+}
+
 static inline int notify_entry(anjay_t *anjay,
                                const anjay_dm_object_def_t *const *obj,
                                anjay_observe_entry_t *entry) {
@@ -968,7 +1039,7 @@ static inline int notify_entry(anjay_t *anjay,
             && attrs.common.min_period > 0) {
         period = attrs.common.min_period;
     }
-    return schedule_trigger(anjay, entry, period);
+    return schedule_trigger(anjay, entry, period, false);
 }
 
 #ifdef ANJAY_TEST
@@ -1170,6 +1241,180 @@ int _anjay_observe_notify(anjay_t *anjay,
     return result;
 }
 
+static int export_entry(const anjay_observe_entry_t *entry,
+                        AVS_LIST(anjay_observation_state_t) *out_state_ptr) {
+    const anjay_observe_resource_value_t *value = entry->last_sent;
+    assert(value);
+    AVS_LIST(anjay_observation_state_t) state =
+            AVS_LIST_NEW_ELEMENT(anjay_observation_state_t);
+    if (!state || (value->value_length
+                   && !(state->last_value = malloc(value->value_length)))) {
+        anjay_log(ERROR, "Out of memory");
+        AVS_LIST_CLEAR(&state);
+        return -1;
+    }
+    state->ssid = entry->key.connection.ssid;
+    state->conn_type = (uint8_t) entry->key.connection.type;
+    state->oid = entry->key.oid;
+    state->iid = entry->key.iid;
+    state->rid = entry->key.rid;
+    state->format = entry->key.format;
+
+    AVS_STATIC_ASSERT(sizeof(state->token) == ANJAY_COAP_MAX_TOKEN_LENGTH,
+                      token_size);
+    state->token_size = (uint8_t) value->identity.token_size;
+    memcpy(state->token, value->identity.token.bytes,
+           value->identity.token_size);
+
+    state->last_msg_id = value->identity.msg_id;
+    state->last_msg_code = value->details.msg_code;
+    state->last_format = value->details.format;
+    state->last_timestamp = value->timestamp;
+    state->last_confirmable = entry->last_confirmable;
+    state->last_numeric = value->numeric;
+    state->last_value_size = value->value_length;
+    if (value->value_length) {
+        memcpy(state->last_value, value->value, value->value_length);
+    }
+    AVS_LIST_INSERT(out_state_ptr, state);
+    return 0;
+}
+
+int _anjay_observe_export(anjay_t *anjay,
+                          anjay_observe_serial_state_t *out_serial,
+                          AVS_LIST(anjay_observation_state_t) *out_states) {
+    assert(!*out_states);
+    if (_anjay_coap_stream_get_observe_serial(anjay->comm_stream,
+                                              &out_serial->serial)) {
+        return -1;
+    }
+    clock_gettime(CLOCK_REALTIME, &out_serial->timestamp);
+    AVS_LIST(anjay_observation_state_t) *tail = out_states;
+    AVS_RBTREE_ELEM(anjay_observe_connection_entry_t) conn;
+    AVS_RBTREE_FOREACH(conn, anjay->observe.connection_entries) {
+        AVS_RBTREE_ELEM(anjay_observe_entry_t) entry;
+        AVS_RBTREE_FOREACH(entry, conn->entries) {
+            if (export_entry(entry, tail)) {
+                _anjay_observation_state_list_clear(out_states);
+                return -1;
+            }
+            tail = AVS_LIST_NEXT_PTR(tail);
+        }
+    }
+    return 0;
+}
+
+static int import_observation(anjay_t *anjay,
+                              const anjay_observation_state_t *state) {
+    if (state->conn_type >= ANJAY_CONNECTION_WILDCARD
+            || state->rid < -1 || state->rid > UINT16_MAX
+            || state->token_size > ANJAY_COAP_MAX_TOKEN_LENGTH
+            || (state->last_value_size && !state->last_value)) {
+        anjay_log(ERROR, "invalid observation state");
+        return -1;
+    }
+    const anjay_observe_key_t key = {
+        .connection = {
+            .ssid = state->ssid,
+            .type = (anjay_connection_type_t) state->conn_type
+        },
+        .oid = state->oid,
+        .iid = state->iid,
+        .rid = state->rid,
+        .format = state->format
+    };
+    AVS_RBTREE_ELEM(anjay_observe_connection_entry_t) conn =
+            find_or_create_connection_state(anjay, &key.connection);
+    if (!conn) {
+        return -1;
+    }
+    AVS_RBTREE_ELEM(anjay_observe_entry_t) entry =
+            find_or_create_observe_entry(conn, &key);
+    if (!entry) {
+        delete_connection_if_empty(anjay, &conn);
+        return -1;
+    }
+    clear_entry(anjay, conn, entry);
+
+    const anjay_msg_details_t details = {
+        .msg_type = ANJAY_COAP_MSG_NON_CONFIRMABLE,
+        .msg_code = state->last_msg_code,
+        .format = state->last_format,
+        .observe_serial = true
+    };
+    anjay_coap_msg_identity_t identity = {
+        .msg_id = state->last_msg_id,
+        .token_size = state->token_size
+    };
+    memcpy(identity.token.bytes, state->token, state->token_size);
+
+    if (!(entry->last_sent = create_resource_value(
+                    &details, entry, &identity, state->last_numeric,
+                    state->last_value, state->last_value_size))) {
+        delete_entry(anjay, &conn, &entry);
+        return -1;
+    }
+    entry->last_sent->timestamp = state->last_timestamp;
+    entry->last_confirmable = state->last_confirmable;
+
+    // the value might have changed while the client was not running
+    if (notify_entry(anjay, _anjay_dm_find_object_by_oid(anjay, key.oid),
+                     entry)) {
+        anjay_log(ERROR, "Could not schedule notification trigger");
+        delete_entry(anjay, &conn, &entry);
+        return -1;
+    }
+    return 0;
+}
+
+static void delete_all_connections(anjay_t *anjay) {
+    AVS_RBTREE_ELEM(anjay_observe_connection_entry_t) conn;
+    while ((conn = AVS_RBTREE_FIRST(anjay->observe.connection_entries))) {
+        delete_connection(anjay, &conn);
+    }
+}
+
+static int import_serial(anjay_t *anjay,
+                         const anjay_observe_serial_state_t *serial) {
+    struct timespec realtime_now;
+    clock_gettime(CLOCK_REALTIME, &realtime_now);
+    struct timespec elapsed;
+    _anjay_time_diff(&elapsed, &realtime_now, &serial->timestamp);
+    // same scale as the Observe option values; the system clock might have
+    // been stepped back, in which case the exported position is used as-is
+    uint32_t elapsed_ticks = 0;
+    if (elapsed.tv_sec >= 0) {
+        elapsed_ticks = ((uint32_t) elapsed.tv_sec << 15)
+                | (uint32_t) (elapsed.tv_nsec >> 15);
+    }
+    return _anjay_coap_stream_set_observe_serial(
+            anjay->comm_stream, serial->serial + elapsed_ticks);
+}
+
+int _anjay_observe_import(anjay_t *anjay,
+                          const anjay_observe_serial_state_t *serial,
+                          AVS_LIST(anjay_observation_state_t) states) {
+    delete_all_connections(anjay);
+    if (serial && import_serial(anjay, serial)) {
+        return -1;
+    }
+    AVS_LIST(anjay_observation_state_t) state;
+    AVS_LIST_FOREACH(state, states) {
+        if (import_observation(anjay, state)) {
+            delete_all_connections(anjay);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void _anjay_observation_state_list_clear(
+        AVS_LIST(anjay_observation_state_t) *states) {
+    AVS_LIST_CLEAR(states) {
+        free((*states)->last_value);
+    }
+}
+
 #ifdef ANJAY_TEST
 #include "test/observe.c"
 #endif // ANJAY_TEST
@@ -94,6 +94,15 @@ void _anjay_observe_remove_entry(anjay_t *anjay,
 void _anjay_observe_remove_by_msg_id(anjay_t *anjay,
                                      uint16_t notify_id);
 
+/**
+ * Continues checking for a notification for the observation identified by
+ * @p key after reading its value has been deferred. If @p result is nonzero,
+ * the error is reported to the observer instead.
+ */
+void _anjay_observe_resume(anjay_t *anjay,
+                           const anjay_observe_key_t *key,
+                           int result);
+
 int _anjay_observe_sched_flush(anjay_t *anjay,
                                anjay_ssid_t ssid,
                                anjay_connection_type_t conn_type);
@@ -67,6 +67,39 @@ static void update_backoff(anjay_sched_retryable_backoff_t *cfg) {
     }
 }
 
+static void randomize_backoff(anjay_sched_t *sched,
+                              anjay_sched_retryable_entry_t *entry) {
+    anjay_sched_retryable_backoff_t *cfg = &entry->backoff;
+    const ssize_t min_ms =
+            _anjay_time_diff_ms(&entry->initial_delay, &ANJAY_TIME_ZERO);
+    ssize_t max_ms = 3 * _anjay_time_diff_ms(&cfg->delay, &ANJAY_TIME_ZERO);
+    max_ms = AVS_MIN(max_ms,
+                     _anjay_time_diff_ms(&cfg->max_delay, &ANJAY_TIME_ZERO));
+
+    ssize_t delay_ms = min_ms;
+    if (max_ms > min_ms) {
+        delay_ms += (ssize_t) (_anjay_rand32(&sched->rand_seed)
+                               % (uint32_t) (max_ms - min_ms + 1));
+    }
+    _anjay_time_from_ms(&cfg->delay, (int32_t) delay_ms);
+}
+
+/**
+ * Returns the delay before retrying a job that has just failed, and advances
+ * the backoff for the following attempts.
+ */
+static struct timespec next_retry_delay(anjay_sched_t *sched,
+                                        anjay_sched_entry_t *entry) {
+    anjay_sched_retryable_entry_t *retryable = get_retryable_entry(entry);
+    if (sched->backoff_randomized) {
+        randomize_backoff(sched, retryable);
+        return retryable->backoff.delay;
+    }
+    struct timespec delay = retryable->backoff.delay;
+    update_backoff(&retryable->backoff);
+    return delay;
+}
+
 static anjay_sched_handle_t
 sched_delayed(anjay_sched_t *sched,
               struct timespec delay,
@@ -100,7 +133,8 @@ static void execute_task(anjay_sched_t *sched,
                     &get_retryable_entry(entry)->backoff;
 
             if (clb_result == 0
-                    || !sched_delayed(sched, backoff->delay, entry)) {
+                    || !sched_delayed(sched, next_retry_delay(sched, entry),
+                                      entry)) {
                 sched_log(TRACE, "retryable job %p cancel (result = %d)",
                           (void*)entry, clb_result);
                 AVS_LIST_DELETE(&entry);
@@ -110,7 +144,6 @@ static void execute_task(anjay_sched_t *sched,
                            && "handle must not be modified if the job fails");
                     *entry->handle_ptr = handle;
                 }
-                update_backoff(backoff);
                 sched_log(TRACE, "retryable job %p backoff = %d.%09u (result = "
                           "%d)", (void*)entry, (int)backoff->delay.tv_sec,
                           (unsigned)backoff->delay.tv_nsec, clb_result);
@@ -137,6 +170,13 @@ ssize_t _anjay_sched_run(anjay_sched_t *sched) {
         }
     }
 
+    if (tasks_executed > 0) {
+        ++sched->stats.wakeups;
+        sched->stats.jobs_executed += (uint32_t) tasks_executed;
+    } else {
+        ++sched->stats.idle_runs;
+    }
+
     struct timespec delay = ANJAY_TIME_ZERO;
     _anjay_sched_time_to_next(sched, &delay);
     sched_log(TRACE, "%lu scheduled tasks remain; next after %ld.%09ld",
@@ -207,12 +247,14 @@ create_entry(anjay_sched_task_type_t type,
     }
 
     entry->when = ANJAY_TIME_ZERO;
+    entry->slack = ANJAY_TIME_ZERO;
     entry->type = type;
     entry->clb = clb;
     entry->clb_data = clb_data;
 
     if (backoff) {
         get_retryable_entry(entry)->backoff = *backoff;
+        get_retryable_entry(entry)->initial_delay = backoff->delay;
     }
 
     return entry;
@@ -250,6 +292,7 @@ static int schedule(anjay_sched_t *sched,
                     anjay_sched_handle_t *out_handle,
                     anjay_sched_retryable_backoff_t *backoff_config,
                     struct timespec delay,
+                    struct timespec slack,
                     anjay_sched_clb_t clb,
                     void *clb_data) {
     assert((!out_handle || *out_handle == NULL)
@@ -263,6 +306,10 @@ static int schedule(anjay_sched_t *sched,
         return -1;
     }
     entry->handle_ptr = out_handle;
+    if (sched && sched->slack_enabled && _anjay_time_is_valid(&slack)
+            && !_anjay_time_before(&slack, &ANJAY_TIME_ZERO)) {
+        entry->slack = slack;
+    }
     anjay_sched_handle_t task = sched_delayed(sched, delay, entry);
     if (!task) {
         AVS_LIST_DELETE(&entry);
@@ -279,7 +326,17 @@ int _anjay_sched(anjay_sched_t *sched,
                  struct timespec delay,
                  anjay_sched_clb_t clb,
                  void *clb_data) {
-    return schedule(sched, out_handle, NULL, delay, clb, clb_data);
+    return schedule(sched, out_handle, NULL, delay, ANJAY_TIME_ZERO,
+                    clb, clb_data);
+}
+
+int _anjay_sched_with_slack(anjay_sched_t *sched,
+                            anjay_sched_handle_t *out_handle,
+                            struct timespec delay,
+                            struct timespec slack,
+                            anjay_sched_clb_t clb,
+                            void *clb_data) {
+    return schedule(sched, out_handle, NULL, delay, slack, clb, clb_data);
 }
 
 int _anjay_sched_retryable(anjay_sched_t *sched,
@@ -288,7 +345,18 @@ int _anjay_sched_retryable(anjay_sched_t *sched,
                            anjay_sched_retryable_backoff_t config,
                            anjay_sched_clb_t clb,
                            void *clb_data) {
-    return schedule(sched, out_handle, &config, delay, clb, clb_data);
+    return schedule(sched, out_handle, &config, delay, ANJAY_TIME_ZERO,
+                    clb, clb_data);
+}
+
+int _anjay_sched_retryable_with_slack(anjay_sched_t *sched,
+                                      anjay_sched_handle_t *out_handle,
+                                      struct timespec delay,
+                                      struct timespec slack,
+                                      anjay_sched_retryable_backoff_t config,
+                                      anjay_sched_clb_t clb,
+                                      void *clb_data) {
+    return schedule(sched, out_handle, &config, delay, slack, clb, clb_data);
 }
 
 int _anjay_sched_del(anjay_sched_t *sched, anjay_sched_handle_t *handle) {
@@ -314,24 +382,66 @@ int _anjay_sched_del(anjay_sched_t *sched, anjay_sched_handle_t *handle) {
     return result;
 }
 
-int _anjay_sched_time_to_next(anjay_sched_t *sched, struct timespec *delay) {
-    struct timespec now;
+/**
+ * Returns the latest moment at which all jobs are still executed within their
+ * slack windows, i.e. the earliest of (when + slack) over all jobs. Jobs are
+ * sorted by their deadlines, so the search can stop at the first job that is
+ * not due before the best candidate found so far.
+ */
+static struct timespec next_wakeup_time(anjay_sched_t *sched) {
+    assert(sched->entries);
+    struct timespec wakeup = sched->entries->when;
+    _anjay_time_add(&wakeup, &sched->entries->slack);
+
     anjay_sched_entry_t *elem;
+    AVS_LIST_FOREACH(elem, AVS_LIST_NEXT(sched->entries)) {
+        if (!_anjay_time_before(&elem->when, &wakeup)) {
+            break;
+        }
+        struct timespec latest = elem->when;
+        _anjay_time_add(&latest, &elem->slack);
+        if (_anjay_time_before(&latest, &wakeup)) {
+            wakeup = latest;
+        }
+    }
+    return wakeup;
+}
 
-    clock_gettime(CLOCK_MONOTONIC, &now);
+int _anjay_sched_time_to_next(anjay_sched_t *sched, struct timespec *delay) {
+    if (!sched->entries) {
+        return -1;
+    }
 
-    AVS_LIST_FOREACH(elem, sched->entries) {
-        if (delay) {
-            _anjay_time_diff(delay, &elem->when, &now);
-            if (delay->tv_sec < 0) {
-                delay->tv_sec = 0;
-                delay->tv_nsec = 0;
-            }
+    if (delay) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        struct timespec wakeup = next_wakeup_time(sched);
+        _anjay_time_diff(delay, &wakeup, &now);
+        if (delay->tv_sec < 0) {
+            delay->tv_sec = 0;
+            delay->tv_nsec = 0;
         }
-        return 0;
     }
+    return 0;
+}
+
+void _anjay_sched_enable_slack(anjay_sched_t *sched) {
+    sched->slack_enabled = true;
+}
+
+bool _anjay_sched_slack_enabled(anjay_sched_t *sched) {
+    return sched->slack_enabled;
+}
+
+void _anjay_sched_randomize_backoff(anjay_sched_t *sched, uint32_t seed) {
+    sched->backoff_randomized = true;
+    sched->rand_seed = (anjay_rand_seed_t) seed;
+}
 
-    return -1;
+void _anjay_sched_get_stats(anjay_sched_t *sched,
+                            anjay_sched_stats_t *out_stats) {
+    *out_stats = sched->stats;
 }
 
 #ifdef ANJAY_TEST
@@ -17,12 +17,15 @@
 #ifndef ANJAY_SCHED_H
 #define	ANJAY_SCHED_H
 
+#include <stdbool.h>
 #include <time.h>
 
 #include <sys/types.h>
 
 #include <anjay/anjay.h>
 
+#include <anjay_modules/time.h>
+
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
 typedef int (*anjay_sched_clb_t)(anjay_t *anjay, void *data);
@@ -34,6 +37,43 @@ anjay_sched_t *_anjay_sched_new(anjay_t *anjay);
 ssize_t _anjay_sched_run(anjay_sched_t *sched);
 void _anjay_sched_delete(anjay_sched_t **sched_ptr);
 
+/**
+ * Makes the scheduler honor the slack passed to @ref _anjay_sched_with_slack
+ * and @ref _anjay_sched_retryable_with_slack. Until this is called, the slack
+ * is ignored and every job wakes the application up at its exact deadline.
+ */
+void _anjay_sched_enable_slack(anjay_sched_t *sched);
+
+bool _anjay_sched_slack_enabled(anjay_sched_t *sched);
+
+/**
+ * Makes failed retryable jobs use "decorrelated jitter" instead of doubling
+ * the delay after each attempt: each delay is drawn uniformly between the
+ * initial delay and three times the previous one, and capped at the maximum
+ * delay. @p seed initializes the random number generator used for that.
+ */
+void _anjay_sched_randomize_backoff(anjay_sched_t *sched, uint32_t seed);
+
+void _anjay_sched_get_stats(anjay_sched_t *sched,
+                            anjay_sched_stats_t *out_stats);
+
+/**
+ * Divisor used by @ref _anjay_sched_default_slack.
+ */
+#define ANJAY_SCHED_DEFAULT_SLACK_DIVISOR 16
+
+/**
+ * Returns the slack suitable for jobs whose exact timing is not important,
+ * proportional to the @p delay they are scheduled with.
+ */
+static inline struct timespec _anjay_sched_default_slack(struct timespec delay) {
+    struct timespec slack = ANJAY_TIME_ZERO;
+    if (delay.tv_sec > 0) {
+        _anjay_time_div(&slack, &delay, ANJAY_SCHED_DEFAULT_SLACK_DIVISOR);
+    }
+    return slack;
+}
+
 /**
  * Schedules oneshot job, that will be removed from the scheduler after
  * it is executed.
@@ -60,6 +100,21 @@ int _anjay_sched(anjay_sched_t *sched,
                  struct timespec delay,
                  anjay_sched_clb_t clb,
                  void *clb_data);
+
+/**
+ * Schedules a oneshot job, just like @ref _anjay_sched, but allows the job to
+ * be executed up to @p slack later than after @p delay.
+ *
+ * The scheduler uses the slack to coalesce wakeups: the application is woken
+ * up at the latest moment that satisfies the windows of all pending jobs, and
+ * executes all jobs whose deadlines have passed at once.
+ */
+int _anjay_sched_with_slack(anjay_sched_t *sched,
+                            anjay_sched_handle_t *out_handle,
+                            struct timespec delay,
+                            struct timespec slack,
+                            anjay_sched_clb_t clb,
+                            void *clb_data);
 /**
  * Removes job handle (pointed by @p handle) from the scheduler, and therefore
  * invalidates it by setting it to NULL.
@@ -97,7 +152,8 @@ typedef struct {
  * canceled using @ref _anjay_sched_del .
  *
  * First execution of the @p clb happens after @p delay . Following attempts use
- * an exponential backoff with a factor of 2, determined by @p backoff .
+ * an exponential backoff with a factor of 2, determined by @p backoff , or
+ * randomized delays if @ref _anjay_sched_randomize_backoff has been called.
  *
  * Note: Similar as to @ref _anjay_sched behavior should be expected, except
  * that job handle invalidation is slightly more complicated:
@@ -124,6 +180,19 @@ int _anjay_sched_retryable(anjay_sched_t *sched,
                            anjay_sched_clb_t clb,
                            void *clb_data);
 
+/**
+ * Schedules a retryable job, just like @ref _anjay_sched_retryable, but allows
+ * each attempt to be executed up to @p slack later than planned. See
+ * @ref _anjay_sched_with_slack for details.
+ */
+int _anjay_sched_retryable_with_slack(anjay_sched_t *sched,
+                                      anjay_sched_handle_t *out_handle,
+                                      struct timespec delay,
+                                      struct timespec slack,
+                                      anjay_sched_retryable_backoff_t backoff,
+                                      anjay_sched_clb_t clb,
+                                      void *clb_data);
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif	/* ANJAY_SCHED_H */
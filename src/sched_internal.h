@@ -33,6 +33,8 @@ typedef struct {
 
     anjay_sched_handle_t *handle_ptr;
     struct timespec when;
+    /* the job may be executed up to this much later than @ref when */
+    struct timespec slack;
     anjay_sched_clb_t clb;
     void *clb_data;
 } anjay_sched_entry_t;
@@ -41,12 +43,18 @@ typedef struct {
     anjay_sched_entry_t entry;
 
     anjay_sched_retryable_backoff_t backoff;
+    /* lower bound of randomized delays */
+    struct timespec initial_delay;
 } anjay_sched_retryable_entry_t;
 
 struct anjay_sched_struct {
     anjay_t *anjay;
     AVS_LIST(anjay_sched_entry_t) entries;
     bool shut_down;
+    bool slack_enabled;
+    bool backoff_randomized;
+    anjay_rand_seed_t rand_seed;
+    anjay_sched_stats_t stats;
 };
 
 VISIBILITY_PRIVATE_HEADER_END
@@ -19,20 +19,21 @@
 
 #include <anjay/anjay.h>
 
+#include <anjay_modules/registration_state.h>
+
+#include "async_connect.h"
+#include "dns_cache.h"
+#include "dtls_session_cache.h"
 #include "utils.h"
 #include "sched.h"
 #include "coap/stream.h"
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
-typedef struct {
-    anjay_oid_t oid;
-    AVS_LIST(anjay_iid_t) instances;
-} anjay_dm_cache_object_t;
-
 typedef struct {
     int64_t lifetime_s;
-    AVS_LIST(anjay_dm_cache_object_t) dm;
+    /* anjay_register_cache_t::version at the time of sending the message */
+    uint32_t dm_version;
     anjay_binding_mode_t binding_mode;
 } anjay_update_parameters_t;
 
@@ -65,6 +66,53 @@ typedef struct {
     avs_net_abstract_socket_t *socket;
     avs_net_resolved_endpoint_t preferred_endpoint;
     char last_local_port[ANJAY_MAX_URL_PORT_SIZE];
+    /* true if the socket carries CoAP over TCP (RFC 8323) */
+    bool tcp;
+    /* true for (D)TLS sockets, which are reconnected in the background */
+    bool secure;
+    /**
+     * Set if the last background connection attempt failed. The socket is then
+     * left suspended, and only reconnected by the retryable Update job, so
+     * that its backoff applies.
+     */
+    bool reconnect_failed;
+    /**
+     * Non-NULL while the socket is being reconnected on a background thread.
+     * The socket must not be accessed in any way until that finishes.
+     */
+    anjay_async_connect_task_t *connect_task;
+    /**
+     * Connection attempt to an address of the other family (IPv4 or IPv6),
+     * raced against the one above if it does not finish quickly enough. The
+     * socket is owned by the attempt until it finishes, and then either
+     * replaces the main socket or is discarded.
+     */
+    anjay_async_connect_task_t *fallback_task;
+    avs_net_abstract_socket_t *fallback_socket;
+    /* NULL for sockets that do not use (D)TLS */
+    anjay_dtls_session_t *dtls_session;
+    /**
+     * Session resumption buffer of the socket, or NULL if it has none. Handed
+     * over to connect_task along with the socket if the attempt is abandoned.
+     */
+    void *dtls_session_buffer;
+    /* NULL if server addresses are not cached for this socket */
+    anjay_dns_cache_entry_t *dns_entry;
+    /**
+     * Hash of the server URI and security configuration the socket has been
+     * created with, used to tell whether a persisted registration still
+     * applies.
+     */
+    uint32_t config_hash;
+    /**
+     * Hash of all the configuration the socket has been created with,
+     * including secret keys, used to skip re-creating the socket if the
+     * Security object has been modified without actually changing it.
+     */
+    uint32_t socket_config_hash;
+    /* reset along with the socket, as the path to the server may change */
+    coap_rtt_estimator_t rtt_estimator;
+    coap_block_size_tuner_t block_size_tuner;
 } anjay_server_connection_private_data_t;
 
 typedef struct {
@@ -103,6 +151,26 @@ typedef struct {
      * <c>_anjay_connection_internal_ensure_online()</c>.
      */
     anjay_sched_handle_t queue_mode_close_socket_clb_handle;
+
+    /**
+     * Starts the fallback connection attempt if the background reconnection
+     * does not finish within ANJAY_CONNECTION_ATTEMPT_DELAY_MS.
+     */
+    anjay_sched_handle_t connect_fallback_clb_handle;
+
+    /**
+     * Incremented whenever the socket is cleaned up, suspended or reconnected.
+     * Allows keeping track of the system-level descriptor without querying it
+     * - a closed descriptor number may be reused by the reconnected socket.
+     */
+    uint32_t socket_generation;
+
+    /**
+     * Set if an Update could not be sent because the socket was being
+     * reconnected. The Update is then scheduled as soon as the connection is
+     * re-established.
+     */
+    bool update_after_connect;
 } anjay_server_connection_t;
 
 typedef struct {
@@ -114,12 +182,31 @@ typedef struct {
     anjay_sched_handle_t sched_update_handle;
 } anjay_active_server_info_t;
 
+/**
+ * Register exchange that does not block while waiting for the response, see
+ * interface/register.h.
+ */
+typedef struct anjay_register_async anjay_register_async_t;
+
 // inactive servers include administratively disabled ones
 // as well as those which were unreachable at connect attempt
 typedef struct {
     anjay_ssid_t ssid;
     anjay_sched_handle_t sched_reactivate_handle;
     bool needs_activation;
+
+    /**
+     * Server being activated. Set from the moment its connection is initiated
+     * until the Register exchange finishes, so that neither the (D)TLS
+     * handshake nor waiting for the response blocks the event loop: the socket
+     * is served through @ref anjay_get_sockets and @ref anjay_serve in the
+     * meantime. Moved to the active server list if the activation succeeds.
+     */
+    AVS_LIST(anjay_active_server_info_t) activating;
+    /* Register sent to @ref activating; NULL while still connecting */
+    anjay_register_async_t *register_async;
+    /* retransmits the Register, or gives up on it, at its deadline */
+    anjay_sched_handle_t register_timeout_handle;
 } anjay_inactive_server_info_t;
 
 typedef struct {
@@ -128,6 +215,12 @@ typedef struct {
     anjay_sched_handle_t reload_sockets_sched_job_handle;
 
     AVS_LIST(avs_net_abstract_socket_t *const) public_sockets;
+
+    /* restored from persistent storage, consumed when servers are activated */
+    AVS_LIST(anjay_registration_state_t) restored_registrations;
+
+    /* carried over to the new struct on each reload */
+    anjay_socket_reload_stats_t reload_stats;
 } anjay_servers_t;
 
 typedef enum {
@@ -143,7 +236,9 @@ typedef struct {
 
 static inline anjay_servers_t
 _anjay_servers_create(void) {
-    return (anjay_servers_t){ NULL, NULL, NULL, NULL };
+    return (anjay_servers_t){
+        NULL, NULL, NULL, NULL, NULL, { 0, 0, 0, 0, 0 }
+    };
 }
 
 /**
@@ -160,6 +255,15 @@ anjay_active_server_info_t *
 _anjay_servers_find_by_udp_socket(anjay_servers_t *servers,
                                   avs_net_abstract_socket_t *socket);
 
+/**
+ * Handles a message received on @p ready_socket if it belongs to a server
+ * that is waiting for the response to its Register.
+ *
+ * @returns true if @p ready_socket belongs to such a server, false otherwise.
+ */
+bool _anjay_servers_serve_activating(anjay_t *anjay,
+                                     avs_net_abstract_socket_t *ready_socket);
+
 /**
  * Returns an active server object for given SSID.
  *
@@ -169,6 +273,21 @@ _anjay_servers_find_by_udp_socket(anjay_servers_t *servers,
 anjay_active_server_info_t *_anjay_servers_find_active(anjay_servers_t *servers,
                                                        anjay_ssid_t ssid);
 
+typedef int anjay_servers_socket_visitor_t(anjay_t *anjay,
+                                           void *arg,
+                                           avs_net_abstract_socket_t *socket,
+                                           uint32_t socket_generation);
+
+/**
+ * Calls @p visitor for each socket that would be returned by
+ * @ref anjay_get_sockets, without building the list. These include the sockets
+ * of servers being activated that wait for the response to their Register.
+ * Stops at the first non-zero value returned by @p visitor and returns it.
+ */
+int _anjay_servers_foreach_online_socket(anjay_t *anjay,
+                                         anjay_servers_socket_visitor_t *visitor,
+                                         void *arg);
+
 int _anjay_schedule_reload_sockets(anjay_t *anjay);
 
 int _anjay_schedule_socket_update(anjay_t *anjay,
@@ -191,13 +310,46 @@ _anjay_server_cached_binding_mode(anjay_active_server_info_t *server);
 anjay_server_connection_mode_t
 _anjay_connection_current_mode(anjay_connection_ref_t ref);
 
+/**
+ * Returns true if the socket of the connection referenced by @p ref is being
+ * reconnected in the background. Messages to be sent through it shall be kept
+ * queued until that finishes.
+ */
+bool _anjay_connection_is_connecting(anjay_connection_ref_t ref);
+
 avs_net_abstract_socket_t *
 _anjay_connection_get_prepared_socket(anjay_t *anjay,
                                       anjay_active_server_info_t *server,
                                       anjay_server_connection_t *connection);
 
+/**
+ * Returns the RTT estimator used for retransmission timeouts on
+ * @p connection, or NULL if the underlying transport is reliable and thus
+ * does not retransmit on the CoAP level.
+ */
+coap_rtt_estimator_t *
+_anjay_connection_rtt_estimator(anjay_server_connection_t *connection);
+
+/**
+ * Returns the block size tuner for @p connection, or NULL if the underlying
+ * transport is reliable, in which case block sizes are not adjusted.
+ */
+coap_block_size_tuner_t *
+_anjay_connection_block_size_tuner(anjay_server_connection_t *connection);
+
 void _anjay_connection_suspend(anjay_connection_ref_t conn_ref);
 
+/**
+ * Shall be called after an exchange initiated by the client over the
+ * connection referenced by @p conn_ref finishes. If @p responded is false, the
+ * server has not responded at all, which makes the next reconnect try another
+ * of its resolved addresses. Otherwise, the family of the current one becomes
+ * the preferred one.
+ */
+void _anjay_connection_exchange_finished(anjay_t *anjay,
+                                         anjay_connection_ref_t conn_ref,
+                                         bool responded);
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif // ANJAY_SERVERS_H
@@ -18,7 +18,11 @@
 
 #include <inttypes.h>
 
+#include <anjay_modules/time.h>
+
 #include "../dm/query.h"
+#include "../sched.h"
+#include "../interface/register.h"
 
 #define ANJAY_SERVERS_INTERNALS
 
@@ -36,54 +40,229 @@ static void active_server_detach_delete(
     AVS_LIST_DELETE(server_ptr);
 }
 
-static int
-initialize_active_server(anjay_t *anjay,
-                         anjay_ssid_t ssid,
-                         anjay_active_server_info_t *server) {
-    server->ssid = ssid;
+static void register_async_update(
+        anjay_t *anjay,
+        AVS_LIST(anjay_inactive_server_info_t) *inactive_server_ptr);
 
-    if (_anjay_server_refresh(anjay, server, true)) {
-        anjay_log(TRACE, "could not initialize sockets for SSID %u",
-                  server->ssid);
-        return -1;
+static int register_timeout_job(anjay_t *anjay, void *ssid_) {
+    AVS_LIST(anjay_inactive_server_info_t) *inactive_server_ptr =
+            _anjay_servers_find_inactive_ptr(&anjay->servers,
+                                             (anjay_ssid_t) (uintptr_t) ssid_);
+    if (inactive_server_ptr && (*inactive_server_ptr)->register_async) {
+        _anjay_coap_async_request_handle_timeout(
+                _anjay_register_async_request(
+                        (*inactive_server_ptr)->register_async));
+        register_async_update(anjay, inactive_server_ptr);
+    }
+    return 0;
+}
+
+static int sched_register_timeout(anjay_t *anjay,
+                                  anjay_inactive_server_info_t *server) {
+    struct timespec deadline = _anjay_coap_async_request_deadline(
+            _anjay_register_async_request(server->register_async));
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    struct timespec delay = ANJAY_TIME_ZERO;
+    if (_anjay_time_before(&now, &deadline)) {
+        _anjay_time_diff(&delay, &deadline, &now);
+    }
+    _anjay_sched_del(anjay->sched, &server->register_timeout_handle);
+    return _anjay_sched(anjay->sched, &server->register_timeout_handle, delay,
+                        register_timeout_job,
+                        (void *) (uintptr_t) server->ssid);
+}
+
+void _anjay_server_activation_cancel(anjay_t *anjay,
+                                     anjay_inactive_server_info_t *server) {
+    _anjay_sched_del(anjay->sched, &server->register_timeout_handle);
+    _anjay_register_async_cleanup(&server->register_async);
+    if (server->activating) {
+        _anjay_server_cleanup(anjay, server->activating);
+        AVS_LIST_DELETE(&server->activating);
+    }
+}
+
+/**
+ * Moves the server being activated to the active server list. The inactive
+ * server entry is deleted.
+ */
+static void commit_activation(
+        anjay_t *anjay,
+        AVS_LIST(anjay_inactive_server_info_t) *inactive_server_ptr) {
+    AVS_LIST(anjay_active_server_info_t) server =
+            (*inactive_server_ptr)->activating;
+    (*inactive_server_ptr)->activating = NULL;
+    _anjay_server_activation_cancel(anjay, *inactive_server_ptr);
+
+    /**
+     * If called from the reactivate job itself, its handle is already cleared
+     * and the job returns 0, so the scheduler will not restore it.
+     */
+    _anjay_sched_del(anjay->sched,
+                     &(*inactive_server_ptr)->sched_reactivate_handle);
+    AVS_LIST_DELETE(inactive_server_ptr);
+    _anjay_servers_add_active(&anjay->servers, server);
+}
+
+/**
+ * Abandons the activation. The reactivate job is left intact, so that it
+ * retries with its backoff.
+ */
+static void fail_activation(anjay_t *anjay,
+                            anjay_inactive_server_info_t *server) {
+    anjay_log(ERROR, "could not activate server SSID %u", server->ssid);
+    _anjay_server_activation_cancel(anjay, server);
+}
+
+#define ACTIVATION_IN_PROGRESS 1
+
+/**
+ * Registers to the server being activated.
+ *
+ * @returns 0 if the server has been registered to, ACTIVATION_IN_PROGRESS if
+ *          a Register has been sent and is being waited for, or a negative
+ *          value in case of error.
+ */
+static int start_register(anjay_t *anjay,
+                          anjay_inactive_server_info_t *inactive_server) {
+    anjay_active_server_info_t *server = inactive_server->activating;
+    int result = _anjay_server_register_async_start(
+            anjay, server, &inactive_server->register_async);
+    if (!result) {
+        if (!sched_register_timeout(anjay, inactive_server)) {
+            return ACTIVATION_IN_PROGRESS;
+        }
+        anjay_log(ERROR, "could not schedule Register retransmission");
+        result = -1;
+    } else if (result > 0) {
+        result = _anjay_server_register(anjay, server);
+    }
+    return result;
+}
+
+static void register_async_update(
+        anjay_t *anjay,
+        AVS_LIST(anjay_inactive_server_info_t) *inactive_server_ptr) {
+    anjay_inactive_server_info_t *server = *inactive_server_ptr;
+    if (_anjay_coap_async_request_state(
+                _anjay_register_async_request(server->register_async))
+            == ANJAY_COAP_ASYNC_REQUEST_WAITING) {
+        if (sched_register_timeout(anjay, server)) {
+            anjay_log(ERROR, "could not schedule Register retransmission");
+            fail_activation(anjay, server);
+        }
+        return;
+    }
+
+    int result = _anjay_server_register_async_finish(anjay, server->activating,
+                                                     &server->register_async);
+    if (result > 0) {
+        // the resumed registration has been rejected
+        result = start_register(anjay, server);
+        if (result == ACTIVATION_IN_PROGRESS) {
+            return;
+        }
     }
 
-    if (server->ssid != ANJAY_SSID_BOOTSTRAP) {
-        if (_anjay_server_register(anjay, server)) {
-            anjay_log(ERROR, "could not register to server SSID %u",
-                      server->ssid);
-            return -1;
+    if (result) {
+        fail_activation(anjay, server);
+    } else {
+        commit_activation(anjay, inactive_server_ptr);
+    }
+}
+
+/**
+ * Continues the activation once the connection to the server is established.
+ *
+ * @returns 0 if the server has been activated, ACTIVATION_IN_PROGRESS if
+ *          a Register or an Update resuming the registration has been sent and
+ *          is being waited for, or a negative value if the activation failed.
+ */
+static int continue_activation(
+        anjay_t *anjay,
+        AVS_LIST(anjay_inactive_server_info_t) *inactive_server_ptr) {
+    anjay_inactive_server_info_t *inactive_server = *inactive_server_ptr;
+    anjay_active_server_info_t *server = inactive_server->activating;
+
+    int result;
+    if (server->ssid == ANJAY_SSID_BOOTSTRAP) {
+        result = _anjay_bootstrap_account_prepare(anjay);
+    } else if (!_anjay_server_resume_registration(
+                       anjay, server, &inactive_server->register_async)) {
+        // a single Update is enough in this case
+        result = 0;
+        if (inactive_server->register_async) {
+            if (!sched_register_timeout(anjay, inactive_server)) {
+                return ACTIVATION_IN_PROGRESS;
+            }
+            anjay_log(ERROR, "could not schedule Update retransmission");
+            result = -1;
         }
     } else {
-        if (_anjay_bootstrap_account_prepare(anjay)) {
-            anjay_log(ERROR, "could not prepare bootstrap account for SSID %u",
-                      server->ssid);
-            return -1;
+        result = start_register(anjay, inactive_server);
+        if (result == ACTIVATION_IN_PROGRESS) {
+            return result;
         }
     }
 
+    if (result) {
+        fail_activation(anjay, inactive_server);
+        return -1;
+    }
+    commit_activation(anjay, inactive_server_ptr);
     return 0;
 }
 
-static AVS_LIST(anjay_active_server_info_t)
-create_active_server_from_ssid(anjay_t *anjay,
-                               anjay_ssid_t ssid) {
-    AVS_LIST(anjay_active_server_info_t) server =
-            AVS_LIST_NEW_ELEMENT(anjay_active_server_info_t);
+static AVS_LIST(anjay_inactive_server_info_t) *
+find_activation(anjay_t *anjay, anjay_active_server_info_t *server) {
+    AVS_LIST(anjay_inactive_server_info_t) *inactive_server_ptr =
+            _anjay_servers_find_inactive_ptr(&anjay->servers, server->ssid);
+    assert(inactive_server_ptr
+           && (*inactive_server_ptr)->activating == server
+           && "not a server being activated");
+    return inactive_server_ptr;
+}
 
-    if (!server) {
-        anjay_log(ERROR, "out of memory");
-        return NULL;
-    }
+void _anjay_server_activation_connected(anjay_t *anjay,
+                                        anjay_active_server_info_t *server) {
+    anjay_log(INFO, "connected to server SSID %u", server->ssid);
+    continue_activation(anjay, find_activation(anjay, server));
+}
 
-    if (initialize_active_server(anjay, ssid, server)) {
-        active_server_detach_delete(anjay, &server);
-        return NULL;
-    }
+void _anjay_server_activation_failed(anjay_t *anjay,
+                                     anjay_active_server_info_t *server) {
+    fail_activation(anjay, *find_activation(anjay, server));
+}
 
-    return server;
+bool _anjay_servers_serve_activating(anjay_t *anjay,
+                                     avs_net_abstract_socket_t *ready_socket) {
+    AVS_LIST(anjay_inactive_server_info_t) *it;
+    AVS_LIST_FOREACH_PTR(it, &anjay->servers.inactive) {
+        if (!(*it)->register_async) {
+            continue;
+        }
+        anjay_coap_async_request_t *request =
+                _anjay_register_async_request((*it)->register_async);
+        if (_anjay_coap_async_request_socket(request) == ready_socket) {
+            _anjay_coap_async_request_handle_readable(request);
+            register_async_update(anjay, it);
+            return true;
+        }
+    }
+    return false;
 }
 
+/**
+ * Connects to the server identified by @p ssid and registers to it. Neither
+ * the (D)TLS handshake nor waiting for the response to Register blocks: the
+ * activation continues from @ref anjay_serve and scheduler jobs, so that any
+ * number of servers may be activated at the same time.
+ *
+ * The job fails, so that the scheduler applies its backoff, until the
+ * activation succeeds.
+ */
 static int activate_server_job(anjay_t *anjay, void *ssid_) {
     anjay_ssid_t ssid = (anjay_ssid_t) (uintptr_t) ssid_;
 
@@ -96,28 +275,42 @@ static int activate_server_job(anjay_t *anjay, void *ssid_) {
     }
     assert(*inactive_server_ptr && "_anjay_servers_find_inactive_ptr broken");
 
-    AVS_LIST(anjay_active_server_info_t) new_server =
-            create_active_server_from_ssid(anjay, ssid);
-    if (!new_server) {
+    anjay_inactive_server_info_t *inactive_server = *inactive_server_ptr;
+    if (inactive_server->activating) {
+        anjay_log(TRACE, "activation of SSID %u still in progress", ssid);
         return -1;
     }
-    /**
-     * No need to remove job handle as we return 0 and scheduler will do it
-     * for us (this is retryable job).
-     */
-    AVS_LIST_DELETE(inactive_server_ptr);
-    _anjay_servers_add_active(&anjay->servers, new_server);
-    return 0;
+
+    inactive_server->activating =
+            AVS_LIST_NEW_ELEMENT(anjay_active_server_info_t);
+    if (!inactive_server->activating) {
+        anjay_log(ERROR, "out of memory");
+        return -1;
+    }
+    inactive_server->activating->ssid = ssid;
+
+    int result = _anjay_server_connect(anjay, inactive_server->activating);
+    if (result == ANJAY_CONNECTION_IN_PROGRESS) {
+        // continued by _anjay_server_activation_connected()
+        return -1;
+    } else if (result) {
+        anjay_log(TRACE, "could not initialize sockets for SSID %u", ssid);
+        fail_activation(anjay, inactive_server);
+        return -1;
+    }
+    return continue_activation(anjay, inactive_server_ptr) ? -1 : 0;
 }
 
 static int sched_reactivate_server(anjay_t *anjay,
                                    anjay_inactive_server_info_t *server,
                                    struct timespec reactivate_delay) {
     _anjay_sched_del(anjay->sched, &server->sched_reactivate_handle);
-    if (_anjay_sched_retryable(anjay->sched, &server->sched_reactivate_handle,
-                               reactivate_delay, ANJAY_SERVER_RETRYABLE_BACKOFF,
-                               activate_server_job,
-                               (void *) (uintptr_t) server->ssid)) {
+    _anjay_server_activation_cancel(anjay, server);
+    if (_anjay_sched_retryable_with_slack(
+                anjay->sched, &server->sched_reactivate_handle,
+                reactivate_delay, _anjay_sched_default_slack(reactivate_delay),
+                ANJAY_SERVER_RETRYABLE_BACKOFF, activate_server_job,
+                (void *) (uintptr_t) server->ssid)) {
         anjay_log(TRACE, "could not schedule reactivate job for server SSID %u",
                   server->ssid);
         return -1;
@@ -43,6 +43,30 @@ int _anjay_server_sched_activate(anjay_t *anjay,
                                  anjay_ssid_t ssid,
                                  struct timespec delay);
 
+/**
+ * Continues the activation of @p server , which must be the server being
+ * activated by one of the inactive server entries, once its connection has
+ * been established in the background. @p server may be freed by this call.
+ */
+void _anjay_server_activation_connected(anjay_t *anjay,
+                                        anjay_active_server_info_t *server);
+
+/**
+ * Abandons the activation of @p server , which must be the server being
+ * activated by one of the inactive server entries, after its connection
+ * could not be established in the background. @p server is freed by this
+ * call; the reactivate job retries the activation with its backoff.
+ */
+void _anjay_server_activation_failed(anjay_t *anjay,
+                                     anjay_active_server_info_t *server);
+
+/**
+ * Abandons the activation of @p server , if any is in progress, without
+ * affecting its reactivate job.
+ */
+void _anjay_server_activation_cancel(anjay_t *anjay,
+                                     anjay_inactive_server_info_t *server);
+
 /**
  * Inserts an active server entry into @p servers .
  *
@@ -17,15 +17,21 @@
 #include <config.h>
 
 #include <inttypes.h>
+#include <stdlib.h>
 
 #include <avsystem/commons/stream/net.h>
 
 #include "../dm/query.h"
+#ifdef WITH_COAP_TCP
+#include "../coap/tcp_socket.h"
+#endif // WITH_COAP_TCP
 
 #define ANJAY_SERVERS_CONNECTION_INFO_C
 #define ANJAY_SERVERS_INTERNALS
 
+#include "activate.h"
 #include "connection_info.h"
+#include "servers.h"
 
 VISIBILITY_SOURCE_BEGIN
 
@@ -51,6 +57,7 @@ typedef struct {
     char local_port[ANJAY_MAX_URL_PORT_SIZE];
     anjay_udp_security_mode_t security_mode;
     dtls_keys_t keys;
+    bool tcp;
 } udp_connection_info_t;
 
 
@@ -58,6 +65,8 @@ typedef struct {
     anjay_iid_t security_iid;
     anjay_ssid_t ssid; // or ANJAY_SSID_BOOTSTRAP
     udp_connection_info_t udp;
+    // secure sockets are connected in the background if set
+    bool connect_in_background;
 } server_connection_info_t;
 
 #define EMPTY_SERVER_INFO_INITIALIZER \
@@ -72,9 +81,49 @@ avs_net_abstract_socket_t *_anjay_connection_internal_get_socket(
     return connection->conn_priv_data_.socket;
 }
 
+coap_rtt_estimator_t *
+_anjay_connection_rtt_estimator(anjay_server_connection_t *connection) {
+    if (connection->conn_priv_data_.tcp) {
+        return NULL;
+    }
+    return &connection->conn_priv_data_.rtt_estimator;
+}
+
+coap_block_size_tuner_t *
+_anjay_connection_block_size_tuner(anjay_server_connection_t *connection) {
+    if (connection->conn_priv_data_.tcp) {
+        return NULL;
+    }
+    return &connection->conn_priv_data_.block_size_tuner;
+}
+
+bool _anjay_connection_internal_reconnect_failed(
+        const anjay_server_connection_t *connection) {
+    return connection->conn_priv_data_.reconnect_failed;
+}
+
+uint32_t _anjay_connection_internal_config_hash(
+        const anjay_server_connection_t *connection) {
+    return connection->conn_priv_data_.config_hash;
+}
+
 void
 _anjay_connection_internal_clean_socket(anjay_server_connection_t *connection) {
+    ++connection->socket_generation;
+    if (connection->conn_priv_data_.connect_task) {
+        // the socket is still in use by the background thread; it will be
+        // cleaned up as soon as the connection attempt finishes
+        _anjay_async_connect_cancel(
+                &connection->conn_priv_data_.connect_task,
+                connection->conn_priv_data_.dtls_session_buffer);
+        connection->conn_priv_data_.socket = NULL;
+        connection->conn_priv_data_.dtls_session_buffer = NULL;
+    }
+    // same for the fallback socket, which is only set during the attempt
+    _anjay_async_connect_cancel(&connection->conn_priv_data_.fallback_task,
+                                NULL);
     avs_net_socket_cleanup(&connection->conn_priv_data_.socket);
+    free(connection->conn_priv_data_.dtls_session_buffer);
     memset(&connection->conn_priv_data_, 0,
            sizeof(connection->conn_priv_data_));
 }
@@ -103,25 +152,35 @@ static struct {
         anjay_server_connection_mode_t udp;
         anjay_server_connection_mode_t sms;
     } connection;
+    bool tcp;
 } const BINDING_TO_CONNECTIONS[] = {
     { ANJAY_BINDING_U,   { .udp = ANJAY_CONNECTION_ONLINE,
-                           .sms = ANJAY_CONNECTION_DISABLED } },
+                           .sms = ANJAY_CONNECTION_DISABLED }, false },
     { ANJAY_BINDING_UQ,  { .udp = ANJAY_CONNECTION_QUEUE,
-                           .sms = ANJAY_CONNECTION_DISABLED } },
+                           .sms = ANJAY_CONNECTION_DISABLED }, false },
     { ANJAY_BINDING_S,   { .udp = ANJAY_CONNECTION_DISABLED,
-                           .sms = ANJAY_CONNECTION_ONLINE } },
+                           .sms = ANJAY_CONNECTION_ONLINE }, false },
     { ANJAY_BINDING_SQ,  { .udp = ANJAY_CONNECTION_DISABLED,
-                           .sms = ANJAY_CONNECTION_QUEUE } },
+                           .sms = ANJAY_CONNECTION_QUEUE }, false },
     { ANJAY_BINDING_US,  { .udp = ANJAY_CONNECTION_ONLINE,
-                           .sms = ANJAY_CONNECTION_ONLINE } },
+                           .sms = ANJAY_CONNECTION_ONLINE }, false },
     { ANJAY_BINDING_UQS, { .udp = ANJAY_CONNECTION_QUEUE,
-                           .sms = ANJAY_CONNECTION_ONLINE } }
+                           .sms = ANJAY_CONNECTION_ONLINE }, false },
+#ifdef WITH_COAP_TCP
+    /* TCP shares the IP connection slot with UDP; the transport itself is
+     * selected by the URI scheme and only checked against the binding */
+    { ANJAY_BINDING_T,   { .udp = ANJAY_CONNECTION_ONLINE,
+                           .sms = ANJAY_CONNECTION_DISABLED }, true },
+    { ANJAY_BINDING_TQ,  { .udp = ANJAY_CONNECTION_QUEUE,
+                           .sms = ANJAY_CONNECTION_DISABLED }, true }
+#endif // WITH_COAP_TCP
 };
 
 static int read_connection_modes(anjay_t *anjay,
                                  anjay_ssid_t ssid,
                                  anjay_server_connection_mode_t *out_udp_mode,
-                                 anjay_server_connection_mode_t *out_sms_mode) {
+                                 anjay_server_connection_mode_t *out_sms_mode,
+                                 bool *out_tcp) {
     if (ssid != ANJAY_SSID_BOOTSTRAP) {
         anjay_binding_mode_t binding_mode = read_binding_mode(anjay, ssid);
         for (size_t i = 0; i < ANJAY_ARRAY_SIZE(BINDING_TO_CONNECTIONS); ++i) {
@@ -132,6 +191,9 @@ static int read_connection_modes(anjay_t *anjay,
                 if (out_sms_mode) {
                     *out_sms_mode = BINDING_TO_CONNECTIONS[i].connection.sms;
                 }
+                if (out_tcp) {
+                    *out_tcp = BINDING_TO_CONNECTIONS[i].tcp;
+                }
                 return 0;
             }
         }
@@ -149,6 +211,17 @@ static int read_connection_modes(anjay_t *anjay,
     }
 }
 
+static bool
+connection_in_progress(const anjay_server_connection_t *connection) {
+    return connection->conn_priv_data_.connect_task
+            || connection->conn_priv_data_.fallback_task;
+}
+
+bool _anjay_connection_is_connecting(anjay_connection_ref_t ref) {
+    anjay_server_connection_t *connection = _anjay_get_server_connection(ref);
+    return connection && connection_in_progress(connection);
+}
+
 anjay_server_connection_mode_t
 _anjay_connection_current_mode(anjay_connection_ref_t ref) {
     anjay_server_connection_t *connection = _anjay_get_server_connection(ref);
@@ -165,10 +238,12 @@ _anjay_connection_current_mode(anjay_connection_ref_t ref) {
 
 static anjay_binding_mode_t
 binding_mode_from_connection_modes(anjay_server_connection_mode_t udp_mode,
-                                   anjay_server_connection_mode_t sms_mode) {
+                                   anjay_server_connection_mode_t sms_mode,
+                                   bool tcp) {
     for (size_t i = 0; i < ANJAY_ARRAY_SIZE(BINDING_TO_CONNECTIONS); ++i) {
         if (BINDING_TO_CONNECTIONS[i].connection.udp == udp_mode
-                && BINDING_TO_CONNECTIONS[i].connection.sms == sms_mode) {
+                && BINDING_TO_CONNECTIONS[i].connection.sms == sms_mode
+                && BINDING_TO_CONNECTIONS[i].tcp == tcp) {
             return BINDING_TO_CONNECTIONS[i].binding;
         }
     }
@@ -180,17 +255,22 @@ _anjay_server_cached_binding_mode(anjay_active_server_info_t *server) {
     if (!server) {
         return ANJAY_BINDING_NONE;
     }
+    const anjay_connection_ref_t udp_ref = {
+        .server = server,
+        .conn_type = ANJAY_CONNECTION_UDP
+    };
     anjay_server_connection_mode_t udp_mode =
-            _anjay_connection_current_mode((anjay_connection_ref_t) {
-                                               .server = server,
-                                               .conn_type = ANJAY_CONNECTION_UDP
-                                           });
+            _anjay_connection_current_mode(udp_ref);
     anjay_server_connection_mode_t sms_mode =
             _anjay_connection_current_mode((anjay_connection_ref_t) {
                                                .server = server,
                                                .conn_type = ANJAY_CONNECTION_SMS
                                            });
-    return binding_mode_from_connection_modes(udp_mode, sms_mode);
+    const anjay_server_connection_t *udp_connection =
+            _anjay_get_server_connection(udp_ref);
+    return binding_mode_from_connection_modes(
+            udp_mode, sms_mode,
+            udp_connection && udp_connection->conn_priv_data_.tcp);
 }
 
 typedef anjay_server_connection_mode_t
@@ -212,6 +292,17 @@ typedef struct {
     create_connected_socket_t *create_connected_socket;
 } connection_type_definition_t;
 
+static int update_last_local_port(anjay_server_connection_t *connection) {
+    if (avs_net_socket_get_local_port(
+                connection->conn_priv_data_.socket,
+                connection->conn_priv_data_.last_local_port,
+                sizeof(connection->conn_priv_data_.last_local_port))) {
+        connection->conn_priv_data_.last_local_port[0] = '\0';
+        return -1;
+    }
+    return 0;
+}
+
 static int refresh_connection(anjay_t *anjay,
                               const connection_type_definition_t *def,
                               anjay_active_server_info_t *server,
@@ -227,6 +318,14 @@ static int refresh_connection(anjay_t *anjay,
             _anjay_connection_internal_get_socket(out_connection);
     bool should_be_connected =
             (def->get_connection_mode(info) != ANJAY_CONNECTION_DISABLED);
+    int result = 0;
+    if (should_be_connected && connection_in_progress(out_connection)) {
+        if (!force_reconnect && !out_connection->needs_socket_update) {
+            return ANJAY_CONNECTION_IN_PROGRESS;
+        }
+        _anjay_connection_internal_clean_socket(out_connection);
+        existing_socket = NULL;
+    }
     if (!should_be_connected) {
         _anjay_connection_internal_clean_socket(out_connection);
     } else {
@@ -238,22 +337,26 @@ static int refresh_connection(anjay_t *anjay,
         if (existing_socket == NULL || force_reconnect
                 || out_connection->needs_socket_update) {
             _anjay_connection_internal_clean_socket(out_connection);
-            if (def->create_connected_socket(anjay, out_connection, info)
-                    || avs_net_socket_get_local_port(
-                            out_connection->conn_priv_data_.socket,
-                            out_connection->conn_priv_data_.last_local_port,
-                            sizeof(out_connection->conn_priv_data_.last_local_port))) {
+            // the local port of a socket connected in the background is
+            // only read once the connection is established
+            result = def->create_connected_socket(anjay, out_connection, info);
+            if (result < 0
+                    || (!result && update_last_local_port(out_connection))) {
                 avs_net_socket_cleanup(&out_connection->conn_priv_data_.socket);
                 return -1;
             }
-        } else if (_anjay_connection_internal_ensure_online(out_connection)) {
-            return -1;
+        } else {
+            result = _anjay_connection_internal_ensure_online(
+                    anjay, out_connection);
+            if (result) {
+                return result;
+            }
         }
     }
     out_connection->needs_socket_update = false;
     out_connection->queue_mode =
             (def->get_connection_mode(info) == ANJAY_CONNECTION_QUEUE);
-    return 0;
+    return result;
 }
 
 static anjay_server_connection_mode_t
@@ -303,12 +406,14 @@ static int init_cert_security(avs_net_security_info_t *security,
 static int fill_udp_socket_config(anjay_t *anjay,
                                   avs_net_ssl_configuration_t *config,
                                   avs_net_resolved_endpoint_t *preferred_endpoint,
+                                  void *dtls_session_buffer,
                                   const udp_connection_info_t *udp_info) {
     memset(config, 0, sizeof(*config));
     config->version = anjay->dtls_version;
     config->backend_configuration = anjay->udp_socket_config;
     config->backend_configuration.reuse_addr = 1;
     config->backend_configuration.preferred_endpoint = preferred_endpoint;
+    _anjay_dtls_session_configure(dtls_session_buffer, config);
 
     switch (udp_info->security_mode) {
     case ANJAY_UDP_SECURITY_NOSEC:
@@ -353,10 +458,28 @@ static int get_udp_security_mode(anjay_t *anjay,
     }
 }
 
+#ifdef WITH_COAP_TCP
+static bool is_tcp_uri(const anjay_url_t *uri) {
+    return !strcmp(uri->protocol, "coap+tcp")
+            || !strcmp(uri->protocol, "coaps+tcp");
+}
+#endif // WITH_COAP_TCP
+
+static bool is_valid_coap_protocol(const char *protocol, bool use_nosec) {
+    if (!strcmp(protocol, use_nosec ? "coap" : "coaps")) {
+        return true;
+    }
+#ifdef WITH_COAP_TCP
+    if (!strcmp(protocol, use_nosec ? "coap+tcp" : "coaps+tcp")) {
+        return true;
+    }
+#endif // WITH_COAP_TCP
+    return false;
+}
+
 static bool is_valid_coap_uri(const anjay_url_t *uri,
                               bool use_nosec) {
-    if ((use_nosec && strcmp(uri->protocol, "coap"))
-            || (!use_nosec && strcmp(uri->protocol, "coaps"))) {
+    if (!is_valid_coap_protocol(uri->protocol, use_nosec)) {
         anjay_log(ERROR, "unsupported protocol: %s (NoSec %s)", uri->protocol,
                   use_nosec ? "enabled" : "disabled");
         return false;
@@ -475,6 +598,17 @@ static int get_udp_connection_info(anjay_t *anjay,
         return -1;
     }
 
+#ifdef WITH_COAP_TCP
+    const bool tcp_uri = is_tcp_uri(&inout_info->udp.uri);
+    if (inout_info->ssid != ANJAY_SSID_BOOTSTRAP
+            && tcp_uri != inout_info->udp.tcp) {
+        anjay_log(ERROR, "%s URI does not match binding mode of server %u",
+                  inout_info->udp.uri.protocol, inout_info->ssid);
+        return -1;
+    }
+    inout_info->udp.tcp = tcp_uri;
+#endif // WITH_COAP_TCP
+
     get_requested_local_port(inout_info->udp.local_port, anjay, old_socket);
 
     anjay_log(DEBUG, "server /%u/%u: %s://%s:%s, local port %s, "
@@ -486,50 +620,186 @@ static int get_udp_connection_info(anjay_t *anjay,
     return 0;
 }
 
-static int create_connected_udp_socket(anjay_t *anjay,
-                                       anjay_server_connection_t *out_conn,
-                                       const server_connection_info_t *info) {
-    avs_net_abstract_socket_t *socket = NULL;
-    avs_net_socket_type_t type =
-            info->udp.security_mode == ANJAY_UDP_SECURITY_NOSEC
-                ? AVS_NET_UDP_SOCKET : AVS_NET_DTLS_SOCKET;
+static avs_net_socket_type_t
+get_socket_type(const udp_connection_info_t *udp_info) {
+    const bool nosec = (udp_info->security_mode == ANJAY_UDP_SECURITY_NOSEC);
+#ifdef WITH_COAP_TCP
+    if (udp_info->tcp) {
+        return nosec ? AVS_NET_TCP_SOCKET : AVS_NET_SSL_SOCKET;
+    }
+#endif // WITH_COAP_TCP
+    return nosec ? AVS_NET_UDP_SOCKET : AVS_NET_DTLS_SOCKET;
+}
 
+static uint32_t hash_udp_connection_info(const udp_connection_info_t *info) {
+    // string terminators are included to separate the fields
+    uint32_t hash = ANJAY_FNV1A32_INITIAL;
+    hash = _anjay_fnv1a32(hash, info->uri.protocol,
+                          strlen(info->uri.protocol) + 1);
+    hash = _anjay_fnv1a32(hash, info->uri.host, strlen(info->uri.host) + 1);
+    hash = _anjay_fnv1a32(hash, info->uri.port, strlen(info->uri.port) + 1);
+    const uint8_t security_mode = (uint8_t) info->security_mode;
+    hash = _anjay_fnv1a32(hash, &security_mode, sizeof(security_mode));
+    // the secret key is left out on purpose, as the hash is persisted
+    hash = _anjay_fnv1a32(hash, info->keys.pk_or_identity.data,
+                          info->keys.pk_or_identity.size);
+    return _anjay_fnv1a32(hash, info->keys.server_pk_or_identity.data,
+                          info->keys.server_pk_or_identity.size);
+}
+
+static uint32_t
+hash_udp_socket_config(const udp_connection_info_t *info) {
+    uint32_t hash = hash_udp_connection_info(info);
+    hash = _anjay_fnv1a32(hash, info->keys.secret_key.data,
+                          info->keys.secret_key.size);
+    const uint8_t tcp = info->tcp;
+    return _anjay_fnv1a32(hash, &tcp, sizeof(tcp));
+}
+
+static int create_udp_socket(anjay_t *anjay,
+                             avs_net_abstract_socket_t **out_socket,
+                             avs_net_resolved_endpoint_t *preferred_endpoint,
+                             void *dtls_session_buffer,
+                             const udp_connection_info_t *info) {
+    avs_net_socket_type_t type = get_socket_type(info);
     avs_net_ssl_configuration_t config;
-    if (fill_udp_socket_config(anjay, &config,
-                               &out_conn->conn_priv_data_.preferred_endpoint,
-                               &info->udp)) {
-        goto error;
+    if (fill_udp_socket_config(anjay, &config, preferred_endpoint,
+                               dtls_session_buffer, info)) {
+        return -1;
     }
 
-    const void *config_ptr = (type == AVS_NET_DTLS_SOCKET)
-            ? (const void *) &config
-            : (const void *) &config.backend_configuration;
+    const void *config_ptr =
+            (type == AVS_NET_DTLS_SOCKET || type == AVS_NET_SSL_SOCKET)
+                    ? (const void *) &config
+                    : (const void *) &config.backend_configuration;
 
-    if (avs_net_socket_create(&socket, type, config_ptr)) {
+    if (avs_net_socket_create(out_socket, type, config_ptr)) {
         anjay_log(ERROR, "could not create CoAP socket");
-        goto error;
+        return -1;
     }
 
-    if (*info->udp.local_port
-            && avs_net_socket_bind(socket, NULL, info->udp.local_port)) {
-        anjay_log(ERROR, "could not bind socket to port %s",
-                  info->udp.local_port);
+#ifdef WITH_COAP_TCP
+    if (info->tcp) {
+        avs_net_abstract_socket_t *backend = *out_socket;
+        *out_socket = NULL;
+        if (_anjay_coap_tcp_socket_create(out_socket, backend)) {
+            anjay_log(ERROR, "could not create CoAP/TCP socket");
+            return -1;
+        }
+    }
+#endif // WITH_COAP_TCP
+
+    /* the listening port setting applies to UDP only; TCP connections always
+     * use an ephemeral local port */
+    if (!info->tcp && *info->local_port
+            && avs_net_socket_bind(*out_socket, NULL, info->local_port)) {
+        anjay_log(ERROR, "could not bind socket to port %s", info->local_port);
+        return -1;
+    }
+    return 0;
+}
+
+static void init_connection(anjay_server_connection_t *out_conn,
+                            avs_net_abstract_socket_t *socket,
+                            anjay_dtls_session_t *dtls_session,
+                            void *dtls_session_buffer,
+                            anjay_dns_cache_entry_t *dns_entry,
+                            const server_connection_info_t *info) {
+    avs_net_socket_type_t type = get_socket_type(&info->udp);
+    out_conn->conn_priv_data_.socket = socket;
+    out_conn->conn_priv_data_.tcp = info->udp.tcp;
+    out_conn->conn_priv_data_.secure = (type == AVS_NET_DTLS_SOCKET
+                                        || type == AVS_NET_SSL_SOCKET);
+    out_conn->conn_priv_data_.dtls_session = dtls_session;
+    out_conn->conn_priv_data_.dtls_session_buffer = dtls_session_buffer;
+    out_conn->conn_priv_data_.dns_entry = dns_entry;
+    out_conn->conn_priv_data_.config_hash =
+            hash_udp_connection_info(&info->udp);
+    out_conn->conn_priv_data_.socket_config_hash =
+            hash_udp_socket_config(&info->udp);
+}
+
+static void reconnect_finished(anjay_t *anjay,
+                               void *connection_,
+                               int result);
+
+static void schedule_connect_fallback(anjay_t *anjay,
+                                      anjay_server_connection_t *connection);
+
+static int create_connected_udp_socket(anjay_t *anjay,
+                                       anjay_server_connection_t *out_conn,
+                                       const server_connection_info_t *info) {
+    avs_net_abstract_socket_t *socket = NULL;
+    avs_net_socket_type_t type = get_socket_type(&info->udp);
+    const bool secure = (type == AVS_NET_DTLS_SOCKET
+                         || type == AVS_NET_SSL_SOCKET);
+
+    // failure to allocate the cache entry only disables session resumption
+    anjay_dtls_session_t *dtls_session =
+            secure ? _anjay_dtls_session_get(anjay, info->ssid,
+                                             info->udp.uri.host,
+                                             info->udp.uri.port,
+                                             hash_udp_socket_config(&info->udp))
+                   : NULL;
+    void *dtls_session_buffer =
+            dtls_session ? _anjay_dtls_session_buffer_new() : NULL;
+
+    if (create_udp_socket(anjay, &socket,
+                          &out_conn->conn_priv_data_.preferred_endpoint,
+                          dtls_session_buffer, &info->udp)) {
         goto error;
     }
 
-    if (avs_net_socket_connect(socket,
-                               info->udp.uri.host, info->udp.uri.port)) {
+    // certificate verification may need the hostname
+    anjay_dns_cache_entry_t *dns_entry =
+            info->udp.security_mode != ANJAY_UDP_SECURITY_CERTIFICATE
+                    ? _anjay_dns_cache_get(anjay, info->ssid,
+                                           info->udp.uri.host,
+                                           info->udp.uri.port)
+                    : NULL;
+    char connect_host[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    if (dns_entry) {
+        // the resolver shall not be waited for if connecting in the background
+        _anjay_dns_cache_lookup(anjay, dns_entry, type,
+                                !(secure && info->connect_in_background),
+                                connect_host, sizeof(connect_host));
+    } else {
+        strcpy(connect_host, info->udp.uri.host);
+    }
+
+    _anjay_dtls_session_handshake_started(dtls_session, dtls_session_buffer);
+    if (secure && info->connect_in_background
+            && !_anjay_async_connect_start(
+                    anjay, &out_conn->conn_priv_data_.connect_task, socket,
+                    connect_host, info->udp.uri.port, reconnect_finished,
+                    out_conn)) {
+        anjay_log(INFO, "connecting to %s:%s in the background",
+                  info->udp.uri.host, info->udp.uri.port);
+        init_connection(out_conn, socket, dtls_session, dtls_session_buffer,
+                        dns_entry, info);
+        schedule_connect_fallback(anjay, out_conn);
+        return ANJAY_CONNECTION_IN_PROGRESS;
+    }
+    int result = avs_net_socket_connect(socket, connect_host,
+                                        info->udp.uri.port);
+    _anjay_dtls_session_handshake_finished(dtls_session, dtls_session_buffer,
+                                           socket, result);
+    if (result) {
         anjay_log(ERROR, "could not connect to %s:%s",
                   info->udp.uri.host, info->udp.uri.port);
+        _anjay_dns_cache_connect_failed(anjay, dns_entry);
         goto error;
     }
+    _anjay_dns_cache_connected(anjay, dns_entry, socket);
 
     anjay_log(INFO, "connected to %s:%s",
               info->udp.uri.host, info->udp.uri.port);
-    out_conn->conn_priv_data_.socket = socket;
+    init_connection(out_conn, socket, dtls_session, dtls_session_buffer,
+                    dns_entry, info);
     return 0;
 error:
     avs_net_socket_cleanup(&socket);
+    free(dtls_session_buffer);
     return -1;
 }
 
@@ -553,8 +823,8 @@ static int get_common_connection_info(anjay_t *anjay,
     out_info->ssid = ssid;
 
     if (read_connection_modes(anjay, ssid, &out_info->udp.mode,
-                              NULL
-                              )) {
+                              NULL,
+                              &out_info->udp.tcp)) {
         return -1;
     }
 
@@ -580,13 +850,51 @@ int _anjay_server_refresh(anjay_t *anjay,
     return udp_result ? udp_result : sms_result;
 }
 
+int _anjay_server_connect(anjay_t *anjay, anjay_active_server_info_t *server) {
+    anjay_log(TRACE, "connecting SSID %u", server->ssid);
+
+    server_connection_info_t server_info = EMPTY_SERVER_INFO_INITIALIZER;
+    if (get_common_connection_info(anjay, server->ssid, &server_info)) {
+        anjay_log(DEBUG, "could not get connection info for SSID %u",
+                  server->ssid);
+        return -1;
+    }
+    server_info.connect_in_background = true;
+    return refresh_connection(anjay, &UDP_CONNECTION, server, &server_info,
+                              true);
+}
+
+bool _anjay_server_config_changed(anjay_t *anjay,
+                                  anjay_active_server_info_t *server) {
+    const anjay_server_connection_t *connection = &server->udp_connection;
+    if (!connection->needs_socket_update) {
+        return false;
+    }
+    if (!_anjay_connection_internal_get_socket(connection)) {
+        return true;
+    }
+
+    server_connection_info_t server_info = EMPTY_SERVER_INFO_INITIALIZER;
+    // the old socket is only used to determine the local port, which does not
+    // affect the comparison - and it must not be touched if it is connecting
+    if (get_common_connection_info(anjay, server->ssid, &server_info)
+            || get_udp_connection_mode(&server_info)
+                    == ANJAY_CONNECTION_DISABLED
+            || UDP_CONNECTION.get_connection_info(anjay, &server_info, NULL)) {
+        return true;
+    }
+    return hash_udp_socket_config(&server_info.udp)
+            != connection->conn_priv_data_.socket_config_hash;
+}
+
 static void connection_suspend(anjay_connection_ref_t conn_ref) {
-    const anjay_server_connection_t *connection =
+    anjay_server_connection_t *connection =
             _anjay_get_server_connection(conn_ref);
     if (connection) {
         avs_net_abstract_socket_t *socket =
                 _anjay_connection_internal_get_socket(connection);
-        if (socket) {
+        if (socket && !connection_in_progress(connection)) {
+            ++connection->socket_generation;
             avs_net_socket_close(socket);
         }
     }
@@ -605,8 +913,287 @@ void _anjay_connection_suspend(anjay_connection_ref_t conn_ref) {
     }
 }
 
+void _anjay_connection_exchange_finished(anjay_t *anjay,
+                                         anjay_connection_ref_t conn_ref,
+                                         bool responded) {
+    anjay_server_connection_t *connection =
+            _anjay_get_server_connection(conn_ref);
+    if (!connection) {
+        return;
+    }
+    if (responded) {
+        _anjay_dns_cache_responded(anjay,
+                                   connection->conn_priv_data_.dns_entry);
+    } else {
+        _anjay_dns_cache_connect_failed(anjay,
+                                        connection->conn_priv_data_.dns_entry);
+    }
+}
+
+/**
+ * Finds the server that owns @p connection, either among the active servers or
+ * among the servers being activated.
+ */
+static anjay_active_server_info_t *
+find_connection_owner(anjay_t *anjay, anjay_server_connection_t *connection) {
+    AVS_LIST(anjay_active_server_info_t) server;
+    AVS_LIST_FOREACH(server, anjay->servers.active) {
+        if (&server->udp_connection == connection) {
+            return server;
+        }
+    }
+    AVS_LIST(anjay_inactive_server_info_t) inactive_server;
+    AVS_LIST_FOREACH(inactive_server, anjay->servers.inactive) {
+        if (inactive_server->activating
+                && &inactive_server->activating->udp_connection
+                        == connection) {
+            return inactive_server->activating;
+        }
+    }
+    return NULL;
+}
+
+static bool is_activating(anjay_t *anjay, anjay_active_server_info_t *server) {
+    return _anjay_servers_find_active(&anjay->servers, server->ssid) != server;
+}
+
+/**
+ * NOTE: If @p server is being activated, it is freed by this function.
+ */
+static void connection_failed(anjay_t *anjay,
+                              anjay_active_server_info_t *server,
+                              anjay_server_connection_t *connection) {
+    if (is_activating(anjay, server)) {
+        anjay_log(ERROR, "could not connect to server %" PRIu16, server->ssid);
+        _anjay_server_activation_failed(anjay, server);
+        return;
+    }
+    anjay_log(ERROR, "could not reconnect to server %" PRIu16, server->ssid);
+    // Scheduling a reconnect here would mean an endless loop without backoff
+    // if the server is down. Instead, the socket is left suspended until the
+    // retryable Update job reconnects it.
+    connection_suspend((anjay_connection_ref_t) {
+        .server = server,
+        .conn_type = ANJAY_CONNECTION_UDP
+    });
+    connection->conn_priv_data_.reconnect_failed = true;
+    bool update_pending = connection->update_after_connect;
+    connection->update_after_connect = false;
+    // if the Update job is waiting for the connection, it is already being
+    // retried; otherwise, the attempt has been started by sending a message
+    // in queue mode, and the Update job needs to take over
+    if (!update_pending
+            && anjay_schedule_registration_update(anjay, server->ssid)) {
+        anjay_log(ERROR, "could not schedule Update for server %" PRIu16,
+                  server->ssid);
+    }
+}
+
+/**
+ * NOTE: If @p server is being activated, it may be freed by this function.
+ */
+static void connection_established(anjay_t *anjay,
+                                   anjay_active_server_info_t *server,
+                                   anjay_server_connection_t *connection) {
+    _anjay_dns_cache_connected(anjay, connection->conn_priv_data_.dns_entry,
+                               connection->conn_priv_data_.socket);
+    if (is_activating(anjay, server)) {
+        _anjay_server_activation_connected(anjay, server);
+        return;
+    }
+    anjay_log(INFO, "reconnected to server %" PRIu16, server->ssid);
+    bool update_after_connect = connection->update_after_connect;
+    connection->update_after_connect = false;
+    if (update_after_connect
+            && server->ssid != ANJAY_SSID_BOOTSTRAP
+            && anjay_schedule_registration_update(anjay, server->ssid)) {
+        anjay_log(ERROR, "could not schedule Update for server %" PRIu16,
+                  server->ssid);
+    }
+    _anjay_observe_sched_flush(anjay, server->ssid, ANJAY_CONNECTION_UDP);
+}
+
+static void reconnect_finished(anjay_t *anjay,
+                               void *connection_,
+                               int result) {
+    anjay_server_connection_t *connection =
+            (anjay_server_connection_t *) connection_;
+    connection->conn_priv_data_.connect_task = NULL;
+    ++connection->socket_generation;
+
+    // the task would have been cancelled if the server was deleted
+    anjay_active_server_info_t *server =
+            find_connection_owner(anjay, connection);
+    assert(server);
+
+    _anjay_dtls_session_handshake_finished(
+            connection->conn_priv_data_.dtls_session,
+            connection->conn_priv_data_.dtls_session_buffer,
+            connection->conn_priv_data_.socket, result);
+
+    _anjay_sched_del(anjay->sched, &connection->connect_fallback_clb_handle);
+    if (result) {
+        _anjay_dns_cache_connect_failed(anjay,
+                                        connection->conn_priv_data_.dns_entry);
+        if (connection->conn_priv_data_.fallback_task) {
+            anjay_log(DEBUG, "waiting for the other address family of server "
+                             "%" PRIu16, server->ssid);
+        } else {
+            connection_failed(anjay, server, connection);
+        }
+        return;
+    }
+
+    // the fallback attempt lost the race
+    _anjay_async_connect_cancel(&connection->conn_priv_data_.fallback_task,
+                                NULL);
+    connection->conn_priv_data_.fallback_socket = NULL;
+    update_last_local_port(connection);
+    connection_established(anjay, server, connection);
+}
+
+static void fallback_finished(anjay_t *anjay,
+                              void *connection_,
+                              int result) {
+    anjay_server_connection_t *connection =
+            (anjay_server_connection_t *) connection_;
+    avs_net_abstract_socket_t *socket =
+            connection->conn_priv_data_.fallback_socket;
+    connection->conn_priv_data_.fallback_task = NULL;
+    connection->conn_priv_data_.fallback_socket = NULL;
+
+    anjay_active_server_info_t *server =
+            find_connection_owner(anjay, connection);
+    assert(server);
+
+    if (result) {
+        avs_net_socket_cleanup(&socket);
+        if (!connection->conn_priv_data_.connect_task) {
+            // both attempts failed
+            _anjay_dns_cache_connect_failed(
+                    anjay, connection->conn_priv_data_.dns_entry);
+            connection_failed(anjay, server, connection);
+        }
+        return;
+    }
+
+    if (connection->conn_priv_data_.connect_task) {
+        // the original socket is cleaned up once its attempt finishes
+        _anjay_async_connect_cancel(
+                &connection->conn_priv_data_.connect_task,
+                connection->conn_priv_data_.dtls_session_buffer);
+        connection->conn_priv_data_.socket = NULL;
+        connection->conn_priv_data_.dtls_session_buffer = NULL;
+    }
+    avs_net_socket_cleanup(&connection->conn_priv_data_.socket);
+    // the fallback socket does not use session resumption
+    free(connection->conn_priv_data_.dtls_session_buffer);
+    connection->conn_priv_data_.dtls_session_buffer = NULL;
+    connection->conn_priv_data_.socket = socket;
+    ++connection->socket_generation;
+    update_last_local_port(connection);
+    _anjay_dtls_session_handshake_finished(
+            connection->conn_priv_data_.dtls_session, NULL, socket, result);
+    connection_established(anjay, server, connection);
+}
+
+/**
+ * Starts connecting to an address of the other family in parallel with the
+ * attempt already in progress, as described in RFC 8305.
+ */
+static void start_connect_fallback(anjay_t *anjay,
+                                   anjay_active_server_info_t *server) {
+    anjay_server_connection_t *connection = &server->udp_connection;
+    char host[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    if (!connection->conn_priv_data_.connect_task
+            || connection->conn_priv_data_.fallback_task
+            || !_anjay_dns_cache_fallback(connection->conn_priv_data_.dns_entry,
+                                          host, sizeof(host))) {
+        return;
+    }
+
+    // the configuration of the original socket is not kept around, so it is
+    // read again, and only used if it has not changed in the meantime; the
+    // session resumption buffer cannot be shared between concurrent
+    // handshakes, so the fallback socket does not use it
+    server_connection_info_t info = EMPTY_SERVER_INFO_INITIALIZER;
+    avs_net_abstract_socket_t *socket = NULL;
+    if (get_common_connection_info(anjay, server->ssid, &info)
+            || get_udp_connection_info(anjay, &info, NULL)
+            || hash_udp_socket_config(&info.udp)
+                    != connection->conn_priv_data_.socket_config_hash
+            || create_udp_socket(anjay, &socket, NULL, NULL, &info.udp)) {
+        anjay_log(DEBUG, "could not create fallback socket for server "
+                         "%" PRIu16, server->ssid);
+        avs_net_socket_cleanup(&socket);
+        return;
+    }
+
+    const char *port =
+            _anjay_dns_cache_port(connection->conn_priv_data_.dns_entry);
+    if (_anjay_async_connect_start(
+                anjay, &connection->conn_priv_data_.fallback_task, socket,
+                host, port, fallback_finished, connection)) {
+        avs_net_socket_cleanup(&socket);
+        return;
+    }
+    connection->conn_priv_data_.fallback_socket = socket;
+    anjay_log(INFO, "also connecting to %s:%s", host, port);
+}
+
+static int connect_fallback_job(anjay_t *anjay, void *ssid_) {
+    anjay_ssid_t ssid = (anjay_ssid_t) (intptr_t) ssid_;
+    anjay_active_server_info_t *server =
+            _anjay_servers_find_active(&anjay->servers, ssid);
+    if (!server) {
+        AVS_LIST(anjay_inactive_server_info_t) *inactive_server_ptr =
+                _anjay_servers_find_inactive_ptr(&anjay->servers, ssid);
+        if (inactive_server_ptr) {
+            server = (*inactive_server_ptr)->activating;
+        }
+    }
+    if (server) {
+        start_connect_fallback(anjay, server);
+    }
+    return 0;
+}
+
+static void schedule_connect_fallback(anjay_t *anjay,
+                                      anjay_server_connection_t *connection) {
+    char host[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    anjay_active_server_info_t *server;
+    if (!_anjay_dns_cache_fallback(connection->conn_priv_data_.dns_entry,
+                                   host, sizeof(host))
+            || !(server = find_connection_owner(anjay, connection))) {
+        return;
+    }
+    struct timespec delay;
+    _anjay_time_from_ms(&delay, ANJAY_CONNECTION_ATTEMPT_DELAY_MS);
+    _anjay_sched_del(anjay->sched, &connection->connect_fallback_clb_handle);
+    if (_anjay_sched(anjay->sched, &connection->connect_fallback_clb_handle,
+                     delay, connect_fallback_job,
+                     (void *) (intptr_t) server->ssid)) {
+        anjay_log(DEBUG, "could not schedule fallback connection attempt");
+    }
+}
+
+static avs_net_socket_type_t
+connection_socket_type(const anjay_server_connection_t *connection) {
+    const anjay_server_connection_private_data_t *data =
+            &connection->conn_priv_data_;
+    if (data->tcp) {
+        return data->secure ? AVS_NET_SSL_SOCKET : AVS_NET_TCP_SOCKET;
+    }
+    return data->secure ? AVS_NET_DTLS_SOCKET : AVS_NET_UDP_SOCKET;
+}
+
 int _anjay_connection_internal_ensure_online(
+        anjay_t *anjay,
         anjay_server_connection_t *connection) {
+    if (connection_in_progress(connection)) {
+        return ANJAY_CONNECTION_IN_PROGRESS;
+    }
+
     char remote_host[ANJAY_MAX_URL_HOSTNAME_SIZE];
     char remote_port[ANJAY_MAX_URL_PORT_SIZE];
 
@@ -620,13 +1207,25 @@ int _anjay_connection_internal_ensure_online(
         // already connected, OK
         return 0;
     }
+    ++connection->socket_generation;
+    connection->conn_priv_data_.reconnect_failed = false;
     if (opt.state != AVS_NET_SOCKET_STATE_CLOSED
             && avs_net_socket_close(connection->conn_priv_data_.socket)) {
         anjay_log(ERROR, "Could not close the socket (?!)");
         return -1;
     }
-    if (avs_net_socket_get_remote_hostname(connection->conn_priv_data_.socket,
-                                           remote_host, sizeof(remote_host))
+    anjay_dns_cache_entry_t *dns_entry = connection->conn_priv_data_.dns_entry;
+    if (dns_entry) {
+        // (D)TLS sockets are connected in the background, so the resolver
+        // shall not be waited for here
+        _anjay_dns_cache_lookup(anjay, dns_entry,
+                                connection_socket_type(connection),
+                                !connection->conn_priv_data_.secure,
+                                remote_host, sizeof(remote_host));
+        strcpy(remote_port, _anjay_dns_cache_port(dns_entry));
+    } else if (avs_net_socket_get_remote_hostname(
+                       connection->conn_priv_data_.socket,
+                       remote_host, sizeof(remote_host))
             || avs_net_socket_get_remote_port(
                     connection->conn_priv_data_.socket,
                     remote_port, sizeof(remote_port))) {
@@ -641,10 +1240,12 @@ int _anjay_connection_internal_ensure_online(
      * - it's a UDP socket and:
      *   - no listening port has been explicitly specified, and
      *   - it's a fresh socket and previously used listening port is unknown
+     * - it's a TCP socket, as the previous port may still be in TIME_WAIT
      * It is safe not to call bind(), because connect() is called below, which
      * will automatically bind the socket to a new ephemeral port.
      */
-    if (*connection->conn_priv_data_.last_local_port
+    if (!connection->conn_priv_data_.tcp
+            && *connection->conn_priv_data_.last_local_port
             && avs_net_socket_bind(
                     connection->conn_priv_data_.socket, NULL,
                     connection->conn_priv_data_.last_local_port)) {
@@ -652,12 +1253,37 @@ int _anjay_connection_internal_ensure_online(
                   connection->conn_priv_data_.last_local_port);
         return -1;
     }
-    if (avs_net_socket_connect(connection->conn_priv_data_.socket,
-                               remote_host, remote_port)) {
+    // the session resumption buffer is still attached to the socket, so
+    // the handshake will be abbreviated if the server permits it
+    _anjay_dtls_session_handshake_started(
+            connection->conn_priv_data_.dtls_session,
+            connection->conn_priv_data_.dtls_session_buffer);
+    // plain UDP sockets connect instantly, so there is no point in involving
+    // another thread for them
+    if (connection->conn_priv_data_.secure
+            && !_anjay_async_connect_start(
+                    anjay, &connection->conn_priv_data_.connect_task,
+                    connection->conn_priv_data_.socket, remote_host,
+                    remote_port, reconnect_finished, connection)) {
+        anjay_log(INFO, "reconnecting to %s:%s in the background",
+                  remote_host, remote_port);
+        schedule_connect_fallback(anjay, connection);
+        return ANJAY_CONNECTION_IN_PROGRESS;
+    }
+    int result = avs_net_socket_connect(connection->conn_priv_data_.socket,
+                                        remote_host, remote_port);
+    _anjay_dtls_session_handshake_finished(
+            connection->conn_priv_data_.dtls_session,
+            connection->conn_priv_data_.dtls_session_buffer,
+            connection->conn_priv_data_.socket, result);
+    if (result) {
         anjay_log(ERROR, "could not connect to %s:%s",
                   remote_host, remote_port);
+        _anjay_dns_cache_connect_failed(anjay, dns_entry);
         return -1;
     }
+    _anjay_dns_cache_connected(anjay, dns_entry,
+                               connection->conn_priv_data_.socket);
     anjay_log(INFO, "reconnected to %s:%s", remote_host, remote_port);
     return 0;
 }
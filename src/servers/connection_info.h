@@ -32,13 +32,56 @@ avs_net_abstract_socket_t *_anjay_connection_internal_get_socket(
 void
 _anjay_connection_internal_clean_socket(anjay_server_connection_t *connection);
 
-int
-_anjay_connection_internal_ensure_online(anjay_server_connection_t *connection);
+/**
+ * @returns Hash of the server URI and security configuration used to create
+ *          the socket, or 0 if there is no socket.
+ */
+uint32_t _anjay_connection_internal_config_hash(
+        const anjay_server_connection_t *connection);
+
+/**
+ * @returns true if the last background connection attempt failed, in which
+ *          case the socket shall only be reconnected by
+ *          @ref _anjay_server_refresh .
+ */
+bool _anjay_connection_internal_reconnect_failed(
+        const anjay_server_connection_t *connection);
+
+/**
+ * Returned by @ref _anjay_connection_internal_ensure_online,
+ * @ref _anjay_server_refresh and @ref _anjay_server_connect if the socket is
+ * being (re)connected in the background. The socket cannot be used until that
+ * finishes.
+ */
+#define ANJAY_CONNECTION_IN_PROGRESS 1
+
+int _anjay_connection_internal_ensure_online(
+        anjay_t *anjay,
+        anjay_server_connection_t *connection);
 
 int _anjay_server_refresh(anjay_t *anjay,
                           anjay_active_server_info_t *server,
                           bool force_reconnect);
 
+/**
+ * Creates the connections of @p server , which is being activated. Unlike
+ * @ref _anjay_server_refresh , secure connections are established in the
+ * background; the activation is then continued by
+ * @ref _anjay_server_activation_connected or abandoned by
+ * @ref _anjay_server_activation_failed .
+ */
+int _anjay_server_connect(anjay_t *anjay, anjay_active_server_info_t *server);
+
+/**
+ * Checks whether the configuration of a server flagged as needing a socket
+ * update differs from the one its socket has been created with.
+ *
+ * @returns false if the socket does not need to be re-created, true otherwise,
+ *          including when the configuration could not be read.
+ */
+bool _anjay_server_config_changed(anjay_t *anjay,
+                                  anjay_active_server_info_t *server);
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif // ANJAY_SERVERS_CONNECTION_INFO_H
@@ -17,12 +17,14 @@
 #include <config.h>
 
 #include <inttypes.h>
+#include <string.h>
 
 #include <anjay_modules/time.h>
 
 #include "../sched.h"
 #include "../anjay.h"
 #include "../servers.h"
+#include "../coap/stream.h"
 #include "../interface/register.h"
 
 #define ANJAY_SERVERS_INTERNALS
@@ -117,20 +119,38 @@ static int send_update_sched_job(anjay_t *anjay, void *args) {
     bool is_bootstrap = (server->ssid == ANJAY_SSID_BOOTSTRAP);
 
     int result = _anjay_server_refresh(anjay, server, reconnect_required);
+    if (result == ANJAY_CONNECTION_IN_PROGRESS) {
+        anjay_log(DEBUG, "SSID %" PRIu16 " is reconnecting, Update deferred",
+                  server->ssid);
+        // rescheduled when the connection is established, see
+        // connection_established() in connection_info.c; until then, the job
+        // is retried with backoff, which also reconnects again if the attempt
+        // fails
+        _anjay_get_server_connection((anjay_connection_ref_t) {
+            .server = server,
+            .conn_type = ANJAY_CONNECTION_UDP
+        })->update_after_connect = true;
+        return -1;
+    }
     if (!result && reconnect_required && is_bootstrap) {
         result = _anjay_bootstrap_update_reconnected(anjay);
     }
 
     if (!result && !is_bootstrap) {
         result = _anjay_server_update_or_reregister(anjay, server);
-        if (result == ANJAY_COAP_SOCKET_ERR_NETWORK) {
-            anjay_log(ERROR, "network communication error while updating "
-                             "registration for SSID==%" PRIu16, server->ssid);
+        if (result == ANJAY_COAP_SOCKET_ERR_NETWORK
+                || result == ANJAY_COAP_SOCKET_ERR_TIMEOUT) {
+            anjay_log(ERROR,
+                      "%s while updating registration for SSID==%" PRIu16,
+                      result == ANJAY_COAP_SOCKET_ERR_TIMEOUT
+                              ? "no response" : "network communication error",
+                      server->ssid);
             // We cannot use _anjay_schedule_server_reconnect(), because it
             // would mean an endless loop without backoff if the server is down.
             // Instead, we disconnect the socket and rely on scheduler's
             // backoff. During the next call, _anjay_server_refresh() will
-            // reconnect the socket.
+            // reconnect the socket - to another of the server's addresses if
+            // it did not respond.
             _anjay_connection_suspend((anjay_connection_ref_t) {
                 .server = server,
                 .conn_type = _anjay_get_default_connection_type(server)
@@ -166,9 +186,10 @@ schedule_update(anjay_t *anjay,
 
     void *update_args = send_update_args_encode(server->ssid, refresh);
 
-    return _anjay_sched_retryable(anjay->sched, out_handle, delay,
-                                  ANJAY_SERVER_RETRYABLE_BACKOFF,
-                                  send_update_sched_job, update_args);
+    return _anjay_sched_retryable_with_slack(
+            anjay->sched, out_handle, delay, _anjay_sched_default_slack(delay),
+            ANJAY_SERVER_RETRYABLE_BACKOFF, send_update_sched_job,
+            update_args);
 }
 
 static int
@@ -181,6 +202,17 @@ schedule_next_update(anjay_t *anjay,
             get_server_update_interval(&server->registration_info);
     _anjay_time_diff(&remaining, &remaining, &update_interval);
 
+    if (anjay->update_jitter_percent
+            && !_anjay_time_before(&remaining, &ANJAY_TIME_ZERO)) {
+        // clients registered at the same time, e.g. after a server outage,
+        // would otherwise keep sending Updates at the same time
+        uint64_t window_ms =
+                (uint64_t) _anjay_time_diff_ms(&remaining, &ANJAY_TIME_ZERO)
+                * anjay->update_jitter_percent / 100;
+        struct timespec jitter = _anjay_random_delay(anjay, window_ms);
+        _anjay_time_diff(&remaining, &remaining, &jitter);
+    }
+
     if (remaining.tv_sec < ANJAY_MIN_UPDATE_INTERVAL_S) {
         remaining = (struct timespec){ ANJAY_MIN_UPDATE_INTERVAL_S, 0 };
     }
@@ -189,6 +221,34 @@ schedule_next_update(anjay_t *anjay,
                            DONT_RECONNECT);
 }
 
+static void registration_established(anjay_t *anjay,
+                                     anjay_connection_ref_t connection) {
+    anjay_active_server_info_t *server = connection.server;
+    _anjay_sched_del(anjay->sched, &server->sched_update_handle);
+    if (schedule_next_update(anjay, &server->sched_update_handle, server)) {
+        anjay_log(WARNING, "could not schedule Update for server %u",
+                  server->ssid);
+    }
+
+    _anjay_observe_sched_flush(anjay, server->ssid, connection.conn_type);
+    _anjay_bootstrap_finish(anjay);
+}
+
+/**
+ * Lets the connection know whether the server has responded to a Register or
+ * Update, judging by its @p result . Local errors do not tell anything about
+ * the server, so they are ignored.
+ */
+static void register_exchange_finished(anjay_t *anjay,
+                                       anjay_connection_ref_t connection,
+                                       int result) {
+    if (!result || result == ANJAY_REGISTRATION_UPDATE_REJECTED) {
+        _anjay_connection_exchange_finished(anjay, connection, true);
+    } else if (result == ANJAY_COAP_SOCKET_ERR_TIMEOUT) {
+        _anjay_connection_exchange_finished(anjay, connection, false);
+    }
+}
+
 static int send_update(anjay_t *anjay,
                        anjay_active_server_info_t *server) {
     anjay_connection_ref_t connection = {
@@ -202,6 +262,7 @@ static int send_update(anjay_t *anjay,
     }
 
     int result = _anjay_update_registration(anjay, stream, server);
+    register_exchange_finished(anjay, connection, result);
     if (result == ANJAY_REGISTRATION_UPDATE_REJECTED) {
         anjay_log(DEBUG, "update rejected for SSID = %u; re-registering",
                   server->ssid);
@@ -245,8 +306,12 @@ static int reschedule_update_for_server(anjay_t *anjay,
                                         anjay_active_server_info_t *server,
                                         reconnect_required_t refresh) {
     _anjay_sched_del(anjay->sched, &server->sched_update_handle);
-    if (schedule_update(anjay, &server->sched_update_handle, server,
-                        ANJAY_TIME_ZERO, refresh)) {
+    struct timespec delay = ANJAY_TIME_ZERO;
+    if (refresh == DO_RECONNECT) {
+        delay = _anjay_random_delay(anjay, anjay->reconnect_jitter_ms);
+    }
+    if (schedule_update(anjay, &server->sched_update_handle, server, delay,
+                        refresh)) {
         anjay_log(ERROR, "could not schedule send_update_sched_job");
         return -1;
     }
@@ -324,18 +389,96 @@ int _anjay_server_register(anjay_t *anjay,
     avs_stream_reset(stream);
     _anjay_release_server_stream(anjay, connection);
 
+    register_exchange_finished(anjay, connection, result);
     if (result) {
         return -1;
     }
 
-    _anjay_sched_del(anjay->sched, &server->sched_update_handle);
-    if (schedule_next_update(anjay, &server->sched_update_handle, server)) {
-        anjay_log(WARNING, "could not schedule Update for server %u",
+    registration_established(anjay, connection);
+    return 0;
+}
+
+/**
+ * Sends a Register or, if @p update is true, an Update message to @p server
+ * using the asynchronous request API.
+ */
+static int send_async(anjay_t *anjay,
+                      anjay_active_server_info_t *server,
+                      bool update,
+                      anjay_register_async_t **out_async) {
+    anjay_connection_ref_t ref = {
+        .server = server,
+        .conn_type = _anjay_get_default_connection_type(server)
+    };
+    if (ref.conn_type != ANJAY_CONNECTION_UDP) {
+        return 1;
+    }
+
+    anjay_server_connection_t *connection = _anjay_get_server_connection(ref);
+    avs_net_abstract_socket_t *socket =
+            _anjay_connection_get_prepared_socket(anjay, server, connection);
+    if (!socket || (!update && _anjay_register_cache_refresh(anjay, true))) {
+        return -1;
+    }
+
+    const anjay_coap_async_request_config_t config = {
+        .socket = socket,
+        .tx_params = &_anjay_coap_DEFAULT_TX_PARAMS,
+        .rtt_estimator = _anjay_connection_rtt_estimator(connection),
+        .out_buffer_size = anjay->out_buffer_size,
+        .in_buffer_size = anjay->in_buffer_size,
+        .rand_seed = (anjay_rand_seed_t) _anjay_rand32(&anjay->rand_seed)
+    };
+    const anjay_coap_msg_identity_t identity =
+            _anjay_coap_stream_next_identity(anjay->comm_stream);
+    int result;
+    if (update) {
+        result = _anjay_update_async_send(out_async, anjay, server, &identity,
+                                          &config);
+    } else {
+        result = _anjay_register_async_send(out_async, anjay, server,
+                                            anjay->endpoint_name, &identity,
+                                            &config);
+    }
+    if (result < 0) {
+        _anjay_release_server_stream(anjay, ref);
+    }
+    return result;
+}
+
+int _anjay_server_register_async_start(anjay_t *anjay,
+                                       anjay_active_server_info_t *server,
+                                       anjay_register_async_t **out_async) {
+    return send_async(anjay, server, false, out_async);
+}
+
+int _anjay_server_register_async_finish(anjay_t *anjay,
+                                        anjay_active_server_info_t *server,
+                                        anjay_register_async_t **async_ptr) {
+    anjay_connection_ref_t connection = {
+        .server = server,
+        .conn_type = _anjay_get_default_connection_type(server)
+    };
+    bool update = _anjay_register_async_is_update(*async_ptr);
+    int result = _anjay_register_async_finish(async_ptr);
+    _anjay_release_server_stream(anjay, connection);
+    register_exchange_finished(anjay, connection, result);
+    if (result) {
+        if (!update) {
+            return -1;
+        }
+        anjay_log(INFO, "could not resume registration to server %" PRIu16,
                   server->ssid);
+        _anjay_registration_info_cleanup(&server->registration_info);
+        // Register would time out just as well if the server is unreachable
+        return result == ANJAY_COAP_SOCKET_ERR_TIMEOUT ? -1 : 1;
     }
 
-    _anjay_observe_sched_flush(anjay, server->ssid, connection.conn_type);
-    _anjay_bootstrap_finish(anjay);
+    if (update) {
+        anjay_log(INFO, "resumed registration to server %" PRIu16,
+                  server->ssid);
+    }
+    registration_established(anjay, connection);
     return 0;
 }
 
@@ -361,3 +504,222 @@ int _anjay_server_deregister(anjay_t *anjay,
     _anjay_release_server_stream_without_scheduling_queue(anjay);
     return result;
 }
+
+static uint32_t registration_config_hash(anjay_t *anjay,
+                                         anjay_active_server_info_t *server) {
+    uint32_t hash =
+            _anjay_connection_internal_config_hash(&server->udp_connection);
+    if (!hash) {
+        return 0;
+    }
+    return _anjay_fnv1a32(hash, anjay->endpoint_name,
+                          strlen(anjay->endpoint_name));
+}
+
+static uint32_t registration_payload_hash(anjay_t *anjay) {
+    size_t payload_size;
+    const void *payload =
+            _anjay_register_cache_get_payload(&anjay->register_cache,
+                                              &payload_size);
+    return _anjay_fnv1a32(ANJAY_FNV1A32_INITIAL, payload, payload_size);
+}
+
+static AVS_LIST(anjay_registration_state_t)
+detach_restored_registration(anjay_servers_t *servers, anjay_ssid_t ssid) {
+    AVS_LIST(anjay_registration_state_t) *state_ptr;
+    AVS_LIST_FOREACH_PTR(state_ptr, &servers->restored_registrations) {
+        if ((*state_ptr)->ssid == ssid) {
+            return AVS_LIST_DETACH(state_ptr);
+        }
+    }
+    return NULL;
+}
+
+static int adopt_registration_state(anjay_t *anjay,
+                                    anjay_active_server_info_t *server,
+                                    anjay_registration_state_t *state) {
+    if (state->config_hash != registration_config_hash(anjay, server)) {
+        anjay_log(INFO, "configuration of server %" PRIu16 " changed, "
+                  "not resuming its registration", server->ssid);
+        return -1;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    time_t remaining_s = state->expire_time - now.tv_sec;
+    if (remaining_s <= ANJAY_MIN_UPDATE_INTERVAL_S) {
+        anjay_log(INFO, "registration to server %" PRIu16 " expired",
+                  server->ssid);
+        return -1;
+    }
+
+    if (_anjay_register_cache_refresh(anjay, true)) {
+        return -1;
+    }
+
+    anjay_registration_info_t *info = &server->registration_info;
+    _anjay_registration_info_cleanup(info);
+    info->endpoint_path = state->endpoint_path;
+    state->endpoint_path = NULL;
+    clock_gettime(CLOCK_MONOTONIC, &info->expire_time);
+    info->expire_time.tv_sec += remaining_s;
+    info->last_update_params.lifetime_s = state->lifetime_s;
+    info->last_update_params.binding_mode = state->binding_mode;
+    // the payload is only included in the Update if the list of Objects and
+    // Instances differs from the one the server already knows
+    info->last_update_params.dm_version = anjay->register_cache.version;
+    if (!state->payload_hash
+            || state->payload_hash != registration_payload_hash(anjay)) {
+        --info->last_update_params.dm_version;
+    }
+    return 0;
+}
+
+int _anjay_server_resume_registration(anjay_t *anjay,
+                                      anjay_active_server_info_t *server,
+                                      anjay_register_async_t **out_async) {
+    AVS_LIST(anjay_registration_state_t) state =
+            detach_restored_registration(&anjay->servers, server->ssid);
+    if (!state) {
+        return -1;
+    }
+
+    int result = adopt_registration_state(anjay, server, state);
+    _anjay_registration_state_list_clear(&state);
+    if (result) {
+        return result;
+    }
+
+    result = send_async(anjay, server, true, out_async);
+    if (!result) {
+        // finished in _anjay_server_register_async_finish()
+        return 0;
+    }
+
+    anjay_connection_ref_t connection = {
+        .server = server,
+        .conn_type = _anjay_get_default_connection_type(server)
+    };
+    if (result > 0) {
+        avs_stream_abstract_t *stream =
+                _anjay_get_server_stream(anjay, connection);
+        if (!stream) {
+            result = -1;
+        } else {
+            result = _anjay_update_registration(anjay, stream, server);
+            avs_stream_reset(stream);
+            _anjay_release_server_stream(anjay, connection);
+        }
+    }
+
+    if (result) {
+        anjay_log(INFO, "could not resume registration to server %" PRIu16,
+                  server->ssid);
+        _anjay_registration_info_cleanup(&server->registration_info);
+        return -1;
+    }
+
+    anjay_log(INFO, "resumed registration to server %" PRIu16, server->ssid);
+    registration_established(anjay, connection);
+    return 0;
+}
+
+static int export_registration(anjay_t *anjay,
+                               anjay_active_server_info_t *server,
+                               const struct timespec *now,
+                               AVS_LIST(anjay_registration_state_t) *out) {
+    const anjay_registration_info_t *info = &server->registration_info;
+    struct timespec remaining = _anjay_register_time_remaining(info);
+    uint32_t config_hash = registration_config_hash(anjay, server);
+    if (!info->endpoint_path || !config_hash
+            || remaining.tv_sec <= ANJAY_MIN_UPDATE_INTERVAL_S) {
+        return 0;
+    }
+
+    AVS_LIST(anjay_registration_state_t) state =
+            AVS_LIST_NEW_ELEMENT(anjay_registration_state_t);
+    if (!state
+            || _anjay_copy_string_list(&state->endpoint_path,
+                                       info->endpoint_path)) {
+        anjay_log(ERROR, "out of memory");
+        AVS_LIST_DELETE(&state);
+        return -1;
+    }
+    state->ssid = server->ssid;
+    state->config_hash = config_hash;
+    // the current list is only known to be the one the server has seen if
+    // it has not changed since the last Register or Update
+    if (info->last_update_params.dm_version == anjay->register_cache.version) {
+        state->payload_hash = registration_payload_hash(anjay);
+    }
+    state->expire_time = now->tv_sec + remaining.tv_sec;
+    state->lifetime_s = info->last_update_params.lifetime_s;
+    state->binding_mode = info->last_update_params.binding_mode;
+    AVS_LIST_INSERT(out, state);
+    return 0;
+}
+
+static int export_restored_registration(
+        const anjay_registration_state_t *restored,
+        AVS_LIST(anjay_registration_state_t) *out) {
+    AVS_LIST(anjay_registration_state_t) state =
+            AVS_LIST_NEW_ELEMENT(anjay_registration_state_t);
+    if (!state) {
+        anjay_log(ERROR, "out of memory");
+        return -1;
+    }
+    *state = *restored;
+    state->endpoint_path = NULL;
+    if (_anjay_copy_string_list(&state->endpoint_path,
+                                restored->endpoint_path)) {
+        AVS_LIST_DELETE(&state);
+        return -1;
+    }
+    AVS_LIST_INSERT(out, state);
+    return 0;
+}
+
+int _anjay_registration_state_export(
+        anjay_t *anjay,
+        AVS_LIST(anjay_registration_state_t) *out_states) {
+    assert(!*out_states);
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    AVS_LIST(anjay_active_server_info_t) server;
+    AVS_LIST_FOREACH(server, anjay->servers.active) {
+        if (server->ssid != ANJAY_SSID_BOOTSTRAP
+                && export_registration(anjay, server, &now, out_states)) {
+            goto error;
+        }
+    }
+
+    AVS_LIST(anjay_registration_state_t) restored;
+    AVS_LIST_FOREACH(restored, anjay->servers.restored_registrations) {
+        if (!_anjay_servers_find_active(&anjay->servers, restored->ssid)
+                && export_restored_registration(restored, out_states)) {
+            goto error;
+        }
+    }
+    return 0;
+
+error:
+    _anjay_registration_state_list_clear(out_states);
+    return -1;
+}
+
+void _anjay_registration_state_import(
+        anjay_t *anjay,
+        AVS_LIST(anjay_registration_state_t) *states) {
+    _anjay_registration_state_list_clear(
+            &anjay->servers.restored_registrations);
+    anjay->servers.restored_registrations = *states;
+    *states = NULL;
+}
+
+void _anjay_registration_state_list_clear(
+        AVS_LIST(anjay_registration_state_t) *states) {
+    AVS_LIST_CLEAR(states) {
+        AVS_LIST_CLEAR(&(*states)->endpoint_path);
+    }
+}
@@ -28,6 +28,52 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 int _anjay_server_register(anjay_t *anjay,
                            anjay_active_server_info_t *server);
 
+/**
+ * Sends a Register message to @p server without waiting for the response, so
+ * that registering to multiple servers at once takes about as long as the
+ * slowest of the exchanges rather than the sum of all of them. The caller is
+ * responsible for driving the request returned in @p out_async and calling
+ * @ref _anjay_server_register_async_finish once it is no longer waiting.
+ *
+ * @returns 0 on success, a negative value in case of error, or a positive
+ *          value if the Register cannot be sent this way (e.g. because it
+ *          requires a BLOCK1 transfer) and @ref _anjay_server_register shall
+ *          be used instead.
+ */
+int _anjay_server_register_async_start(anjay_t *anjay,
+                                       anjay_active_server_info_t *server,
+                                       anjay_register_async_t **out_async);
+
+/**
+ * Processes the outcome of a Register sent using
+ * @ref _anjay_server_register_async_start , or an Update sent by
+ * @ref _anjay_server_resume_registration , and frees @p *async_ptr .
+ *
+ * @returns 0 if the registration succeeded or has been resumed, a positive
+ *          value if the resumed registration has been rejected and the server
+ *          needs to be registered to as usual, or a negative value otherwise.
+ */
+int _anjay_server_register_async_finish(anjay_t *anjay,
+                                        anjay_active_server_info_t *server,
+                                        anjay_register_async_t **async_ptr);
+
+/**
+ * Resumes the registration to @p server restored from persistent storage, if
+ * there is one that is still valid, by sending an Update instead of Register.
+ *
+ * Whenever possible, the Update is sent just like
+ * @ref _anjay_server_register_async_start sends Register: @p out_async is then
+ * set and the caller is responsible for calling
+ * @ref _anjay_server_register_async_finish once the request is no longer
+ * waiting. Otherwise, the Update is sent synchronously.
+ *
+ * @returns 0 if the Update has been sent or the registration resumed, or
+ *          a negative value if the server needs to be registered to as usual.
+ */
+int _anjay_server_resume_registration(anjay_t *anjay,
+                                      anjay_active_server_info_t *server,
+                                      anjay_register_async_t **out_async);
+
 int _anjay_server_update_or_reregister(anjay_t *anjay,
                                        anjay_active_server_info_t *server);
 
@@ -16,7 +16,12 @@
 
 #include <config.h>
 
+#include <inttypes.h>
+
+#include <anjay_modules/time.h>
+
 #include "../dm/query.h"
+#include "../dtls_session_cache.h"
 
 #define ANJAY_SERVERS_INTERNALS
 
@@ -68,6 +73,18 @@ static int reload_active_server(anjay_t *anjay,
     _anjay_servers_add_active(servers, server);
 
     if (server_needs_reconnect(server)) {
+        if (!_anjay_server_config_changed(anjay, server)) {
+            anjay_log(DEBUG, "configuration of server SSID %u did not change, "
+                      "keeping the connection", server->ssid);
+            server->udp_connection.needs_socket_update = false;
+            ++servers->reload_stats.unchanged;
+            return 0;
+        }
+
+        ++servers->reload_stats.reconnects;
+        // the cached session might have been established with credentials
+        // that are no longer valid
+        _anjay_dtls_session_invalidate(anjay, server->ssid);
         if (_anjay_server_refresh(anjay, server, false)) {
             return -1;
         }
@@ -149,10 +166,11 @@ static int reload_sockets_sched_job(anjay_t *anjay, void *unused);
 
 static void reschedule_reload_sockets_job(anjay_t *anjay,
                                           const long reload_delay_s) {
-    if (_anjay_sched(anjay->sched,
-                     &anjay->servers.reload_sockets_sched_job_handle,
-                     (struct timespec){.tv_sec = reload_delay_s },
-                     reload_sockets_sched_job, NULL)) {
+    const struct timespec delay = { .tv_sec = reload_delay_s };
+    if (_anjay_sched_with_slack(anjay->sched,
+                                &anjay->servers.reload_sockets_sched_job_handle,
+                                delay, _anjay_sched_default_slack(delay),
+                                reload_sockets_sched_job, NULL)) {
         anjay_log(ERROR, "could not re-schedule reload_sockets_job");
     }
 }
@@ -162,7 +180,15 @@ static int reload_sockets_sched_job(anjay_t *anjay, void *unused) {
     anjay_log(TRACE, "reloading sockets");
 
     static const long RELOAD_DELAY_S = 5;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
     anjay_servers_t reloaded_servers = _anjay_servers_create();
+    reloaded_servers.reload_stats = anjay->servers.reload_stats;
+    // not yet activated servers may still need them
+    reloaded_servers.restored_registrations =
+            anjay->servers.restored_registrations;
+    anjay->servers.restored_registrations = NULL;
     reload_server_sockets_state_t reload_state = {
         .old_servers = &anjay->servers,
         .new_servers = &reloaded_servers,
@@ -197,12 +223,28 @@ static int reload_sockets_sched_job(anjay_t *anjay, void *unused) {
         anjay->servers = reloaded_servers;
     }
 
-    anjay_log(TRACE, "sockets reloaded; %lu active, %lu inactive",
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ssize_t duration_ms = _anjay_time_diff_ms(&now, &start);
+    anjay_socket_reload_stats_t *stats = &anjay->servers.reload_stats;
+    ++stats->reloads;
+    stats->last_duration_ms = (int32_t) duration_ms;
+    stats->total_duration_ms += duration_ms;
+
+    anjay_log(TRACE, "sockets reloaded in %ld ms; %lu active, %lu inactive; "
+              "%" PRIu32 " reconnects, %" PRIu32 " unchanged so far",
+              (long) duration_ms,
               (unsigned long)AVS_LIST_SIZE(anjay->servers.active),
-              (unsigned long)AVS_LIST_SIZE(anjay->servers.inactive));
+              (unsigned long)AVS_LIST_SIZE(anjay->servers.inactive),
+              stats->reconnects, stats->unchanged);
     return 0;
 }
 
+void anjay_get_socket_reload_stats(anjay_t *anjay,
+                                   anjay_socket_reload_stats_t *out_stats) {
+    *out_stats = anjay->servers.reload_stats;
+}
+
 int _anjay_schedule_reload_sockets(anjay_t *anjay) {
     _anjay_sched_del(anjay->sched, &anjay->servers.reload_sockets_sched_job_handle);
     if (_anjay_sched_now(anjay->sched,
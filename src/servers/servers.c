@@ -40,6 +40,7 @@ static void connection_cleanup(anjay_t *anjay,
     _anjay_connection_internal_clean_socket(connection);
     _anjay_sched_del(anjay->sched,
                      &connection->queue_mode_close_socket_clb_handle);
+    _anjay_sched_del(anjay->sched, &connection->connect_fallback_clb_handle);
 }
 
 void _anjay_server_cleanup(anjay_t *anjay, anjay_active_server_info_t *server) {
@@ -72,10 +73,12 @@ void _anjay_servers_cleanup(anjay_t *anjay,
     _anjay_sched_del(anjay->sched, &servers->reload_sockets_sched_job_handle);
     active_servers_delete_and_deregister(anjay, &servers->active);
     AVS_LIST_CLEAR(&servers->inactive) {
+        _anjay_server_activation_cancel(anjay, servers->inactive);
         _anjay_sched_del(anjay->sched,
                          &servers->inactive->sched_reactivate_handle);
     }
     AVS_LIST_CLEAR(&servers->public_sockets);
+    _anjay_registration_state_list_clear(&servers->restored_registrations);
 }
 
 static bool
@@ -101,7 +104,17 @@ _anjay_connection_get_prepared_socket(anjay_t *anjay,
     if (!socket) {
         return NULL;
     }
-    if (_anjay_connection_internal_ensure_online(connection)) {
+    if (_anjay_connection_internal_reconnect_failed(connection)) {
+        anjay_log(DEBUG, "waiting for the Update job to reconnect to server "
+                         "%" PRIu16, server->ssid);
+        return NULL;
+    }
+    int result = _anjay_connection_internal_ensure_online(anjay, connection);
+    if (result == ANJAY_CONNECTION_IN_PROGRESS) {
+        anjay_log(DEBUG, "connection to server %" PRIu16 " is being "
+                         "established", server->ssid);
+        return NULL;
+    } else if (result) {
         anjay_log(ERROR, "broken socket for server %" PRIu16, server->ssid);
         if (_anjay_schedule_server_reconnect(anjay, server)) {
             anjay_log(ERROR, "could not schedule reconnect for server %" PRIu16,
@@ -128,31 +141,20 @@ get_online_connection_socket(anjay_t *anjay,
     return NULL;
 }
 
-static int
-add_socket_onto_list(AVS_LIST(avs_net_abstract_socket_t *const) *tail_ptr,
-                     avs_net_abstract_socket_t *socket) {
-    AVS_LIST_INSERT_NEW(avs_net_abstract_socket_t *const, tail_ptr);
-    if (!*tail_ptr) {
-        anjay_log(ERROR, "Out of memory while building socket list");
-        return -1;
-    }
-    *(avs_net_abstract_socket_t **) (intptr_t) *tail_ptr = socket;
-    return 0;
-}
-
-AVS_LIST(avs_net_abstract_socket_t *const) anjay_get_sockets(anjay_t *anjay) {
-    AVS_LIST_CLEAR(&anjay->servers.public_sockets);
-    AVS_LIST(avs_net_abstract_socket_t *const) *tail_ptr =
-            &anjay->servers.public_sockets;
-
+int _anjay_servers_foreach_online_socket(anjay_t *anjay,
+                                         anjay_servers_socket_visitor_t *visitor,
+                                         void *arg) {
     bool sms_active = false;
     anjay_active_server_info_t *server;
     AVS_LIST_FOREACH(server, anjay->servers.active) {
         avs_net_abstract_socket_t *udp_socket =
                 get_online_connection_socket(anjay, server,
                                              ANJAY_CONNECTION_UDP);
-        if (udp_socket && !add_socket_onto_list(tail_ptr, udp_socket)) {
-            tail_ptr = AVS_LIST_NEXT_PTR(tail_ptr);
+        int result;
+        if (udp_socket
+                && (result = visitor(anjay, arg, udp_socket,
+                                     server->udp_connection.socket_generation))) {
+            return result;
         }
 
         if (get_online_connection_socket(anjay, server, ANJAY_CONNECTION_SMS)) {
@@ -160,10 +162,62 @@ AVS_LIST(avs_net_abstract_socket_t *const) anjay_get_sockets(anjay_t *anjay) {
         }
     }
 
+    anjay_inactive_server_info_t *inactive_server;
+    AVS_LIST_FOREACH(inactive_server, anjay->servers.inactive) {
+        int result;
+        if (inactive_server->register_async
+                && (result = visitor(
+                        anjay, arg,
+                        _anjay_coap_async_request_socket(
+                                _anjay_register_async_request(
+                                        inactive_server->register_async)),
+                        inactive_server->activating
+                                ->udp_connection.socket_generation))) {
+            return result;
+        }
+    }
+
     if (sms_active) {
         assert(_anjay_sms_router(anjay));
-        add_socket_onto_list(tail_ptr, _anjay_sms_poll_socket(anjay));
+        int result = visitor(anjay, arg, _anjay_sms_poll_socket(anjay), 0);
+        if (result) {
+            return result;
+        }
     }
+
+    avs_net_abstract_socket_t *connect_wakeup_socket =
+            _anjay_async_connect_wakeup_socket(anjay);
+    if (connect_wakeup_socket) {
+        return visitor(anjay, arg, connect_wakeup_socket, 0);
+    }
+    return 0;
+}
+
+static int
+add_socket_onto_list(anjay_t *anjay,
+                     void *tail_ptr_,
+                     avs_net_abstract_socket_t *socket,
+                     uint32_t socket_generation) {
+    (void) socket_generation;
+    AVS_LIST(avs_net_abstract_socket_t *const) **tail_ptr =
+            (AVS_LIST(avs_net_abstract_socket_t *const) **) tail_ptr_;
+    AVS_LIST_INSERT_NEW(avs_net_abstract_socket_t *const, *tail_ptr);
+    if (!**tail_ptr) {
+        anjay_log(ERROR, "Out of memory while building socket list");
+        // not a failure, continue with the remaining sockets
+        return 0;
+    }
+    *(avs_net_abstract_socket_t **) (intptr_t) **tail_ptr = socket;
+    *tail_ptr = AVS_LIST_NEXT_PTR(*tail_ptr);
+    return 0;
+}
+
+AVS_LIST(avs_net_abstract_socket_t *const) anjay_get_sockets(anjay_t *anjay) {
+    AVS_LIST_CLEAR(&anjay->servers.public_sockets);
+    AVS_LIST(avs_net_abstract_socket_t *const) *tail_ptr =
+            &anjay->servers.public_sockets;
+    _anjay_servers_foreach_online_socket(anjay, add_socket_onto_list,
+                                         &tail_ptr);
     return anjay->servers.public_sockets;
 }
 
@@ -288,3 +342,33 @@ int anjay_disable_server(anjay_t *anjay,
     }
     return 0;
 }
+
+int anjay_get_server_rtt_stats(anjay_t *anjay,
+                               anjay_ssid_t ssid,
+                               anjay_server_rtt_stats_t *out_stats) {
+    anjay_active_server_info_t *server =
+            _anjay_servers_find_active(&anjay->servers, ssid);
+    if (!server) {
+        anjay_log(DEBUG, "no active server with SSID = %u", ssid);
+        return -1;
+    }
+    const coap_rtt_estimator_t *estimator =
+            _anjay_connection_rtt_estimator(&server->udp_connection);
+    if (!estimator) {
+        anjay_log(DEBUG, "server SSID = %u does not use CoAP retransmissions",
+                  ssid);
+        return -1;
+    }
+
+    *out_stats = (anjay_server_rtt_stats_t) {
+        .strong_samples = estimator->strong.samples,
+        .strong_srtt_ms = estimator->strong.srtt_ms,
+        .strong_rttvar_ms = estimator->strong.rttvar_ms,
+        .weak_samples = estimator->weak.samples,
+        .weak_srtt_ms = estimator->weak.srtt_ms,
+        .weak_rttvar_ms = estimator->weak.rttvar_ms,
+        .rto_ms = _anjay_coap_rtt_current_rto_ms(
+                estimator, &_anjay_coap_DEFAULT_TX_PARAMS)
+    };
+    return 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <limits.h>
+#include <poll.h>
+
+#include <avsystem/commons/unit/mocksock.h>
+#include <avsystem/commons/unit/test.h>
+
+static void store_result(anjay_t *anjay, void *out_result, int result) {
+    (void) anjay;
+    *(int *) out_result = result;
+}
+
+static void wait_for_wakeup(anjay_t *anjay) {
+    avs_net_abstract_socket_t *wakeup =
+            _anjay_async_connect_wakeup_socket(anjay);
+    AVS_UNIT_ASSERT_NOT_NULL(wakeup);
+    struct pollfd poll_fd = {
+        .fd = *(const int *) avs_net_socket_get_system(wakeup),
+        .events = POLLIN
+    };
+    AVS_UNIT_ASSERT_EQUAL(poll(&poll_fd, 1, 5000), 1);
+}
+
+AVS_UNIT_TEST(async_connect, connect_in_background) {
+    anjay_t *anjay = (anjay_t *) calloc(1, sizeof(anjay_t));
+    AVS_UNIT_ASSERT_NULL(_anjay_async_connect_wakeup_socket(anjay));
+
+    avs_net_abstract_socket_t *mocksock = NULL;
+    avs_unit_mocksock_create(&mocksock);
+    avs_unit_mocksock_expect_connect(mocksock, "example.com", "5684");
+
+    int result = INT_MIN;
+    anjay_async_connect_task_t *task = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_async_connect_start(
+            anjay, &task, mocksock, "example.com", "5684", store_result,
+            &result));
+    AVS_UNIT_ASSERT_NOT_NULL(task);
+
+    wait_for_wakeup(anjay);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(
+            anjay, _anjay_async_connect_wakeup_socket(anjay)));
+    AVS_UNIT_ASSERT_EQUAL(result, 0);
+    // no more attempts in progress
+    AVS_UNIT_ASSERT_NULL(_anjay_async_connect_wakeup_socket(anjay));
+
+    avs_unit_mocksock_assert_expects_met(mocksock);
+    avs_net_socket_cleanup(&mocksock);
+    _anjay_async_connect_cleanup(&anjay->async_connect);
+    free(anjay);
+}
+
+AVS_UNIT_TEST(async_connect, cancel) {
+    anjay_t *anjay = (anjay_t *) calloc(1, sizeof(anjay_t));
+
+    avs_net_abstract_socket_t *mocksock = NULL;
+    avs_unit_mocksock_create(&mocksock);
+    avs_unit_mocksock_expect_connect(mocksock, "example.com", "5684");
+
+    int result = INT_MIN;
+    anjay_async_connect_task_t *task = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_async_connect_start(
+            anjay, &task, mocksock, "example.com", "5684", store_result,
+            &result));
+    // leaks of the socket data would be reported by valgrind
+    _anjay_async_connect_cancel(&task, malloc(16));
+    AVS_UNIT_ASSERT_NULL(task);
+
+    wait_for_wakeup(anjay);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_async_connect_process(anjay));
+    // the callback is not called and the socket is cleaned up by the task,
+    // along with its data
+    AVS_UNIT_ASSERT_EQUAL(result, INT_MIN);
+    AVS_UNIT_ASSERT_NULL(_anjay_async_connect_wakeup_socket(anjay));
+
+    _anjay_async_connect_cleanup(&anjay->async_connect);
+    free(anjay);
+}
@@ -739,6 +739,24 @@ AVS_UNIT_TEST(dm_execute, error) {
     DM_TEST_FINISH;
 }
 
+AVS_UNIT_TEST(dm_execute, positive_result) {
+    DM_TEST_INIT;
+    static const char REQUEST[] =
+            "\x40\x02\xFA\x3E" // CoAP header
+            "\xB2" "42" // OID
+            "\x03" "514" // IID
+            "\x01" "4"; // RID
+    avs_unit_mocksock_input(mocksocks[0], REQUEST, sizeof(REQUEST) - 1);
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ, 514, 1);
+    _anjay_mock_dm_expect_resource_present(anjay, &OBJ, 514, 4, 1);
+    _anjay_mock_dm_expect_resource_execute(anjay, &OBJ, 514, 4,
+                                           ANJAY_MOCK_DM_NONE, 1);
+    // not mistaken for a deferred response
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], "\x60\xA0\xFA\x3E");
+    AVS_UNIT_ASSERT_FAILED(anjay_serve(anjay, mocksocks[0]));
+    DM_TEST_FINISH;
+}
+
 AVS_UNIT_TEST(dm_execute, resource_out_of_bounds) {
     DM_TEST_INIT;
     static const char REQUEST[] =
@@ -2409,3 +2427,178 @@ AVS_UNIT_TEST(dm_res_read, no_space) {
 
     DM_TEST_FINISH;
 }
+
+static anjay_execute_deferred_t *DEFERRED_EXECUTE;
+
+static int deferred_execute(anjay_t *anjay,
+                            const anjay_dm_object_def_t *const *obj_ptr,
+                            anjay_iid_t iid,
+                            anjay_rid_t rid,
+                            anjay_execute_ctx_t *ctx) {
+    (void)iid; (void)rid; (void)anjay; (void)obj_ptr;
+    DEFERRED_EXECUTE = anjay_execute_defer(ctx);
+    AVS_UNIT_ASSERT_NOT_NULL(DEFERRED_EXECUTE);
+    AVS_UNIT_ASSERT_NULL(anjay_execute_defer(ctx));
+    return 0;
+}
+
+AVS_UNIT_TEST(dm_execute, deferred) {
+    DM_TEST_INIT;
+    static const char REQUEST[] =
+            "\x41\x02\xFA\x3E" // CoAP header
+            "\x42" // token
+            "\xB3" "128" // OID
+            "\x03" "514" // IID
+            "\x01" "1"; // RID
+
+    EXECUTE_OBJ->handlers.resource_execute = deferred_execute;
+    avs_unit_mocksock_input(mocksocks[0], REQUEST, sizeof(REQUEST) - 1);
+    _anjay_mock_dm_expect_instance_present(anjay,
+        (const anjay_dm_object_def_t *const *) &EXECUTE_OBJ, 514, 1);
+    _anjay_mock_dm_expect_resource_present(anjay,
+        (const anjay_dm_object_def_t *const *) &EXECUTE_OBJ, 514, 1, 1);
+
+    // empty ACK
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], "\x60\x00\xFA\x3E");
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    avs_unit_mocksock_assert_expects_met(mocksocks[0]);
+
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_execute_deferred_complete(anjay, DEFERRED_EXECUTE, 0));
+
+    // separate response, with the token of the request
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], "\x41\x44\x69\xED\x42");
+    avs_unit_mocksock_input(mocksocks[0], "\x60\x00\x69\xED", 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    AVS_UNIT_ASSERT_NULL(anjay->execute_deferred);
+    DM_TEST_FINISH;
+}
+
+static int deferred_execute_error(anjay_t *anjay,
+                                  const anjay_dm_object_def_t *const *obj_ptr,
+                                  anjay_iid_t iid,
+                                  anjay_rid_t rid,
+                                  anjay_execute_ctx_t *ctx) {
+    (void)iid; (void)rid; (void)anjay; (void)obj_ptr;
+    DEFERRED_EXECUTE = anjay_execute_defer(ctx);
+    AVS_UNIT_ASSERT_NOT_NULL(DEFERRED_EXECUTE);
+    return ANJAY_ERR_CONFLICT;
+}
+
+AVS_UNIT_TEST(dm_execute, deferred_error) {
+    DM_TEST_INIT;
+    static const char REQUEST[] =
+            "\x40\x02\xFA\x3E" // CoAP header
+            "\xB3" "128" // OID
+            "\x03" "514" // IID
+            "\x01" "1"; // RID
+
+    EXECUTE_OBJ->handlers.resource_execute = deferred_execute_error;
+    avs_unit_mocksock_input(mocksocks[0], REQUEST, sizeof(REQUEST) - 1);
+    _anjay_mock_dm_expect_instance_present(anjay,
+        (const anjay_dm_object_def_t *const *) &EXECUTE_OBJ, 514, 1);
+    _anjay_mock_dm_expect_resource_present(anjay,
+        (const anjay_dm_object_def_t *const *) &EXECUTE_OBJ, 514, 1, 1);
+
+    // the error is reported immediately, completion sends nothing
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], "\x60\x89\xFA\x3E");
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_execute_deferred_complete(anjay, DEFERRED_EXECUTE, 0));
+    AVS_UNIT_ASSERT_NULL(anjay->execute_deferred);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    DM_TEST_FINISH;
+}
+
+static anjay_read_deferred_t *DEFERRED_READ;
+
+static int deferred_read(anjay_t *anjay,
+                         const anjay_dm_object_def_t *const *obj_ptr,
+                         anjay_iid_t iid,
+                         anjay_rid_t rid,
+                         anjay_output_ctx_t *ctx) {
+    (void)iid; (void)rid; (void)obj_ptr;
+    if (!DEFERRED_READ) {
+        DEFERRED_READ = anjay_read_defer(anjay, ctx);
+        AVS_UNIT_ASSERT_NOT_NULL(DEFERRED_READ);
+        return ANJAY_READ_DEFERRED;
+    }
+    return anjay_ret_i32(ctx, 514);
+}
+
+AVS_UNIT_TEST(dm_read, deferred) {
+    DM_TEST_INIT;
+    static const char REQUEST[] =
+            "\x40\x01\xFA\x3E" // CoAP header
+            "\xB3" "128" // OID
+            "\x03" "514" // IID
+            "\x01" "1"; // RID
+
+    anjay_dm_resource_read_t *const original_read =
+            EXECUTE_OBJ->handlers.resource_read;
+    EXECUTE_OBJ->handlers.resource_read = deferred_read;
+    DEFERRED_READ = NULL;
+    avs_unit_mocksock_input(mocksocks[0], REQUEST, sizeof(REQUEST) - 1);
+    _anjay_mock_dm_expect_instance_present(anjay,
+        (const anjay_dm_object_def_t *const *) &EXECUTE_OBJ, 514, 1);
+    _anjay_mock_dm_expect_resource_present(anjay,
+        (const anjay_dm_object_def_t *const *) &EXECUTE_OBJ, 514, 1, 1);
+
+    // empty ACK
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], "\x60\x00\xFA\x3E");
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    avs_unit_mocksock_assert_expects_met(mocksocks[0]);
+    AVS_UNIT_ASSERT_NOT_NULL(DEFERRED_READ);
+
+    // Read is performed again after completion
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_read_deferred_complete(anjay, DEFERRED_READ, 0));
+    _anjay_mock_dm_expect_instance_present(anjay,
+        (const anjay_dm_object_def_t *const *) &EXECUTE_OBJ, 514, 1);
+    _anjay_mock_dm_expect_resource_present(anjay,
+        (const anjay_dm_object_def_t *const *) &EXECUTE_OBJ, 514, 1, 1);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0],
+            "\x40\x45\x69\xED" // CoAP header
+            "\xc0" // Content-Format
+            "\xff" "514");
+    avs_unit_mocksock_input(mocksocks[0], "\x60\x00\x69\xED", 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    AVS_UNIT_ASSERT_NULL(anjay->read_deferred);
+
+    EXECUTE_OBJ->handlers.resource_read = original_read;
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(dm_read, deferred_error) {
+    DM_TEST_INIT;
+    static const char REQUEST[] =
+            "\x50\x01\xFA\x3E" // CoAP header (Non-confirmable)
+            "\xB3" "128" // OID
+            "\x03" "514" // IID
+            "\x01" "1"; // RID
+
+    anjay_dm_resource_read_t *const original_read =
+            EXECUTE_OBJ->handlers.resource_read;
+    EXECUTE_OBJ->handlers.resource_read = deferred_read;
+    DEFERRED_READ = NULL;
+    avs_unit_mocksock_input(mocksocks[0], REQUEST, sizeof(REQUEST) - 1);
+    _anjay_mock_dm_expect_instance_present(anjay,
+        (const anjay_dm_object_def_t *const *) &EXECUTE_OBJ, 514, 1);
+    _anjay_mock_dm_expect_resource_present(anjay,
+        (const anjay_dm_object_def_t *const *) &EXECUTE_OBJ, 514, 1, 1);
+
+    // nothing is sent until completion
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    AVS_UNIT_ASSERT_NOT_NULL(DEFERRED_READ);
+
+    // error is reported without calling the handler again
+    AVS_UNIT_ASSERT_SUCCESS(anjay_read_deferred_complete(
+            anjay, DEFERRED_READ, ANJAY_ERR_SERVICE_UNAVAILABLE));
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], "\x50\xA3\x69\xED");
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    AVS_UNIT_ASSERT_NULL(anjay->read_deferred);
+
+    EXECUTE_OBJ->handlers.resource_read = original_read;
+    DM_TEST_FINISH;
+}
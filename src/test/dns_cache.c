@@ -0,0 +1,237 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <avsystem/commons/unit/mocksock.h>
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay_test/mock_clock.h>
+
+static void init_fake_anjay(anjay_t *anjay, time_t ttl_s) {
+    memset(anjay, 0, sizeof(*anjay));
+    anjay->dns_cache.ttl_s = ttl_s;
+}
+
+static void lookup(anjay_t *anjay,
+                   anjay_dns_cache_entry_t *entry,
+                   bool may_resolve,
+                   char (*out_host)[ANJAY_MAX_URL_HOSTNAME_SIZE]) {
+    _anjay_dns_cache_lookup(anjay, entry, AVS_NET_UDP_SOCKET, may_resolve,
+                            *out_host, sizeof(*out_host));
+}
+
+AVS_UNIT_TEST(dns_cache, disabled) {
+    anjay_t anjay;
+    init_fake_anjay(&anjay, 0);
+    AVS_UNIT_ASSERT_NULL(_anjay_dns_cache_get(&anjay, 1, "127.0.0.1", "5683"));
+    anjay_dns_cache_stats_t stats;
+    AVS_UNIT_ASSERT_FAILED(anjay_get_dns_cache_stats(&anjay, &stats));
+}
+
+AVS_UNIT_TEST(dns_cache, get) {
+    anjay_t anjay;
+    init_fake_anjay(&anjay, 60);
+
+    anjay_dns_cache_entry_t *entry2 =
+            _anjay_dns_cache_get(&anjay, 2, "127.0.0.1", "5683");
+    AVS_UNIT_ASSERT_NOT_NULL(entry2);
+    anjay_dns_cache_entry_t *entry1 =
+            _anjay_dns_cache_get(&anjay, 1, "127.0.0.1", "5683");
+    AVS_UNIT_ASSERT_NOT_NULL(entry1);
+    AVS_UNIT_ASSERT_TRUE(entry1 != entry2);
+    AVS_UNIT_ASSERT_TRUE(anjay.dns_cache.entries == entry1);
+
+    char host[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    lookup(&anjay, entry1, true, &host);
+    AVS_UNIT_ASSERT_EQUAL(entry1->address_count, 1);
+
+    // the same entry is reused for the same server
+    AVS_UNIT_ASSERT_TRUE(
+            _anjay_dns_cache_get(&anjay, 1, "127.0.0.1", "5683") == entry1);
+    AVS_UNIT_ASSERT_EQUAL(entry1->address_count, 1);
+
+    // ...but the addresses are discarded if the server moves
+    AVS_UNIT_ASSERT_TRUE(
+            _anjay_dns_cache_get(&anjay, 1, "127.0.0.1", "5684") == entry1);
+    AVS_UNIT_ASSERT_EQUAL(entry1->address_count, 0);
+    AVS_UNIT_ASSERT_EQUAL_STRING(_anjay_dns_cache_port(entry1), "5684");
+
+    _anjay_dns_cache_cleanup(&anjay.dns_cache);
+    AVS_UNIT_ASSERT_NULL(anjay.dns_cache.entries);
+}
+
+AVS_UNIT_TEST(dns_cache, lookup_and_expire) {
+    _anjay_mock_clock_start(&(const struct timespec) { 1000, 0 });
+    anjay_t anjay;
+    init_fake_anjay(&anjay, 60);
+    anjay_dns_cache_entry_t *entry =
+            _anjay_dns_cache_get(&anjay, 1, "127.0.0.1", "5683");
+    AVS_UNIT_ASSERT_NOT_NULL(entry);
+
+    char host[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    // the socket resolves the hostname itself if resolving is not allowed
+    lookup(&anjay, entry, false, &host);
+    AVS_UNIT_ASSERT_EQUAL_STRING(host, "127.0.0.1");
+    AVS_UNIT_ASSERT_EQUAL(entry->address_count, 0);
+
+    lookup(&anjay, entry, true, &host);
+    AVS_UNIT_ASSERT_EQUAL_STRING(host, "127.0.0.1");
+    AVS_UNIT_ASSERT_EQUAL(entry->address_count, 1);
+
+    _anjay_mock_clock_advance(&(const struct timespec) { 59, 0 });
+    lookup(&anjay, entry, false, &host);
+    AVS_UNIT_ASSERT_EQUAL_STRING(host, "127.0.0.1");
+
+    anjay_dns_cache_stats_t stats;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_dns_cache_stats(&anjay, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.hits, 1);
+    AVS_UNIT_ASSERT_EQUAL(stats.misses, 2);
+
+    _anjay_mock_clock_advance(&(const struct timespec) { 1, 0 });
+    lookup(&anjay, entry, false, &host);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_dns_cache_stats(&anjay, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.hits, 1);
+    AVS_UNIT_ASSERT_EQUAL(stats.misses, 3);
+
+    _anjay_dns_cache_cleanup(&anjay.dns_cache);
+    _anjay_mock_clock_finish();
+}
+
+AVS_UNIT_TEST(dns_cache, failover) {
+    anjay_t anjay;
+    init_fake_anjay(&anjay, 60);
+    anjay_dns_cache_entry_t *entry =
+            _anjay_dns_cache_get(&anjay, 1, "example.invalid", "5683");
+    AVS_UNIT_ASSERT_NOT_NULL(entry);
+
+    // simulate a hostname resolved to two addresses
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    strcpy(entry->addresses[0], "192.0.2.1");
+    strcpy(entry->addresses[1], "2001:db8::1");
+    entry->address_count = 2;
+    set_expire_time(&anjay, entry, &now);
+
+    char host[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    lookup(&anjay, entry, false, &host);
+    AVS_UNIT_ASSERT_EQUAL_STRING(host, "192.0.2.1");
+
+    _anjay_dns_cache_connect_failed(&anjay, entry);
+    lookup(&anjay, entry, false, &host);
+    AVS_UNIT_ASSERT_EQUAL_STRING(host, "2001:db8::1");
+
+    // all addresses failed, so the hostname needs to be resolved again
+    _anjay_dns_cache_connect_failed(&anjay, entry);
+    lookup(&anjay, entry, false, &host);
+    AVS_UNIT_ASSERT_EQUAL_STRING(host, "example.invalid");
+
+    anjay_dns_cache_stats_t stats;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_dns_cache_stats(&anjay, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.hits, 2);
+    AVS_UNIT_ASSERT_EQUAL(stats.misses, 1);
+    AVS_UNIT_ASSERT_EQUAL(stats.failovers, 2);
+
+    _anjay_dns_cache_cleanup(&anjay.dns_cache);
+}
+
+#if ANJAY_DNS_CACHE_MAX_ADDRESSES >= 3
+static anjay_dns_cache_entry_t *setup_dual_stack_entry(anjay_t *anjay) {
+    init_fake_anjay(anjay, 60);
+    anjay_dns_cache_entry_t *entry =
+            _anjay_dns_cache_get(anjay, 1, "example.invalid", "5684");
+    AVS_UNIT_ASSERT_NOT_NULL(entry);
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    strcpy(entry->addresses[0], "2001:db8::1");
+    strcpy(entry->addresses[1], "2001:db8::2");
+    strcpy(entry->addresses[2], "192.0.2.1");
+    entry->address_count = 3;
+    set_expire_time(anjay, entry, &now);
+    return entry;
+}
+
+AVS_UNIT_TEST(dns_cache, interleave_families) {
+    anjay_t anjay;
+    anjay_dns_cache_entry_t *entry = setup_dual_stack_entry(&anjay);
+
+    interleave_families(entry, AVS_NET_AF_INET6);
+    AVS_UNIT_ASSERT_EQUAL_STRING(entry->addresses[0], "2001:db8::1");
+    AVS_UNIT_ASSERT_EQUAL_STRING(entry->addresses[1], "192.0.2.1");
+    AVS_UNIT_ASSERT_EQUAL_STRING(entry->addresses[2], "2001:db8::2");
+
+    interleave_families(entry, AVS_NET_AF_INET4);
+    AVS_UNIT_ASSERT_EQUAL_STRING(entry->addresses[0], "192.0.2.1");
+    AVS_UNIT_ASSERT_EQUAL_STRING(entry->addresses[1], "2001:db8::1");
+    AVS_UNIT_ASSERT_EQUAL_STRING(entry->addresses[2], "2001:db8::2");
+
+    _anjay_dns_cache_cleanup(&anjay.dns_cache);
+}
+
+AVS_UNIT_TEST(dns_cache, fallback_to_other_family) {
+    anjay_t anjay;
+    anjay_dns_cache_entry_t *entry = setup_dual_stack_entry(&anjay);
+    interleave_families(entry, AVS_NET_AF_INET6);
+
+    char host[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    lookup(&anjay, entry, false, &host);
+    AVS_UNIT_ASSERT_EQUAL_STRING(host, "2001:db8::1");
+    AVS_UNIT_ASSERT_TRUE(_anjay_dns_cache_fallback(entry, host, sizeof(host)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(host, "192.0.2.1");
+
+    // the IPv4 attempt won the race
+    avs_net_abstract_socket_t *mocksock = NULL;
+    avs_unit_mocksock_create(&mocksock);
+    avs_unit_mocksock_expect_remote_host(mocksock, "192.0.2.1");
+    _anjay_dns_cache_connected(&anjay, entry, mocksock);
+    // connecting a UDP socket does not prove that the server is reachable
+    AVS_UNIT_ASSERT_EQUAL(entry->preferred_family, AVS_NET_AF_UNSPEC);
+    _anjay_dns_cache_responded(&anjay, entry);
+    AVS_UNIT_ASSERT_EQUAL(entry->preferred_family, AVS_NET_AF_INET4);
+    lookup(&anjay, entry, false, &host);
+    AVS_UNIT_ASSERT_EQUAL_STRING(host, "192.0.2.1");
+
+    AVS_UNIT_ASSERT_TRUE(_anjay_dns_cache_fallback(entry, host, sizeof(host)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(host, "2001:db8::2");
+
+    // switching back to IPv6 after the server stops responding over IPv4 is
+    // counted
+    _anjay_dns_cache_connect_failed(&anjay, entry);
+    avs_unit_mocksock_expect_remote_host(mocksock, "2001:db8::2");
+    _anjay_dns_cache_connected(&anjay, entry, mocksock);
+    AVS_UNIT_ASSERT_EQUAL(entry->preferred_family, AVS_NET_AF_INET4);
+    _anjay_dns_cache_responded(&anjay, entry);
+    AVS_UNIT_ASSERT_EQUAL(entry->preferred_family, AVS_NET_AF_INET6);
+    _anjay_dns_cache_responded(NULL, NULL);
+
+    // there are no more IPv4 addresses after the current one
+    AVS_UNIT_ASSERT_FALSE(
+            _anjay_dns_cache_fallback(entry, host, sizeof(host)));
+    AVS_UNIT_ASSERT_FALSE(_anjay_dns_cache_fallback(NULL, host, sizeof(host)));
+
+    anjay_dns_cache_stats_t stats;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_dns_cache_stats(&anjay, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.family_switches, 1);
+
+    // the remembered family is forgotten when the server moves
+    _anjay_dns_cache_get(&anjay, 1, "example.invalid", "5683");
+    AVS_UNIT_ASSERT_EQUAL(entry->preferred_family, AVS_NET_AF_UNSPEC);
+
+    avs_unit_mocksock_assert_expects_met(mocksock);
+    avs_net_socket_cleanup(&mocksock);
+    _anjay_dns_cache_cleanup(&anjay.dns_cache);
+}
+#endif // ANJAY_DNS_CACHE_MAX_ADDRESSES >= 3
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <avsystem/commons/unit/mocksock.h>
+#include <avsystem/commons/unit/test.h>
+
+static bool buffer_empty(const anjay_dtls_session_t *session) {
+    for (size_t i = 0; i < sizeof(session->buffer); ++i) {
+        if (session->buffer[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+AVS_UNIT_TEST(dtls_session_cache, get) {
+    anjay_dtls_session_cache_t cache = { NULL };
+
+    anjay_dtls_session_t *session2 = get_session(&cache, 2, "host", "5684", 0);
+    AVS_UNIT_ASSERT_NOT_NULL(session2);
+    anjay_dtls_session_t *session1 = get_session(&cache, 1, "host", "5684", 0);
+    AVS_UNIT_ASSERT_NOT_NULL(session1);
+    AVS_UNIT_ASSERT_TRUE(session1 != session2);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(cache.sessions), 2);
+    AVS_UNIT_ASSERT_TRUE(cache.sessions == session1);
+
+    AVS_UNIT_ASSERT_TRUE(find_session(&cache, 2) == session2);
+    AVS_UNIT_ASSERT_NULL(find_session(&cache, 3));
+
+    // the same entry is reused for the same server
+    memset(session1->buffer, 0x42, sizeof(session1->buffer));
+    AVS_UNIT_ASSERT_TRUE(get_session(&cache, 1, "host", "5684", 0) == session1);
+    AVS_UNIT_ASSERT_FALSE(buffer_empty(session1));
+
+    // ...but its state is discarded if the server moves
+    AVS_UNIT_ASSERT_TRUE(get_session(&cache, 1, "host", "5685", 0) == session1);
+    AVS_UNIT_ASSERT_TRUE(buffer_empty(session1));
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(cache.sessions), 2);
+
+    // ...or if the credentials change
+    memset(session1->buffer, 0x42, sizeof(session1->buffer));
+    AVS_UNIT_ASSERT_TRUE(get_session(&cache, 1, "host", "5685", 1) == session1);
+    AVS_UNIT_ASSERT_TRUE(buffer_empty(session1));
+
+    _anjay_dtls_session_cache_cleanup(&cache);
+    AVS_UNIT_ASSERT_NULL(cache.sessions);
+}
+
+AVS_UNIT_TEST(dtls_session_cache, configure) {
+    void *socket_buffer = _anjay_dtls_session_buffer_new();
+    AVS_UNIT_ASSERT_NOT_NULL(socket_buffer);
+
+    avs_net_ssl_configuration_t config;
+    memset(&config, 0, sizeof(config));
+    _anjay_dtls_session_configure(socket_buffer, &config);
+    AVS_UNIT_ASSERT_TRUE(config.session_resumption_buffer == socket_buffer);
+    AVS_UNIT_ASSERT_EQUAL(config.session_resumption_buffer_size,
+                          ANJAY_DTLS_SESSION_BUFFER_SIZE);
+
+    _anjay_dtls_session_configure(NULL, &config);
+    AVS_UNIT_ASSERT_NULL(config.session_resumption_buffer);
+    AVS_UNIT_ASSERT_EQUAL(config.session_resumption_buffer_size, 0);
+
+    free(socket_buffer);
+}
+
+AVS_UNIT_TEST(dtls_session_cache, socket_buffer_sync) {
+    anjay_dtls_session_cache_t cache = { NULL };
+    anjay_dtls_session_t *session = get_session(&cache, 1, "host", "5684", 0);
+    AVS_UNIT_ASSERT_NOT_NULL(session);
+    char *socket_buffer = (char *) _anjay_dtls_session_buffer_new();
+    AVS_UNIT_ASSERT_NOT_NULL(socket_buffer);
+
+    avs_net_abstract_socket_t *mocksock = NULL;
+    avs_unit_mocksock_create(&mocksock);
+
+    // cached state is loaded into the socket buffer before the handshake
+    memset(session->buffer, 0x42, sizeof(session->buffer));
+    _anjay_dtls_session_handshake_started(session, socket_buffer);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(socket_buffer, session->buffer,
+                                      sizeof(session->buffer));
+
+    // ...and is only replaced after a successful one
+    memset(socket_buffer, 0x43, ANJAY_DTLS_SESSION_BUFFER_SIZE);
+    _anjay_dtls_session_handshake_finished(session, socket_buffer, mocksock,
+                                           -1);
+    AVS_UNIT_ASSERT_EQUAL(session->buffer[0], 0x42);
+
+    avs_unit_mocksock_expect_get_opt(mocksock,
+                                     AVS_NET_SOCKET_OPT_SESSION_RESUMED,
+                                     (avs_net_socket_opt_value_t) {
+                                         .flag = false
+                                     });
+    _anjay_dtls_session_handshake_started(session, socket_buffer);
+    memset(socket_buffer, 0x43, ANJAY_DTLS_SESSION_BUFFER_SIZE);
+    _anjay_dtls_session_handshake_finished(session, socket_buffer, mocksock,
+                                           0);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(session->buffer, socket_buffer,
+                                      sizeof(session->buffer));
+
+    avs_unit_mocksock_assert_expects_met(mocksock);
+    avs_net_socket_cleanup(&mocksock);
+    free(socket_buffer);
+    _anjay_dtls_session_cache_cleanup(&cache);
+}
+
+AVS_UNIT_TEST(dtls_session_cache, handshake_stats) {
+    anjay_dtls_session_cache_t cache = { NULL };
+    anjay_dtls_session_t *session = get_session(&cache, 1, "host", "5684", 0);
+    AVS_UNIT_ASSERT_NOT_NULL(session);
+
+    avs_net_abstract_socket_t *mocksock = NULL;
+    avs_unit_mocksock_create(&mocksock);
+
+    _anjay_dtls_session_handshake_started(session, NULL);
+    _anjay_dtls_session_handshake_finished(session, NULL, mocksock, -1);
+    AVS_UNIT_ASSERT_EQUAL(session->stats.failed_handshakes, 1);
+    AVS_UNIT_ASSERT_EQUAL(session->stats.full_handshakes, 0);
+
+    avs_unit_mocksock_expect_get_opt(mocksock,
+                                     AVS_NET_SOCKET_OPT_SESSION_RESUMED,
+                                     (avs_net_socket_opt_value_t) {
+                                         .flag = false
+                                     });
+    _anjay_dtls_session_handshake_started(session, NULL);
+    _anjay_dtls_session_handshake_finished(session, NULL, mocksock, 0);
+    AVS_UNIT_ASSERT_EQUAL(session->stats.failed_handshakes, 1);
+    AVS_UNIT_ASSERT_EQUAL(session->stats.full_handshakes, 1);
+    AVS_UNIT_ASSERT_EQUAL(session->stats.resumed_handshakes, 0);
+    AVS_UNIT_ASSERT_TRUE(session->stats.last_duration_ms >= 0);
+
+    avs_unit_mocksock_expect_get_opt(mocksock,
+                                     AVS_NET_SOCKET_OPT_SESSION_RESUMED,
+                                     (avs_net_socket_opt_value_t) {
+                                         .flag = true
+                                     });
+    _anjay_dtls_session_handshake_started(session, NULL);
+    _anjay_dtls_session_handshake_finished(session, NULL, mocksock, 0);
+    AVS_UNIT_ASSERT_EQUAL(session->stats.failed_handshakes, 1);
+    AVS_UNIT_ASSERT_EQUAL(session->stats.full_handshakes, 1);
+    AVS_UNIT_ASSERT_EQUAL(session->stats.resumed_handshakes, 1);
+
+    // sessions are only tracked for secure sockets
+    _anjay_dtls_session_handshake_started(NULL, NULL);
+    _anjay_dtls_session_handshake_finished(NULL, NULL, mocksock, 0);
+
+    avs_unit_mocksock_assert_expects_met(mocksock);
+    avs_net_socket_cleanup(&mocksock);
+    _anjay_dtls_session_cache_cleanup(&cache);
+}
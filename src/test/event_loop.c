@@ -0,0 +1,262 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <sys/socket.h>
+
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay_modules/dm.h>
+
+#include "../sched.h"
+
+// HACK to enable _anjay_server_cleanup
+#define ANJAY_SERVERS_INTERNALS
+#include "../servers/servers.h"
+#undef ANJAY_SERVERS_INTERNALS
+
+#define TEST_SSID 1
+#define TEST_IID 1
+
+static char test_server_uri[64];
+
+static int test_instance_it(anjay_t *anjay,
+                            const anjay_dm_object_def_t *const *obj_ptr,
+                            anjay_iid_t *out,
+                            void **cookie) {
+    (void) anjay;
+    (void) obj_ptr;
+    *out = *cookie ? ANJAY_IID_INVALID : TEST_IID;
+    *cookie = (void *) (intptr_t) 1;
+    return 0;
+}
+
+static int test_instance_present(anjay_t *anjay,
+                                 const anjay_dm_object_def_t *const *obj_ptr,
+                                 anjay_iid_t iid) {
+    (void) anjay;
+    (void) obj_ptr;
+    return iid == TEST_IID;
+}
+
+static int test_security_read(anjay_t *anjay,
+                              const anjay_dm_object_def_t *const *obj_ptr,
+                              anjay_iid_t iid,
+                              anjay_rid_t rid,
+                              anjay_output_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    (void) iid;
+    switch (rid) {
+    case ANJAY_DM_RID_SECURITY_SERVER_URI:
+        return anjay_ret_string(ctx, test_server_uri);
+    case ANJAY_DM_RID_SECURITY_BOOTSTRAP:
+        return anjay_ret_bool(ctx, false);
+    case ANJAY_DM_RID_SECURITY_MODE:
+        return anjay_ret_i32(ctx, ANJAY_UDP_SECURITY_NOSEC);
+    case ANJAY_DM_RID_SECURITY_SSID:
+        return anjay_ret_i32(ctx, TEST_SSID);
+    default:
+        return ANJAY_ERR_NOT_FOUND;
+    }
+}
+
+static int test_server_read(anjay_t *anjay,
+                            const anjay_dm_object_def_t *const *obj_ptr,
+                            anjay_iid_t iid,
+                            anjay_rid_t rid,
+                            anjay_output_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    (void) iid;
+    switch (rid) {
+    case ANJAY_DM_RID_SERVER_SSID:
+        return anjay_ret_i32(ctx, TEST_SSID);
+    case ANJAY_DM_RID_SERVER_LIFETIME:
+        return anjay_ret_i32(ctx, 86400);
+    case ANJAY_DM_RID_SERVER_NOTIFICATION_STORING:
+        return anjay_ret_bool(ctx, false);
+    case ANJAY_DM_RID_SERVER_BINDING:
+        return anjay_ret_string(ctx, "U");
+    default:
+        return ANJAY_ERR_NOT_FOUND;
+    }
+}
+
+#define TEST_OBJECT_HANDLERS(Read) \
+    .instance_it = test_instance_it, \
+    .instance_present = test_instance_present, \
+    .resource_present = anjay_dm_resource_present_TRUE, \
+    .resource_read = (Read), \
+    .transaction_begin = anjay_dm_transaction_NOOP, \
+    .transaction_validate = anjay_dm_transaction_NOOP, \
+    .transaction_commit = anjay_dm_transaction_NOOP, \
+    .transaction_rollback = anjay_dm_transaction_NOOP
+
+static const anjay_dm_object_def_t *const TEST_SECURITY =
+        &(const anjay_dm_object_def_t) {
+            .oid = ANJAY_DM_OID_SECURITY,
+            .supported_rids = ANJAY_DM_SUPPORTED_RIDS(
+                    ANJAY_DM_RID_SECURITY_SERVER_URI,
+                    ANJAY_DM_RID_SECURITY_BOOTSTRAP,
+                    ANJAY_DM_RID_SECURITY_MODE,
+                    ANJAY_DM_RID_SECURITY_SSID),
+            .handlers = {
+                TEST_OBJECT_HANDLERS(test_security_read)
+            }
+        };
+
+static const anjay_dm_object_def_t *const TEST_SERVER =
+        &(const anjay_dm_object_def_t) {
+            .oid = ANJAY_DM_OID_SERVER,
+            .supported_rids = ANJAY_DM_SUPPORTED_RIDS(
+                    ANJAY_DM_RID_SERVER_SSID,
+                    ANJAY_DM_RID_SERVER_LIFETIME,
+                    ANJAY_DM_RID_SERVER_NOTIFICATION_STORING,
+                    ANJAY_DM_RID_SERVER_BINDING),
+            .handlers = {
+                TEST_OBJECT_HANDLERS(test_server_read)
+            }
+        };
+
+#undef TEST_OBJECT_HANDLERS
+
+typedef struct {
+    int server_fd;
+    bool responded;
+    bool registered;
+    unsigned polls_left;
+} register_test_env_t;
+
+/**
+ * Answers a Register received on the server socket with 2.01 Created.
+ */
+static void respond_to_register(register_test_env_t *env) {
+    uint8_t request[4096];
+    struct sockaddr_in client_addr;
+    socklen_t client_addr_len = sizeof(client_addr);
+    ssize_t size = recvfrom(env->server_fd, request, sizeof(request),
+                            MSG_DONTWAIT, (struct sockaddr *) &client_addr,
+                            &client_addr_len);
+    if (size < 4) {
+        return;
+    }
+    size_t token_size = request[0] & 0x0F;
+    AVS_UNIT_ASSERT_EQUAL(request[0] & 0x30, 0x00); // Confirmable
+    AVS_UNIT_ASSERT_EQUAL(request[1], ANJAY_COAP_CODE_POST);
+    AVS_UNIT_ASSERT_TRUE((size_t) size >= 4 + token_size);
+
+    uint8_t response[4 + 8 + 8];
+    size_t response_size = 0;
+    // Acknowledgement, 2.01 Created, same Message ID and token
+    response[response_size++] = (uint8_t) (0x60 | token_size);
+    response[response_size++] = ANJAY_COAP_CODE_CREATED;
+    response[response_size++] = request[2];
+    response[response_size++] = request[3];
+    memcpy(&response[response_size], &request[4], token_size);
+    response_size += token_size;
+    // Location-Path: rd/5a3f
+    memcpy(&response[response_size], "\x82rd\x04" "5a3f", 8);
+    response_size += 8;
+
+    AVS_UNIT_ASSERT_EQUAL(sendto(env->server_fd, response, response_size, 0,
+                                 (const struct sockaddr *) &client_addr,
+                                 client_addr_len),
+                          (ssize_t) response_size);
+    env->responded = true;
+}
+
+/**
+ * Plays the server role from within the event loop, and stops the loop once
+ * the client registers or the test times out.
+ */
+static int register_test_job(anjay_t *anjay, void *env_) {
+    register_test_env_t *env = (register_test_env_t *) env_;
+    if (!env->responded) {
+        respond_to_register(env);
+    }
+    if (_anjay_servers_find_active(&anjay->servers, TEST_SSID)) {
+        env->registered = true;
+    }
+    if (env->registered || !env->polls_left--) {
+        AVS_UNIT_ASSERT_SUCCESS(anjay_event_loop_interrupt(anjay));
+        return 0;
+    }
+    const struct timespec poll_interval = { 0, 10000000 };
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_sched(anjay->sched, NULL, poll_interval,
+                                         register_test_job, env));
+    return 0;
+}
+
+AVS_UNIT_TEST(event_loop, register) {
+    register_test_env_t env = {
+        .server_fd = socket(AF_INET, SOCK_DGRAM, 0),
+        // 5 seconds
+        .polls_left = 500
+    };
+    AVS_UNIT_ASSERT_TRUE(env.server_fd >= 0);
+    struct sockaddr_in server_addr = {
+        .sin_family = AF_INET,
+        .sin_addr = {
+            .s_addr = htonl(INADDR_LOOPBACK)
+        }
+    };
+    socklen_t server_addr_len = sizeof(server_addr);
+    AVS_UNIT_ASSERT_SUCCESS(bind(env.server_fd,
+                                 (const struct sockaddr *) &server_addr,
+                                 server_addr_len));
+    AVS_UNIT_ASSERT_SUCCESS(getsockname(env.server_fd,
+                                        (struct sockaddr *) &server_addr,
+                                        &server_addr_len));
+    AVS_UNIT_ASSERT_TRUE(
+            snprintf(test_server_uri, sizeof(test_server_uri),
+                     "coap://127.0.0.1:%u", ntohs(server_addr.sin_port))
+            < (int) sizeof(test_server_uri));
+
+    anjay_t *anjay = anjay_new(&(const anjay_configuration_t) {
+        .endpoint_name = "urn:dev:os:anjay-test",
+        .in_buffer_size = 4096,
+        .out_buffer_size = 4096
+    });
+    AVS_UNIT_ASSERT_NOT_NULL(anjay);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_register_object(anjay, &TEST_SECURITY));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_register_object(anjay, &TEST_SERVER));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_sched_now(anjay->sched, NULL,
+                                             register_test_job, &env));
+
+    // the Register response is read from the socket of a server that is still
+    // being activated
+    AVS_UNIT_ASSERT_SUCCESS(anjay_event_loop_run(anjay));
+    AVS_UNIT_ASSERT_TRUE(env.responded);
+    AVS_UNIT_ASSERT_TRUE(env.registered);
+
+    anjay_active_server_info_t *server =
+            _anjay_servers_find_active(&anjay->servers, TEST_SSID);
+    AVS_UNIT_ASSERT_NOT_NULL(server);
+    AVS_UNIT_ASSERT_EQUAL(
+            AVS_LIST_SIZE(server->registration_info.endpoint_path), 2);
+
+    // skip De-Register, which would block waiting for a response
+    AVS_LIST_CLEAR(&anjay->servers.active) {
+        _anjay_server_cleanup(anjay, anjay->servers.active);
+    }
+    anjay_delete(anjay);
+    close(env.server_fd);
+}
@@ -27,12 +27,21 @@ AVS_UNIT_MOCK_CREATE(_anjay_coap_stream_get_tx_params)
 AVS_UNIT_MOCK_CREATE(_anjay_coap_stream_set_tx_params)
 #define _anjay_coap_stream_set_tx_params(...) AVS_UNIT_MOCK_WRAPPER(_anjay_coap_stream_set_tx_params)(__VA_ARGS__)
 
+AVS_UNIT_MOCK_CREATE(_anjay_coap_stream_set_rtt_estimator)
+#define _anjay_coap_stream_set_rtt_estimator(...) AVS_UNIT_MOCK_WRAPPER(_anjay_coap_stream_set_rtt_estimator)(__VA_ARGS__)
+
+AVS_UNIT_MOCK_CREATE(_anjay_coap_stream_set_block_size_tuner)
+#define _anjay_coap_stream_set_block_size_tuner(...) AVS_UNIT_MOCK_WRAPPER(_anjay_coap_stream_set_block_size_tuner)(__VA_ARGS__)
+
 AVS_UNIT_MOCK_CREATE(_anjay_coap_stream_setup_request)
 #define _anjay_coap_stream_setup_request(...) AVS_UNIT_MOCK_WRAPPER(_anjay_coap_stream_setup_request)(__VA_ARGS__)
 
 AVS_UNIT_MOCK_CREATE(_anjay_coap_stream_set_error)
 #define _anjay_coap_stream_set_error(...) AVS_UNIT_MOCK_WRAPPER(_anjay_coap_stream_set_error)(__VA_ARGS__)
 
+AVS_UNIT_MOCK_CREATE(_anjay_coap_stream_send_empty_ack)
+#define _anjay_coap_stream_send_empty_ack(...) AVS_UNIT_MOCK_WRAPPER(_anjay_coap_stream_send_empty_ack)(__VA_ARGS__)
+
 AVS_UNIT_MOCK_CREATE(_anjay_coap_stream_get_code)
 #define _anjay_coap_stream_get_code(...) AVS_UNIT_MOCK_WRAPPER(_anjay_coap_stream_get_code)(__VA_ARGS__)
 
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2017 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <avsystem/commons/unit/test.h>
+
+#ifdef WITH_NOTIFY_INBOX
+
+static bool wakeup_fd_readable(anjay_notify_inbox_t *inbox) {
+    char byte;
+    ssize_t result = read(inbox->wakeup_fds[0], &byte, 1);
+    if (result > 0) {
+        // put it back, so that the state is not modified
+        AVS_UNIT_ASSERT_EQUAL(write(inbox->wakeup_fds[1], &byte, 1), 1);
+        return true;
+    }
+    return false;
+}
+
+AVS_UNIT_TEST(notify_inbox, disabled) {
+    anjay_notify_inbox_t inbox;
+    memset(&inbox, 0, sizeof(inbox));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_notify_inbox_init(&inbox, 0));
+    AVS_UNIT_ASSERT_EQUAL(inbox.wakeup_fds[0], -1);
+    AVS_UNIT_ASSERT_FAILED(_anjay_notify_inbox_push(&inbox, 42, 69, 4));
+
+    anjay_notify_inbox_cell_t cell;
+    AVS_UNIT_ASSERT_FALSE(_anjay_notify_inbox_pop(&inbox, &cell));
+    _anjay_notify_inbox_cleanup(&inbox);
+}
+
+AVS_UNIT_TEST(notify_inbox, push_pop_and_overflow) {
+    anjay_notify_inbox_t inbox;
+    memset(&inbox, 0, sizeof(inbox));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_notify_inbox_init(&inbox, 3));
+    AVS_UNIT_ASSERT_EQUAL(inbox.mask, 3);
+    AVS_UNIT_ASSERT_FALSE(wakeup_fd_readable(&inbox));
+
+    anjay_notify_inbox_cell_t cell;
+    // wrap around the ring a couple of times
+    for (anjay_rid_t round = 0; round < 3; ++round) {
+        for (anjay_rid_t rid = 0; rid < 4; ++rid) {
+            AVS_UNIT_ASSERT_SUCCESS(
+                    _anjay_notify_inbox_push(&inbox, 42, round, rid));
+        }
+        AVS_UNIT_ASSERT_FAILED(_anjay_notify_inbox_push(&inbox, 42, 0, 0));
+        AVS_UNIT_ASSERT_TRUE(wakeup_fd_readable(&inbox));
+
+        for (anjay_rid_t rid = 0; rid < 4; ++rid) {
+            AVS_UNIT_ASSERT_TRUE(_anjay_notify_inbox_pop(&inbox, &cell));
+            AVS_UNIT_ASSERT_EQUAL(cell.oid, 42);
+            AVS_UNIT_ASSERT_EQUAL(cell.iid, round);
+            AVS_UNIT_ASSERT_EQUAL(cell.rid, rid);
+        }
+        AVS_UNIT_ASSERT_FALSE(_anjay_notify_inbox_pop(&inbox, &cell));
+        clear_wakeup(&inbox);
+        AVS_UNIT_ASSERT_FALSE(wakeup_fd_readable(&inbox));
+    }
+    AVS_UNIT_ASSERT_EQUAL(inbox.dropped, 3);
+
+    _anjay_notify_inbox_cleanup(&inbox);
+    AVS_UNIT_ASSERT_NULL(inbox.cells);
+}
+
+AVS_UNIT_TEST(notify_inbox, wakeup_written_once) {
+    anjay_notify_inbox_t inbox;
+    memset(&inbox, 0, sizeof(inbox));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_notify_inbox_init(&inbox, 16));
+
+    for (anjay_rid_t rid = 0; rid < 8; ++rid) {
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_notify_inbox_push(&inbox, 42, 69, rid));
+    }
+    char buf[16];
+    AVS_UNIT_ASSERT_EQUAL(read(inbox.wakeup_fds[0], buf, sizeof(buf)), 1);
+
+    _anjay_notify_inbox_cleanup(&inbox);
+}
+
+AVS_UNIT_TEST(notify_inbox, late_wakeup_byte_is_drained) {
+    anjay_notify_inbox_t inbox;
+    memset(&inbox, 0, sizeof(inbox));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_notify_inbox_init(&inbox, 16));
+
+    // a producer sets wakeup_pending, the consumer clears it, and only then
+    // the producer's byte reaches the pipe
+    inbox.wakeup_pending = 1;
+    clear_wakeup(&inbox);
+    AVS_UNIT_ASSERT_EQUAL(write(inbox.wakeup_fds[1], "", 1), 1);
+    AVS_UNIT_ASSERT_TRUE(wakeup_fd_readable(&inbox));
+
+    // wakeup_pending is already clear, but the pipe must be drained anyway
+    clear_wakeup(&inbox);
+    AVS_UNIT_ASSERT_FALSE(wakeup_fd_readable(&inbox));
+
+    // and subsequent pushes must wake the consumer again
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_notify_inbox_push(&inbox, 42, 69, 4));
+    AVS_UNIT_ASSERT_TRUE(wakeup_fd_readable(&inbox));
+
+    _anjay_notify_inbox_cleanup(&inbox);
+}
+
+#endif // WITH_NOTIFY_INBOX
@@ -16,6 +16,8 @@
 
 #include <config.h>
 
+#include <string.h>
+
 #include <avsystem/commons/unit/test.h>
 #include <anjay_test/mock_clock.h>
 
@@ -304,3 +306,204 @@ AVS_UNIT_TEST(sched, retryable_job_handle_nullification) {
     AVS_UNIT_ASSERT_NULL(global.task);
     teardown_test(&env);
 }
+
+AVS_UNIT_TEST(sched, slack_coalesces_wakeups) {
+    sched_test_env_t env = setup_test();
+    _anjay_sched_enable_slack(env.sched);
+
+    int counter = 0;
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_sched_with_slack(env.sched, NULL,
+                                    (const struct timespec) { 10, 0 },
+                                    (const struct timespec) { 5, 0 },
+                                    increment_task, &counter));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_sched_with_slack(env.sched, NULL,
+                                    (const struct timespec) { 12, 0 },
+                                    (const struct timespec) { 1, 0 },
+                                    increment_task, &counter));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_sched(env.sched, NULL, (const struct timespec) { 20, 0 },
+                         increment_task, &counter));
+
+    // the second job is the tightest one: 12 + 1 < 10 + 5
+    struct timespec time_to_next;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_sched_time_to_next(env.sched,
+                                                      &time_to_next));
+    AVS_UNIT_ASSERT_EQUAL(time_to_next.tv_sec, 13);
+    AVS_UNIT_ASSERT_EQUAL(time_to_next.tv_nsec, 0);
+
+    _anjay_mock_clock_advance(&time_to_next);
+    AVS_UNIT_ASSERT_EQUAL(2, _anjay_sched_run(env.sched));
+    AVS_UNIT_ASSERT_EQUAL(2, counter);
+
+    // jobs without slack are executed exactly on time
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_sched_time_to_next(env.sched,
+                                                      &time_to_next));
+    AVS_UNIT_ASSERT_EQUAL(time_to_next.tv_sec, 7);
+    _anjay_mock_clock_advance(&time_to_next);
+    AVS_UNIT_ASSERT_EQUAL(1, _anjay_sched_run(env.sched));
+    AVS_UNIT_ASSERT_EQUAL(3, counter);
+
+    anjay_sched_stats_t stats;
+    _anjay_sched_get_stats(env.sched, &stats);
+    AVS_UNIT_ASSERT_EQUAL(stats.wakeups, 2);
+    AVS_UNIT_ASSERT_EQUAL(stats.jobs_executed, 3);
+    AVS_UNIT_ASSERT_EQUAL(stats.idle_runs, 0);
+
+    teardown_test(&env);
+}
+
+AVS_UNIT_TEST(sched, slack_disabled_by_default) {
+    sched_test_env_t env = setup_test();
+    AVS_UNIT_ASSERT_FALSE(_anjay_sched_slack_enabled(env.sched));
+
+    int counter = 0;
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_sched_with_slack(env.sched, NULL,
+                                    (const struct timespec) { 10, 0 },
+                                    (const struct timespec) { 5, 0 },
+                                    increment_task, &counter));
+
+    struct timespec time_to_next;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_sched_time_to_next(env.sched,
+                                                      &time_to_next));
+    AVS_UNIT_ASSERT_EQUAL(time_to_next.tv_sec, 10);
+
+    AVS_UNIT_ASSERT_EQUAL(0, _anjay_sched_run(env.sched));
+    _anjay_mock_clock_advance(&time_to_next);
+    AVS_UNIT_ASSERT_EQUAL(1, _anjay_sched_run(env.sched));
+    AVS_UNIT_ASSERT_EQUAL(1, counter);
+
+    anjay_sched_stats_t stats;
+    _anjay_sched_get_stats(env.sched, &stats);
+    AVS_UNIT_ASSERT_EQUAL(stats.wakeups, 1);
+    AVS_UNIT_ASSERT_EQUAL(stats.jobs_executed, 1);
+    AVS_UNIT_ASSERT_EQUAL(stats.idle_runs, 1);
+
+    teardown_test(&env);
+}
+
+AVS_UNIT_TEST(sched, retryable_randomized_backoff) {
+    sched_test_env_t env = setup_test();
+    _anjay_sched_randomize_backoff(env.sched, 42);
+
+    const anjay_sched_retryable_backoff_t backoff = {
+        .delay = { 1, 0 },
+        .max_delay = { 30, 0 }
+    };
+
+    int counter = 0;
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_sched_retryable(env.sched, NULL, ANJAY_TIME_ZERO, backoff,
+                                   increment_and_fail_task, &counter));
+    AVS_UNIT_ASSERT_EQUAL(1, _anjay_sched_run(env.sched));
+
+    ssize_t previous_ms = 1000;
+    for (int i = 0; i < 50; ++i) {
+        struct timespec delay;
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_sched_time_to_next(env.sched, &delay));
+        ssize_t delay_ms = _anjay_time_diff_ms(&delay, &ANJAY_TIME_ZERO);
+        AVS_UNIT_ASSERT_TRUE(delay_ms >= 1000);
+        AVS_UNIT_ASSERT_TRUE(delay_ms <= AVS_MIN(3 * previous_ms, 30000));
+        previous_ms = delay_ms;
+
+        assert_executes_after_delay(&env, delay);
+    }
+    AVS_UNIT_ASSERT_EQUAL(51, counter);
+
+    teardown_test(&env);
+}
+
+#define FLEET_SIZE 100
+#define FLEET_SIM_DURATION_S 600
+
+typedef struct {
+    struct timespec outage_end;
+    /* number of requests received by the server in each second */
+    unsigned load[FLEET_SIM_DURATION_S];
+} fleet_sim_t;
+
+static int fleet_request_task(anjay_t *anjay, void *sim_) {
+    (void) anjay;
+    fleet_sim_t *sim = (fleet_sim_t *) sim_;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (now.tv_sec < FLEET_SIM_DURATION_S) {
+        ++sim->load[now.tv_sec];
+    }
+    return _anjay_time_before(&now, &sim->outage_end) ? -1 : 0;
+}
+
+/**
+ * Simulates a fleet of clients that all start retrying a request with the
+ * server backoff at the beginning of a server outage, and returns the highest
+ * number of requests that the server receives in a single second once it is
+ * back up.
+ */
+static unsigned simulate_fleet(fleet_sim_t *sim, bool randomize) {
+    _anjay_mock_clock_start(&ANJAY_TIME_ZERO);
+    memset(sim, 0, sizeof(*sim));
+    sim->outage_end = (struct timespec) { 300, 0 };
+
+    anjay_sched_t *scheds[FLEET_SIZE];
+    for (size_t i = 0; i < FLEET_SIZE; ++i) {
+        scheds[i] = _anjay_sched_new(NULL);
+        AVS_UNIT_ASSERT_NOT_NULL(scheds[i]);
+        if (randomize) {
+            _anjay_sched_randomize_backoff(scheds[i], (uint32_t) i);
+        }
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_sched_retryable(
+                scheds[i], NULL, ANJAY_TIME_ZERO,
+                (anjay_sched_retryable_backoff_t) {
+                    .delay = { 1, 0 },
+                    .max_delay = { 120, 0 }
+                },
+                fleet_request_task, sim));
+    }
+
+    bool pending;
+    do {
+        pending = false;
+        struct timespec next = ANJAY_TIME_ZERO;
+        for (size_t i = 0; i < FLEET_SIZE; ++i) {
+            _anjay_sched_run(scheds[i]);
+            struct timespec delay;
+            if (!_anjay_sched_time_to_next(scheds[i], &delay)
+                    && (!pending || _anjay_time_before(&delay, &next))) {
+                next = delay;
+                pending = true;
+            }
+        }
+        _anjay_mock_clock_advance(&next);
+    } while (pending);
+
+    for (size_t i = 0; i < FLEET_SIZE; ++i) {
+        _anjay_sched_delete(&scheds[i]);
+    }
+    _anjay_mock_clock_finish();
+
+    unsigned peak = 0;
+    for (size_t s = (size_t) sim->outage_end.tv_sec; s < FLEET_SIM_DURATION_S;
+            ++s) {
+        peak = AVS_MAX(peak, sim->load[s]);
+    }
+    return peak;
+}
+
+AVS_UNIT_TEST(sched, fleet_simulation) {
+    static fleet_sim_t sim;
+
+    // doubling delays make the whole fleet retry in lockstep: at 247 s, and
+    // then at 367 s, when the server is already back up
+    AVS_UNIT_ASSERT_EQUAL(simulate_fleet(&sim, false), FLEET_SIZE);
+    AVS_UNIT_ASSERT_EQUAL(sim.load[367], FLEET_SIZE);
+
+    AVS_UNIT_ASSERT_TRUE(simulate_fleet(&sim, true) < FLEET_SIZE / 10);
+    unsigned after_outage = 0;
+    for (size_t s = 300; s < FLEET_SIM_DURATION_S; ++s) {
+        after_outage += sim.load[s];
+    }
+    // every client has eventually succeeded, with a single request
+    AVS_UNIT_ASSERT_EQUAL(after_outage, FLEET_SIZE);
+}
@@ -384,3 +384,36 @@ AVS_UNIT_TEST(time, div_big_negative) {
     AVS_UNIT_ASSERT_EQUAL(value.tv_sec, -1);
     AVS_UNIT_ASSERT_EQUAL(value.tv_nsec, 1 * 1000 * 1000);
 }
+
+AVS_UNIT_TEST(fnv1a32, known_values) {
+    AVS_UNIT_ASSERT_EQUAL(_anjay_fnv1a32(ANJAY_FNV1A32_INITIAL, "", 0),
+                          UINT32_C(0x811c9dc5));
+    AVS_UNIT_ASSERT_EQUAL(_anjay_fnv1a32(ANJAY_FNV1A32_INITIAL, "a", 1),
+                          UINT32_C(0xe40c292c));
+    AVS_UNIT_ASSERT_EQUAL(_anjay_fnv1a32(ANJAY_FNV1A32_INITIAL, "foobar", 6),
+                          UINT32_C(0xbf9cf968));
+    // hashing in parts gives the same result
+    AVS_UNIT_ASSERT_EQUAL(
+            _anjay_fnv1a32(_anjay_fnv1a32(ANJAY_FNV1A32_INITIAL, "foo", 3),
+                           "bar", 3),
+            UINT32_C(0xbf9cf968));
+}
+
+AVS_UNIT_TEST(string_list, copy) {
+    AVS_LIST(const anjay_string_t) strings =
+            _anjay_make_string_list("rd", "5a3f", NULL);
+    AVS_UNIT_ASSERT_NOT_NULL(strings);
+
+    AVS_LIST(const anjay_string_t) copy = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_copy_string_list(&copy, strings));
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(copy), 2);
+    AVS_UNIT_ASSERT_TRUE(copy != strings);
+    AVS_UNIT_ASSERT_EQUAL_STRING(copy->c_str, "rd");
+    AVS_UNIT_ASSERT_EQUAL_STRING(AVS_LIST_NEXT(copy)->c_str, "5a3f");
+
+    AVS_LIST_CLEAR(&copy);
+    AVS_LIST_CLEAR(&strings);
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_copy_string_list(&copy, NULL));
+    AVS_UNIT_ASSERT_NULL(copy);
+}
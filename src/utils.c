@@ -163,6 +163,15 @@ uint32_t _anjay_rand32(anjay_rand_seed_t *seed) {
 }
 #endif
 
+uint32_t _anjay_fnv1a32(uint32_t hash, const void *data, size_t size) {
+    const uint8_t *bytes = (const uint8_t *) data;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= UINT32_C(16777619);
+    }
+    return hash;
+}
+
 ssize_t _anjay_snprintf(char *buffer,
                         size_t buffer_size,
                         const char *fmt,
@@ -208,6 +217,27 @@ AVS_LIST(const anjay_string_t) _anjay_make_string_list(const char *string,
     return strings_list;
 }
 
+int _anjay_copy_string_list(AVS_LIST(const anjay_string_t) *out_copy,
+                            AVS_LIST(const anjay_string_t) strings) {
+    assert(!*out_copy);
+    AVS_LIST(const anjay_string_t) *tail = out_copy;
+    AVS_LIST(const anjay_string_t) it;
+    AVS_LIST_FOREACH(it, strings) {
+        size_t len = strlen(it->c_str) + 1;
+        AVS_LIST(anjay_string_t) list_elem =
+                (AVS_LIST(anjay_string_t))AVS_LIST_NEW_BUFFER(len);
+        if (!list_elem) {
+            anjay_log(ERROR, "out of memory");
+            AVS_LIST_CLEAR(out_copy);
+            return -1;
+        }
+        memcpy(list_elem->c_str, it->c_str, len);
+        AVS_LIST_INSERT(tail, list_elem);
+        tail = AVS_LIST_NEXT_PTR(tail);
+    }
+    return 0;
+}
+
 static struct {
     anjay_binding_mode_t binding;
     const char *str;
@@ -217,7 +247,9 @@ static struct {
     { ANJAY_BINDING_S,   "S" },
     { ANJAY_BINDING_SQ,  "SQ" },
     { ANJAY_BINDING_US,  "US" },
-    { ANJAY_BINDING_UQS, "UQS" }
+    { ANJAY_BINDING_UQS, "UQS" },
+    { ANJAY_BINDING_T,   "T" },
+    { ANJAY_BINDING_TQ,  "TQ" }
 };
 
 const char *anjay_binding_mode_as_str(anjay_binding_mode_t binding_mode) {
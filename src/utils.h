@@ -34,11 +34,22 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 #define anjay_log(...) _anjay_log(anjay, __VA_ARGS__)
 
 int _anjay_safe_strtoll(const char *in, long long *value);
+int _anjay_safe_strtof(const char *in, float *value);
 int _anjay_safe_strtod(const char *in, double *value);
 
-#define ANJAY_MAX_URL_PROTO_SIZE sizeof("coaps")
-#define ANJAY_MAX_URL_HOSTNAME_SIZE (256 - ANJAY_MAX_URL_PROTO_SIZE - (sizeof("://" ":0") - 1))
-#define ANJAY_MAX_URL_PORT_SIZE sizeof("65535")
+/* Large enough for any value formatted by _anjay_(float|double)_to_string */
+#define ANJAY_DOUBLE_STRING_SIZE 32
+
+/**
+ * Formats @p value as the shortest decimal string that reads back as exactly
+ * the same value, e.g. "0.1", "1e+21" or "1.2345e-7". NaN and infinities are
+ * written as "nan", "inf" and "-inf".
+ *
+ * @returns Length of the resulting string, or a negative value if @p size is
+ *          not enough to hold it along with the terminating nullbyte.
+ */
+ssize_t _anjay_double_to_string(char *out, size_t size, double value);
+ssize_t _anjay_float_to_string(char *out, size_t size, float value);
 
 #ifdef ANJAY_BIG_ENDIAN
 #define ANJAY_CONVERT_BYTES_BE(Bytes)
@@ -68,14 +79,29 @@ typedef unsigned anjay_rand_seed_t;
 #endif
 uint32_t _anjay_rand32(anjay_rand_seed_t *seed);
 
-typedef struct anjay_string {
-    char c_str[1]; // actually a FAM, but a struct must not consist of FAM only
-} anjay_string_t;
+#define ANJAY_FNV1A32_INITIAL UINT32_C(2166136261)
+
+/**
+ * Feeds @p data into a 32-bit FNV-1a hash. Not suitable for anything
+ * security-related - only meant to detect changes in persisted data.
+ *
+ * @param hash Hash of the previous data, or @ref ANJAY_FNV1A32_INITIAL.
+ */
+uint32_t _anjay_fnv1a32(uint32_t hash, const void *data, size_t size);
 
 AVS_LIST(const anjay_string_t)
 _anjay_make_string_list(const char *string,
                         ... /* strings */) AVS_F_SENTINEL;
 
+/**
+ * Makes a deep copy of @p strings into <c>*out_copy</c>, which must be empty.
+ *
+ * @returns 0 on success, or a negative value in case of an out-of-memory
+ *          condition, in which case <c>*out_copy</c> is left empty.
+ */
+int _anjay_copy_string_list(AVS_LIST(const anjay_string_t) *out_copy,
+                            AVS_LIST(const anjay_string_t) strings);
+
 AVS_LIST(const anjay_string_t)
 _anjay_make_query_string_list(const char *version,
                               const char *endpoint_name,
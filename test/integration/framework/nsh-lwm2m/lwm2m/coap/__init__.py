@@ -20,7 +20,7 @@ from .code import Code
 from .content_format import ContentFormat
 from .option import Option, ContentFormatOption, AcceptOption
 from .packet import Packet
-from .server import Server, DtlsServer
+from .server import Server, DtlsServer, TcpServer
 from .type import Type
 
 __all__ = [
@@ -29,6 +29,6 @@ __all__ = [
     'ContentFormat',
     'Option', 'ContentFormatOption', 'AcceptOption',
     'Packet',
-    'Server', 'DtlsServer',
+    'Server', 'DtlsServer', 'TcpServer',
     'Type'
 ]
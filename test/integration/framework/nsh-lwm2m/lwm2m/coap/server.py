@@ -16,6 +16,7 @@
 
 import contextlib
 import socket
+import struct
 from typing import Tuple, Optional
 
 from .packet import Packet
@@ -167,3 +168,186 @@ class DtlsServer(Server):
 
     def get_listen_port(self) -> int:
         return self.server_socket.getsockname()[1]
+
+
+class TcpServer(Server):
+    """
+    Local stand-in for a CoAP over TCP server (RFC 8323).
+
+    Messages are translated to and from the UDP format, the same way the client
+    does it, so that tests can keep working on Packet objects:
+
+    - Type and Message ID of sent packets are dropped; Empty messages (ACK,
+      Reset) are not sent at all,
+    - a received response to one of the sent requests gets the ACK type and
+      the Message ID of that request; any other message is received as CON,
+      with a locally generated Message ID,
+    - CSM is sent after accepting a connection and Ping is answered with Pong.
+    """
+
+    CODE_EMPTY = 0x00
+    CODE_CSM = 0xE1
+    CODE_PING = 0xE2
+    CODE_PONG = 0xE3
+    CODE_RELEASE = 0xE4
+    CODE_ABORT = 0xE5
+
+    OPTION_MAX_MESSAGE_SIZE = 2
+
+    TYPE_CONFIRMABLE = 0
+    TYPE_ACKNOWLEDGEMENT = 2
+
+    def __init__(self, listen_port=0, max_message_size=None):
+        self.server_socket = None
+        self.max_message_size = max_message_size
+        self.peer_max_message_size = None
+        self._recv_buffer = b''
+        self._next_msg_id = 0
+        self._pending_requests = {}
+
+        super().__init__(listen_port)
+
+    @staticmethod
+    def _encode_frame(code: int, token: bytes, body: bytes) -> bytes:
+        length = len(body)
+        if length < 13:
+            header = struct.pack('!B', (length << 4) | len(token))
+        elif length < 269:
+            header = struct.pack('!BB', (13 << 4) | len(token), length - 13)
+        elif length < 65805:
+            header = struct.pack('!BH', (14 << 4) | len(token), length - 269)
+        else:
+            header = struct.pack('!BI', (15 << 4) | len(token), length - 65805)
+        return header + struct.pack('!B', code) + token + body
+
+    def _send_frame(self, code: int, token: bytes = b'', body: bytes = b'') -> None:
+        self.socket.sendall(self._encode_frame(code, token, body))
+
+    def _send_csm(self) -> None:
+        body = b''
+        if self.max_message_size is not None:
+            value = self.max_message_size.to_bytes(4, 'big').lstrip(b'\0')
+            # option delta 2, value shorter than 13 bytes
+            body = struct.pack('!B', (self.OPTION_MAX_MESSAGE_SIZE << 4)
+                               | len(value)) + value
+        self._send_frame(self.CODE_CSM, body=body)
+
+    def _recv_exact(self, size: int) -> bytes:
+        # data is kept in self._recv_buffer until a whole frame is available,
+        # so that a timeout never loses a partially received frame
+        while len(self._recv_buffer) < size:
+            chunk = self.socket.recv(65536)
+            if not chunk:
+                raise ConnectionResetError('connection closed by peer')
+            self._recv_buffer += chunk
+        return self._recv_buffer[:size]
+
+    def _recv_frame(self) -> Tuple[int, bytes, bytes]:
+        first_byte = self._recv_exact(1)[0]
+        length = first_byte >> 4
+        token_length = first_byte & 0x0F
+        ext_size = {13: 1, 14: 2, 15: 4}.get(length, 0)
+
+        header = self._recv_exact(2 + ext_size)
+        if ext_size:
+            length = (int.from_bytes(header[1:1 + ext_size], 'big')
+                      + {1: 13, 2: 269, 4: 65805}[ext_size])
+        code = header[1 + ext_size]
+
+        frame_size = len(header) + token_length + length
+        frame = self._recv_exact(frame_size)
+        self._recv_buffer = self._recv_buffer[frame_size:]
+
+        token = frame[len(header):len(header) + token_length]
+        return code, token, frame[len(header) + token_length:]
+
+    def _handle_csm(self, body: bytes) -> None:
+        opt_number = 0
+        while body and body[0] != 0xFF:
+            delta = body[0] >> 4
+            length = body[0] & 0x0F
+            if delta >= 13 or length >= 13:
+                # extended option fields are not used by any known CSM option
+                return
+            opt_number += delta
+            if opt_number == self.OPTION_MAX_MESSAGE_SIZE:
+                self.peer_max_message_size = int.from_bytes(body[1:1 + length], 'big')
+            body = body[1 + length:]
+
+    def listen(self, timeout_s: float = -1) -> None:
+        with _override_timeout(self.server_socket, timeout_s):
+            self.socket, _ = self.server_socket.accept()
+
+        self.socket.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        if self.socket_timeout is not None:
+            self.socket.settimeout(self.socket_timeout)
+
+        self._recv_buffer = b''
+        self._pending_requests = {}
+        self.peer_max_message_size = None
+        self._send_csm()
+
+    def connect(self, remote_addr: Tuple[str, int]) -> None:
+        raise NotImplementedError('CoAP/TCP connections are initiated by the client')
+
+    def close(self) -> None:
+        super().close()
+        if self.server_socket:
+            self.server_socket.close()
+            self.server_socket = None
+
+    def reset(self, listen_port=None) -> None:
+        if listen_port is None:
+            listen_port = self.get_listen_port() if self.server_socket else 0
+
+        self.close()
+        self.server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.server_socket.bind(('', listen_port))
+        self.server_socket.listen(1)
+
+    def send(self, coap_packet: Packet) -> None:
+        serialized = coap_packet.serialize()
+        token_length = serialized[0] & 0x0F
+        code = serialized[1]
+        if code == self.CODE_EMPTY:
+            return
+
+        token = serialized[4:4 + token_length]
+        if code >> 5 == 0:
+            self._pending_requests[token] = coap_packet.msg_id
+        self._send_frame(code, token, serialized[4 + token_length:])
+
+    def send_ping(self, token: bytes = b'') -> None:
+        self._send_frame(self.CODE_PING, token)
+
+    def send_release(self) -> None:
+        self._send_frame(self.CODE_RELEASE)
+
+    def recv(self, timeout_s: float = -1) -> Packet:
+        with _override_timeout(self.socket, timeout_s):
+            if not self.get_remote_addr():
+                self.listen()
+
+            while True:
+                code, token, body = self._recv_frame()
+                if code == self.CODE_CSM:
+                    self._handle_csm(body)
+                elif code == self.CODE_PING:
+                    self._send_frame(self.CODE_PONG, token)
+                elif code >> 5 != 7 and code != self.CODE_EMPTY:
+                    break
+
+        if code >> 5 != 0 and token in self._pending_requests:
+            type = self.TYPE_ACKNOWLEDGEMENT
+            msg_id = self._pending_requests.pop(token)
+        else:
+            type = self.TYPE_CONFIRMABLE
+            msg_id = self._next_msg_id
+            self._next_msg_id = (self._next_msg_id + 1) % 2 ** 16
+
+        return Packet.parse(struct.pack('!BBH', (1 << 6) | (type << 4) | len(token),
+                                        code, msg_id) + token + body)
+
+    def get_listen_port(self) -> int:
+        return self.server_socket.getsockname()[1]
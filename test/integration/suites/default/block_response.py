@@ -177,6 +177,37 @@ class BlockResponseSizeRenegotiationInTheMiddleOfTransfer(BlockResponseTest):
         self.read_blocks(iid=1, block_size=1024)
 
 
+class BlockResponseSizeLoweredOnLoss(BlockResponseTest):
+    def runTest(self):
+        data = bytearray()
+        response = self.read_bytes(iid=1, seq_num=0, block_size=1024)
+        self.assertBlockResponse(response, seq_num=0, has_more=1, block_size=1024)
+        data += response.content
+
+        # pretend that responses to the next two blocks get lost by requesting
+        # each of them twice
+        for seq_num in (1, 2):
+            self.read_bytes(iid=1, seq_num=seq_num, block_size=1024)
+            response = self.read_bytes(iid=1, seq_num=seq_num, block_size=1024)
+            self.assertBlockResponse(response, seq_num=seq_num, has_more=1, block_size=1024)
+            data += response.content
+
+        # the client should now switch to smaller blocks, keeping the offset
+        response = self.read_bytes(iid=1, seq_num=3, block_size=1024)
+        self.assertBlockResponse(response, seq_num=6, has_more=1, block_size=512)
+        data += response.content
+
+        data += self.read_blocks(iid=1, block_size=512, base_seq=7)
+        self.assertEqual(9001, len(data))
+        for i in range(len(data)):
+            self.assertEqual(data[i], i % 128)
+
+        # subsequent transfers keep using the lowered block size
+        response = self.read_bytes(iid=1)
+        self.assertBlockResponse(response, seq_num=0, has_more=1, block_size=512)
+        self.read_blocks(iid=1, block_size=512, base_seq=1)
+
+
 class BlockResponseInvalidSizeDuringRenegotation(BlockResponseTest):
     def runTest(self):
         # Case 0: when first request does not contain BLOCK2 option.
@@ -48,9 +48,21 @@ class JsonEncodingBnInstance(JsonEncodingTest.Test):
 
 class JsonEncodingBnObject(JsonEncodingTest.Test):
     def runTest(self):
+        # only one Instance exists, so its path is the longest common prefix
+        res = as_json(self.read_object(self.serv, oid=OID.Test,
+                                       accept=coap.ContentFormat.APPLICATION_LWM2M_JSON))
+        self.assertEqual('/%d/1' % OID.Test, res['bn'])
+
+
+class JsonEncodingBnObjectMultipleInstances(JsonEncodingTest.Test):
+    def runTest(self):
+        self.create_instance(self.serv, oid=OID.Test, iid=2)
+
         res = as_json(self.read_object(self.serv, oid=OID.Test,
                                        accept=coap.ContentFormat.APPLICATION_LWM2M_JSON))
         self.assertEqual('/%d' % OID.Test, res['bn'])
+        for resource in res['e']:
+            self.assertIn(resource['n'].split('/')[1], ('1', '2'))
 
 
 class JsonEncodingAllNamesAreSlashPrefixed(JsonEncodingTest.Test):
@@ -137,3 +137,28 @@ class ConcurrentRequestWhileWaitingForResponse(Register.TestCase):
                             self.serv.recv())
 
         self.serv.send(Lwm2mCreated.matching(pkt)(location='/rd/demo'))
+
+
+class ConcurrentRegisterToMultipleServers(test_suite.Lwm2mTest):
+    def setUp(self):
+        self.setup_demo_with_servers(num_servers=3, auto_register=False)
+
+    def tearDown(self):
+        self.teardown_demo_with_servers()
+
+    def runTest(self):
+        # Register requests to all servers should be in flight at the same
+        # time, without waiting for the response from any other server
+        pkts = [serv.recv(timeout_s=2) for serv in self.servers]
+        for pkt in pkts:
+            self.assertMsgEqual(
+                Lwm2mRegister('/rd?lwm2m=%s&ep=%s&lt=86400' % (DEMO_LWM2M_VERSION, DEMO_ENDPOINT_NAME)),
+                pkt)
+
+        for serv, pkt in reversed(list(zip(self.servers, pkts))):
+            serv.send(Lwm2mCreated.matching(pkt)(location=DEFAULT_REGISTER_ENDPOINT))
+
+        # no retransmissions are expected once all servers responded
+        for serv in self.servers:
+            with self.assertRaises(socket.timeout, msg='unexpected message'):
+                print(serv.recv(timeout_s=3))
@@ -0,0 +1,40 @@
+# -*- coding: utf-8 -*-
+#
+# Copyright 2017 AVSystem <avsystem@avsystem.com>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from framework.lwm2m_test import *
+
+BURST_SIZE = 64
+
+
+class RequestBurstTest(test_suite.Lwm2mSingleServerTest):
+    def runTest(self):
+        # send all requests at once, so that the client finds many of them
+        # already queued on the socket when it wakes up
+        requests = [Lwm2mRead('/3/0/0', msg_id=0x1000 + i,
+                              token=b'burst%03d' % (i,))
+                    for i in range(BURST_SIZE)]
+        for req in requests:
+            self.serv.send(req)
+
+        responses = {}
+        for _ in range(BURST_SIZE):
+            res = self.serv.recv(timeout_s=5)
+            responses[res.msg_id] = res
+
+        self.assertEqual(BURST_SIZE, len(responses))
+        for req in requests:
+            self.assertMsgEqual(Lwm2mContent.matching(req)(),
+                                responses[req.msg_id])
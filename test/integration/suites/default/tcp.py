@@ -0,0 +1,49 @@
+# -*- coding: utf-8 -*-
+#
+# Copyright 2017 AVSystem <avsystem@avsystem.com>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from framework.lwm2m_test import *
+
+
+class TcpBindingTest(test_suite.Lwm2mTest):
+    def setUp(self):
+        self.servers = [Lwm2mServer(coap.TcpServer())]
+        self.start_demo(['--security-mode', 'nosec', '--binding=T',
+                         '--server-uri', 'coap+tcp://127.0.0.1:%d'
+                         % (self.servers[0].get_listen_port(),)])
+
+    def tearDown(self):
+        self.teardown_demo_with_servers()
+
+    def runTest(self):
+        serv = self.servers[0]
+
+        pkt = serv.recv(timeout_s=2)
+        self.assertMsgEqual(
+            Lwm2mRegister('/rd?lwm2m=%s&ep=%s&lt=86400&b=T'
+                          % (DEMO_LWM2M_VERSION, DEMO_ENDPOINT_NAME)),
+            pkt)
+        serv.send(Lwm2mCreated.matching(pkt)(location=self.DEFAULT_REGISTER_ENDPOINT))
+
+        # requests and responses flow without ACKs or retransmissions
+        req = Lwm2mRead('/3/0/0')
+        serv.send(req)
+        self.assertMsgEqual(Lwm2mContent.matching(req)(), serv.recv())
+
+        # the client must answer Ping on its own
+        serv.send_ping(b'ping')
+        req = Lwm2mRead('/3/0/1')
+        serv.send(req)
+        self.assertMsgEqual(Lwm2mContent.matching(req)(), serv.recv())
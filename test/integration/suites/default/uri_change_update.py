@@ -14,6 +14,8 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+import socket
+
 from framework.lwm2m_test import *
 
 
@@ -76,3 +78,49 @@ class UriChangeUpdateTest(test_suite.Lwm2mTest):
 
         # we should now get a Registration Update on the new URL
         self.assertDemoUpdatesRegistration(self.servers[1])
+
+
+class UriRewriteWithSameValueTest(test_suite.Lwm2mTest):
+    def setUp(self):
+        self.servers = [Lwm2mServer()]
+        self.bootstrap_server = Lwm2mServer()
+
+        demo_args = (self.make_demo_args([self.bootstrap_server, self.servers[0]])
+                     + ['--bootstrap'])
+        self.start_demo(demo_args)
+
+    def tearDown(self):
+        try:
+            self.request_demo_shutdown()
+            self.assertDemoDeregisters(self.servers[0])
+        finally:
+            self.bootstrap_server.close()
+            self.servers[0].close()
+
+            self.terminate_demo()
+
+    def runTest(self):
+        regular_serv_uri = 'coap://127.0.0.1:%d' % self.servers[0].get_listen_port()
+
+        self.assertDemoRegisters(self.servers[0])
+
+        # write the same server URI
+        demo_port = int(self.communicate('get-port -1', match_regex='PORT==([0-9]+)\n').group(1))
+        self.bootstrap_server.connect(('127.0.0.1', demo_port))
+
+        req = Lwm2mWrite('/0/2/%d' % RID.Security.ServerURI,
+                         regular_serv_uri)
+        self.bootstrap_server.send(req)
+
+        self.assertMsgEqual(Lwm2mChanged.matching(req)(),
+                            self.bootstrap_server.recv())
+
+        req = Lwm2mBootstrapFinish()
+        self.bootstrap_server.send(req)
+
+        self.assertMsgEqual(Lwm2mChanged.matching(req)(),
+                            self.bootstrap_server.recv())
+
+        # the connection is kept intact, so there is no need for an Update
+        with self.assertRaises(socket.timeout):
+            print(self.servers[0].recv(timeout_s=3))
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright 2017 AVSystem <avsystem@avsystem.com>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Shows how the load that a fleet of clients puts on the LwM2M Server spreads
+over time after a server outage, depending on the randomization settings of
+anjay_configuration_t (randomize_retry_backoff, update_jitter_percent and
+reconnect_jitter_ms).
+
+All clients lose the connection when the outage starts, retry with the
+backoff used for Register/Update jobs (1 s initial delay, 120 s maximum) until
+the server is back up, and then keep sending periodic Updates.
+"""
+
+import argparse
+import random
+
+INITIAL_DELAY_S = 1.0
+MAX_DELAY_S = 120.0
+UPDATE_INTERVAL_MARGIN_FACTOR = 2
+
+
+def next_retry_delay(previous_s, randomize, rng):
+    if randomize:
+        # "decorrelated jitter", see randomize_backoff() in src/sched.c
+        upper = min(3 * previous_s, MAX_DELAY_S)
+        return rng.uniform(INITIAL_DELAY_S, max(upper, INITIAL_DELAY_S))
+    return min(2 * previous_s, MAX_DELAY_S)
+
+
+def update_delay(lifetime_s, jitter_percent, rng):
+    # see schedule_next_update() in src/servers/register.c
+    delay = lifetime_s - lifetime_s / UPDATE_INTERVAL_MARGIN_FACTOR
+    return delay - rng.uniform(0, delay * jitter_percent / 100)
+
+
+def simulate_client(args, rng):
+    requests = []
+    t = args.outage_start + rng.uniform(0, args.reconnect_jitter_ms / 1000)
+    delay = None
+    while True:
+        requests.append(t)
+        if t >= args.outage_end:
+            break
+        delay = (INITIAL_DELAY_S if delay is None
+                 else next_retry_delay(delay, args.randomize_backoff, rng))
+        t += delay
+    while t < args.duration:
+        t += update_delay(args.lifetime, args.update_jitter_percent, rng)
+        requests.append(t)
+    return requests
+
+
+def main():
+    parser = argparse.ArgumentParser(
+            description=__doc__,
+            formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--clients', type=int, default=1000)
+    parser.add_argument('--outage-start', type=float, default=0.0)
+    parser.add_argument('--outage-end', type=float, default=300.0)
+    parser.add_argument('--duration', type=float, default=1800.0,
+                        help='simulated time, in seconds')
+    parser.add_argument('--lifetime', type=float, default=600.0,
+                        help='Registration Lifetime, in seconds')
+    parser.add_argument('--randomize-backoff', action='store_true')
+    parser.add_argument('--update-jitter-percent', type=float, default=0.0)
+    parser.add_argument('--reconnect-jitter-ms', type=float, default=0.0)
+    parser.add_argument('--bucket', type=float, default=10.0,
+                        help='histogram bucket size, in seconds')
+    parser.add_argument('--seed', type=int, default=0)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    buckets = [0] * (int(args.duration / args.bucket) + 1)
+    for _ in range(args.clients):
+        for t in simulate_client(args, rng):
+            if t < args.duration:
+                buckets[int(t / args.bucket)] += 1
+
+    peak = max(buckets)
+    width = 60
+    for index, count in enumerate(buckets):
+        bar = '#' * int(round(width * count / peak)) if peak else ''
+        print('%7.0f s %7d %s' % (index * args.bucket, count, bar))
+    recovered = buckets[int(args.outage_end / args.bucket):]
+    print('peak after the outage: %d requests per %g s'
+          % (max(recovered) if recovered else 0, args.bucket))
+
+
+if __name__ == '__main__':
+    main()